@@ -0,0 +1,40 @@
+#version 330 core
+
+// Single-pass cubemap rendering, see RenderTarget::kCubemapLayered.
+// Emits the triangle to every face in SU_CUBE_FACES (bit per face, 
+// +x -x +y -y +z -z), the faces culled on CPU are skipped.
+
+layout(triangles) in;
+layout(triangle_strip, max_vertices = 18) out;
+
+uniform mat4 SU_CUBE_PV_MATRIX_0;
+uniform mat4 SU_CUBE_PV_MATRIX_1;
+uniform mat4 SU_CUBE_PV_MATRIX_2;
+uniform mat4 SU_CUBE_PV_MATRIX_3;
+uniform mat4 SU_CUBE_PV_MATRIX_4;
+uniform mat4 SU_CUBE_PV_MATRIX_5;
+uniform int  SU_CUBE_FACES;
+
+mat4 FacePv(int face) {
+  if (face == 0) return SU_CUBE_PV_MATRIX_0;
+  if (face == 1) return SU_CUBE_PV_MATRIX_1;
+  if (face == 2) return SU_CUBE_PV_MATRIX_2;
+  if (face == 3) return SU_CUBE_PV_MATRIX_3;
+  if (face == 4) return SU_CUBE_PV_MATRIX_4;
+  return SU_CUBE_PV_MATRIX_5;
+}
+
+void main() {
+  for (int face = 0; face < 6; ++face) {
+    if ((SU_CUBE_FACES & (1 << face)) == 0) {
+      continue;
+    }
+    mat4 pv = FacePv(face);
+    for (int i = 0; i < 3; ++i) {
+      gl_Layer = face;
+      gl_Position = pv * gl_in[i].gl_Position;
+      EmitVertex();
+    }
+    EndPrimitive();
+  }
+}
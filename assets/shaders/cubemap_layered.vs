@@ -0,0 +1,10 @@
+#version 330 core
+
+layout(location = 0) in vec3 IN_position;
+
+uniform mat4 SU_M_MATRIX;
+
+// World space, the geometry shader projects it to the cube faces
+void main() {
+  gl_Position = SU_M_MATRIX * vec4(IN_position, 1); 
+}
@@ -0,0 +1,186 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "actor.h"
+#include "scene.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+// Idle animation of a building or a prop, a bit of math every tick which 
+// does not move anything (flags, lights, the shop signs)
+struct Idle : public Action {
+  float phase = 0;
+  float value = 0;
+
+  Idle(std::shared_ptr<Transformation> t, float p) : Action(t), phase(p) {}
+
+  void Update() override {
+    phase += 0.016f;
+    value = std::sin(phase) * std::cos(phase * 0.5f);
+    benchmark::DoNotOptimize(value);
+  }
+};
+
+// Drives for a while and parks, traffic() wakes it up again
+struct Drive : public Action {
+  int frames_left = 0;
+
+  Drive(std::shared_ptr<Transformation> t, int frames) 
+    : Action(t), frames_left(frames) {}
+
+  void Update() override {
+    if (frames_left > 0) {
+      --frames_left;
+      transform->Translate(glm::vec3(0.1f, 0, 0));
+      transform->Rotate(glm::vec3(0, 0.5f, 0));
+    }
+  }
+};
+
+// Always walking
+struct Walk : public Action {
+  Walk(std::shared_ptr<Transformation> t) : Action(t) {}
+
+  void Update() override {
+    transform->Translate(glm::vec3(0, 0, 0.02f));
+  }
+};
+
+// 90% buildings, 8% cars, 2% pedestrians. The flags on: the buildings are
+// static, the cars fall asleep a second after they park.
+struct City {
+  std::vector<std::shared_ptr<Actor>> actors;
+  std::vector<std::shared_ptr<Drive>> cars;
+
+  City(int n, bool flags) {
+    for (int i = 0; i < n; ++i) {
+      auto actor = std::make_shared<Actor>("actor." + std::to_string(i));
+      actor->transform->SetLocalPosition(i % 256 * 10.0f, 0, i / 256 * 10.0f);
+      int kind = i % 50;
+      if (kind < 45) {
+        actor->AddAction<Idle>(i * 0.1f);
+        actor->SetStatic(flags);
+      } else if (kind < 49) {
+        cars.push_back(actor->AddAction<Drive>(i % 120));
+        if (flags) {
+          actor->SetAutoSleep(60);
+        }
+      } else {
+        actor->AddAction<Walk>();
+      }
+      actors.push_back(actor);
+    }
+  }
+
+  // A few cars drive away every frame, each one every 10 s
+  void Traffic(int frame) {
+    for (size_t i = frame % 600; i < cars.size(); i += 600) {
+      if (cars[i]->frames_left == 0) {
+        cars[i]->frames_left = 120;
+        cars[i]->GetTransform()->GetActor().WakeUp();
+      }
+    }
+  }
+};
+
+static void BM_CityUpdate(benchmark::State& state) {
+  City city(state.range(0), state.range(1));
+  int frame = 0;
+  size_t n_ticked = 0;
+  glm::mat4 model;
+  for (auto _: state) {
+    city.Traffic(frame++);
+    for (auto& actor: city.actors) {
+      actor->Update(1 / 60.0f);
+      n_ticked += actor->HasTicked();
+    }
+
+    // What the render queue needs of every actor
+    for (auto& actor: city.actors) {
+      actor->GetWorldMatrix(model);
+      benchmark::DoNotOptimize(model);
+    }
+  }
+  state.counters["ticked"] = benchmark::Counter(
+      n_ticked, benchmark::Counter::kAvgIterations);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CityUpdate)
+  ->ArgNames({"actors", "flags"})
+  ->Args({50000, 0})
+  ->Args({50000, 1})
+  ->Unit(benchmark::kMillisecond);
+
+// Animated by the time passed, whatever the tick rate
+struct Wander : public Action {
+  float phase = 0;
+
+  Wander(std::shared_ptr<Transformation> t, float p) : Action(t), phase(p) {}
+
+  void Update() override {
+    phase += GetDeltaTime();
+    transform->Translate(glm::vec3(std::cos(phase), 0, std::sin(phase)) *
+                         GetDeltaTime());
+  }
+};
+
+// 50k animated actors on a 450x450 field around the camera, everyone ticks
+// every frame or by the distance as Scene::UpdateActor() does
+static void BM_CrowdTickRates(benchmark::State& state) {
+  int n = state.range(0);
+  bool rates = state.range(1);
+  std::vector<std::shared_ptr<Actor>> actors;
+  int side = (int)std::sqrt((float)n);
+  for (int i = 0; i < n; ++i) {
+    auto actor = std::make_shared<Actor>("actor." + std::to_string(i));
+    actor->transform->SetLocalPosition(
+        (i % side - side / 2) * 2.0f, 0, (i / side - side / 2) * 2.0f);
+    actor->AddAction<Wander>(i * 0.1f);
+    actors.push_back(actor);
+  }
+
+  Scene::TickRates tick_rates;
+  glm::vec3 eye(0);
+  size_t n_ticked = 0;
+  for (auto _: state) {
+    for (auto& actor: actors) {
+      if (rates) {
+        float distance = glm::distance(actor->transform->GetGlobalPosition(), eye);
+        actor->SetTickInterval(tick_rates.GetInterval(distance), false);
+      }
+      actor->Update(1 / 60.0f);
+      n_ticked += actor->HasTicked();
+    }
+  }
+  state.counters["ticked"] = benchmark::Counter(
+      n_ticked, benchmark::Counter::kAvgIterations);
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_CrowdTickRates)
+  ->ArgNames({"actors", "rates"})
+  ->Args({50000, 0})
+  ->Args({50000, 1})
+  ->Unit(benchmark::kMillisecond);
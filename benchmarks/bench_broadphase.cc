@@ -0,0 +1,120 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "phys/sweepandprune.h"
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+using Phys::Aabb;
+using Phys::SweepAndPrune;
+
+// Bodies drifting in a box, the density about the same for any count
+struct Bodies {
+  std::vector<glm::vec3> centers;
+  std::vector<glm::vec3> velocities;
+  std::vector<glm::vec3> sizes;
+  float                  extent;
+
+  explicit Bodies(int n) : extent(std::cbrt((float)n) * 6) {
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> position(-extent, extent);
+    std::uniform_real_distribution<float> velocity(-0.1f, 0.1f);
+    std::uniform_real_distribution<float> size(0.5f, 2);
+    for (int i = 0; i < n; ++i) {
+      centers.emplace_back(position(rng), position(rng), position(rng));
+      velocities.emplace_back(velocity(rng), velocity(rng), velocity(rng));
+      sizes.emplace_back(size(rng));
+    }
+  }
+
+  void Step() {
+    for (size_t i = 0; i < centers.size(); ++i) {
+      centers[i] += velocities[i];
+      for (int k = 0; k < 3; ++k) {
+        if (std::abs(centers[i][k]) > extent) velocities[i][k] *= -1;
+      }
+    }
+  }
+
+  Aabb GetBounds(size_t i) const {
+    return {centers[i] - sizes[i], centers[i] + sizes[i]};
+  }
+};
+
+static void BM_BroadPhaseBruteForce(benchmark::State& state) {
+  Bodies bodies(state.range(0));
+  std::vector<Aabb> boxes(bodies.centers.size());
+  std::vector<SweepAndPrune::Pair> pairs;
+  for (auto _: state) {
+    bodies.Step();
+    for (size_t i = 0; i < boxes.size(); ++i) {
+      boxes[i] = bodies.GetBounds(i);
+    }
+    SweepAndPrune::FindPairsBruteForce(boxes, pairs);
+  }
+  state.counters["pairs"] = pairs.size();
+}
+BENCHMARK(BM_BroadPhaseBruteForce)
+  ->ArgName("bodies")
+  ->Arg(10000)
+  ->Unit(benchmark::kMillisecond);
+
+static void BM_BroadPhaseSap(benchmark::State& state) {
+  Bodies bodies(state.range(0));
+  SweepAndPrune::Params params;
+  params.isa = state.range(1) ? SweepAndPrune::Isa::kBest 
+                              : SweepAndPrune::Isa::kScalar;
+  params.n_threads = state.range(2);
+  SweepAndPrune sap(params);
+  for (size_t i = 0; i < bodies.centers.size(); ++i) {
+    sap.Add(bodies.GetBounds(i));
+  }
+  sap.FindPairs();
+
+  size_t n_swaps = 0, n_tests = 0;
+  for (auto _: state) {
+    bodies.Step();
+    for (size_t i = 0; i < bodies.centers.size(); ++i) {
+      sap.Update(i, bodies.GetBounds(i));
+    }
+    sap.FindPairs();
+    n_swaps += sap.GetStats().swaps;
+    n_tests += sap.GetStats().tests;
+  }
+  auto avg = benchmark::Counter::kAvgIterations;
+  state.counters["pairs"] = sap.GetStats().pairs;
+  state.counters["swaps"] = benchmark::Counter(n_swaps, avg);
+  state.counters["tests"] = benchmark::Counter(n_tests, avg);
+}
+// bodies, simd, threads (0 - all the cores)
+BENCHMARK(BM_BroadPhaseSap)
+  ->ArgNames({"bodies", "simd", "threads"})
+  ->Args({10000, 0, 1})
+  ->Args({10000, 1, 1})
+  ->Args({10000, 1, 0})
+  ->Args({50000, 0, 1})
+  ->Args({50000, 1, 1})
+  ->Args({50000, 1, 0})
+  ->Unit(benchmark::kMillisecond);
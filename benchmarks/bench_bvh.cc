@@ -0,0 +1,159 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "phys/bvh.h"
+#include "meshloader.h"
+#include "gridmesh.h"
+#include "noise/perlin.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <random>
+#include <vector>
+
+using Phys::Bvh;
+using Phys::Ray;
+
+// The assets are relative to the repository root, run from there 
+// (the run_benchmarks target does)
+
+static std::shared_ptr<Mesh> GetKnight() {
+  static auto mesh = MeshLoader::Load("assets/models/knight.dsm");
+  return mesh;
+}
+
+// 1001x1001 vertices, 2M triangles
+static std::shared_ptr<Mesh> GetTerrain() {
+  static std::shared_ptr<Mesh> mesh;
+  if (!mesh) {
+    GridMesh::Params params;
+    params.x_vertices = params.z_vertices = 1001;
+    params.x_length = params.z_length = 2000;
+    mesh = GridMesh::Build(params, [](int x, int z) {
+      return Noise::Perlin::Fbm(x / 100.0f, z / 100.0f, 
+                                Noise::Perlin::FbmParams()) * 200;
+    });
+  }
+  return mesh;
+}
+
+static std::shared_ptr<Mesh> GetMesh(int which) {
+  return which ? GetTerrain() : GetKnight();
+}
+
+// From the points around the bounds to the points inside, most of them hit
+static std::vector<Ray> MakeRays(const Phys::Aabb& bounds, int n) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> unit(0, 1);
+  glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
+  float radius = glm::length(bounds.max - bounds.min);
+  std::vector<Ray> rays;
+  for (int i = 0; i < n; ++i) {
+    glm::vec3 from = center + radius * glm::normalize(
+        glm::vec3(unit(rng) - 0.5f, unit(rng) * 0.5f, unit(rng) - 0.5f));
+    glm::vec3 to = bounds.min + (bounds.max - bounds.min) * 
+                   glm::vec3(unit(rng), unit(rng), unit(rng));
+    rays.push_back({from, glm::normalize(to - from)});
+  }
+  return rays;
+}
+
+static void BM_BvhBuild(benchmark::State& state) {
+  auto mesh = GetMesh(state.range(0));
+  Bvh::Params params;
+  params.n_threads = state.range(1);
+  size_t n_nodes = 0;
+  for (auto _: state) {
+    Bvh bvh(*mesh, params);
+    n_nodes = bvh.GetStats().nodes;
+  }
+  state.counters["nodes"] = n_nodes;
+  state.SetItemsProcessed(state.iterations() * mesh->indices.size() / 3);
+}
+// mesh: 0 - knight, 1 - terrain; threads: 0 - all the cores
+BENCHMARK(BM_BvhBuild)
+  ->ArgNames({"mesh", "threads"})
+  ->Args({0, 1})
+  ->Args({0, 0})
+  ->Args({1, 1})
+  ->Args({1, 0})
+  ->Unit(benchmark::kMillisecond);
+
+static void BM_BvhRaycast(benchmark::State& state) {
+  auto mesh = GetMesh(state.range(0));
+  Bvh::Params params;
+  params.isa = state.range(1) ? Bvh::Isa::kBest : Bvh::Isa::kScalar;
+  Bvh bvh(*mesh, params);
+  auto rays = MakeRays(bvh.GetBounds(), 4096);
+  size_t n_hits = 0;
+  for (auto _: state) {
+    for (auto& ray: rays) {
+      Bvh::Hit hit;
+      n_hits += bvh.Raycast(ray, hit);
+    }
+  }
+  state.counters["rays"] = benchmark::Counter(
+      state.iterations() * rays.size(), benchmark::Counter::kIsRate);
+  state.counters["hits"] = (double)n_hits / (state.iterations() * rays.size());
+  state.counters["sah"] = bvh.GetStats().sah_cost;
+}
+BENCHMARK(BM_BvhRaycast)
+  ->ArgNames({"mesh", "simd"})
+  ->Args({0, 0})
+  ->Args({0, 1})
+  ->Args({1, 0})
+  ->Args({1, 1})
+  ->Unit(benchmark::kMillisecond);
+
+static void BM_BvhOccluded(benchmark::State& state) {
+  auto mesh = GetMesh(state.range(0));
+  Bvh bvh(*mesh);
+  auto rays = MakeRays(bvh.GetBounds(), 4096);
+  for (auto _: state) {
+    for (auto& ray: rays) {
+      benchmark::DoNotOptimize(bvh.Occluded(ray));
+    }
+  }
+  state.counters["rays"] = benchmark::Counter(
+      state.iterations() * rays.size(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_BvhOccluded)
+  ->ArgName("mesh")
+  ->Arg(0)
+  ->Arg(1)
+  ->Unit(benchmark::kMillisecond);
+
+// What the tools did before
+static void BM_RaycastBruteForce(benchmark::State& state) {
+  auto mesh = GetKnight();
+  auto rays = MakeRays(Bvh(*mesh).GetBounds(), 64);
+  for (auto _: state) {
+    for (auto& ray: rays) {
+      Bvh::Hit hit;
+      benchmark::DoNotOptimize(Bvh::RaycastBruteForce(*mesh, ray, hit));
+    }
+  }
+  state.counters["rays"] = benchmark::Counter(
+      state.iterations() * rays.size(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_RaycastBruteForce)->Unit(benchmark::kMillisecond);
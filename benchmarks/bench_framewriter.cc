@@ -0,0 +1,106 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "image/framewriter.h"
+#include "image/portablepixmap.h"
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <fstream>
+
+using Image::FrameWriter;
+using Image::ColorMap32;
+
+static const int kWidth  = 1920;
+static const int kHeight = 1080;
+
+static void Fill(ColorMap32& frame, int seed) {
+  for (size_t i = 0; i < frame.GetLength(); ++i) {
+    uint8_t c = (uint8_t)(i * 7 + seed);
+    frame.At(i) = Color32(c, c / 2, 255 - c, 255);
+  }
+}
+
+// The PortablePixMap::Write as it was: ostream write per pixel
+static void BM_PpmWriteLegacy(benchmark::State& state) {
+  Image::ColorMap img(kWidth, kHeight);
+  for (auto _: state) {
+    std::ofstream out("bench_framewriter.ppm", std::ios::out | std::ios::binary);
+    out << "P6\n" << kWidth << " " << kHeight << "\n" << 255 << "\n";
+    for (size_t i = 0; i < img.GetLength(); ++i) {
+      const Color& c = img.At(i);
+      uint8_t rgb[3] = {(uint8_t)Math::Clamp(0.0f, 255.0f, c.r*255),
+                        (uint8_t)Math::Clamp(0.0f, 255.0f, c.g*255),
+                        (uint8_t)Math::Clamp(0.0f, 255.0f, c.b*255)};
+      out.write((char*)rgb, 3);
+    }
+  }
+  std::remove("bench_framewriter.ppm");
+}
+BENCHMARK(BM_PpmWriteLegacy)->Unit(benchmark::kMillisecond);
+
+static void BM_PpmWrite(benchmark::State& state) {
+  Image::ColorMap img(kWidth, kHeight);
+  for (auto _: state) {
+    Image::PortablePixMap::Write("bench_framewriter.ppm", img);
+  }
+  std::remove("bench_framewriter.ppm");
+}
+BENCHMARK(BM_PpmWrite)->Unit(benchmark::kMillisecond);
+
+static void BM_EncodeY4m(benchmark::State& state) {
+  ColorMap32 frame(kWidth, kHeight);
+  Fill(frame, 0);
+  std::vector<uint8_t> out;
+  for (auto _: state) {
+    FrameWriter::EncodeY4mFrame(frame, out);
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK(BM_EncodeY4m)->Unit(benchmark::kMillisecond);
+
+// The render thread side of a capture: take a frame, copy the readback
+// into it, push. The conversion and the writes happen on the writer threads.
+static void BM_FrameWriterPush(benchmark::State& state) {
+  FrameWriter::Params params;
+  params.filename = "bench_framewriter.y4m";
+  ColorMap32 readback(kWidth, kHeight);
+  Fill(readback, 0);
+  size_t dropped = 0, written = 0;
+  {
+    FrameWriter writer(params, kWidth, kHeight);
+    for (auto _: state) {
+      auto frame = writer.GetFrame();
+      std::copy(readback.GetArray(), readback.GetArray() + readback.GetLength(),
+                frame->GetArray());
+      writer.Push(frame);
+    }
+    writer.Flush();
+    dropped = writer.GetStats().dropped;
+    written = writer.GetStats().written;
+  }
+  state.counters["written"] = written;
+  state.counters["dropped"] = dropped;
+  std::remove("bench_framewriter.y4m");
+}
+BENCHMARK(BM_FrameWriterPush)->Unit(benchmark::kMillisecond);
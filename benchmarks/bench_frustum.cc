@@ -0,0 +1,75 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "camera.h"
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+struct Aabb {
+  glm::vec3 mins;
+  glm::vec3 maxs;
+};
+
+// Boxes around the camera, about a fourth of them in the frustum
+static std::vector<Aabb> GetBoxes() {
+  std::vector<Aabb> boxes;
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> position(-500, 500);
+  std::uniform_real_distribution<float> size(0.5f, 10);
+  for (int i = 0; i < 10000; ++i) {
+    glm::vec3 p(position(rng), position(rng) / 10, position(rng));
+    glm::vec3 s(size(rng));
+    boxes.push_back({p - s, p + s});
+  }
+  return boxes;
+}
+
+static void BM_FrustumTestAabb(benchmark::State& state) {
+  auto boxes = GetBoxes();
+  Frustum frustum;
+  frustum.Calculate(
+      glm::perspective(glm::radians(60.0f), 16 / 9.0f, 0.1f, 1000.0f) *
+      glm::lookAt(glm::vec3(0, 10, 0), glm::vec3(1, 10, 1), glm::vec3(0, 1, 0)));
+  size_t visible = 0;
+  for (auto _: state) {
+    for (auto& box: boxes) {
+      visible += frustum.TestAabb(box.mins, box.maxs);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * boxes.size());
+  state.counters["visible"] = benchmark::Counter(
+      visible / (double)boxes.size(), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_FrustumTestAabb)->Unit(benchmark::kMicrosecond);
+
+static void BM_FrustumCalculate(benchmark::State& state) {
+  Frustum frustum;
+  glm::mat4 pv = glm::perspective(glm::radians(60.0f), 16 / 9.0f, 0.1f, 1000.0f);
+  for (auto _: state) {
+    frustum.Calculate(pv);
+    benchmark::DoNotOptimize(frustum);
+  }
+}
+BENCHMARK(BM_FrustumCalculate);
@@ -0,0 +1,65 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "b3d.h"
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+
+// Needs a GL context, a hidden window. Without a display build with 
+// B3D_HEADLESS_OSMESA. Not in the GL-free run_benchmarks target, see 
+// run_benchmarks_gl.
+static void InitContext() {
+  static bool ready = false;
+  if (!ready) {
+    AppContext::Init(64, 64, "bench", Profile("3 3 core"), true);
+    ready = true;
+  }
+}
+
+static const std::vector<std::string> kMaterials = {
+  "assets/materials/texture.mat",
+  "assets/materials/shadow_caster_receiver_dirlight_csm.mat",
+  "assets/materials/postprocess/blur_linear.mat",
+  "assets/fonts/mono.mat",
+};
+
+// The shaders, textures and YAML documents are cached after the first load,
+// every next Load() builds the Material and the passes from the cache
+static void BM_MaterialLoaderLoadCached(benchmark::State& state) {
+  InitContext();
+  for (auto& filename: kMaterials) {
+    MaterialLoader::Load(filename);
+  }
+  MaterialLoader::Wait();
+
+  for (auto _: state) {
+    for (auto& filename: kMaterials) {
+      auto material = MaterialLoader::Load(filename);
+      benchmark::DoNotOptimize(material.get());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kMaterials.size());
+}
+BENCHMARK(BM_MaterialLoaderLoadCached)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,109 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "gridmesh.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <functional>
+
+static const int kSize = 2049;
+
+static float SampleHeight(int x, int z) {
+  return std::sin(x * 0.01f) * std::cos(z * 0.01f) * 10.0f;
+}
+
+static glm::vec4 SampleColor(int x, int z) {
+  return glm::vec4(x / (float)kSize, z / (float)kSize, 0.5f, 1.0f);
+}
+
+// The old terrain generators: std::function samplers, serial loop, 
+// index buffer per mesh and Mesh::RecalculateNormals
+static std::shared_ptr<Mesh> BuildLegacy(std::function<float(int, int)> sample_height,
+                                         std::function<glm::vec4(int, int)> sample_color,
+                                         int resolution, float scale) {
+  auto mesh = std::make_shared<Mesh>();
+  mesh->vertices.resize(resolution * resolution);
+  mesh->uv.resize(resolution * resolution);
+  mesh->colors.resize(resolution * resolution);
+  mesh->indices.resize((resolution - 1) * (resolution - 1) * 6);
+
+  int triangle_index = 0;
+  auto add_triangle = [&mesh, &triangle_index] (int a, int b, int c) {
+    mesh->indices[triangle_index] = a;
+    mesh->indices[triangle_index + 1] = b;
+    mesh->indices[triangle_index + 2] = c;
+    triangle_index += 3;
+  };
+
+  int vertex_index = 0;
+  for (int z = 0; z < resolution; z++) {
+    float v = (float)z / (resolution - 1);
+    float zpos = Math::Lerp(-0.5f, 0.5f, v) * scale;
+    for (int x = 0; x < resolution; x++) {
+      float u = (float)x / (resolution - 1);
+      float xpos = Math::Lerp(-0.5f, 0.5f, u) * scale;
+      mesh->vertices[vertex_index] = glm::vec3(xpos, sample_height(x, z), zpos);
+      mesh->uv[vertex_index] = glm::vec2(u, v);
+      mesh->colors[vertex_index] = sample_color(x, z);
+      if (x < resolution - 1 && z < resolution - 1) {
+        add_triangle(vertex_index, vertex_index + resolution, vertex_index + resolution + 1);
+        add_triangle(vertex_index, vertex_index + resolution + 1, vertex_index + 1);
+      }
+      vertex_index++;
+    }
+  }
+
+  mesh->RecalculateNormals();
+  return mesh;
+}
+
+static void BM_GridMeshLegacy(benchmark::State& state) {
+  for (auto _: state) {
+    auto mesh = BuildLegacy(SampleHeight, SampleColor, kSize, 1000);
+    benchmark::DoNotOptimize(mesh->vertices.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kSize * kSize);
+}
+BENCHMARK(BM_GridMeshLegacy)->Unit(benchmark::kMillisecond);
+
+// Arg: threads (0 is all the cores)
+static void BM_GridMeshBuild(benchmark::State& state) {
+  GridMesh::Params params;
+  params.x_vertices = kSize;
+  params.z_vertices = kSize;
+  params.x_length = 1000;
+  params.z_length = 1000;
+  params.rows = GridMesh::kRowsToPositiveZ;
+  params.n_threads = state.range(0);
+  for (auto _: state) {
+    auto mesh = GridMesh::Build(params, SampleHeight, SampleColor);
+    benchmark::DoNotOptimize(mesh->vertices.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kSize * kSize);
+}
+BENCHMARK(BM_GridMeshBuild)
+  ->ArgName("threads")
+  ->Arg(1)
+  ->Arg(0)
+  ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,71 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "lightclusters.h"
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+static std::vector<LightClusters::Light> GetLights(size_t n) {
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> pos(-200, 200);
+  std::uniform_real_distribution<float> range(2, 15);
+  std::vector<LightClusters::Light> lights(n);
+  for (auto& light: lights) {
+    light.position = glm::vec3(pos(rng), pos(rng) * 0.05f, pos(rng) - 200);
+    light.range = range(rng);
+  }
+  return lights;
+}
+
+// Lights, threads (0 - all the cores)
+static void BM_LightClustersBin(benchmark::State& state) {
+  auto lights = GetLights(state.range(0));
+  LightClusters::Params params;
+  params.n_threads = state.range(1);
+  LightClusters clusters(params);
+  glm::mat4 proj = glm::perspective(glm::radians(60.0f), 16 / 9.0f, 0.5f, 500.0f);
+
+  size_t n_indices = 0;
+  float a = 0;
+  for (auto _: state) {
+    a += 0.01f;
+    glm::mat4 view = glm::lookAt(glm::vec3(0, 10, 0), 
+                                 glm::vec3(std::sin(a), 0, -std::cos(a)) * 100.0f,
+                                 glm::vec3(0, 1, 0));
+    clusters.Bin(lights, view, proj, 0.5f, 500.0f);
+    n_indices += clusters.GetStats().indices;
+  }
+  state.counters["indices"] = benchmark::Counter(n_indices, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_LightClustersBin)
+  ->ArgNames({"lights", "threads"})
+  ->Args({1024, 1})
+  ->Args({1024, 0})
+  ->Args({4096, 1})
+  ->Args({4096, 0})
+  ->Args({16384, 1})
+  ->Args({16384, 0})
+  ->Unit(benchmark::kMicrosecond)
+  ->UseRealTime();
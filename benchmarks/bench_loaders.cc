@@ -0,0 +1,104 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "meshloader.h"
+#include "image/portablepixmap.h"
+#include "yaml_main.h"
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// The assets are relative to the repository root, run from there 
+// (the run_benchmarks target does)
+
+// The cache keeps weak references, nobody holds the mesh so it's parsed
+// every time
+static void BM_MeshLoaderLoadDsm(benchmark::State& state) {
+  size_t n_vertices = 0;
+  for (auto _: state) {
+    auto mesh = MeshLoader::Load("assets/models/knight.dsm");
+    n_vertices = mesh->vertices.size();
+  }
+  state.SetItemsProcessed(state.iterations() * n_vertices);
+}
+BENCHMARK(BM_MeshLoaderLoadDsm)->Unit(benchmark::kMillisecond);
+
+static void BM_MeshRecalculateNormals(benchmark::State& state) {
+  auto mesh = MeshLoader::Load("assets/models/knight.dsm");
+  for (auto _: state) {
+    mesh->RecalculateNormals();
+    benchmark::DoNotOptimize(mesh->normals.data());
+  }
+  state.SetItemsProcessed(state.iterations() * mesh->indices.size() / 3);
+}
+BENCHMARK(BM_MeshRecalculateNormals)->Unit(benchmark::kMillisecond);
+
+static void BM_PortablePixMapRead(benchmark::State& state) {
+  const std::string filename = "bench_loaders.ppm";
+  int size = state.range(0);
+  Image::ColorMap image(size, size);
+  for (int y = 0; y < size; ++y) {
+    for (int x = 0; x < size; ++x) {
+      image.At(x, y) = Rgba(x & 255, y & 255, (x ^ y) & 255, 255);
+    }
+  }
+  Image::PortablePixMap::Write(filename, image);
+
+  for (auto _: state) {
+    auto read = Image::PortablePixMap::Read(filename);
+    benchmark::DoNotOptimize(read->GetArray());
+  }
+  state.SetBytesProcessed(state.iterations() * size * size * 3);
+  std::remove(filename.c_str());
+}
+BENCHMARK(BM_PortablePixMapRead)
+  ->ArgName("size")
+  ->Arg(512)
+  ->Arg(2048)
+  ->Unit(benchmark::kMillisecond);
+
+// The YAML part of MaterialLoader::Load(), the first load of a material.
+// The rest (shaders, textures) needs GL, see bench_gl_materialloader.
+static void BM_MaterialYamlParse(benchmark::State& state) {
+  const std::vector<std::string> filenames = {
+    "assets/materials/texture.mat",
+    "assets/materials/shadow_caster_receiver_dirlight_csm.mat",
+    "assets/materials/postprocess/blur_linear.mat",
+    "assets/fonts/mono.mat",
+  };
+  size_t n_passes = 0;
+  for (auto _: state) {
+    for (auto& filename: filenames) {
+      YAML::Node root = YAML::LoadFile(filename);
+      for (auto node: root) {
+        n_passes += node.first.as<std::string>() == "pass";
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * filenames.size());
+  state.counters["passes"] = benchmark::Counter(
+      n_passes, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_MaterialYamlParse)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,185 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "looseoctree.h"
+#include "camera.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+static const float kHalfSize       = 8192;
+static const float kActiveDistance = 500;
+
+// 1M boxes on the ground of 16 x 16 km, the things of 1 - 8 m
+struct World {
+  std::vector<glm::vec3> min;
+  std::vector<glm::vec3> max;
+
+  explicit World(size_t n) {
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> position(-kHalfSize * 0.95f, 
+                                                   kHalfSize * 0.95f);
+    std::uniform_real_distribution<float> size(0.5f, 4);
+    for (size_t i = 0; i < n; ++i) {
+      glm::vec3 center(position(rng), 0, position(rng));
+      glm::vec3 half(size(rng), size(rng), size(rng));
+      center.y = half.y;
+      min.push_back(center - half);
+      max.push_back(center + half);
+    }
+  }
+
+  // A quarter of the things walks, ~5 m/s at 60 fps
+  void Move(size_t i, uint32_t frame) {
+    if (i % 4 == 0) {
+      float a = (i % 628) * 0.01f + frame * 0.001f;
+      glm::vec3 d(std::cos(a) * 0.08f, 0, std::sin(a) * 0.08f);
+      min[i] += d;
+      max[i] += d;
+    }
+  }
+};
+
+// Four cameras flying circles over the world
+struct Cameras {
+  glm::vec3 eyes[4];
+  Frustum   frustums[4];
+
+  void Next(uint32_t frame) {
+    for (int i = 0; i < 4; ++i) {
+      float a = frame * 0.001f + i * 1.57f;
+      float r = 1000.0f + i * 1500.0f;
+      eyes[i] = glm::vec3(r * std::cos(a), 30, r * std::sin(a));
+      glm::vec3 ahead(-std::sin(a), -0.1f, std::cos(a));
+      frustums[i].Calculate(
+          glm::perspective(glm::radians(60.0f), 16 / 9.0f, 0.5f, 
+                           kActiveDistance) * 
+          glm::lookAt(eyes[i], eyes[i] + ahead, glm::vec3(0, 1, 0)));
+    }
+  }
+};
+
+static World& GetWorld() {
+  static World world(1000000);
+  return world;
+}
+
+// Every thing moves, every thing is tested against every frustum
+static void BM_PartitionBruteForce(benchmark::State& state) {
+  World world = GetWorld();
+  Cameras cameras;
+  uint32_t frame = 0;
+  size_t n_updated = 0, n_tested = 0, n_visible = 0;
+  for (auto _: state) {
+    cameras.Next(++frame);
+    for (size_t i = 0; i < world.min.size(); ++i) {
+      world.Move(i, frame);
+    }
+    n_updated += world.min.size();
+    for (auto& frustum: cameras.frustums) {
+      for (size_t i = 0; i < world.min.size(); ++i) {
+        n_visible += frustum.TestAabb(world.min[i], world.max[i]);
+      }
+      n_tested += world.min.size();
+    }
+  }
+  auto avg = benchmark::Counter::kAvgIterations;
+  state.counters["updated"] = benchmark::Counter(n_updated, avg);
+  state.counters["tested"] = benchmark::Counter(n_tested, avg);
+  state.counters["visible"] = benchmark::Counter(n_visible, avg);
+}
+BENCHMARK(BM_PartitionBruteForce)->Unit(benchmark::kMillisecond);
+
+// ScenePartition per frame: the things around the cameras move and are 
+// synced, the rest sleeps, the frustums are queried
+static void BM_PartitionLooseOctree(benchmark::State& state) {
+  World world = GetWorld();
+  LooseOctree::Params params;
+  params.half_size = kHalfSize;
+  params.max_depth = state.range(0);
+  LooseOctree octree(params);
+  for (size_t i = 0; i < world.min.size(); ++i) {
+    octree.Add(world.min[i], world.max[i]);
+  }
+
+  Cameras cameras;
+  uint32_t frame = 0;
+  std::vector<uint32_t> marks(world.min.size(), 0), active, ids;
+  size_t n_updated = 0, n_tested = 0, n_visible = 0, n_moved = 0;
+  for (auto _: state) {
+    cameras.Next(++frame);
+    octree.ResetStats();
+    active.clear();
+    glm::vec3 distance(kActiveDistance);
+    for (auto& eye: cameras.eyes) {
+      ids.clear();
+      octree.Query(eye - distance, eye + distance, ids);
+      for (uint32_t id: ids) {
+        if (marks[id] != frame) {
+          marks[id] = frame;
+          active.push_back(id);
+        }
+      }
+    }
+    for (uint32_t id: active) {
+      world.Move(id, frame);
+      octree.Update(id, world.min[id], world.max[id]);
+    }
+    for (auto& frustum: cameras.frustums) {
+      ids.clear();
+      octree.Query(frustum, ids);
+      n_visible += ids.size();
+    }
+    n_updated += active.size();
+    n_tested += octree.GetStats().object_tests;
+    n_moved += octree.GetStats().moves;
+  }
+  auto avg = benchmark::Counter::kAvgIterations;
+  state.counters["updated"] = benchmark::Counter(n_updated, avg);
+  state.counters["tested"] = benchmark::Counter(n_tested, avg);
+  state.counters["visible"] = benchmark::Counter(n_visible, avg);
+  state.counters["moved"] = benchmark::Counter(n_moved, avg);
+  state.counters["nodes"] = octree.GetStats().nodes;
+}
+BENCHMARK(BM_PartitionLooseOctree)
+  ->ArgName("depth")
+  ->Arg(6)
+  ->Arg(8)
+  ->Arg(10)
+  ->Unit(benchmark::kMillisecond);
+
+static void BM_LooseOctreeBuild(benchmark::State& state) {
+  World& world = GetWorld();
+  LooseOctree::Params params;
+  params.half_size = kHalfSize;
+  for (auto _: state) {
+    LooseOctree octree(params);
+    for (size_t i = 0; i < world.min.size(); ++i) {
+      octree.Add(world.min[i], world.max[i]);
+    }
+    benchmark::DoNotOptimize(octree.GetStats().nodes);
+  }
+}
+BENCHMARK(BM_LooseOctreeBuild)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,109 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "occlusionbuffer.h"
+#include "gridmesh.h"
+#include "noise/perlin.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+// Hilly 2km terrain (129 x 129 grid, 32k triangles) as the occluder, the 
+// camera low in a valley, 10k boxes scattered over the terrain.
+
+static std::shared_ptr<Mesh> GetTerrain() {
+  static std::shared_ptr<Mesh> mesh;
+  if (!mesh) {
+    GridMesh::Params params;
+    params.x_vertices = params.z_vertices = 129;
+    params.x_length = params.z_length = 2000;
+    mesh = GridMesh::Build(params, [](int x, int z) {
+      return Noise::Perlin::Get(x / 16.0f, z / 16.0f, 0.5f) * 150;
+    });
+  }
+  return mesh;
+}
+
+static glm::mat4 GetPv() {
+  return glm::perspective(glm::radians(60.0f), 16 / 9.0f, 1.0f, 3000.0f) *
+         glm::lookAt(glm::vec3(0, 20, 0), glm::vec3(500, 0, 300), 
+                     glm::vec3(0, 1, 0));
+}
+
+static std::vector<glm::vec3> GetBoxes() {
+  std::vector<glm::vec3> boxes;
+  for (int i = 0; i < 10000; ++i) {
+    float x = std::fmod(i * 7.31f, 1.0f) * 2000 - 1000;
+    float z = std::fmod(i * 3.17f + 0.5f, 1.0f) * 2000 - 1000;
+    boxes.emplace_back(x, Noise::Perlin::Get(x / 125, z / 125, 0.5f) * 150, z);
+  }
+  return boxes;
+}
+
+static void Rasterize(benchmark::State& state, OcclusionBuffer::Isa isa) {
+  OcclusionBuffer::Params params;
+  params.isa = isa;
+  params.n_threads = (int)state.range(0);
+  OcclusionBuffer buffer(params);
+  auto mesh = GetTerrain();
+  auto pv = GetPv();
+
+  for (auto _ : state) {
+    buffer.Begin(pv);
+    buffer.AddOccluder(mesh->vertices, mesh->indices, glm::mat4(1.0f));
+    buffer.Rasterize();
+  }
+  state.counters["triangles"] = buffer.GetStats().triangles;
+}
+
+static void BM_RasterizeScalar(benchmark::State& state) {
+  Rasterize(state, OcclusionBuffer::Isa::kScalar);
+}
+BENCHMARK(BM_RasterizeScalar)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+static void BM_RasterizeSse2(benchmark::State& state) {
+  Rasterize(state, OcclusionBuffer::Isa::kSse2);
+}
+BENCHMARK(BM_RasterizeSse2)->Arg(1)->Arg(4)->Unit(benchmark::kMicrosecond);
+
+static void BM_TestAabb(benchmark::State& state) {
+  OcclusionBuffer buffer(OcclusionBuffer::Params{});
+  auto mesh = GetTerrain();
+  auto boxes = GetBoxes();
+  buffer.Begin(GetPv());
+  buffer.AddOccluder(mesh->vertices, mesh->indices, glm::mat4(1.0f));
+  buffer.Rasterize();
+
+  size_t visible = 0;
+  for (auto _ : state) {
+    visible = 0;
+    for (auto& p: boxes) {
+      visible += buffer.TestAabb(p - glm::vec3(2, 0, 2), p + glm::vec3(2, 8, 2));
+    }
+  }
+  state.counters["occluded"] = boxes.size() - visible;
+  state.counters["boxes"] = boxes.size();
+}
+BENCHMARK(BM_TestAabb)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,76 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "noise/perlin.h"
+#include <benchmark/benchmark.h>
+#include <vector>
+
+using Noise::Perlin;
+
+static const int kSize = 4096;
+
+static Perlin::FbmParams GetParams() {
+  Perlin::FbmParams params;
+  params.octaves = 5;
+  params.lacunarity = 1.9f;
+  params.persistance = 0.5f;
+  return params;
+}
+
+// The old way, one point and one octave at a time
+static void BM_PerlinFbmPerPoint(benchmark::State& state) {
+  std::vector<float> map(kSize * kSize);
+  auto params = GetParams();
+  for (auto _: state) {
+    for (int y = 0; y < kSize; ++y) {
+      for (int x = 0; x < kSize; ++x) {
+        map[x + y * kSize] = Perlin::Fbm(x / 50.0f, y / 50.0f, params);
+      }
+    }
+    benchmark::DoNotOptimize(map.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kSize * kSize);
+}
+BENCHMARK(BM_PerlinFbmPerPoint)->Unit(benchmark::kMillisecond);
+
+// Args: instruction set, threads (0 is all the cores)
+static void BM_PerlinFillFbm(benchmark::State& state) {
+  std::vector<float> map(kSize * kSize);
+  auto params = GetParams();
+  Perlin::SetIsa(static_cast<Perlin::Isa>(state.range(0)));
+  for (auto _: state) {
+    Perlin::FillFbm(map.data(), kSize, kSize, 0, 0, 1 / 50.0f, params, 
+                    state.range(1));
+    benchmark::DoNotOptimize(map.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kSize * kSize);
+  Perlin::SetIsa(Perlin::Isa::kBest);
+}
+BENCHMARK(BM_PerlinFillFbm)
+  ->ArgNames({"isa", "threads"})
+  ->Args({(int)Perlin::Isa::kScalar, 1})
+  ->Args({(int)Perlin::Isa::kSse2,   1})
+  ->Args({(int)Perlin::Isa::kAvx2,   1})
+  ->Args({(int)Perlin::Isa::kBest,   0})
+  ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,153 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "portalgraph.h"
+#include "camera.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+static const int   kRooms    = 32;  // On a side
+static const float kRoomSize = 10;
+static const int   kThings   = 20;  // In a room
+
+// A maze of rooms, every wall has a 2 x 3 door in the middle, the things
+// of 0.5 - 1.5 m on the floors
+struct Building {
+  PortalGraph            graph;
+  std::vector<glm::vec3> min;
+  std::vector<glm::vec3> max;
+
+  Building() {
+    for (int z = 0; z < kRooms; ++z) {
+      for (int x = 0; x < kRooms; ++x) {
+        graph.AddCell(glm::vec3(x, 0, z) * kRoomSize, 
+                      glm::vec3(x + 1, 0.4f, z + 1) * kRoomSize);
+      }
+    }
+    for (int z = 0; z < kRooms; ++z) {
+      for (int x = 0; x < kRooms; ++x) {
+        int cell = z * kRooms + x;
+        float h = kRoomSize / 2;
+        if (x + 1 < kRooms) {
+          glm::vec3 c((x + 1) * kRoomSize, 0, z * kRoomSize + h);
+          graph.AddPortal(cell, cell + 1, {c + glm::vec3(0, 0, -1), 
+                                           c + glm::vec3(0, 0, 1),
+                                           c + glm::vec3(0, 3, 1), 
+                                           c + glm::vec3(0, 3, -1)});
+        }
+        if (z + 1 < kRooms) {
+          glm::vec3 c(x * kRoomSize + h, 0, (z + 1) * kRoomSize);
+          graph.AddPortal(cell, cell + kRooms, {c + glm::vec3(-1, 0, 0), 
+                                                c + glm::vec3(1, 0, 0),
+                                                c + glm::vec3(1, 3, 0), 
+                                                c + glm::vec3(-1, 3, 0)});
+        }
+      }
+    }
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> position(1, kRoomSize - 1);
+    std::uniform_real_distribution<float> size(0.25f, 0.75f);
+    for (int z = 0; z < kRooms; ++z) {
+      for (int x = 0; x < kRooms; ++x) {
+        for (int i = 0; i < kThings; ++i) {
+          glm::vec3 half(size(rng), size(rng), size(rng));
+          glm::vec3 center(x * kRoomSize + position(rng), half.y, 
+                           z * kRoomSize + position(rng));
+          min.push_back(center - half);
+          max.push_back(center + half);
+          graph.Add(min.back(), max.back());
+        }
+      }
+    }
+  }
+};
+
+// Walking around the middle of the building, looking along the corridors
+// of the doors and across them
+struct Walk {
+  int       frame = 0;
+  glm::vec3 eye;
+  Frustum   frustum;
+
+  void Next() {
+    float a = frame++ * 0.002f;
+    float center = kRooms * kRoomSize / 2;
+    eye = glm::vec3(center + 40 * std::cos(a) + 0.5f, 1.7f, 
+                    center + 40 * std::sin(a) + 0.5f);
+    glm::vec3 ahead(std::cos(a * 7), 0, std::sin(a * 7));
+    frustum.Calculate(
+        glm::perspective(glm::radians(70.0f), 16 / 9.0f, 0.1f, 300.0f) * 
+        glm::lookAt(eye, eye + ahead, glm::vec3(0, 1, 0)));
+  }
+};
+
+static Building& GetBuilding() {
+  static Building building;
+  return building;
+}
+
+static void BM_PortalsFrustumOnly(benchmark::State& state) {
+  Building& building = GetBuilding();
+  Walk walk;
+  size_t n_found = 0, n_tested = 0;
+  for (auto _: state) {
+    walk.Next();
+    for (size_t i = 0; i < building.min.size(); ++i) {
+      n_found += walk.frustum.TestAabb(building.min[i], building.max[i]);
+    }
+    n_tested += building.min.size();
+  }
+  auto avg = benchmark::Counter::kAvgIterations;
+  state.counters["found"] = benchmark::Counter(n_found, avg);
+  state.counters["tested"] = benchmark::Counter(n_tested, avg);
+}
+BENCHMARK(BM_PortalsFrustumOnly)->Unit(benchmark::kMicrosecond);
+
+static void BM_PortalsQuery(benchmark::State& state) {
+  Building& building = GetBuilding();
+  Walk walk;
+  std::vector<uint32_t> ids;
+  size_t n_found = 0, n_tested = 0, n_cells = 0, n_portals = 0, n_culled = 0;
+  for (auto _: state) {
+    walk.Next();
+    ids.clear();
+    building.graph.Query(walk.eye, walk.frustum, ids);
+    auto& stats = building.graph.GetStats();
+    n_found += stats.objects_found;
+    n_tested += stats.objects_tested;
+    n_cells += stats.cells_visited;
+    n_portals += stats.portals_tested;
+    n_culled += stats.objects_culled;
+  }
+  auto avg = benchmark::Counter::kAvgIterations;
+  state.counters["found"] = benchmark::Counter(n_found, avg);
+  state.counters["tested"] = benchmark::Counter(n_tested, avg);
+  state.counters["cells"] = benchmark::Counter(n_cells, avg);
+  state.counters["portals"] = benchmark::Counter(n_portals, avg);
+  state.counters["culled"] = benchmark::Counter(n_culled, avg);
+}
+BENCHMARK(BM_PortalsQuery)->Unit(benchmark::kMicrosecond);
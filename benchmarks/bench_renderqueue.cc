@@ -0,0 +1,76 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "renderqueue.h"
+#include "meshrenderer.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Materials with a color pass and a shadow pass, in three queues
+static std::vector<std::shared_ptr<Material>> GetMaterials(int n_materials) {
+  std::vector<std::shared_ptr<Material>> materials;
+  for (int i = 0; i < n_materials; ++i) {
+    auto material = std::make_shared<Material>();
+    material->SetName("material." + std::to_string(i));
+    auto color = std::make_shared<Pass>();
+    color->SetTags({"onscreen"});
+    color->SetQueue(1000 + (i % 3) * 1000);
+    auto shadow = std::make_shared<Pass>();
+    shadow->SetTags({"shadowmap"});
+    material->AddPass(color);
+    material->AddPass(shadow);
+    materials.push_back(material);
+  }
+  return materials;
+}
+
+// RenderTarget::Draw() rebuilds the queue every frame
+static void BM_RenderQueueBuild(benchmark::State& state) {
+  auto materials = GetMaterials(state.range(1));
+  std::vector<std::shared_ptr<Actor>> actors;
+  for (int i = 0; i < state.range(0); ++i) {
+    auto actor = std::make_shared<Actor>("actor." + std::to_string(i));
+    actor->AddComponent<MeshRenderer>()->SetMaterial(
+        materials[i % materials.size()]);
+    actors.push_back(actor);
+  }
+
+  RenderQueue queue;
+  Tags tags({"onscreen"});
+  for (auto _: state) {
+    queue.Clear();
+    for (auto& actor: actors) {
+      queue.AddActor(actor, tags);
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * actors.size());
+}
+BENCHMARK(BM_RenderQueueBuild)
+  ->ArgNames({"actors", "materials"})
+  ->Args({1000, 10})
+  ->Args({10000, 100})
+  ->Unit(benchmark::kMicrosecond);
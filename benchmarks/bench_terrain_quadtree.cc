@@ -0,0 +1,167 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "terrain/quadtree.h"
+#include "noise/perlin.h"
+#include "camera.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <vector>
+
+using Terrain::QuadTree;
+
+static const float kHalfSize     = 4000;
+static const float kMaxElevation = 1000;
+
+static const Array2d<float>& GetHeights() {
+  static Array2d<float> heights(1024, 1024);
+  static bool ready = false;
+  if (!ready) {
+    Noise::Perlin::FbmParams params;
+    Noise::Perlin::FillFbm(heights.GetArray(), 1024, 1024, 0, 0, 1 / 200.0f, 
+                           params);
+    for (size_t i = 0; i < heights.GetLength(); ++i) {
+      heights.At(i) = (heights.At(i) * 0.5f + 0.5f) * kMaxElevation;
+    }
+    ready = true;
+  }
+  return heights;
+}
+
+// Flight around the terrain, ~200 units/s at 60 fps
+struct Flight {
+  int frame = 0;
+  glm::vec3 eye;
+  Frustum   frustum;
+
+  void Next() {
+    float a = frame++ * 0.001f;
+    eye = glm::vec3(2000 * std::cos(a), kMaxElevation * 0.75f, 2000 * std::sin(a));
+    glm::vec3 ahead(-std::sin(a), -0.3f, std::cos(a));
+    frustum.Calculate(
+        glm::perspective(glm::radians(60.0f), 16 / 9.0f, 1.0f, 9000.0f) * 
+        glm::lookAt(eye, eye + ahead, glm::vec3(0, 1, 0)));
+  }
+};
+
+// The pointer quadtree from examples 40/41 as it was: full tree up front, 
+// std::function walker, constant max elevation, all the instances every frame
+struct LegacyNode {
+  std::unique_ptr<LegacyNode> childs[4];
+  glm::vec3 position;
+  float     size;
+  int       level;
+
+  void Subdivide(int levels) {
+    level = levels;
+    if (levels == 0) return;
+    const glm::vec3 offsets[4] = {
+      {-size/2, 0, size/2}, {size/2, 0, size/2}, 
+      {size/2, 0, -size/2}, {-size/2, 0, -size/2}
+    };
+    for (int i = 0; i < 4; ++i) {
+      childs[i].reset(new LegacyNode());
+      childs[i]->position = position + offsets[i];
+      childs[i]->size = size/2;
+      childs[i]->Subdivide(levels - 1);
+    }
+  }
+
+  void Traverse(std::function<bool(LegacyNode* node)> walker) {
+    if (walker(this)) {
+      for (auto& child: childs) {
+        if (child) child->Traverse(walker);
+      }
+    }
+  }
+};
+
+static void BM_QuadTreeLegacy(benchmark::State& state) {
+  LegacyNode root;
+  root.position = glm::vec3(0);
+  root.size = kHalfSize;
+  root.Subdivide(state.range(0));
+
+  std::vector<QuadTree::Patch> patches;
+  Flight flight;
+  size_t n_patches = 0;
+  for (auto _: state) {
+    flight.Next();
+    patches.clear();
+    root.Traverse([&](LegacyNode* node) {
+      glm::vec3 min = node->position - node->size;
+      glm::vec3 max = node->position + node->size;
+      max.y = kMaxElevation;
+      if (!flight.frustum.TestAabb(min, max)) {
+        return false;
+      }
+      glm::vec3 p = node->position, c = flight.eye;
+      p.y = 0; c.y = 0;
+      if (glm::distance(p, c) > 8 * std::sqrt(2.0f) * node->size || node->level == 0) {
+        patches.push_back({glm::vec4(node->position, node->size), glm::vec4(0)});
+        return false;
+      }
+      return true;
+    });
+    n_patches += patches.size();
+  }
+  state.counters["patches"] = benchmark::Counter(n_patches, benchmark::Counter::kAvgIterations);
+  state.counters["uploaded"] = benchmark::Counter(n_patches, benchmark::Counter::kAvgIterations);
+}
+// A 16 level pointer tree does not fit in memory, 4^16 leaves
+BENCHMARK(BM_QuadTreeLegacy)->ArgName("levels")->Arg(8)->Unit(benchmark::kMicrosecond);
+
+static void BM_QuadTreeUpdate(benchmark::State& state) {
+  QuadTree::Params params;
+  params.levels = state.range(0);
+  params.half_size = kHalfSize;
+  QuadTree tree(params, GetHeights());
+
+  Flight flight;
+  flight.Next();
+  tree.Update(flight.eye, flight.frustum);
+
+  size_t n_patches = 0, n_cut = 0, n_uploaded = 0, n_tests = 0;
+  for (auto _: state) {
+    flight.Next();
+    tree.Update(flight.eye, flight.frustum);
+    auto& stats = tree.GetStats();
+    n_patches += stats.visible;
+    n_cut += stats.cut;
+    n_uploaded += stats.uploaded;
+    n_tests += stats.frustum_tests;
+  }
+  auto avg = benchmark::Counter::kAvgIterations;
+  state.counters["patches"] = benchmark::Counter(n_patches, avg);
+  state.counters["cut"] = benchmark::Counter(n_cut, avg);
+  state.counters["uploaded"] = benchmark::Counter(n_uploaded, avg);
+  state.counters["tests"] = benchmark::Counter(n_tests, avg);
+}
+BENCHMARK(BM_QuadTreeUpdate)
+  ->ArgName("levels")
+  ->Arg(8)
+  ->Arg(16)
+  ->Unit(benchmark::kMicrosecond);
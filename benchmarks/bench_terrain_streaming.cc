@@ -0,0 +1,144 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "terrain/chunkstreamer.h"
+#include "noise/perlin.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using Terrain::ChunkStreamer;
+using Clock = std::chrono::steady_clock;
+
+// Fly-through at 60 fps (the frames are paced like with vsync, the workers
+// get the idle time), 600 units/s over the fbm terrain of example 45.
+//
+// Counters are the main thread frame times (Update() and the vertex copies
+// standing in for the uploads): p50, p99, max and the frames over 16.7 ms.
+//
+// Sync  - everything the camera needs is generated and uploaded in the 
+//         frame, like one TerrainGenerator per chunk
+// Async - workers, upload budget
+
+static void Generate(int x0, int z0, int stride, int n, float* out) {
+  const float scale = 1 / 400.0f;
+  Noise::Perlin::FbmParams fbm;
+  fbm.octaves = 6;
+  Noise::Perlin::FillFbm(out, n, n, x0 * scale, z0 * scale, stride * scale, 
+                         fbm, 1);
+  for (int i = 0; i < n * n; ++i) {
+    out[i] = std::max(0.0f, out[i] * 0.5f + 0.3f) * 300;
+  }
+}
+
+static Color Colorize(float h, const glm::vec3& normal) {
+  return Color(h / 300, normal.y, 0.5f, 1);
+}
+
+// Copies what glBufferData would
+static void Upload(const Mesh& mesh, std::vector<char>& vram) {
+  size_t bytes = mesh.vertices.size() * sizeof(mesh.vertices[0]) + 
+                 mesh.normals.size() * sizeof(mesh.normals[0]) +
+                 mesh.colors.size() * sizeof(mesh.colors[0]) +
+                 mesh.uv.size() * sizeof(mesh.uv[0]) +
+                 mesh.indices.size() * sizeof(mesh.indices[0]);
+  vram.resize(std::max(vram.size(), bytes));
+  char* out = vram.data();
+  auto copy = [&out](const void* data, size_t size) {
+    memcpy(out, data, size);
+    out += size;
+  };
+  copy(mesh.vertices.data(), mesh.vertices.size() * sizeof(mesh.vertices[0]));
+  copy(mesh.normals.data(), mesh.normals.size() * sizeof(mesh.normals[0]));
+  copy(mesh.colors.data(), mesh.colors.size() * sizeof(mesh.colors[0]));
+  copy(mesh.uv.data(), mesh.uv.size() * sizeof(mesh.uv[0]));
+  copy(mesh.indices.data(), mesh.indices.size() * sizeof(mesh.indices[0]));
+}
+
+static void FlyThrough(benchmark::State& state, bool async) {
+  ChunkStreamer::Params params;
+  params.chunk_vertices = 65;
+  params.texel_size = 4;
+  params.lod_levels = 4;
+  params.lod_distance = 2;
+  params.view_distance = 10;
+  params.cache_size = 128;
+  params.n_workers = async ? std::max(1, (int)std::thread::hardware_concurrency() - 1) : 0;
+  params.upload_budget = async ? 65 * 65 * 2 : 1 << 30;
+
+  const int kFrames = (int)state.range(0);
+  const auto kFrame = std::chrono::microseconds(16667);
+  std::vector<char> vram;
+  std::vector<float> frame_ms;
+
+  for (auto _ : state) {
+    ChunkStreamer streamer(params, Generate, Colorize);
+    // The start area is loaded up front, same as a loading screen
+    streamer.Update(glm::vec3(0, 200, 0));
+    streamer.Flush();
+    for (int i = 0; i < 64; ++i) {
+      streamer.Update(glm::vec3(0, 200, 0));
+    }
+
+    frame_ms.clear();
+    auto next = Clock::now();
+    for (int frame = 0; frame < kFrames; ++frame) {
+      glm::vec3 eye(frame * 10.0f, 200, 0);
+      auto start = Clock::now();
+      streamer.Update(eye);
+      for (auto chunk: streamer.GetUploads()) {
+        Upload(*chunk->mesh, vram);
+      }
+      for (auto chunk: streamer.GetRestitched()) {
+        Upload(*chunk->mesh, vram);
+      }
+      auto end = Clock::now();
+      frame_ms.push_back(std::chrono::duration<float, std::milli>(end - start).count());
+
+      next += kFrame;
+      std::this_thread::sleep_until(next);
+    }
+  }
+
+  std::sort(frame_ms.begin(), frame_ms.end());
+  state.counters["p50_ms"] = frame_ms[frame_ms.size() / 2];
+  state.counters["p99_ms"] = frame_ms[frame_ms.size() * 99 / 100];
+  state.counters["max_ms"] = frame_ms.back();
+  state.counters["over_16ms"] = (double)(frame_ms.end() - 
+      std::upper_bound(frame_ms.begin(), frame_ms.end(), 16.7f));
+}
+
+static void BM_FlyThroughSync(benchmark::State& state) {
+  FlyThrough(state, false);
+}
+BENCHMARK(BM_FlyThroughSync)->Arg(600)->Iterations(1)->Unit(benchmark::kMillisecond);
+
+static void BM_FlyThroughAsync(benchmark::State& state) {
+  FlyThrough(state, true);
+}
+BENCHMARK(BM_FlyThroughAsync)->Arg(600)->Iterations(1)->Unit(benchmark::kMillisecond);
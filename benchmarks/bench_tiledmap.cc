@@ -0,0 +1,172 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "terrain/tiledmap.h"
+#include "noise/perlin.h"
+#include "common/array2d.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using Terrain::TiledMap;
+using Terrain::TiledMapWriter;
+
+// Text (.hm) vs tiled (.tmap) heightmaps, 2k and 16k texels per side.
+// Both files are generated once into /tmp, the 16k text file is ~3GB.
+//
+// time     - load the text map / open the tiled map and read the tiles 
+//            around the map center (3x3 tiles, what the camera needs)
+// rss_MiB  - process RSS growth caused by that
+
+static std::string GetPath(int size, const char* ext) {
+  return "/tmp/b3d_bench_" + std::to_string(size) + ext;
+}
+
+static void FillRow(std::vector<float>& row, int size, int y) {
+  Noise::Perlin::FbmParams params;
+  Noise::Perlin::FillFbm(row.data(), size, 1, 0, y / 500.0f, 1 / 500.0f, params);
+}
+
+static void Generate(int size) {
+  std::vector<float> row(size);
+  if (!std::ifstream(GetPath(size, ".tmap")).good()) {
+    TiledMapWriter writer(GetPath(size, ".tmap"), TiledMap::kFloat32, size, size);
+    for (int y = 0; y < size; ++y) {
+      FillRow(row, size, y);
+      writer.AddRow(row.data());
+    }
+    writer.Close();
+  }
+  if (!std::ifstream(GetPath(size, ".hm")).good()) {
+    FILE* out = fopen(GetPath(size, ".hm").c_str(), "w");
+    fprintf(out, "%d %d\n", size, size);
+    for (int y = 0; y < size; ++y) {
+      FillRow(row, size, y);
+      for (float h : row) fprintf(out, "%.7g\n", h);
+    }
+    fclose(out);
+  }
+}
+
+static size_t GetRss() {
+  long pages = 0, resident = 0;
+  FILE* f = fopen("/proc/self/statm", "r");
+  if (f) {
+    if (fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+    fclose(f);
+  }
+  return (size_t)resident * 4096;
+}
+
+static size_t GetRssGrowth(size_t before) {
+  size_t now = GetRss();
+  return now > before ? now - before : 0;
+}
+
+// The loader examples/myactions/terrainloader.h used before .tmap
+static std::shared_ptr<Array2d<float>> ReadNoiseMap(const std::string& filename) {
+  std::ifstream in(filename, std::ios::in);
+  std::string line;
+  std::getline(in, line);
+  std::stringstream dimensions(line);
+  size_t width, height;
+  dimensions >> width;
+  dimensions >> height;
+
+  std::shared_ptr<Array2d<float>> noise(new Array2d<float>(width, height));
+  for (size_t i = 0; i < noise->GetWidth() * noise->GetHeight(); ++i) {
+    std::getline(in, line);
+    std::stringstream n(line);
+    n >> noise->At(i);
+  }
+  return noise;
+}
+
+static void BM_TextLoad(benchmark::State& state) {
+  int size = (int)state.range(0);
+  Generate(size);
+  size_t rss = 0;
+  for (auto _ : state) {
+    size_t before = GetRss();
+    auto map = ReadNoiseMap(GetPath(size, ".hm"));
+    benchmark::DoNotOptimize(map->At(size / 2, size / 2));
+    rss = GetRssGrowth(before);
+  }
+  state.counters["rss_MiB"] = rss / 1048576.0;
+}
+BENCHMARK(BM_TextLoad)->Arg(2048)->Arg(16384)->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_TiledOpen(benchmark::State& state) {
+  int size = (int)state.range(0);
+  Generate(size);
+  size_t rss = 0;
+  for (auto _ : state) {
+    size_t before = GetRss();
+    auto map = TiledMap::Open(GetPath(size, ".tmap"));
+    int n = map->GetTileSize() * map->GetTileSize();
+    int cx = map->GetTilesX() / 2, cy = map->GetTilesY() / 2;
+    float sum = 0;
+    for (int ty = cy - 1; ty <= cy + 1; ++ty) {
+      for (int tx = cx - 1; tx <= cx + 1; ++tx) {
+        const float* h = map->GetHeights(tx, ty);
+        for (int i = 0; i < n; ++i) sum += h[i];
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+    rss = GetRssGrowth(before);
+  }
+  state.counters["rss_MiB"] = rss / 1048576.0;
+}
+BENCHMARK(BM_TiledOpen)->Arg(2048)->Arg(16384)->Unit(benchmark::kMicrosecond);
+
+// Full pass over the 16k map tile by tile, the RSS stays flat thanks to 
+// Evict()
+static void BM_TiledScan(benchmark::State& state) {
+  int size = (int)state.range(0);
+  Generate(size);
+  auto map = TiledMap::Open(GetPath(size, ".tmap"));
+  int n = map->GetTileSize() * map->GetTileSize();
+  size_t peak = 0;
+  for (auto _ : state) {
+    size_t before = GetRss();
+    float sum = 0;
+    for (int ty = 0; ty < map->GetTilesY(); ++ty) {
+      for (int tx = 0; tx < map->GetTilesX(); ++tx) {
+        const float* h = map->GetHeights(tx, ty);
+        for (int i = 0; i < n; ++i) sum += h[i];
+        map->Evict(tx, ty);
+      }
+      peak = std::max(peak, GetRssGrowth(before));
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.counters["peak_rss_MiB"] = peak / 1048576.0;
+}
+BENCHMARK(BM_TiledScan)->Arg(16384)->Iterations(1)->Unit(benchmark::kMillisecond);
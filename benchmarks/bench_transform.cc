@@ -0,0 +1,97 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "actor.h"
+#include "transformation.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+
+// A chain of depth transforms, the last one is the leaf
+static std::vector<std::shared_ptr<Transformation>> BuildChain(Actor& actor, 
+                                                               int depth) {
+  std::vector<std::shared_ptr<Transformation>> chain;
+  for (int i = 0; i < depth; ++i) {
+    auto t = std::make_shared<Transformation>(actor);
+    t->SetLocalPosition(glm::vec3(1, 0.5f, 0));
+    t->SetLocalEulerAngles(glm::vec3(0, 10, 5));
+    if (!chain.empty()) {
+      Transformation::SetParent(chain.back(), t);
+    }
+    chain.push_back(t);
+  }
+  return chain;
+}
+
+// Nothing moves, the matrices are up to date
+static void BM_TransformGetMatrix(benchmark::State& state) {
+  Actor actor("bench.actor");
+  auto chain = BuildChain(actor, state.range(0));
+  glm::mat4 matrix;
+  for (auto _: state) {
+    chain.back()->GetMatrix(matrix);
+    benchmark::DoNotOptimize(matrix);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TransformGetMatrix)->ArgName("depth")->Arg(1)->Arg(4)->Arg(16);
+
+// The root moves every time
+static void BM_TransformGetMatrixDirty(benchmark::State& state) {
+  Actor actor("bench.actor");
+  auto chain = BuildChain(actor, state.range(0));
+  glm::mat4 matrix;
+  float x = 0;
+  for (auto _: state) {
+    chain.front()->SetLocalPosition(glm::vec3(x += 0.01f, 0, 0));
+    chain.back()->GetMatrix(matrix);
+    benchmark::DoNotOptimize(matrix);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TransformGetMatrixDirty)->ArgName("depth")->Arg(1)->Arg(4)->Arg(16);
+
+// All the nodes of a scene graph: 64 roots, each with a chain of depth - 1
+static void BM_TransformGetMatrixHierarchy(benchmark::State& state) {
+  Actor actor("bench.actor");
+  std::vector<std::vector<std::shared_ptr<Transformation>>> chains;
+  for (int i = 0; i < 64; ++i) {
+    chains.push_back(BuildChain(actor, state.range(0)));
+  }
+  glm::mat4 matrix;
+  for (auto _: state) {
+    for (auto& chain: chains) {
+      for (auto& t: chain) {
+        t->GetMatrix(matrix);
+        benchmark::DoNotOptimize(matrix);
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 64 * state.range(0));
+}
+BENCHMARK(BM_TransformGetMatrixHierarchy)
+  ->ArgName("depth")
+  ->Arg(4)
+  ->Arg(16)
+  ->Unit(benchmark::kMicrosecond);
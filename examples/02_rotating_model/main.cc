@@ -24,6 +24,7 @@
 
 #include "b3d.h"
 #include "my/all.h"
+#include <iostream>
 
 // Rotating associated actor in all directions.
 struct MyRotator: public Action {
@@ -31,15 +32,34 @@ struct MyRotator: public Action {
   MyRotator(std::shared_ptr<Transformation> transform): Action(transform) {}
 
   void Update() override {
-    transform->Rotate(rotation_speed * GetTimer().GetTimeDelta());
+    transform->Rotate(rotation_speed * GetDeltaTime());
   }
 };
 
 int main(int argc, char* argv[]) {
   Scene scene;
 
+  // --headless renders offscreen, --frames N renders N frames and exits,
+  // --context-api egl|osmesa selects the context (osmesa - Mesa llvmpipe)
+  bool headless = false;
+  int n_frames = 0;
+  std::string context_api = "native";
+  for (int i = 1; i < argc; ++i) {
+    headless |= std::string(argv[i]) == "--headless";
+    if (std::string(argv[i]) == "--frames" && i + 1 < argc) {
+      n_frames = std::stoi(argv[++i]);
+    }
+    if (std::string(argv[i]) == "--context-api" && i + 1 < argc) {
+      context_api = argv[++i];
+    }
+  }
+  if (headless && n_frames == 0) {
+    n_frames = 600;
+  }
+
   // Step 1. Initialize application.
-  AppContext::Init(1280, 720, "Rotating 3D model [b3d]", Profile("3 3 core"));
+  AppContext::Init(1280, 720, "Rotating 3D model [b3d]", 
+                   Profile("3 3 core " + context_api), headless);
   AppContext::Instance().display.ShowCursor(false);
   int width = AppContext::Instance().display.GetWidth();
   int height = AppContext::Instance().display.GetHeight();
@@ -55,20 +75,88 @@ int main(int argc, char* argv[]) {
   camera->SetPerspective(60, 1.0f*width/height, 0.1, 150.0);
   camera->transform->SetLocalPosition(0, 3, 3);
   camera->transform->SetLocalEulerAngles(-30, 0, 0);
+
+  // Optional. --camera-path assets/paths/orbit.yaml flies the camera around,
+  // with B3D_FIXED_STEP the runs are frame to frame the same
+  for (int i = 1; i < argc; ++i) {
+    if (std::string(argv[i]) == "--camera-path" && i + 1 < argc) {
+      camera->AddAction<CameraPathController>(CameraPath::Load(argv[++i]));
+    }
+  }
   
-  // Step 4. Setup RenderTarget and FrameBuffer.
-  Cfg<RenderTarget>(scene, "rt.screen", 2000)
-    . Tags("onscreen")
-    . Clear(.4, .4, .4, 1)
-    . Done();
+  // Step 4. Setup RenderTarget and FrameBuffer. Offscreen when headless.
+  std::shared_ptr<FrameBuffer> target_fb;
+  if (headless) {
+    target_fb = Cfg<RenderTarget>(scene, "rt.offscreen", 2000)
+      . Tags("onscreen")
+      . Type(FrameBuffer::kTexture2D)
+      . Resolution(width, height)
+      . Layer(Layer::kColor, Layer::kReadWrite)
+      . Layer(Layer::kDepth, Layer::kWrite)
+      . Clear(.4, .4, .4, 1)
+      . Done();
+  } else {
+    target_fb = Cfg<RenderTarget>(scene, "rt.screen", 2000)
+      . Tags("onscreen")
+      . Clear(.4, .4, .4, 1)
+      . Done();
+  }
+
+  // Optional. --capture video.y4m or --capture "frame%05d.ppm" 
+  // streams the frames to the disk without stalling the render.
+  std::unique_ptr<FrameCapture> capture;
+  for (int i = 1; i < argc; ++i) {
+    if (std::string(argv[i]) == "--capture" && i + 1 < argc) {
+      FrameCapture::Params params;
+      params.writer.filename = argv[++i];
+      if (params.writer.filename.find("%") != std::string::npos) {
+        params.writer.format = Image::FrameWriter::kPpmSequence;
+      }
+      capture.reset(new FrameCapture(params, width, height));
+    }
+  }
+
+  // Optional. With B3D_PROFILING, the frame profiler on the screen and 
+  // --trace trace.json writes the Chrome trace of the first 600 frames
+  std::string trace;
+  for (int i = 1; i < argc; ++i) {
+    if (std::string(argv[i]) == "--trace" && i + 1 < argc) {
+      trace = argv[++i];
+      Profiler::Instance().StartTrace();
+    }
+  }
+#ifdef B3D_PROFILING
+  for (int line = 0; line < 5 && !headless; ++line) {
+    Cfg<Actor>(scene, "actor.profiler." + std::to_string(line))
+      . Action<ProfilerOverlay>(line)
+      . Done();
+  }
+#endif
 
   // Step 5. Main loop. Press ESC to exit.
-  do {
-    AppContext::BeginFrame();
-    scene.Update();
-    scene.Draw();
-    AppContext::EndFrame();
-  } while (AppContext::Running());
+  auto loop = FrameLoop::Run(scene, n_frames, [&](int frame) {
+    if (capture) {
+      capture->Capture(*target_fb);
+    }
+  });
+  std::cerr << "Rendered " << loop.frames << " frames in " << loop.seconds 
+            << " s, " << loop.fps << " fps, frame " << loop.ms_min << "/" 
+            << loop.ms_avg << "/" << loop.ms_max << " ms (min/avg/max)" 
+            << std::endl;
+
+  if (capture) {
+    capture->Flush();
+    auto stats = capture->GetStats();
+    std::cerr << "Captured " << stats.captured << " frames, written " 
+              << stats.writer.written << ", dropped " << stats.writer.dropped 
+              << ", stalls " << stats.stalls << ", skipped " << stats.skipped 
+              << std::endl;
+    capture.reset();
+  }
+
+  if (!trace.empty()) {
+    Profiler::Instance().WriteTrace(trace);
+  }
 
   // Step 6. Cleanup and close the app.
   AppContext::Close();
@@ -45,7 +45,7 @@ struct MoveCameraAround : public Action {
   }
 
   void Update() override {
-    angle += rotate_speed * GetTimer().GetTimeDelta();
+    angle += rotate_speed * GetDeltaTime();
     auto a = glm::radians(angle);
     glm::vec3 pos(radius.x * cos(a), elevation, radius.y * sin(a)); 
     transform->SetLocalPosition(pos);
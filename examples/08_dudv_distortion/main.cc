@@ -41,7 +41,7 @@ struct SetPostProcessingUniform: public Action {
   }
   
   void Update() override {
-    dudv_offset += dudv_speed * GetTimer().GetTimeDelta();
+    dudv_offset += dudv_speed * GetDeltaTime();
     if (dudv_offset > 1) {
       dudv_offset = 0;
     }
@@ -43,7 +43,7 @@ struct MirrorHandler: public Action {
 
   void Update() override {
     // Lemniscate of Gerono
-    angle += speed * GetTimer().GetTimeDelta();
+    angle += speed * GetDeltaTime();
     auto p = transform->GetLocalPosition();
     float a = glm::radians(angle);
     float x = radius*cos(a);
@@ -50,7 +50,7 @@ struct SetWaterSurfaceUniform: public Action {
     : Action(transform) {}
 
   void Update() override {
-    dudv_offset += dudv_speed * GetTimer().GetTimeDelta();
+    dudv_offset += dudv_speed * GetDeltaTime();
     if (dudv_offset > 1) {
       dudv_offset = 0;
     }
@@ -25,62 +25,6 @@
 #include "b3d.h"
 #include "my/all.h"
 
-// Sets various of uniforms for shadow receivers
-// The most important is bias * proj * view matrix of the shadow map camera
-// in order to calculate uv coordinates for sampling the shadowmap.
-struct ShadowUniform : public Action {
-  using CamPtr = std::shared_ptr<Camera>;
-  using LhtPtr = std::shared_ptr<Light>;
-
-  LhtPtr light;
-  CamPtr shadowmap_camera;
-
-  ShadowUniform(std::shared_ptr<Transformation> t, LhtPtr l, CamPtr c) 
-    : Action(t), light(l), shadowmap_camera(c) {}
-
-  void PreDraw() override {
-    glm::mat4 view;
-    glm::mat4 proj;
-    glm::mat4 bias (
-      0.5, 0.0, 0.0, 0.0,
-      0.0, 0.5, 0.0, 0.0,
-      0.0, 0.0, 0.5, 0.0,
-      0.5, 0.5, 0.5, 1.0
-    );
-
-    shadowmap_camera->GetViewMatrix(view);
-    shadowmap_camera->GetProjectionMatrix(proj);
-
-    if (auto mtrl = transform->GetActor().GetComponent<Material>()) {
-      mtrl->SetUniform("depth_bias_pvm", bias * proj * view);
-      mtrl->SetUniform("light.direction", light->GetDirection());
-      mtrl->SetUniform("light.color", light->GetColor());
-    }
-  }
-};
-
-// Tracking the directional light source and updating shadowcamera position
-// based on it.
-struct ShadowMapCameraController : public Action {
-  using LhtPtr = std::shared_ptr<Light>;
-
-  LhtPtr sun;
-  float  distance = 10.0f; // How far the sun is
-
-  ShadowMapCameraController(std::shared_ptr<Transformation> t, LhtPtr l, float d = 10.0f)
-    : Action(t), sun(l), distance(d) {}
-
-  void Update() override {
-    auto pos = -distance * sun->GetDirection();
-    auto rot = sun->transform->GetLocalEulerAngles();
-    rot.y = rot.y - 180;
-    rot.x = -rot.x;
-
-    transform->SetLocalPosition(pos);
-    transform->SetLocalEulerAngles(rot);
-  }
-};
-
 // Rotator for our sun. Does not allow it to go above the horizont.
 struct SpecialRotator : public Rotator {
   SpecialRotator(std::shared_ptr<Transformation> t, const glm::vec3& rot_speed)
@@ -101,83 +45,120 @@ int main(int argc, char* argv[]) {
   using T = std::vector<std::string>;
   using glm::vec3;
 
+  // --rotate-sun moves the light every frame, the cached cascades are 
+  // redrawn every frame then. --show-cascades tints the cascades.
+  bool rotate_sun = false;
+  bool show_cascades = false;
+  for (int i = 1; i < argc; ++i) {
+    rotate_sun |= std::string(argv[i]) == "--rotate-sun";
+    show_cascades |= std::string(argv[i]) == "--show-cascades";
+  }
+
   // Initialize application.
   AppContext::Init(1280, 720, "Shadow mapping [b3d]", Profile("3 3 core"));
   AppContext::Instance().display.ShowCursor(false);
   int width = AppContext::Instance().display.GetWidth();
   int height = AppContext::Instance().display.GetHeight();
   
-  // Setup main and shadowmap rendertargets
+  // Setup main rendertarget
   Cfg<RenderTarget>(scene, "rt.screen", 2000)
     . Tags("onscreen")
     . Clear(.4, .4, .4, 1)
     . Done();
     
-  auto shadow_tex = Cfg<RenderTarget>(scene, "rt.shadowmap", 0) 
-    . Camera("camera.shadowmap")
-    . Tags("shadow-caster")
-    . Type(FrameBuffer::kTexture2D)
-    . Resolution(width, height)
-    . Layer(Layer::kDepth, Layer::kReadWrite)
-    . Done()
-    ->GetLayerAsTexture(0, Layer::kDepth);
-  
   // Compose the scene. 
-  Cfg<Camera>(scene, "camera.main")
+  auto camera = Cfg<Camera>(scene, "camera.main")
     . Perspective(60, (float)width/height, .1, 500)
     . Position(-10, 6, 0)
     . EulerAngles(-30, -90, 0)
     . Action<FlyingCameraController>(5)
     . Done();
 
-  auto sun = Cfg<Light>(scene, "light.sun", Light::kDirectional)
+  Cfg<Light> sun_cfg(scene, "light.sun", Light::kDirectional);
+  sun_cfg
     . EulerAngles(40, -225, 0)
-    . Color(1, 1, 1, 1) 
-    . Action<SpecialRotator>(vec3(5, 2, 0))
-    . Done();
-
-  int w = 5, h = 5, d = 10; // the shadowcube, bigger the cube => lower the quality
-  auto cam_shadowmap = Cfg<Camera>(scene, "camera.shadowmap")
-    . Ortho(-w, h, w, -h, -d, d*2)
-    . Action<ShadowMapCameraController>(sun, 10)
-    . Done();
-
-  Cfg<Actor>(scene, "actor.floor")
-    . Model("assets/models/plane.dsm", "assets/materials/shadow_caster_receiver_dirlight.mat")
-    . Texture(0, shadow_tex)
-    . Action<ShadowUniform>(sun, cam_shadowmap)
-    . Done();
+    . Color(1, 1, 1, 1);
+  if (rotate_sun) {
+    sun_cfg.Action<SpecialRotator>(vec3(5, 2, 0));
+  }
+  auto sun = sun_cfg.Done();
+
+  // Cascaded shadow maps, a depth rendertarget and an ortho camera per 
+  // cascade. The far cascades are redrawn every 4th frame.
+  ShadowCascades::Params csm_params;
+  csm_params.n_cascades   = 4;
+  csm_params.resolution   = 1024;
+  csm_params.max_distance = 150;
+  csm_params.z_extension  = 50;
+  csm_params.cache_from   = 2;
+  csm_params.cache_frames = 4;
+  auto cascades = std::make_shared<ShadowCascades>(csm_params);
+
+  std::vector<std::shared_ptr<Camera>>       csm_cameras;
+  std::vector<std::shared_ptr<RenderTarget>> csm_targets;
+  std::vector<std::shared_ptr<Texture>>      shadow_maps;
+  for (int i = 0; i < csm_params.n_cascades; ++i) {
+    std::string name = "csm" + std::to_string(i);
+    Cfg<RenderTarget> rt(scene, "rt." + name, i);
+    shadow_maps.push_back(rt
+      . Camera("camera." + name)
+      . Tags("shadow-caster")
+      . Type(FrameBuffer::kTexture2D)
+      . Resolution(csm_params.resolution, csm_params.resolution)
+      . Layer(Layer::kDepth, Layer::kReadWrite)
+      . FrustumCulling()
+      . Done()
+      ->GetLayerAsTexture(0, Layer::kDepth));
+    csm_targets.push_back(rt.GetClient());
+    csm_cameras.push_back(Cfg<Camera>(scene, "camera." + name).Done());
+  }
 
-  Cfg<Actor>(scene, "actor.1")
-    . Model("assets/models/torus.dsm", "assets/materials/shadow_caster_receiver_dirlight.mat")
-    . Texture(0, shadow_tex)
-    . Position(0, 1.0, 0)
-    . Scale(.8, .8, .8)
-    . Action<Rotator>(vec3(30, 60, 30))
-    . Action<ShadowUniform>(sun, cam_shadowmap)
-    . Done();
-  
-  Cfg<Actor>(scene, "actor.2")
-    . Model("assets/models/unity_cube.dsm", "assets/materials/shadow_caster_receiver_dirlight.mat")
-    . Texture(0, shadow_tex)
-    . Position(-2, 0.5, -2)
-    . Action<Rotator>(vec3(0, -30, 0))
-    . Action<ShadowUniform>(sun, cam_shadowmap)
+  Cfg<Actor>(scene, "actor.csm")
+    . Action<CascadedShadows>(cascades, camera, sun, csm_cameras, csm_targets)
     . Done();
 
-  Cfg<Actor>(scene, "actor.3")
-    . Model("assets/models/knight.dsm", "assets/materials/shadow_caster_receiver_dirlight.mat")
-    . Texture(0, shadow_tex)
-    . Position(2, 0, 2)
-    . Action<Rotator>(vec3(0, 45, 0))
-    . Action<ShadowUniform>(sun, cam_shadowmap)
-    . Done();
+  // Shadow casters and receivers
+  auto AddActor = [&](const std::string& name, const std::string& model, 
+                      vec3 position, vec3 scale, vec3 rotation_speed) {
+    Cfg<Actor> actor(scene, name);
+    actor
+      . Model(model, "assets/materials/shadow_caster_receiver_dirlight_csm.mat")
+      . Position(position)
+      . Scale(scale)
+      . Action<CascadedShadowUniform>(cascades, sun, show_cascades);
+    for (size_t i = 0; i < shadow_maps.size(); ++i) {
+      actor.Texture(i, shadow_maps[i]);
+    }
+    if (rotation_speed != vec3(0)) {
+      actor.Action<Rotator>(rotation_speed);
+    }
+    return actor.Done();
+  };
+
+  AddActor("actor.floor", "assets/models/plane.dsm", 
+           vec3(0), vec3(20, 1, 20), vec3(0));
+  AddActor("actor.1", "assets/models/torus.dsm", 
+           vec3(0, 1, 0), vec3(.8), vec3(30, 60, 30));
+  AddActor("actor.2", "assets/models/unity_cube.dsm", 
+           vec3(-2, .5, -2), vec3(1), vec3(0, -30, 0));
+  AddActor("actor.3", "assets/models/knight.dsm", 
+           vec3(2, 0, 2), vec3(1), vec3(0, 45, 0));
+
+  // Columns all over the floor, most of them are out of the near cascades
+  for (int x = -4; x <= 4; ++x) {
+    for (int z = -4; z <= 4; ++z) {
+      if (x == 0 && z == 0) continue;
+      AddActor("actor.column." + std::to_string(x) + "." + std::to_string(z),
+               "assets/models/unity_cube.dsm", 
+               vec3(x * 20, 3, z * 20), vec3(1, 6, 1), vec3(0));
+    }
+  }
   
-  // Overlay display for the shadowmap and FPS
+  // Overlay display for the nearest cascade and FPS
   Cfg<Actor>(scene, "actor.display.shadowmap")
     . Model("assets/models/screen.dsm", "assets/materials/overlay_texture_border.mat")
     . Tags(0, T{"onscreen"})
-    . Texture(0, shadow_tex)
+    . Texture(0, shadow_maps[0])
     . Scale   (.25, .25, 0)
     . Position(.75, .75, 0)
     . Done();
@@ -186,6 +167,11 @@ int main(int argc, char* argv[]) {
     . Action<FpsMeter>()
     . Done();
 
+  // Shadow pass cost
+  Cfg<Actor>(scene, "actor.csm.stats")
+    . Action<RenderTargetStatsMeter>("Shadow cascades", csm_targets)
+    . Done();
+
   // Main loop. Press ESC to exit.
   do {
     AppContext::BeginFrame();
@@ -37,7 +37,7 @@ struct LemniscateGerono : public Action {
     : Action(t), camera(c) {}
 
   void Update() override {
-    angle += speed * GetTimer().GetTimeDelta();
+    angle += speed * GetDeltaTime();
     float a = glm::radians(angle);
     float z = radius*cos(a);
     float x = radius*sin(a) * cos(a);
@@ -83,7 +83,7 @@ struct Shading : public Action {
     if (color_mix_factor < 0) color_mix_speed = -color_mix_speed;
     if (color_mix_factor > 1) color_mix_speed = -color_mix_speed;
 
-    color_mix_factor += color_mix_speed * GetTimer().GetTimeDelta();
+    color_mix_factor += color_mix_speed * GetDeltaTime();
     light->SetColor(glm::mix(color1, color2, color_mix_factor));
   }
 
@@ -108,6 +108,9 @@ struct Shading : public Action {
 int main(int argc, char* argv[]) {
   Scene scene;
 
+  // --layered renders the shadow cubemap in one pass with gl_Layer
+  bool layered = argc > 1 && std::string(argv[1]) == "--layered";
+
   // Initialize application.
   AppContext::Init(1280, 720, "Omni shadow map [b3d]", Profile("3 3 core"));
   AppContext::Instance().display.ShowCursor(false);
@@ -124,10 +127,13 @@ int main(int argc, char* argv[]) {
   // All actors material passes that posses tag 'shadow-caster' will 
   // be selected for rendering to this rendertarget.
   int w = 800, h = 800;
-  auto shadow_map = Cfg<RenderTarget>(scene, "rt.shadowmap", 0)
+  Cfg<RenderTarget> shadow_rt(scene, "rt.shadowmap", 0);
+  auto shadow_map = shadow_rt
     . Camera("camera.cubemap")
-    . Tags("shadow-caster")
+    . Tags(layered ? "shadow-caster-layered" : "shadow-caster")
     . Type(FrameBuffer::kCubeMap)
+    . CubemapMode(layered ? RenderTarget::kCubemapLayered 
+                          : RenderTarget::kCubemapPerFace)
     . Resolution(w, h)
     . Layer(Layer::kDepth, Layer::kReadWrite)
     . Done()
@@ -261,6 +267,13 @@ int main(int argc, char* argv[]) {
   Cfg<Actor>(scene, "actor.fps.meter")
     . Action<FpsMeter>()
     . Done();
+
+  // Shadow cubemap cost
+  Cfg<Actor>(scene, "actor.cubemap.stats")
+    . Action<RenderTargetStatsMeter>(
+        layered ? "Shadow cubemap, layered" : "Shadow cubemap, per face",
+        std::vector<std::shared_ptr<RenderTarget>>{shadow_rt.GetClient()})
+    . Done();
   
   // Main loop. Press ESC to exit.
   do {
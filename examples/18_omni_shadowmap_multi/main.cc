@@ -38,7 +38,7 @@ struct LemniscateGerono : public Action {
     : Action(t), camera(c), angle(a)  {}
 
   void Update() override {
-    angle += speed * GetTimer().GetTimeDelta();
+    angle += speed * GetDeltaTime();
     float a = glm::radians(angle);
     float z = radius*cos(a);
     float x = radius*sin(a) * cos(a);
@@ -65,6 +65,7 @@ struct LightInfo {
   std::shared_ptr<Light>   light_src;  // light source
   std::shared_ptr<Camera>  shadow_cam; // camera used for rendering to shadowmap
   std::shared_ptr<Texture> shadow_map; // cube depth map
+  std::shared_ptr<RenderTarget> shadow_rt;
   
   // 'Disco'
   Color color1;
@@ -97,7 +98,7 @@ struct Shading : public Action {
 
   void Update() override {
     for (auto& l: lights) {
-      l.Update(GetTimer().GetTimeDelta());
+      l.Update(GetDeltaTime());
     }
   }
 
@@ -142,17 +143,21 @@ struct Shading : public Action {
   }
 };
 
-LightInfo CreatePointLight(Scene& scene, float startpos) {
+LightInfo CreatePointLight(Scene& scene, float startpos, 
+                           RenderTarget::CubemapMode mode) {
   static int counter = 0;
   counter += 1;
   std::string name = "shadowmap" + std::to_string(counter);
   int w = 800;
 
-  // Rendertarget
-  auto shadow_map = Cfg<RenderTarget>(scene, "rt." + name, counter+1)
+  // Rendertarget, the layered one takes the passes with the geometry shader
+  bool layered = mode == RenderTarget::kCubemapLayered;
+  Cfg<RenderTarget> shadow_rt(scene, "rt." + name, counter+1);
+  auto shadow_map = shadow_rt
     . Camera("camera." + name)
-    . Tags("shadow-caster")
+    . Tags(layered ? "shadow-caster-layered" : "shadow-caster")
     . Type(FrameBuffer::kCubeMap)
+    . CubemapMode(mode)
     . Resolution(w, w)
     . Layer(Layer::kDepth, Layer::kReadWrite)
     . Done()
@@ -178,7 +183,7 @@ LightInfo CreatePointLight(Scene& scene, float startpos) {
     . Parent(lamp)
     . Done();
   
-  return LightInfo {
+  LightInfo info {
     lamp, 
     shadow_cam, 
     shadow_map, 
@@ -186,13 +191,22 @@ LightInfo CreatePointLight(Scene& scene, float startpos) {
     Rgb(255, 128, 128), 
     .05
   };
+  info.shadow_rt = shadow_rt.GetClient();
+  return info;
 }
 
 int main(int argc, char* argv[]) {
   Scene scene;
 
+  // --layered renders each shadow cubemap in one pass with gl_Layer
+  auto cubemap_mode = RenderTarget::kCubemapPerFace;
+  if (argc > 1 && std::string(argv[1]) == "--layered") {
+    cubemap_mode = RenderTarget::kCubemapLayered;
+  }
+
   // Initialize application.
   AppContext::Init(1280, 720, "Multiple light sources [b3d]", Profile("3 3 core"));
+  ProgramCache::Instance().SetDirectory("shader_cache");
   AppContext::Instance().display.ShowCursor(false);
   int width = AppContext::Instance().display.GetWidth();
   int height = AppContext::Instance().display.GetHeight();
@@ -213,9 +227,9 @@ int main(int argc, char* argv[]) {
   
 
   std::vector<LightInfo> all_lights = {
-    CreatePointLight(scene, 0),
-    CreatePointLight(scene, 100),
-    CreatePointLight(scene, 200)
+    CreatePointLight(scene, 0, cubemap_mode),
+    CreatePointLight(scene, 100, cubemap_mode),
+    CreatePointLight(scene, 200, cubemap_mode)
   };
 
   // Create room, place 6 pillars, a postament in the centre and 
@@ -311,6 +325,21 @@ int main(int argc, char* argv[]) {
     . Action<FpsMeter>()
     . Done();
 
+  // Shadow cubemaps cost
+  std::vector<std::shared_ptr<RenderTarget>> shadow_rts;
+  for (auto& l: all_lights) {
+    shadow_rts.push_back(l.shadow_rt);
+  }
+  Cfg<Actor>(scene, "actor.cubemap.stats")
+    . Action<RenderTargetStatsMeter>(
+        cubemap_mode == RenderTarget::kCubemapLayered ? 
+          "Shadow cubemaps, layered" : "Shadow cubemaps, per face",
+        shadow_rts)
+    . Done();
+
+  ResourceCache::Instance().PrintStats(std::cerr);
+  ProgramCache::Instance().PrintStats(std::cerr);
+
   // Main loop. Press ESC to exit.
   do {
     AppContext::BeginFrame();
@@ -40,8 +40,8 @@ struct TessShader : public Action {
   {}
 
   void Update() override {
-    tess_level_inner += dt_inner * GetTimer().GetTimeDelta();
-    tess_level_outer += dt_outer * GetTimer().GetTimeDelta();
+    tess_level_inner += dt_inner * GetDeltaTime();
+    tess_level_outer += dt_outer * GetDeltaTime();
 
     if (tess_level_inner > 10) {
       dt_inner = -abs(dt_inner);
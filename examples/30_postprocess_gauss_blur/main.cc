@@ -24,25 +24,7 @@
 
 #include "b3d.h"
 #include "my/all.h"
-
-struct BlurUniform: public Action {
-  int       width;
-  int       height;
-  glm::vec2 direction;
-
-  BlurUniform(std::shared_ptr<Transformation> transform, 
-              int a_width, int a_height, glm::vec2 a_direction)
-    :  Action(transform), width(a_width), height(a_height), 
-       direction(a_direction) {}
-
-  void PreDraw() override {
-    if (auto m = transform->GetActor().GetComponent<Material>()) {
-      m->SetUniform("target_width",  width); 
-      m->SetUniform("target_height", height); 
-      m->SetUniform("direction",     direction); 
-    }
-  }
-};
+#include <iostream>
 
 struct BypassUniform: public Action {
   Color     tint;
@@ -99,31 +81,36 @@ int main(int argc, char* argv[]) {
       . Done()
       ->GetLayerAsTexture(0, Layer::kColor);
 
-  // Downsample then blur, then downsample and blur again
-  // 5 passes in total, 11x11 gauss kernel.
-  int w = width / 8, h = height / 8;
+  // Downsample to the half resolution chain, blur every level with the
+  // linear sampled gauss kernel and combine them back, see BlurChain. 
+  BlurChain::Params blur_params;
+  for (int i = 1; i < argc; ++i) {
+    if (std::string(argv[i]) == "--radius" && i + 1 < argc) {
+      blur_params.radius = std::stoi(argv[++i]);
+    }
+    if (std::string(argv[i]) == "--levels" && i + 1 < argc) {
+      blur_params.levels = std::stoi(argv[++i]);
+    }
+  }
+  BlurChain blur(blur_params, width, height);
+  std::cerr << "Blur: " << blur.GetStages().size() << " stages, " 
+            << blur.GetShadedPixels() << " pixels, " 
+            << blur.GetTextureFetches() << " texture fetches per frame" 
+            << std::endl;
+
   PostprocessPipeline pp_blur(scene, "assets/materials/postprocess");
   pp_blur.Input(10, PostprocessPipeline::TexLs{scene_tex});
-  pp_blur
-    . Stage("downscale",   w,  h,  "bypass.mat");
-  pp_blur
-    . Stage("hblur",       w,  h,  "gauss_blur.mat")
-    . Action<BlurUniform> (w,  h,  vec2(1, 0));
-  pp_blur
-    . Stage("vblur",       w,  h,  "gauss_blur.mat")
-    . Action<BlurUniform> (w,  h,  vec2(0, 1));
-  w /= 2; h /= 2;
-  pp_blur
-    . Stage("hblur2",      w,  h,  "gauss_blur.mat")
-    . Action<BlurUniform> (w,  h,  vec2(1, 0));
-  pp_blur
-    . Stage("vblur2",      w,  h,  "gauss_blur.mat")
-    . Action<BlurUniform> (w,  h,  vec2(0, 1));
+  AddBlurChain(pp_blur, blur, "blur.");
+  // Shown on the screen, not recycled: the first downsample and the 
+  // coarsest level blurred
+  int coarsest = blur_params.levels + 1;
+  pp_blur.Output(0);
+  pp_blur.Output(coarsest);
   pp_blur.Done();
 
   // Get different stages outputs in order to show them on the screen
   auto downs_tex = pp_blur.Tex(0);
-  auto pass1_tex = pp_blur.Tex(2);
+  auto pass1_tex = pp_blur.Tex(coarsest);
   auto final_tex = pp_blur.Tex(); 
   
   /////////////////////////////////////////////////////////////////////////////
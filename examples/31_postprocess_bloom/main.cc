@@ -25,25 +25,6 @@
 #include "b3d.h"
 #include "my/all.h"
 
-struct BlurUniform: public Action {
-  int       width;
-  int       height;
-  glm::vec2 direction;
-
-  BlurUniform(std::shared_ptr<Transformation> transform, 
-              int a_width, int a_height, glm::vec2 a_direction)
-    :  Action(transform), width(a_width), height(a_height), 
-       direction(a_direction) {}
-
-  void PreDraw() override {
-    if (auto m = transform->GetActor().GetComponent<Material>()) {
-      m->SetUniform("target_width",  width); 
-      m->SetUniform("target_height", height); 
-      m->SetUniform("direction",     direction); 
-    }
-  }
-};
-
 struct BypassUniform: public Action {
   Color     tint;
   bool      uv_flip_vert;
@@ -79,6 +60,7 @@ int main(int argc, char* argv[]) {
   // Step 1. Initialize application.
   /////////////////////////////////////////////////////////////////////////////
   AppContext::Init(1280, 720, "Bloom [b3d]", Profile("3 3 core"));
+  ProgramCache::Instance().SetDirectory("shader_cache");
   AppContext::Instance().display.ShowCursor(false);
   int width = AppContext::Instance().display.GetWidth();
   int height = AppContext::Instance().display.GetHeight();
@@ -101,39 +83,45 @@ int main(int argc, char* argv[]) {
       . Done()
       ->GetLayerAsTexture(0, Layer::kColor);
 
-  // Downsample and highlight then blur, then downsample and blur again.
-  // 5 passes in total, 11x11 gauss kernel.
+  // Downsample with the highlight threshold to the half resolution chain,
+  // blur every level and combine them back, see BlurChain. 
   // Then take scene texture and combine with blur-highlighted. 
-  int w = width / 8, h = height / 8;
-  PostprocessPipeline pp_blur(scene, "assets/materials/postprocess");
-  pp_blur.Input(10, TexLs{scene_tex});
-  pp_blur
-    . Stage("highlight",   w,  h,  "bloom_highlight.mat");
-  pp_blur
-    . Stage("hblur",       w,  h,  "gauss_blur.mat")
-    . Action<BlurUniform> (w,  h,  vec2(1, 0));
-  pp_blur
-    . Stage("vblur",       w,  h,  "gauss_blur.mat")
-    . Action<BlurUniform> (w,  h,  vec2(0, 1));
-  w /= 2; h /= 2;
-  pp_blur
-    . Stage("hblur2",      w,  h,  "gauss_blur.mat")
-    . Action<BlurUniform> (w,  h,  vec2(1, 0));
-  pp_blur
-    . Stage("vblur2",      w,  h,  "gauss_blur.mat")
-    . Action<BlurUniform> (w,  h,  vec2(0, 1));
-  pp_blur.Done();
+  // The dead blur stages textures are reused, see RenderGraph.
+  BlurChain::Params blur_params;
+  blur_params.threshold = 0.6;
+  blur_params.scatter = 0.7;
+  for (int i = 1; i < argc; ++i) {
+    if (std::string(argv[i]) == "--radius" && i + 1 < argc) {
+      blur_params.radius = std::stoi(argv[++i]);
+    }
+    if (std::string(argv[i]) == "--levels" && i + 1 < argc) {
+      blur_params.levels = std::stoi(argv[++i]);
+    }
+  }
+  BlurChain blur(blur_params, width, height);
+  std::cerr << "Bloom blur: " << blur.GetStages().size() << " stages, " 
+            << blur.GetShadedPixels() << " pixels, " 
+            << blur.GetTextureFetches() << " texture fetches per frame" 
+            << std::endl;
 
-  // Bloom combine textures
-  w = width, h = height;
   PostprocessPipeline pp_bloom(scene, "assets/materials/postprocess");
-  pp_bloom.Input(20, TexLs{scene_tex, pp_blur.Tex()}); 
-  pp_bloom.Stage("bloom",  w,  h,  "bloom_combine.mat");
+  pp_bloom.Input(10, TexLs{scene_tex});
+  auto blurred = AddBlurChain(pp_bloom, blur, "bloom.", "input.0");
+  int blurred_stage = pp_bloom.GetStageNumber() - 1;
+
+  // Bloom combine textures
+  pp_bloom
+    . Stage("bloom",  width,  height,  "bloom_combine.mat", 
+            PostprocessPipeline::TagLs{"input.0", blurred});
+
+  // Shown on the screen
+  pp_bloom.Output(0);
+  pp_bloom.Output(blurred_stage);
   pp_bloom.Done();
 
   // Get different stages outputs in order to show them on the screen
-  auto hightilght_tex = pp_blur.Tex(0);
-  auto blur_tex = pp_blur.Tex();
+  auto hightilght_tex = pp_bloom.Tex(0);
+  auto blur_tex = pp_bloom.Tex(blurred_stage);
   auto final_tex = pp_bloom.Tex(); 
   
   /////////////////////////////////////////////////////////////////////////////
@@ -208,6 +196,10 @@ int main(int argc, char* argv[]) {
     . Tags(0, T{"pp-final"})
     . Done();
   
+  ResourceCache::Instance().PrintStats(std::cerr);
+  ProgramCache::Instance().PrintStats(std::cerr);
+  pp_bloom.Graph().PrintStats(std::cerr);
+
   /////////////////////////////////////////////////////////////////////////////
   // Step 5. Main loop. Press ESC to exit.
   /////////////////////////////////////////////////////////////////////////////
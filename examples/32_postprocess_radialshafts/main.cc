@@ -24,6 +24,7 @@
 
 #include "b3d.h"
 #include "my/all.h"
+#include <iostream>
   
 struct BlurUniform: public Action {
   int       width;
@@ -64,40 +65,31 @@ void InitPostProcessingPipeline(Scene& scene) {
       ->GetLayerAsTexture(0, Layer::kColor);
   
   // hightlight/downscale -> radial blur -> gauss blur -> combine
+  // The dead stages textures are reused, see RenderGraph.
   int w = width / 8, h = height / 8;
-  PostprocessPipeline pp_highlight(scene, "assets/materials/postprocess");
-  pp_highlight.Input(10, TexLs{scene_tex});
-  pp_highlight.Stage("highlight",   w,  h,  "bloom_highlight.mat");
-  pp_highlight.Done();
-
-  PostprocessPipeline pp_radblur(scene, "assets/materials/postprocess");
-  pp_radblur.Input(20, TexLs{pp_highlight.Tex()});
-  pp_radblur.Stage("radialblur", w, h, "radial_blur.mat");
-  pp_radblur.Done();
-  
-  PostprocessPipeline pp_gaussblur(scene, "assets/materials/postprocess");
-  pp_gaussblur.Input(25, TexLs{pp_radblur.Tex()});
-  pp_gaussblur
+  PostprocessPipeline pp_shafts(scene, "assets/materials/postprocess");
+  pp_shafts.Input(10, TexLs{scene_tex});
+  pp_shafts.Stage("highlight",   w,  h,  "bloom_highlight.mat");
+  pp_shafts.Stage("radialblur",  w,  h,  "radial_blur.mat");
+  pp_shafts
     . Stage("hblur",       w,  h,  "gauss_blur.mat")
     . Action<BlurUniform> (w,  h,  vec2(1, 0));
-  pp_gaussblur
+  pp_shafts
     . Stage("vblur",       w,  h,  "gauss_blur.mat")
     . Action<BlurUniform> (w,  h,  vec2(0, 1));
   w /= 2; h /= 2;
-  pp_gaussblur
+  pp_shafts
     . Stage("hblur2",      w,  h,  "gauss_blur.mat")
     . Action<BlurUniform> (w,  h,  vec2(1, 0));
-  pp_gaussblur
+  pp_shafts
     . Stage("vblur2",      w,  h,  "gauss_blur.mat")
     . Action<BlurUniform> (w,  h,  vec2(0, 1));
-  pp_gaussblur.Done();
-  
-  PostprocessPipeline pp_final(scene, "assets/materials/postprocess");
-  pp_final.Input(30, TexLs{scene_tex, pp_gaussblur.Tex()});
-  pp_final.Stage("combine",   width,  height,  "bloom_combine.mat");
-  pp_final.Done();
+  pp_shafts.Stage("combine",   width,  height,  "bloom_combine.mat",
+                  PostprocessPipeline::TagLs{"input.0", "vblur2"});
+  pp_shafts.Done();
+  pp_shafts.Graph().PrintStats(std::cerr);
 
-  auto final_tex = pp_final.Tex(); 
+  auto final_tex = pp_shafts.Tex(); 
 
   Cfg<Actor>(scene, "actor.display.final")
     . Model("assets/models/screen.dsm", "assets/materials/overlay_texture.mat")
@@ -55,115 +55,28 @@ struct Tint : public Action {
   }
 };
 
-// Quick and dirty quadtree
-// nw -x+z
-// ne +x+z
-// se +x-z
-// nw -x-z
-struct QuadTreeNode {
-  QuadTreeNode* parent;
-  QuadTreeNode* childs[4];
-
-  glm::vec3     position;
-  float         size;
-
-  size_t        level;
-
-  enum Dir {
-    kNw = 0, kNe, kSe, kSw
-  };
-
-  ~QuadTreeNode() {
-    if (childs[0]) delete childs[0];
-    if (childs[1]) delete childs[1];
-    if (childs[2]) delete childs[2];
-    if (childs[3]) delete childs[3];
-  }
-
-  bool IsLeaf() const {
-    return !childs[0] && !childs[1] && !childs[2] && !childs[3];
-  }
-
-  // Offset for child position
-  glm::vec3 offset(Dir dir) const {
-    switch(dir) {
-      case kNw: return glm::vec3(-size/2,  0,  size/2);
-      case kNe: return glm::vec3( size/2,  0,  size/2);
-      case kSe: return glm::vec3( size/2,  0, -size/2);
-      case kSw: return glm::vec3(-size/2,  0, -size/2);
-      default: ABORT_F("Invalid child direction");
-    }
-  }
-
-  void Subdivide(size_t level) {
-    this->level = level;
-    if (level == 0) return;
-    for (size_t i = 0; i < 4; ++i) {
-      childs[i] = new QuadTreeNode();
-      childs[i]->position = position + offset((Dir)i); 
-      childs[i]->size = size/2;
-      childs[i]->Subdivide(level - 1);
-    }
-  }
-
-  // Total number of elements, including root
-  // 4^0 + 4^1 + 4^2 + ... + 4^N, where N - number of subdivisions
-  size_t Count() {
-    size_t count = 0;
-    for(size_t i = 0; i < 4; ++i) {
-      if (childs[i]) count += childs[i]->Count();
-    }
-    return count + 1;
-  }
-  
-  // walker returns: true - go for the childs, false - dont
-  void Traverse(std::function<bool(QuadTreeNode* node)> walker) {
-    if (walker(this)) {
-      for (size_t i = 0; i < 4; ++i) {
-        if (childs[i]) childs[i]->Traverse(walker);
-      }
-    }
-  }
-};
-
-struct QuadTree {
-  QuadTreeNode* root;
-  size_t n_subdivisions;
-
-  QuadTree(size_t n_subdivisions, size_t size) {
-    this->n_subdivisions = n_subdivisions;
-    root = new QuadTreeNode();
-    root->position = glm::vec3(0, 0, 0);
-    root->size = size;
-
-    root->Subdivide(n_subdivisions);
-  }
-
-  ~QuadTree() {
-    if (root) {
-      delete root;
-      root = 0;
-    }
-  }
-};
-
 struct QuadTreeVisualiser : public Action {
-  std::shared_ptr<QuadTree> tree;
-  std::shared_ptr<Camera> camera;
+  std::shared_ptr<Terrain::QuadTree> tree;
+  std::shared_ptr<Camera>            camera;
 
   QuadTreeVisualiser(std::shared_ptr<Transformation> t, 
                      std::shared_ptr<Camera> cam,
-                     size_t levels, float size)
+                     int levels, float size)
     : Action(t), camera(cam) {
     // separator
     if (dynamic_cast<ActorPool*>(&GetActor()) == nullptr) {
       ABORT_F("QuadTreeVisualiser must be attached to an ActorPool");
     }
-    tree = std::make_shared<QuadTree>(levels, size);
+
+    // Flat terrain, subdivide everything that is visible
+    Terrain::QuadTree::Params params;
+    params.levels = levels;
+    params.half_size = size;
+    params.split_distance = std::numeric_limits<float>::max();
+    tree = std::make_shared<Terrain::QuadTree>(params, Array2d<float>(1, 1));
     std::cerr << "QuadTree (" <<
-                 "C: " << tree->root->Count() << ", "
-                 "L: " << tree->root->level << ", "
-                 "S: " << tree->root->size << ")" << std::endl;
+                 "L: " << levels << ", "
+                 "S: " << size << ")" << std::endl;
   }
 
   ActorPool* GetPool() {
@@ -174,43 +87,28 @@ struct QuadTreeVisualiser : public Action {
     auto pool = GetPool();
     pool->Clear();
 
-    auto walker = [this, &pool](QuadTreeNode* node) -> bool {
-      assert(node);
-      auto& frustum = camera->GetFrustum();
-      glm::vec3 min = node->position - node->size;
-      glm::vec3 max = node->position + node->size;
-      bool test = frustum.TestAabb(min, max);
-
-      if (!test) {
-        // A bit of profiling and optimization. Not delete actions, just modify
-        // them (to avoid memory allocations). 
-        // And shared pointers... they are cool but expensive.
-        auto a = pool->Get(false);
-        if (a) {
-          a->transform->SetLocalPosition(node->position);
-          a->transform->SetLocalScale(glm::vec3(node->size, 1, node->size));
-          auto tint = a->GetAction<Tint>();
-          if (!tint) a->AddAction<Tint>(Color(1,0,0,1));
-          else       tint->color = Color(1,0,0,1);
-        }
-        return false;
+    auto& frustum = camera->GetFrustum();
+    tree->Update(camera->transform->GetGlobalPosition(), frustum);
+
+    // Red - culled, yellow - visible 
+    for (auto& node: tree->GetCut()) {
+      glm::vec3 min, max;
+      tree->GetBounds(node, min, max);
+      float size = (max.x - min.x) / 2;
+      Color color = frustum.TestAabb(min, max) ? Color(1,1,0,1) : Color(1,0,0,1);
+
+      // A bit of profiling and optimization. Not delete actions, just modify
+      // them (to avoid memory allocations). 
+      // And shared pointers... they are cool but expensive.
+      auto a = pool->Get(false);
+      if (a) {
+        a->transform->SetLocalPosition((min + max) / 2.0f);
+        a->transform->SetLocalScale(glm::vec3(size, 1, size));
+        auto tint = a->GetAction<Tint>();
+        if (!tint) a->AddAction<Tint>(color);
+        else       tint->color = color;
       }
-
-      if (node->IsLeaf()) {
-        auto a = pool->Get(false);
-        if (a) {
-          a->transform->SetLocalPosition(node->position);
-          a->transform->SetLocalScale(glm::vec3(node->size, 1, node->size));
-          auto tint = a->GetAction<Tint>();
-          if (!tint) a->AddAction<Tint>(Color(1,1,0,1));
-          else       tint->color = Color(1,1,0,1);
-        }
-      }
-      return true;
-    };
-
-    // Rebuild every frame
-    tree->root->Traverse(walker);
+    }
   }
 };
 
@@ -40,126 +40,50 @@ auto Patch() {
   return mesh;
 }
 
-// Quick and dirty quadtree
-// nw -x+z
-// ne +x+z
-// se +x-z
-// nw -x-z
-struct QuadTreeNode {
-  QuadTreeNode* childs[4] = {nullptr, nullptr, nullptr, nullptr};
-
-  glm::vec3     position;
-  float         size;
-
-  size_t        level;
-
-  enum Dir {
-    kNw = 0, kNe, kSe, kSw
-  };
-
-  ~QuadTreeNode() {
-    if (childs[0]) delete childs[0];
-    if (childs[1]) delete childs[1];
-    if (childs[2]) delete childs[2];
-    if (childs[3]) delete childs[3];
-  }
-
-  // Offset for child position
-  glm::vec3 offset(Dir dir) const {
-    switch(dir) {
-      case kNw: return glm::vec3(-size/2,  0,  size/2);
-      case kNe: return glm::vec3( size/2,  0,  size/2);
-      case kSe: return glm::vec3( size/2,  0, -size/2);
-      case kSw: return glm::vec3(-size/2,  0, -size/2);
-      default: ABORT_F("Invalid child direction");
-    }
-  }
-
-  // Subdivide 'level' times
-  void Subdivide(size_t level) {
-    this->level = level;
-    if (level == 0) return;
-    for (size_t i = 0; i < 4; ++i) {
-      childs[i] = new QuadTreeNode();
-      childs[i]->position = position + offset((Dir)i); 
-      childs[i]->size = size/2;
-      childs[i]->Subdivide(level - 1);
-    }
-  }
-
-  // Total number of elements, including root
-  // 4^0 + 4^1 + 4^2 + ... + 4^N, where N - number of subdivisions
-  size_t NodeCount() {
-    size_t count = 0;
-    for(size_t i = 0; i < 4; ++i) {
-      if (childs[i]) count += childs[i]->NodeCount();
-    }
-    return count + 1;
-  }
-  
-  // walker returns: true - go for the childs, false - dont
-  void Traverse(std::function<bool(QuadTreeNode* node)> walker) {
-    if (walker(this)) {
-      for (size_t i = 0; i < 4; ++i) {
-        if (childs[i]) childs[i]->Traverse(walker);
-      }
-    }
-  }
-};
-
-struct QuadTree {
-  QuadTreeNode* root;
-  size_t        n_subdivisions;
-
-  QuadTree(size_t n_subdivisions, size_t size) {
-    this->n_subdivisions = n_subdivisions;
-    root = new QuadTreeNode();
-    root->position = glm::vec3(0, 0, 0);
-    root->size = size;
-
-    if (n_subdivisions) {
-      root->Subdivide(n_subdivisions);
-    }
-  }
-
-  ~QuadTree() {
-    if (root) {
-      delete root;
-      root = 0;
-    }
+float Sigma(float x) {
+  if (x < 0.5) {
+    return 0.5 * (2*x)*(2*x)*(2*x);
   }
-};
+  return 0.5 * ( (2*x-2)*(2*x-2)*(2*x-2) + 2);
+}
 
 // Instanced quad-tree renderer 
 struct QuadTreeRenderer : public Action {
-  std::shared_ptr<QuadTree> tree;
-  std::shared_ptr<Camera>   camera;
-  size_t                    max_nodes;
-  float                     max_elevation;
+  std::shared_ptr<Terrain::QuadTree> tree;
+  std::shared_ptr<Camera>            camera;
+  size_t                             max_patches;
+  float                              max_elevation;
   
   // vec4 xyz - position, w - size
-  // vec4 - lod color 
+  // vec4 - level, max level, min and max height
   using Layout = AttributeLayout<true, glm::vec4, glm::vec4>;
-  std::vector<uint8_t> node_buffer;
+  static_assert(Layout::Stride() == sizeof(Terrain::QuadTree::Patch),
+                "Patch does not match the instance layout");
 
   std::shared_ptr<MeshFilter> mesh_filter;
   std::shared_ptr<MeshRenderer> mesh_renderer;
 
   QuadTreeRenderer(std::shared_ptr<Transformation> t, 
                    std::shared_ptr<Camera> cam,
-                   size_t levels, float size, float elevation)
-    : Action(t), camera(cam) {
-    // separator
-    tree = std::make_shared<QuadTree>(levels, size);
-    max_nodes = tree->root->NodeCount();
-    node_buffer.resize(Layout::Stride() * max_nodes);
-    max_elevation = elevation;
+                   const std::string& heightmap,
+                   int levels, float size, float elevation)
+    : Action(t), camera(cam), max_patches(0), max_elevation(elevation) {
+    // Same elevations as the tesselation shader, for the node bounds
+    auto hmap = Image::Load(heightmap);
+    Array2d<float> heights(hmap->GetWidth(), hmap->GetHeight());
+    for (size_t i = 0; i < heights.GetLength(); ++i) {
+      heights.At(i) = Sigma(hmap->At(i).r) * max_elevation;
+    }
+
+    Terrain::QuadTree::Params params;
+    params.levels = levels;
+    params.half_size = size;
+    tree = std::make_shared<Terrain::QuadTree>(params, heights);
 
     LOG_SCOPE_F(INFO, "QuadTree");
-    LOG_F(INFO, "Node count       : %zu", tree->root->NodeCount());
-    LOG_F(INFO, "Tree levels      : %zu", tree->root->level);
-    LOG_F(INFO, "Root node scale  : %.0f", tree->root->size);
-    LOG_F(INFO, "Node vRAM        : %.1f MB", node_buffer.size() / (1024 * 1024.));
+    LOG_F(INFO, "Tree levels      : %d", levels);
+    LOG_F(INFO, "Root node scale  : %.0f", size);
+    LOG_F(INFO, "Node bounds      : %zu", tree->GetBoundsCount());
   }
 
   void Start() override {
@@ -188,68 +112,40 @@ struct QuadTreeRenderer : public Action {
     if (!mesh_filter || !mesh_renderer) {
       ABORT_F("MeshFilter/MeshRenderer not found");
     }
-    mesh_renderer->n_instances = 0;
-    Build(camera);
-  }
-
-  // Compare node diagonal vs distance to camera
-  // Used for QuadTree subdivision LOD 
-  bool LodDiagonal(QuadTreeNode* node) {
-    glm::vec3 p = node->position; 
-    glm::vec3 c = camera->transform->GetGlobalPosition(); 
-    p.y = 0; c.y = 0; // xz plane only
-    auto dc = glm::distance(p, c);
-    // more the multiplier, higher the details overall...
-    auto d = 8 * glm::distance(p + node->offset(QuadTreeNode::kNw),
-                               p + node->offset(QuadTreeNode::kSe));
-    return dc > d;
-  }
-
-  void PlacePatch(QuadTreeNode* node, const Color& color) {
-    BufferView buff(&node_buffer[0], node_buffer.size());
-
-    Layout::Set<0>(buff, mesh_renderer->n_instances, glm::vec4(node->position, node->size));
-    Layout::Set<1>(buff, mesh_renderer->n_instances, color);
+    tree->Update(camera->transform->GetGlobalPosition(), camera->GetFrustum());
+    Upload();
 
-    mesh_renderer->n_instances++;
+    auto& stats = tree->GetStats();
+    LOG_F(1, "QuadTree cut=%zu patches=%zu +%zu -%zu uploaded=%zu", 
+          stats.cut, stats.visible, stats.added, stats.removed, stats.uploaded);
   }
-  
-  void Build(std::shared_ptr<Camera>& camera) {
-    auto walker = [this, &camera](QuadTreeNode* node) -> bool {
-      assert(node);
-      auto& frustum = camera->GetFrustum();
-      glm::vec3 min = node->position - node->size;
-      glm::vec3 max = node->position + node->size;
-      max.y = max_elevation; 
-      bool test = frustum.TestAabb(min, max);
-
-      if (!test) {
-        // Frustum culling failed, dont go deeper 
-        return false;
-      }
 
-      if (LodDiagonal(node) || node->level == 0) {
-        auto c = Color(1, (tree->root->level-node->level) / (float)tree->root->level, 0, 1);
-        PlacePatch(node, c);
-        return false;
-      }
-
-      // Keep going deeper
-      return true;
-    };
+  // Only the patches changed since the last frame go to vRAM 
+  void Upload() {
+    auto& patches = tree->GetPatches();
+    mesh_renderer->n_instances = patches.size();
+    if (patches.empty()) {
+      return;
+    }
 
-    // Rebuild every frame
-    tree->root->Traverse(walker);
+    if (patches.size() > max_patches) {
+      max_patches = std::max<size_t>(patches.size() * 2, 1024);
+      mesh_filter->
+        Upload<Layout>(
+            8, 0, max_patches, nullptr, VertexArrayObject::kUsageDynamic);
+      mesh_filter->UploadRange<Layout>(8, 0, patches.size(), patches.data());
+      return;
+    }
 
-    mesh_filter->
-      Upload<Layout>(
-          8, mesh_renderer->n_instances, max_nodes, &node_buffer[0], 
-          VertexArrayObject::kUsageStream);
+    for (auto& range: tree->GetDirtyRanges()) {
+      mesh_filter->UploadRange<Layout>(
+          8, range.first, range.second, &patches[range.first]);
+    }
   }
 
   void PreDraw() override {
     if (auto m = GetActor().GetComponent<Material>()) {
-      m->SetUniform("terrain_half_size", tree->root->size);
+      m->SetUniform("terrain_half_size", tree->GetParams().half_size);
       m->SetUniform("max_elevation", max_elevation);
       m->SetUniform("tesselation_min_distance", 50.0f);
       m->SetUniform("tesselation_max_distance", 200.0f);
@@ -284,7 +180,8 @@ int main(int argc, char* argv[]) {
   Cfg<Actor>(scene, "actor.terrain")
     . Mesh(Patch())
     . Material("assets/materials/quadtree_tesselation.mat")
-    . Action<QuadTreeRenderer>(maincam, 8, 4000, 1000)
+    . Action<QuadTreeRenderer>(
+        maincam, "assets/heightmaps/sfo_8x8_hmap.pgm", 16, 4000, 1000)
     . Done();
 
   // Sun
@@ -42,7 +42,7 @@ struct Rot : public Action {
       dr.x = -abs(dr.x);
     }
 
-    transform->Rotate(dr * GetTimer().GetTimeDelta());
+    transform->Rotate(dr * GetDeltaTime());
   }
 };
 
@@ -63,13 +63,13 @@ struct TerrainHmap: public Action {
 
   void Build() {
     hmap = Image::Load("assets/heightmaps/geo_20x20.pgm");
-    std::function<float(int, int)>     sample_alt = [this](int x, int z) {
+    auto sample_alt = [this](int x, int z) {
       int ix = x % hmap->GetWidth();
       int iz = z % hmap->GetHeight();
       float h = hmap->At(ix, iz).r;
       return params.max_altitude * Sigma(h);
     };
-    std::function<Color(int, int)> sample_col = [this, sample_alt](int x, int z) {
+    auto sample_col = [this, sample_alt](int x, int z) -> Color {
       float n = sample_alt(x, z) / params.max_altitude;
 
       float elevation = .15;
@@ -79,10 +79,13 @@ struct TerrainHmap: public Action {
       return glm::mix(low_color, hi_color, n);
     };
 
-    auto mesh = Grid(
-        sample_alt, sample_col,
-        hmap->GetWidth(),
-        params.xz_scale);
+    GridMesh::Params grid;
+    grid.x_vertices = hmap->GetWidth();
+    grid.z_vertices = hmap->GetWidth();
+    grid.x_length = params.xz_scale;
+    grid.z_length = params.xz_scale;
+    grid.rows = GridMesh::kRowsToPositiveZ;
+    auto mesh = GridMesh::Build(grid, sample_alt, sample_col);
 
     GetActor().AddComponent<MeshFilter>()->SetMesh(mesh);
 
@@ -91,64 +94,6 @@ struct TerrainHmap: public Action {
   }
 
  private:
-  std::shared_ptr<Mesh> Grid(std::function<float(int, int)> sample_altitude,
-                             std::function<Color(int, int)> sample_color,
-                             int resolution,  // n_vertices per row = . res x res
-                             float scale) {
-    assert(resolution > 1);
-
-    auto mesh = std::make_shared<Mesh>();
-
-    auto n_vertices = resolution * resolution;
-    auto n_indices = (resolution - 1) * (resolution - 1) * 6;
-
-    mesh->vertices.resize(n_vertices);
-    mesh->uv.resize(n_vertices);
-    mesh->colors.resize(n_vertices);
-    mesh->indices.resize(n_indices);
-
-    int triangle_index = 0;
-    auto add_triangle = [mesh, &triangle_index] (int a, int b, int c) {
-      mesh->indices[triangle_index] = a;
-      mesh->indices[triangle_index + 1] = b;
-      mesh->indices[triangle_index + 2] = c;
-      triangle_index += 3;
-    };
-
-    int vertex_index = 0;
-
-    for (int z = 0; z < resolution; z++) {
-      float v = (float)z / (resolution - 1);
-      float zpos = Math::Lerp(-0.5f, 0.5f, v) * scale;
-
-      for (int x = 0; x < resolution; x++) {
-        float u = (float)x / (resolution - 1);
-        float xpos = Math::Lerp(-0.5f,  0.5f, u) * scale;
-
-        float altitude = 0;
-        if (sample_altitude) {
-          altitude = sample_altitude(x, z);
-        }
-
-        mesh->vertices[vertex_index] = glm::vec3(xpos, altitude, zpos);
-        mesh->uv[vertex_index] = glm::vec2(u, v);
-
-        if (sample_color) {
-          mesh->colors[vertex_index] = sample_color(x, z);
-        }
-
-        if (x < resolution - 1 && z < resolution - 1) {
-          add_triangle(vertex_index, vertex_index + resolution, vertex_index + resolution + 1);
-          add_triangle(vertex_index, vertex_index + resolution + 1, vertex_index + 1);
-        }
-        vertex_index++;
-      }
-    }
-
-    mesh->RecalculateNormals();
-    return mesh;
-  }
-
   float Sigma(float x) const {
     if (x < 0.5) {
       return 0.5 * (2*x)*(2*x)*(2*x);
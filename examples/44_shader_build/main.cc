@@ -0,0 +1,116 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "b3d.h"
+#include "my/all.h"
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Builds every material and measures how long it takes until all the 
+// shaders are ready. The frame loop keeps running meanwhile.
+//
+// 44_shader_build [--sync] [--cache] [file.mat ...]
+//   --sync  wait for every material right after loading it (old behavior)
+//   --cache use the program binary cache in shader_cache/
+//   Without files all the materials under assets/ are built.
+int main(int argc, char* argv[]) {
+  bool sync = false;
+  bool cache = false;
+  std::vector<std::string> filenames;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--sync") {
+      sync = true;
+    } else if (arg == "--cache") {
+      cache = true;
+    } else {
+      filenames.push_back(arg);
+    }
+  }
+
+  if (filenames.empty()) {
+    namespace fs = std::filesystem;
+    for (auto& entry: fs::recursive_directory_iterator("assets")) {
+      if (entry.path().extension() == ".mat") {
+        filenames.push_back(entry.path().generic_string());
+      }
+    }
+  }
+
+  Scene scene;
+
+  AppContext::Init(1280, 720, "Shader build [b3d]", Profile("4 1 core"));
+  if (cache) {
+    ProgramCache::Instance().SetDirectory("shader_cache");
+  }
+
+  scene.Add<Camera>("camera.main");
+
+  Cfg<RenderTarget>(scene, "rt.screen", 2000)
+    . Tags("onscreen")
+    . Clear(.4, .4, .4, 1)
+    . Done();
+
+  Cfg<Actor>(scene, "actor.fps.meter")
+    . Action<FpsMeter>()
+    . Done();
+
+  // Keep them alive, otherwise the shaders are freed right away
+  std::vector<std::shared_ptr<Material>> materials;
+
+  double start = glfwGetTime();
+  for (auto& filename: filenames) {
+    materials.push_back(MaterialLoader::Load(filename));
+    if (sync) {
+      MaterialLoader::Wait();
+    }
+  }
+  double submitted = glfwGetTime();
+
+  int frames = 0;
+  size_t pending = MaterialLoader::Poll();
+  while (pending > 0 && AppContext::Running()) {
+    AppContext::BeginFrame();
+    scene.Update();
+    scene.Draw();
+    AppContext::EndFrame();
+    pending = MaterialLoader::Poll();
+    frames++;
+  }
+  double done = glfwGetTime();
+
+  std::cerr << "Materials: " << materials.size() 
+            << (sync ? " (sync)" : " (async)") << std::endl
+            << "  load calls " << (submitted - start) * 1000 << " ms" 
+            << std::endl
+            << "  all ready  " << (done - start) * 1000 << " ms, " 
+            << frames << " frames drawn meanwhile" << std::endl;
+  ResourceCache::Instance().PrintStats(std::cerr);
+  ProgramCache::Instance().PrintStats(std::cerr);
+
+  AppContext::Close();
+  return 0;
+}
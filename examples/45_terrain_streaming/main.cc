@@ -0,0 +1,138 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "b3d.h"
+#include "my/all.h"
+
+// Scripted fly-through, same path every run: a wide figure eight, 
+// low over the terrain, looking ahead
+struct FigureEight : public Action {
+  float speed;
+  float radius;
+  float altitude;
+
+  FigureEight(std::shared_ptr<Transformation> t, 
+             float speed, float radius, float altitude)
+    : Action(t), speed(speed), radius(radius), altitude(altitude) {}
+
+  glm::vec3 GetPosition(float time) const {
+    float a = time * speed / radius;
+    return glm::vec3(radius * std::sin(a), altitude, 
+                     radius * std::sin(a) * std::cos(a));
+  }
+
+  void Update() override {
+    float time = GetTimer().GetTime();
+    glm::vec3 eye = GetPosition(time);
+    glm::vec3 ahead = GetPosition(time + 1);
+    ahead.y = altitude * 0.7f;
+    transform->SetLocalPosition(eye);
+    transform->LookAt(ahead, glm::vec3(0, 1, 0));
+  }
+};
+
+int main(int argc, char* argv[]) {
+  using glm::vec3;
+  Scene scene;
+  bool free_flight = argc > 1 && std::string(argv[1]) == "--free";
+
+  AppContext::Init(1280, 720, "Terrain streaming [b3d]", Profile("3 3 core"));
+  AppContext::Instance().display.ShowCursor(false);
+  int width = AppContext::Instance().display.GetWidth();
+  int height = AppContext::Instance().display.GetHeight();
+
+  Cfg<RenderTarget>(scene, "rt.screen", 2000)
+    . Tags("onscreen")
+    . Clear(.4, .4, .4, 1)
+    . Done();
+
+  scene.Add<Light>("light.sun", Light::kDirectional)
+    ->transform->SetLocalEulerAngles(-210, 0, 0);
+
+  Terrain::ChunkStreamer::Params params;
+  params.chunk_vertices = 65;
+  params.texel_size = 4;
+  params.lod_levels = 4;
+  params.lod_distance = 2;
+  params.view_distance = 10;
+  params.cache_size = 128;
+  params.upload_budget = 65 * 65 * 2;
+  params.n_workers = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+  float far = params.view_distance * (params.chunk_vertices - 1) * params.texel_size;
+
+  auto camera = Cfg<Camera>(scene, "camera.main")
+    . Perspective(60, (float)width/height, 1, far) 
+    . Position(0, 200, 0)
+    . Done();
+  if (free_flight) {
+    camera->AddAction<FlyingCameraController>(200);
+  } else {
+    camera->AddAction<FigureEight>(150, 4000, 220);
+  }
+
+  // Endless fbm terrain, computed per chunk on the workers
+  const float kMaxAltitude = 300;
+  auto generator = [kMaxAltitude](int x0, int z0, int stride, int n, float* out) {
+    const float scale = 1 / 400.0f;
+    Noise::Perlin::FbmParams fbm;
+    fbm.octaves = 6;
+    Noise::Perlin::FillFbm(out, n, n, x0 * scale, z0 * scale, stride * scale, 
+                           fbm, 1);
+    for (int i = 0; i < n * n; ++i) {
+      out[i] = std::max(0.0f, out[i] * 0.5f + 0.5f - 0.2f) * kMaxAltitude;
+    }
+  };
+  auto colorizer = [kMaxAltitude](float h, const glm::vec3& normal) -> Color {
+    if (h <= 0) {
+      return Rgb(255, 248, 220);
+    }
+    Color grass = glm::mix(Rgb(46, 139, 87), Rgb(139, 69, 19), h / kMaxAltitude);
+    return glm::mix(Rgb(120, 120, 120), grass, glm::smoothstep(0.6f, 0.8f, normal.y));
+  };
+
+  int max_chunks = (params.view_distance * 2 + 1) * (params.view_distance * 2 + 1);
+  Cfg<ActorPool>(scene, "actor.terrain.chunks", max_chunks)
+    . Material("assets/materials/terrain_flatshading.mat")
+    . Action<TerrainStreamer>(camera, params, generator, colorizer)
+    . Done();
+
+  // The fly-through lasts a minute, the histogram goes to the log
+  Cfg<Actor>(scene, "actor.frame.times")
+    . Action<FrameTimeHistogram>(60)
+    . Done();
+
+  Cfg<Actor>(scene, "actor.fps.meter")
+    . Action<FpsMeter>()
+    . Done();
+
+  do {
+    AppContext::BeginFrame();
+    scene.Update();
+    scene.Draw();
+    AppContext::EndFrame();
+  } while (AppContext::Running());
+
+  AppContext::Close();
+  return 0;
+}
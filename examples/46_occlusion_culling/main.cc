@@ -0,0 +1,129 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "b3d.h"
+#include "my/all.h"
+#include <iostream>
+
+// Logs the occlusion culling counters once a second
+struct OcclusionStats : public Action {
+  std::shared_ptr<RenderTarget> target;
+  float                         next_report;
+
+  OcclusionStats(std::shared_ptr<Transformation> t, 
+                 std::shared_ptr<RenderTarget> rt)
+    : Action(t), target(rt), next_report(1) {}
+
+  void Update() override {
+    auto buffer = target->GetOcclusionBuffer();
+    if (!buffer || GetTimer().GetTime() < next_report) {
+      return;
+    }
+    next_report = GetTimer().GetTime() + 1;
+
+    auto& stats = buffer->GetStats();
+    std::cerr << "Occlusion: " << stats.occluded << "/" << stats.tested 
+              << " actors occluded, " << stats.occluders << " occluders, " 
+              << stats.triangles << " triangles, raster " << stats.raster_ms 
+              << " ms" << std::endl;
+  }
+};
+
+int main(int argc, char* argv[]) {
+  Scene scene;
+
+  AppContext::Init(1280, 720, "Occlusion culling [b3d]", Profile("3 3 core"));
+  AppContext::Instance().display.ShowCursor(false);
+  int width = AppContext::Instance().display.GetWidth();
+  int height = AppContext::Instance().display.GetHeight();
+
+  // 256 x 128 software depth buffer for the main camera
+  Cfg<RenderTarget>(scene, "rt.screen", 2000)
+    . Tags("onscreen")
+    . Clear(.4, .4, .4, 1)
+    . OcclusionCulling(256, 128)
+    . Done();
+
+  scene.Add<Light>("light.sun", Light::kDirectional)
+    ->transform->SetLocalEulerAngles(-45, 30, 0);
+
+  Cfg<Camera>(scene, "camera.main")
+    . Perspective(60, (float)width/height, .5, 500) 
+    . Position(0, 2, 0)
+    . Action<FlyingCameraController>(10)
+    . Done();
+
+  // Square yard walled in, the walls and the ground are the occluders
+  Cfg<Actor>(scene, "actor.ground")
+    . Model("assets/models/plane.dsm", "assets/materials/dirlight.mat")
+    . Scale(200, 1, 200)
+    . Occluder()
+    . Done();
+
+  const float kYard = 20;
+  for (int i = 0; i < 4; ++i) {
+    float angle = i * 90.0f;
+    glm::vec3 position(-kYard * std::sin(glm::radians(angle)), 4, 
+                       -kYard * std::cos(glm::radians(angle)));
+    Cfg<Actor>(scene, "actor.wall." + std::to_string(i))
+      . Model("assets/models/unity_cube.dsm", "assets/materials/dirlight.mat")
+      . Position(position)
+      . EulerAngles(0, angle, 0)
+      . Scale(kYard * 2, 8, 1)
+      . Occluder()
+      . Done();
+  }
+
+  // Crowd outside the yard, most of it is behind the walls
+  for (int z = 0; z < 30; ++z) {
+    for (int x = 0; x < 30; ++x) {
+      glm::vec3 position(x * 6 - 87, 0, z * 6 - 87);
+      if (std::abs(position.x) < kYard + 2 && std::abs(position.z) < kYard + 2) {
+        continue;
+      }
+      Cfg<Actor>(scene, "actor.knight." + std::to_string(z * 30 + x))
+        . Model("assets/models/knight.dsm", "assets/materials/dirlight.mat")
+        . Position(position)
+        . Done();
+    }
+  }
+
+  Cfg<Actor>(scene, "actor.occlusion.stats")
+    . Action<OcclusionStats>(scene.Get<RenderTarget>(2000))
+    . Done();
+
+  Cfg<Actor>(scene, "actor.fps.meter")
+    . Action<FpsMeter>()
+    . Done();
+
+  do {
+    AppContext::BeginFrame();
+    scene.Update();
+    scene.Draw();
+    AppContext::EndFrame();
+  } while (AppContext::Running());
+
+  AppContext::Close();
+  return 0;
+}
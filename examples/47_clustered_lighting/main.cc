@@ -0,0 +1,181 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "b3d.h"
+#include "my/all.h"
+#include <iostream>
+#include <random>
+
+// Circles around the start position, every light at its own pace
+struct Orbit : public Action {
+  glm::vec3 center;
+  float     radius;
+  float     speed;
+  float     phase;
+
+  Orbit(std::shared_ptr<Transformation> t, float r, float s, float p)
+    : Action(t), center(t->GetLocalPosition()), radius(r), speed(s), phase(p) {}
+
+  void Update() override {
+    float a = phase + GetTimer().GetTime() * speed;
+    transform->SetLocalPosition(
+        center + glm::vec3(std::cos(a), 0, std::sin(a)) * radius);
+  }
+};
+
+// Surface properties and the cluster heat map toggle
+struct SurfaceUniform : public Action {
+  bool show_clusters;
+
+  SurfaceUniform(std::shared_ptr<Transformation> t, bool show)
+    : Action(t), show_clusters(show) {}
+
+  void PreDraw() override {
+    if (auto m = transform->GetActor().GetComponent<Material>()) {
+      m->SetUniform("surface.diffuse",    glm::vec4(.8, .8, .8, 1));
+      m->SetUniform("surface.ambient",    glm::vec4(.02, .02, .02, 1));
+      m->SetUniform("surface.specular",   glm::vec4(.3, .3, .3, 1));
+      m->SetUniform("surface.shininess",  20.0f);
+      m->SetUniform("surface.has_albedo", 1);
+      m->SetUniform("show_clusters",      (int)show_clusters);
+    }
+  }
+};
+
+// Logs the light binning counters once a second
+struct ClusterStats : public Action {
+  std::shared_ptr<RenderTarget> target;
+  float                         next_report;
+
+  ClusterStats(std::shared_ptr<Transformation> t, 
+               std::shared_ptr<RenderTarget> rt)
+    : Action(t), target(rt), next_report(1) {}
+
+  void Update() override {
+    auto lighting = target->GetClusteredLighting();
+    if (!lighting || GetTimer().GetTime() < next_report) {
+      return;
+    }
+    next_report = GetTimer().GetTime() + 1;
+
+    auto& stats = lighting->GetClusters().GetStats();
+    std::cerr << "Clusters: " << stats.lights << " lights, " 
+              << stats.indices << " indices, max " << stats.max_cluster 
+              << " per cluster, binning " << stats.bin_ms << " ms" 
+              << std::endl;
+  }
+};
+
+int main(int argc, char* argv[]) {
+  Scene scene;
+
+  // --lights N (1024 by default), --show-clusters tints the light count
+  int n_lights = 1024;
+  bool show_clusters = false;
+  for (int i = 1; i < argc; ++i) {
+    if (std::string(argv[i]) == "--lights" && i + 1 < argc) {
+      n_lights = std::stoi(argv[++i]);
+    }
+    show_clusters |= std::string(argv[i]) == "--show-clusters";
+  }
+
+  AppContext::Init(1280, 720, "Clustered lighting [b3d]", Profile("3 3 core"));
+  AppContext::Instance().display.ShowCursor(false);
+  int width = AppContext::Instance().display.GetWidth();
+  int height = AppContext::Instance().display.GetHeight();
+
+  // 16 x 9 tiles, 24 depth slices
+  Cfg<RenderTarget>(scene, "rt.screen", 2000)
+    . Tags("onscreen")
+    . Clear(0, 0, 0, 1)
+    . ClusteredLighting(16, 9, 24)
+    . Done();
+
+  // Dim moonlight
+  Cfg<Light>(scene, "light.moon", Light::kDirectional)
+    . EulerAngles(-60, 30, 0)
+    . Color(.05, .05, .1, 1)
+    . Done();
+
+  Cfg<Camera>(scene, "camera.main")
+    . Perspective(60, (float)width/height, .5, 300) 
+    . Position(0, 8, 40)
+    . EulerAngles(-15, 0, 0)
+    . Action<FlyingCameraController>(10)
+    . Done();
+
+  Cfg<Actor>(scene, "actor.ground")
+    . Model("assets/models/plane.dsm", "assets/materials/clustered_lighting.mat")
+    . Scale(150, 1, 150)
+    . Action<SurfaceUniform>(show_clusters)
+    . Done();
+
+  for (int z = 0; z < 12; ++z) {
+    for (int x = 0; x < 12; ++x) {
+      Cfg<Actor>(scene, "actor.column." + std::to_string(z * 12 + x))
+        . Model("assets/models/unity_cube.dsm", "assets/materials/clustered_lighting.mat")
+        . Position(x * 20 - 110, 3, z * 20 - 110)
+        . Scale(1.5, 6, 1.5)
+        . Action<SurfaceUniform>(show_clusters)
+        . Done();
+    }
+  }
+
+  // Every 4th is a spot light looking down
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> unit(0, 1);
+  for (int i = 0; i < n_lights; ++i) {
+    bool spot = i % 4 == 0;
+    glm::vec3 color = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)));
+    Cfg<Light>(scene, "light.local." + std::to_string(i), 
+               spot ? Light::kSpot : Light::kPoint)
+      . Position(unit(rng) * 240 - 120, 1 + unit(rng) * 4, unit(rng) * 240 - 120)
+      . EulerAngles(90, 0, 0)
+      . Color(color.r, color.g, color.b, 1)
+      . Range(spot ? 10 : 6)
+      . Intensity(spot ? 2 : 1)
+      . SpotAngle(50)
+      . Attenuation(1, 0, 0.05)
+      . Action<Orbit>(2 + unit(rng) * 6, 0.2f + unit(rng), unit(rng) * 6.28f)
+      . Done();
+  }
+
+  Cfg<Actor>(scene, "actor.cluster.stats")
+    . Action<ClusterStats>(scene.Get<RenderTarget>(2000))
+    . Done();
+
+  Cfg<Actor>(scene, "actor.fps.meter")
+    . Action<FpsMeter>()
+    . Done();
+
+  do {
+    AppContext::BeginFrame();
+    scene.Update();
+    scene.Draw();
+    AppContext::EndFrame();
+  } while (AppContext::Running());
+
+  AppContext::Close();
+  return 0;
+}
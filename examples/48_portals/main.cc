@@ -0,0 +1,182 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "b3d.h"
+#include "my/all.h"
+#include <iostream>
+#include <random>
+
+const int   kRooms    = 8;  // On a side
+const float kRoomSize = 10;
+const float kHeight   = 4;
+const float kDoor     = 2;  // Wide, 3 high
+
+// Logs the portal counters once a second
+struct PortalStats : public Action {
+  std::shared_ptr<const PortalGraph> portals;
+  float                              next_report;
+
+  PortalStats(std::shared_ptr<Transformation> t, 
+              std::shared_ptr<const PortalGraph> p)
+    : Action(t), portals(p), next_report(1) {}
+
+  void Update() override {
+    if (GetTimer().GetTime() < next_report) {
+      return;
+    }
+    next_report = GetTimer().GetTime() + 1;
+
+    auto& stats = portals->GetStats();
+    std::cerr << "Portals: " << stats.cells_visited << " cells visited, " 
+              << stats.portals_passed << "/" << stats.portals_tested 
+              << " portals passed, " << stats.objects_found 
+              << " actors found, " << stats.objects_culled << " culled" 
+              << (stats.outside ? " (outside)" : "") << std::endl;
+  }
+};
+
+// A wall piece, the center and the size
+static void AddWall(Scene& scene, const glm::vec3& center, 
+                    const glm::vec3& size) {
+  static int n_walls = 0;
+  Cfg<Actor>(scene, "actor.wall." + std::to_string(n_walls++))
+    . Model("assets/models/unity_cube.dsm", "assets/materials/dirlight.mat")
+    . Position(center)
+    . Scale(size.x, size.y, size.z)
+    . Done();
+}
+
+// The wall with the door in the middle, along x or z from the start
+static void AddDoorWall(Scene& scene, const glm::vec3& start, bool along_x) {
+  glm::vec3 axis = along_x ? glm::vec3(1, 0, 0) : glm::vec3(0, 0, 1);
+  glm::vec3 thick = along_x ? glm::vec3(0, 0, .2f) : glm::vec3(.2f, 0, 0);
+  float side = (kRoomSize - kDoor) / 2;
+  for (float offset: {side / 2, kRoomSize - side / 2}) {
+    AddWall(scene, start + axis * offset + glm::vec3(0, kHeight / 2, 0), 
+            axis * side + thick + glm::vec3(0, kHeight, 0));
+  }
+  AddWall(scene, start + axis * (kRoomSize / 2) + glm::vec3(0, 3.5f, 0), 
+          axis * kDoor + thick + glm::vec3(0, kHeight - 3, 0));
+}
+
+int main(int argc, char* argv[]) {
+  Scene scene;
+
+  AppContext::Init(1280, 720, "Portals [b3d]", Profile("3 3 core"));
+  AppContext::Instance().display.ShowCursor(false);
+  int width = AppContext::Instance().display.GetWidth();
+  int height = AppContext::Instance().display.GetHeight();
+
+  // The portals work for the frustum culled targets
+  Cfg<RenderTarget>(scene, "rt.screen", 2000)
+    . Tags("onscreen")
+    . Clear(.4, .4, .4, 1)
+    . FrustumCulling()
+    . Done();
+
+  scene.Add<Light>("light.sun", Light::kDirectional)
+    ->transform->SetLocalEulerAngles(-45, 30, 0);
+
+  Cfg<Camera>(scene, "camera.main")
+    . Perspective(60, (float)width/height, .1, 500) 
+    . Position(kRoomSize / 2, 1.7, kRoomSize / 2)
+    . Action<FlyingCameraController>(5)
+    . Done();
+
+  // kRooms x kRooms rooms, the doors in every wall between them
+  auto portals = std::make_shared<PortalGraph>();
+  for (int z = 0; z < kRooms; ++z) {
+    for (int x = 0; x < kRooms; ++x) {
+      portals->AddCell(glm::vec3(x, 0, z) * kRoomSize, 
+                       glm::vec3(x + 1, 0, z + 1) * kRoomSize + 
+                       glm::vec3(0, kHeight, 0));
+    }
+  }
+  float total = kRooms * kRoomSize;
+  for (int i = 0; i <= kRooms; ++i) {
+    for (int j = 0; j < kRooms; ++j) {
+      float a = i * kRoomSize, b = j * kRoomSize;
+      bool outer = i == 0 || i == kRooms;
+      if (outer) {
+        AddWall(scene, glm::vec3(b + kRoomSize / 2, kHeight / 2, a), 
+                glm::vec3(kRoomSize, kHeight, .2f));
+        AddWall(scene, glm::vec3(a, kHeight / 2, b + kRoomSize / 2), 
+                glm::vec3(.2f, kHeight, kRoomSize));
+        continue;
+      }
+      AddDoorWall(scene, glm::vec3(b, 0, a), true);
+      AddDoorWall(scene, glm::vec3(a, 0, b), false);
+
+      // The doors at z = a and at x = a
+      float c = b + kRoomSize / 2, h = kDoor / 2;
+      portals->AddPortal((i - 1) * kRooms + j, i * kRooms + j, 
+                         {{c - h, 0, a}, {c + h, 0, a}, 
+                          {c + h, 3, a}, {c - h, 3, a}});
+      portals->AddPortal(j * kRooms + i - 1, j * kRooms + i, 
+                         {{a, 0, c - h}, {a, 0, c + h}, 
+                          {a, 3, c + h}, {a, 3, c - h}});
+    }
+  }
+
+  Cfg<Actor>(scene, "actor.floor")
+    . Model("assets/models/plane.dsm", "assets/materials/dirlight.mat")
+    . Position(total / 2, 0, total / 2)
+    . Scale(total / 2, 1, total / 2)
+    . Done();
+
+  // A crowd in every room
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> position(1.5f, kRoomSize - 1.5f);
+  for (int z = 0; z < kRooms; ++z) {
+    for (int x = 0; x < kRooms; ++x) {
+      for (int i = 0; i < 4; ++i) {
+        Cfg<Actor>(scene, "actor.knight." + 
+                   std::to_string((z * kRooms + x) * 4 + i))
+          . Model("assets/models/knight.dsm", "assets/materials/dirlight.mat")
+          . Position(x * kRoomSize + position(rng), 0, 
+                     z * kRoomSize + position(rng))
+          . Done();
+      }
+    }
+  }
+  scene.SetPortals(portals);
+
+  Cfg<Actor>(scene, "actor.portal.stats")
+    . Action<PortalStats>(portals)
+    . Done();
+
+  Cfg<Actor>(scene, "actor.fps.meter")
+    . Action<FpsMeter>()
+    . Done();
+
+  do {
+    AppContext::BeginFrame();
+    scene.Update();
+    scene.Draw();
+    AppContext::EndFrame();
+  } while (AppContext::Running());
+
+  AppContext::Close();
+  return 0;
+}
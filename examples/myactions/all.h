@@ -36,5 +36,12 @@
 #include "fliptriangles.h"
 #include "coordinateaxes.h"
 #include "dsmexporter.h"
+#include "terrainstreamer.h"
+#include "frametimehistogram.h"
+#include "rendertargetstats.h"
+#include "cascadedshadows.h"
+#include "profileroverlay.h"
+#include "camerapathcontroller.h"
+#include "picker.h"
 
 #endif // _ALL_H_2394564A_90F0_4E9B_A81B_9A4B6572BA42_
@@ -0,0 +1,50 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _ACTION_CAMERAPATHCONTROLLER_H_D7F76215_C78A_4B92_BC93_8DBA6150D0D3_
+#define _ACTION_CAMERAPATHCONTROLLER_H_D7F76215_C78A_4B92_BC93_8DBA6150D0D3_ 
+
+#include "action.h"
+#include "camerapath.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// Flies the actor (a camera) along the CameraPath by Timer::GetTime(), so 
+// with the fixed step (B3D_FIXED_STEP) every run sees the same frames.
+//////////////////////////////////////////////////////////////////////////////
+struct CameraPathController : public Action {
+  CameraPath path;
+
+  CameraPathController(std::shared_ptr<Transformation> transform, 
+                       CameraPath camera_path)
+    : Action(transform), path(std::move(camera_path)) {}
+
+  void Update() override {
+    glm::vec3 position, euler;
+    path.Sample(GetTimer().GetTime(), position, euler);
+    transform->SetLocalPosition(position);
+    transform->SetLocalEulerAngles(euler);
+  }
+};
+
+#endif // _ACTION_CAMERAPATHCONTROLLER_H_D7F76215_C78A_4B92_BC93_8DBA6150D0D3_
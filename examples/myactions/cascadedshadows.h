@@ -0,0 +1,121 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _ACTION_CASCADEDSHADOWS_H_9D803309_40CF_4EDD_B785_08CC3A8CF050_
+#define _ACTION_CASCADEDSHADOWS_H_9D803309_40CF_4EDD_B785_08CC3A8CF050_ 
+
+#include "action.h"
+#include "camera.h"
+#include "light.h"
+#include "rendertarget.h"
+#include "shadowcascades.h"
+#include "common/logging.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+// Drives the cascade cameras and render targets of ShadowCascades for the
+// viewer camera and the directional light. One camera, ortho, and one 
+// depth render target per cascade, the render targets are expected to 
+// have the frustum culling on (per-cascade casters culling). The cached 
+// cascades not updated this frame are disabled and keep the old depth.
+//////////////////////////////////////////////////////////////////////////////
+struct CascadedShadows : public Action {
+  std::shared_ptr<ShadowCascades>            cascades;
+  std::shared_ptr<Camera>                    viewer;
+  std::shared_ptr<Light>                     light;
+  std::vector<std::shared_ptr<Camera>>       cameras;
+  std::vector<std::shared_ptr<RenderTarget>> targets;
+
+  CascadedShadows(std::shared_ptr<Transformation> t,
+                  std::shared_ptr<ShadowCascades> csm,
+                  std::shared_ptr<Camera> cam, std::shared_ptr<Light> lht,
+                  std::vector<std::shared_ptr<Camera>> cascade_cameras,
+                  std::vector<std::shared_ptr<RenderTarget>> cascade_targets)
+    : Action(t), cascades(csm), viewer(cam), light(lht), 
+      cameras(std::move(cascade_cameras)), 
+      targets(std::move(cascade_targets)) {
+    if ((int)cameras.size() != cascades->GetCount() || 
+        (int)targets.size() != cascades->GetCount()) {
+      ABORT_F("Need a camera and a render target per cascade");
+    }
+  }
+
+  void Update() override {
+    cascades->Update(*viewer, light->GetDirection());
+    for (int i = 0; i < cascades->GetCount(); ++i) {
+      auto& cascade = cascades->GetCascade(i);
+      targets[i]->SetEnabled(cascade.update);
+      if (!cascade.update) {
+        continue;
+      }
+      auto& min = cascade.box_min;
+      auto& max = cascade.box_max;
+      cameras[i]->SetOrtho(min.x, max.y, max.x, min.y, -max.z, -min.z);
+      cameras[i]->transform->SetLocalPosition(glm::vec3(0));
+      cameras[i]->transform->SetLocalEulerAngles(cascades->GetLightEulerAngles());
+    }
+  }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// Cascades uniforms for the shadow receivers, see 
+// assets/materials/shadow_caster_receiver_dirlight_csm.mat. The cascade 
+// shadow maps are the textures 0...n-1 of the material.
+//////////////////////////////////////////////////////////////////////////////
+struct CascadedShadowUniform : public Action {
+  std::shared_ptr<ShadowCascades> cascades;
+  std::shared_ptr<Light>          light;
+  bool                            show_cascades;
+
+  CascadedShadowUniform(std::shared_ptr<Transformation> t, 
+                        std::shared_ptr<ShadowCascades> csm, 
+                        std::shared_ptr<Light> lht, bool show = false) 
+    : Action(t), cascades(csm), light(lht), show_cascades(show) {}
+
+  void PreDraw() override {
+    glm::mat4 bias (
+      0.5, 0.0, 0.0, 0.0,
+      0.0, 0.5, 0.0, 0.0,
+      0.0, 0.0, 0.5, 0.0,
+      0.5, 0.5, 0.5, 1.0
+    );
+
+    if (auto mtrl = transform->GetActor().GetComponent<Material>()) {
+      for (int i = 0; i < cascades->GetCount(); ++i) {
+        auto& cascade = cascades->GetCascade(i);
+        std::string name = "cascade[" + std::to_string(i) + "]";
+        mtrl->SetUniform(name + ".depth_bias_pv", bias * cascade.pv);
+        mtrl->SetUniform(name + ".far", cascade.split_far);
+      }
+      mtrl->SetUniform("total_cascades", cascades->GetCount());
+      mtrl->SetUniform("show_cascades", (int)show_cascades);
+      mtrl->SetUniform("light.direction", light->GetDirection());
+      mtrl->SetUniform("light.color", light->GetColor());
+    }
+  }
+};
+
+#endif // _ACTION_CASCADEDSHADOWS_H_9D803309_40CF_4EDD_B785_08CC3A8CF050_
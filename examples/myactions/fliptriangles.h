@@ -37,8 +37,10 @@ struct FlipTriangles : public Action {
     if (done) return;
 
     if (auto f = transform->GetActor().GetComponent<MeshFilter>()) {
-      if (auto m = f->GetMesh()) {
-        if (!m->indices.empty()) {
+      if (auto shared = f->GetMesh()) {
+        if (!shared->indices.empty()) {
+          // Loaded meshes are shared, flip a copy
+          auto m = std::make_shared<Mesh>(*shared);
           for (size_t i = 0; i < m->indices.size(); i+=3) {
             std::swap(m->indices.at(i), m->indices.at(i+2));
           }
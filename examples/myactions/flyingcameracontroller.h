@@ -48,7 +48,7 @@ struct FlyingCameraController: public Action {
     float v_axis  = GetInput().GetAxis("Vertical");
     float x_mouse = GetInput().GetAxis("Mouse X"); 
     float y_mouse = GetInput().GetAxis("Mouse Y");
-    float dt      = GetTimer().GetTimeDelta();
+    float dt      = GetDeltaTime();
 
     transform->Rotate(glm::vec3(y_mouse, x_mouse, 0) * mouse_sensivity);
 
@@ -0,0 +1,105 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _ACTION_FRAMETIMEHISTOGRAM_H_667F8049_E927_485C_86D5_080E63C464F7_
+#define _ACTION_FRAMETIMEHISTOGRAM_H_667F8049_E927_485C_86D5_080E63C464F7_ 
+
+#include "action.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+// Collects the frame times for the given number of seconds and prints the 
+// histogram and the percentiles once. For the spike hunting, the average
+// fps hides them.
+//////////////////////////////////////////////////////////////////////////////
+struct FrameTimeHistogram : public Action {
+  float              duration;
+  std::vector<float> frame_ms;
+  bool               reported;
+
+  FrameTimeHistogram(std::shared_ptr<Transformation> t, float seconds = 60) 
+    : Action(t), duration(seconds), reported(false) {}
+
+  ~FrameTimeHistogram() {
+    if (!reported && !frame_ms.empty()) {
+      std::cerr << GetReport() << std::endl;
+    }
+  }
+
+  void Update() override {
+    float dt = GetTimer().GetTimeDelta();
+    if (reported || dt <= 0) {
+      return;
+    }
+
+    // The first frames are the loading
+    if (GetTimer().GetFrameNumber() > 10) {
+      frame_ms.push_back(dt * 1000);
+    }
+
+    if (GetTimer().GetTime() >= duration) {
+      std::cerr << GetReport() << std::endl;
+      reported = true;
+    }
+  }
+
+  std::string GetReport() const {
+    static const float kBuckets[] = {8.4f, 16.7f, 25.0f, 33.4f, 50.0f, 100.0f};
+
+    std::vector<float> sorted(frame_ms);
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&sorted](float p) {
+      return sorted.empty() ? 0 : sorted[(size_t)(p * (sorted.size() - 1))];
+    };
+
+    char line[128];
+    snprintf(line, sizeof(line), 
+             "Frame times, %zu frames: p50 %.2f p99 %.2f p99.9 %.2f max %.2f ms",
+             sorted.size(), percentile(0.5f), percentile(0.99f), 
+             percentile(0.999f), sorted.empty() ? 0 : sorted.back());
+    std::string report = line;
+
+    float low = 0;
+    for (size_t i = 0; i <= sizeof(kBuckets) / sizeof(kBuckets[0]); ++i) {
+      bool last = i == sizeof(kBuckets) / sizeof(kBuckets[0]);
+      float high = last ? 1e9f : kBuckets[i];
+      size_t n = std::lower_bound(sorted.begin(), sorted.end(), high) - 
+                 std::lower_bound(sorted.begin(), sorted.end(), low);
+      if (last) {
+        snprintf(line, sizeof(line), "\n  >= %6.1f ms %8zu", low, n);
+      } else {
+        snprintf(line, sizeof(line), "\n   < %6.1f ms %8zu", high, n);
+      }
+      report += line;
+      low = high;
+    }
+    return report;
+  }
+};
+
+#endif // _ACTION_FRAMETIMEHISTOGRAM_H_667F8049_E927_485C_86D5_080E63C464F7_
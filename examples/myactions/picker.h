@@ -0,0 +1,72 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _ACTION_PICKER_H_44B73D06_6796_4CD1_833A_3DF802B800B9_
+#define _ACTION_PICKER_H_44B73D06_6796_4CD1_833A_3DF802B800B9_ 
+
+#include "action.h"
+#include "phys/ray.h"
+#include <iostream>
+
+//////////////////////////////////////////////////////////////////////////////
+// Attached to a camera. On the left click picks the actor in the middle of
+// the screen (the cursor is hidden by the flying camera), prints it and puts
+// the marker to the hit point.
+//////////////////////////////////////////////////////////////////////////////
+struct Picker : public Action {
+  Scene&                 scene;
+  std::shared_ptr<Actor> marker;
+  bool                   was_down = false;
+
+  Picker(std::shared_ptr<Transformation> transform, Scene& scene, 
+         std::shared_ptr<Actor> marker = nullptr)
+    : Action(transform), scene(scene), marker(marker) {}
+
+  void Update() override {
+    bool down = GetInput().GetMouseButtonDown(GLFW_MOUSE_BUTTON_LEFT);
+    bool clicked = down && !was_down;
+    was_down = down;
+    auto camera = dynamic_cast<Camera*>(&transform->GetActor());
+    if (!clicked || !camera) {
+      return;
+    }
+
+    glm::mat4 proj, view;
+    camera->GetProjectionMatrix(proj);
+    camera->GetViewMatrix(view);
+    auto ray = Phys::ScreenPointToRay(proj * view, glm::vec2(0, 0));
+    Scene::RaycastHit hit;
+    if (!scene.Raycast(ray, hit, camera->GetFar())) {
+      std::cerr << "Picked nothing" << std::endl;
+      return;
+    }
+    std::cerr << "Picked " << hit.actor->GetName() << " at " << hit.distance 
+              << ", triangle " << hit.triangle << std::endl;
+    if (marker) {
+      marker->transform->SetLocalPosition(hit.point + hit.normal * 0.05f);
+    }
+  }
+};
+
+#endif // _ACTION_PICKER_H_44B73D06_6796_4CD1_833A_3DF802B800B9_
@@ -0,0 +1,131 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _ACTION_PROFILEROVERLAY_H_79BF6A7F_4B4F_434B_8C28_413E19B4E9FD_
+#define _ACTION_PROFILEROVERLAY_H_79BF6A7F_4B4F_434B_8C28_413E19B4E9FD_ 
+
+#include "action.h"
+#include "textlabel.h"
+#include "profiler.h"
+#include "material/material_loader.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+// One line of the Profiler stats, refreshed every period seconds. The app
+// must be built with B3D_PROFILING, otherwise there is nothing to show.
+//  line 0  - frame, CPU (Scene::Update + Scene::Draw) and GPU time, ms
+//  line 1  - the counters
+//  line 2+ - the slowest GPU scopes, render targets and material/pass 
+//////////////////////////////////////////////////////////////////////////////
+class ProfilerOverlay : public Action {
+ public:
+  ProfilerOverlay(std::shared_ptr<Transformation> transform, int line = 0,
+                  float seconds = 0.5f)
+    : Action(transform), 
+      line_(line),
+      period_(seconds),
+      elapsed_(seconds),
+      label_(glm::vec2(1.2f, 1.2f), glm::vec2(20.0f, 60.0f + 26.0f * line),
+             transform->GetActor().AddComponent<MeshFilter>(),
+             transform->GetActor().AddComponent<MeshRenderer>()),
+      font_("assets/fonts/mono.fnt") {
+    label_.SetText(font_, "-");
+    if (auto mr = transform->GetActor().GetComponent<MeshRenderer>()) {
+      mr->SetMaterial(MaterialLoader::Load("assets/fonts/mono.mat"));
+    }
+  }
+
+  void Update() override {
+    elapsed_ += GetDeltaTime();
+    if (elapsed_ < period_) {
+      return;
+    }
+    elapsed_ = 0;
+    label_.SetText(font_, GetLine(Profiler::Instance().GetLastFrame()));
+  }
+
+  std::string GetLine(const Profiler::Frame& frame) const {
+    char text[128] = "";
+    if (line_ == 0) {
+      double cpu_ms = 0;
+      for (auto& event: frame.cpu) {
+        if (!std::strcmp(event.name, "Scene::Update") || 
+            !std::strcmp(event.name, "Scene::Draw")) {
+          cpu_ms += Ms(event.end_ns - event.begin_ns);
+        }
+      }
+      int64_t gpu_begin = 0, gpu_end = 0;
+      for (auto& event: frame.gpu) {
+        gpu_begin = gpu_end ? std::min(gpu_begin, event.begin_ns) : 
+                              event.begin_ns;
+        gpu_end = std::max(gpu_end, event.end_ns);
+      }
+      std::snprintf(text, sizeof(text), "frame %.2f cpu %.2f gpu %.2f ms",
+                    Ms(frame.end_ns - frame.begin_ns), cpu_ms, 
+                    Ms(gpu_end - gpu_begin));
+    } else if (line_ == 1) {
+      auto& c = frame.counters;
+      std::snprintf(text, sizeof(text), 
+                    "draws %lld tris %lldk binds %lld uploads %lld %lldkb",
+                    (long long)c[Profiler::kDrawCalls], 
+                    (long long)c[Profiler::kTriangles] / 1000, 
+                    (long long)c[Profiler::kStateChanges], 
+                    (long long)c[Profiler::kUploads],
+                    (long long)c[Profiler::kUploadBytes] / 1024);
+    } else {
+      // Same name scopes summed up, the cube map faces for instance
+      std::map<std::string, int64_t> scopes;
+      for (auto& event: frame.gpu) {
+        scopes[event.name] += event.end_ns - event.begin_ns;
+      }
+      std::vector<std::pair<int64_t, std::string>> sorted;
+      for (auto& scope: scopes) {
+        sorted.emplace_back(scope.second, scope.first);
+      }
+      std::sort(sorted.rbegin(), sorted.rend());
+      size_t i = line_ - 2;
+      if (i < sorted.size()) {
+        std::snprintf(text, sizeof(text), "%6.3f %s", Ms(sorted[i].first), 
+                      sorted[i].second.c_str());
+      }
+    }
+    return text[0] ? text : " ";
+  }
+
+ private:
+  static double Ms(int64_t ns) { return ns / 1e6; }
+
+  int        line_;
+  float      period_;
+  float      elapsed_;
+  TextLabel  label_;
+  BitmapFont font_;
+};
+
+#endif // _ACTION_PROFILEROVERLAY_H_79BF6A7F_4B4F_434B_8C28_413E19B4E9FD_
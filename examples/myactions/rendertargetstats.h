@@ -0,0 +1,88 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _ACTION_RENDERTARGETSTATS_H_CEB3FC3E_E818_41E5_9BB6_ADF657E6E16A_
+#define _ACTION_RENDERTARGETSTATS_H_CEB3FC3E_E818_41E5_9BB6_ADF657E6E16A_ 
+
+#include "action.h"
+#include "rendertarget.h"
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+// Prints the render target updates, the draw calls, the culled actors and 
+// the CPU time per frame, averaged over the period (seconds) and summed up
+// for all the given render targets. See RenderTarget::GetDrawStats().
+//////////////////////////////////////////////////////////////////////////////
+struct RenderTargetStatsMeter : public Action {
+  std::string label;
+  std::vector<std::shared_ptr<RenderTarget>> targets;
+  float  period;
+  float  elapsed = 0;
+  int    updates = 0;
+  double frames = 0;
+  double draws = 0;
+  double culled = 0;
+  double cpu_ms = 0;
+
+  RenderTargetStatsMeter(std::shared_ptr<Transformation> t, 
+                         std::string name,
+                         std::vector<std::shared_ptr<RenderTarget>> rts,
+                         float seconds = 5) 
+    : Action(t), label(std::move(name)), targets(std::move(rts)), 
+      period(seconds) {}
+
+  void Update() override {
+    // The stats are from the previous frame
+    if (GetTimer().GetFrameNumber() <= 1) {
+      return;
+    }
+    for (auto& rt: targets) {
+      auto& stats = rt->GetDrawStats();
+      if (stats.drawn) {
+        draws += stats.draws;
+        culled += stats.culled;
+        cpu_ms += stats.cpu_ms;
+        ++updates;
+      }
+    }
+
+    frames += 1;
+    elapsed += GetDeltaTime();
+    if (elapsed >= period) {
+      std::cerr << label << " per frame: " << updates / frames 
+                << " updates, " << draws / frames << " draws, " 
+                << culled / frames << " culled, " << cpu_ms / frames 
+                << " ms CPU" << std::endl;
+      elapsed = 0;
+      frames = 0;
+      updates = 0;
+      draws = culled = cpu_ms = 0;
+    }
+  }
+};
+
+#endif // _ACTION_RENDERTARGETSTATS_H_CEB3FC3E_E818_41E5_9BB6_ADF657E6E16A_
@@ -44,7 +44,7 @@ struct Rotator: public Action {
   }
 
   void Update() override {
-    transform->Rotate(rotation_speed * GetTimer().GetTimeDelta());
+    transform->Rotate(rotation_speed * GetDeltaTime());
   }
 };
 
@@ -28,6 +28,7 @@
 #include "action.h"
 #include "material/material_loader.h"
 #include "meshfilter.h"
+#include "gridmesh.h"
 #include "math_main.h"
 #include "noise/perlin.h"
   
@@ -46,7 +47,7 @@ struct TerrainGenerator: public Action {
   void Build() {
     noise_map_ = GenerateNoiseMap(241, 241, 5, 1.9, .5, 50, 0, 0);
 
-    std::function<float(int, int)>     sample_alt = [this](int x, int z) {
+    auto sample_alt = [this](int x, int z) {
       int ix = x % noise_map_->GetWidth();
       int iz = z % noise_map_->GetHeight();
       float n = noise_map_->At(ix, iz);
@@ -59,7 +60,7 @@ struct TerrainGenerator: public Action {
 
       return max_altitude * Sigma(n) * falloff;
     };
-    std::function<glm::vec4(int, int)> sample_col = [this, sample_alt](int x, int z) {
+    auto sample_col = [this, sample_alt](int x, int z) -> Color {
       float n = sample_alt(x, z) / max_altitude; 
 
       float elevation = .15;
@@ -68,73 +69,18 @@ struct TerrainGenerator: public Action {
       }
       return glm::mix(low_color, hi_color, n);
     };
-    auto mesh = Generate(sample_alt, sample_col, noise_map_->GetWidth(), noise_map_->GetHeight(), xz_scale, xz_scale);
+
+    GridMesh::Params params;
+    params.x_vertices = noise_map_->GetWidth();
+    params.z_vertices = noise_map_->GetHeight();
+    params.x_length = xz_scale;
+    params.z_length = xz_scale;
+    auto mesh = GridMesh::Build(params, sample_alt, sample_col);
     GetActor().AddComponent<MeshFilter>()->SetMesh(mesh);
     LOG_F(INFO, "Terrain generated   vert=%ld   triangles=%ld", mesh->vertices.size(), mesh->indices.size()/3);
   }
 
  private: 
-  // Generate xz mesh from heightmap and [apply radial spherical deformation];
-  std::shared_ptr<Mesh> Generate(std::function<float(int, int)> sample_altitude, 
-                                 std::function<glm::vec4(int, int)> sample_color, 
-                                 int x_vertices, int z_vertices, 
-                                 float x_length, float z_length) { 
-    assert(x_vertices > 1);
-    assert(z_vertices > 1);
-
-    std::shared_ptr<Mesh> mesh(new Mesh);
-    mesh->vertices.resize(x_vertices * z_vertices);
-    mesh->indices.resize((x_vertices-1) * (z_vertices-1) * 6);
-    mesh->uv.resize(x_vertices * z_vertices);
-    mesh->colors.resize(x_vertices * z_vertices);
-    
-    int triangle_index = 0;
-    auto add_triangle = [mesh, &triangle_index] (int a, int b, int c) {
-      mesh->indices[triangle_index] = a;
-      mesh->indices[triangle_index + 1] = b;
-      mesh->indices[triangle_index + 2] = c;
-      triangle_index += 3;
-    };
-
-    int vertex_index = 0;
-
-    for (int z = 0; z < z_vertices; z++) {
-      float tz = (float)z / (z_vertices - 1);
-      float zpos = Math::Lerp(0.5f, -0.5f, tz) * z_length;
-
-      for (int x = 0; x < x_vertices; x++) {
-        float tx = (float)x / (x_vertices - 1);
-        float xpos = Math::Lerp(-0.5f,  0.5f, tx) * x_length;
-
-        float altitude = 0;
-        if (sample_altitude) {
-          altitude = sample_altitude(x, z);
-        }
-
-        mesh->vertices[vertex_index] = glm::vec3(xpos, altitude, zpos);
-        mesh->uv[vertex_index] = glm::vec2(tx, tz);
-
-        //float radius = (x_length + z_length)/2; 
-        //glm::vec3 dir = glm::normalize(mesh->vertices[vertex_index] - glm::vec3(0,-radius,0));
-        //mesh->vertices[vertex_index] += dir * radius;
-        //mesh->vertices[vertex_index].y -= radius;
-
-        if (sample_color) {
-          mesh->colors[vertex_index] = sample_color(x, z);
-        }
-
-        if (x < x_vertices - 1 && z < z_vertices - 1) {
-          add_triangle(vertex_index, vertex_index + x_vertices + 1, vertex_index + x_vertices);
-          add_triangle(vertex_index, vertex_index + 1, vertex_index + x_vertices + 1);
-        }
-        vertex_index++;
-      }
-    }
-
-    mesh->RecalculateNormals();
-    return mesh;
-  }
-
   typedef Array2d<float> NoiseMap;
   std::shared_ptr<NoiseMap> GenerateNoiseMap(size_t width, size_t height,
                                              int octaves = 5, 
@@ -144,37 +90,27 @@ struct TerrainGenerator: public Action {
                                              float offset_x = 0.0f, float offset_y = 0.0f) {
     std::shared_ptr<NoiseMap> noise_map(new NoiseMap(width, height));
     
-    std::vector<glm::vec2> offset(octaves);
+    Noise::Perlin::FbmParams fbm;
+    fbm.octaves = octaves;
+    fbm.lacunarity = lacunarity;
+    fbm.persistance = persistance;
     for (int i = 0; i < octaves; i++) {
-      float ox = Math::Random(-1000, 1000) + offset_x;
-      float oy = Math::Random(-1000, 1000) + offset_y;
-      offset[i] = glm::vec2(ox, oy);
+      fbm.offset_x.push_back(Math::Random(-1000, 1000) + offset_x);
+      fbm.offset_y.push_back(Math::Random(-1000, 1000) + offset_y);
     }
 
     float half_width = noise_map->GetWidth() / 2.0f;
     float half_height = noise_map->GetHeight() / 2.0f;
-    float noise_min = std::numeric_limits<float>::max(); 
-    float noise_max = std::numeric_limits<float>::min(); 
-
-    for(int y = 0; y < (int)noise_map->GetHeight(); ++y) {     
-      for(int x = 0; x < (int)noise_map->GetWidth(); ++x) {  
-        float amplitude = 1;
-        float frequency = 1;
-        float noise_value = 0;
-
-        for (int i = 0; i < octaves; ++i) {
-          float sample_x = (x - half_width) / scale * frequency + offset[i].x;
-          float sample_y = (y - half_height) / scale * frequency + offset[i].y;
-          float perlin = Noise::Perlin::Get(sample_x, sample_y) * 2 - 1;
-          noise_value += amplitude * perlin;
+    Noise::Perlin::FillFbm(noise_map->GetArray(), 
+                           noise_map->GetWidth(), noise_map->GetHeight(),
+                           -half_width / scale, -half_height / scale, 
+                           1.0f / scale, fbm);
 
-          frequency *= lacunarity;
-          amplitude *= persistance;
-        }
-        noise_min = std::min(noise_min, noise_value);
-        noise_max = std::max(noise_max, noise_value);
-        noise_map->At(x, y) = noise_value;
-      }
+    float noise_min = std::numeric_limits<float>::max(); 
+    float noise_max = std::numeric_limits<float>::lowest(); 
+    for (size_t i = 0; i < noise_map->GetLength(); ++i) {
+      noise_min = std::min(noise_min, noise_map->At(i));
+      noise_max = std::max(noise_max, noise_map->At(i));
     }
     
     // Normalize
@@ -0,0 +1,94 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _ACTION_TERRAINSTREAMER_H_DDA4181A_9226_4641_95FA_6AC847CAAEB7_
+#define _ACTION_TERRAINSTREAMER_H_DDA4181A_9226_4641_95FA_6AC847CAAEB7_ 
+
+#include "action.h"
+#include "actor_pool.h"
+#include "camera.h"
+#include "meshfilter.h"
+#include "terrain/chunkstreamer.h"
+#include <map>
+#include <memory>
+
+//////////////////////////////////////////////////////////////////////////////
+// Streamed terrain around the camera, see Terrain::ChunkStreamer.
+//
+// Must be attached to an ActorPool with the terrain material, one pooled 
+// actor per visible chunk. Every chunk has its own MeshFilter, created on 
+// upload and dropped when the streamer releases the chunk.
+//////////////////////////////////////////////////////////////////////////////
+struct TerrainStreamer : public Action {
+  std::shared_ptr<Terrain::ChunkStreamer> streamer;
+  std::shared_ptr<Camera>                 camera;
+
+  TerrainStreamer(std::shared_ptr<Transformation> t,
+                  std::shared_ptr<Camera> cam,
+                  const Terrain::ChunkStreamer::Params& params,
+                  Terrain::ChunkStreamer::Generator generator,
+                  Terrain::ChunkStreamer::Colorizer colorizer = nullptr)
+    : Action(t), camera(cam) {
+    if (dynamic_cast<ActorPool*>(&GetActor()) == nullptr) {
+      ABORT_F("TerrainStreamer must be attached to an ActorPool");
+    }
+    streamer = std::make_shared<Terrain::ChunkStreamer>(
+        params, std::move(generator), std::move(colorizer));
+  }
+
+  void Update() override {
+    streamer->Update(camera->transform->GetGlobalPosition());
+
+    for (auto& key: streamer->GetReleased()) {
+      filters_.erase(key);
+    }
+    for (auto chunk: streamer->GetUploads()) {
+      auto mf = std::make_shared<MeshFilter>();
+      mf->SetMesh(chunk->mesh);
+      filters_[chunk->key] = mf;
+    }
+    for (auto chunk: streamer->GetRestitched()) {
+      filters_.at(chunk->key)->UpdateIndices();
+    }
+
+    auto pool = (ActorPool*)&GetActor();
+    pool->Clear();
+
+    auto& frustum = camera->GetFrustum();
+    for (auto chunk: streamer->GetVisible()) {
+      if (!frustum.TestAabb(chunk->min, chunk->max)) {
+        continue;
+      }
+      if (auto a = pool->Get(false)) {
+        a->SetComponent(filters_.at(chunk->key));
+        a->transform->SetLocalPosition(chunk->origin);
+      }
+    }
+  }
+
+ private:
+  std::map<Terrain::ChunkStreamer::Key, std::shared_ptr<MeshFilter>> filters_;
+};
+
+#endif // _ACTION_TERRAINSTREAMER_H_DDA4181A_9226_4641_95FA_6AC847CAAEB7_
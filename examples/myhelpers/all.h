@@ -28,5 +28,6 @@
 #include "cfg_rendertarget.h"
 #include "cfg_actor.h"
 #include "postprocesspipeline.h"
+#include "postprocessblur.h"
 
 #endif // _ALL_H_6317A920_3088_4214_970C_B56FC0E14462_
@@ -131,6 +131,23 @@ class CfgActorBase {
     return CastSelf();
   }
 
+  Ret& Occluder(bool occluder = true) {
+    client_->SetOccluder(occluder);
+    return CastSelf();
+  }
+
+  // See Actor::SetStatic()
+  Ret& Static(bool super_static = false) {
+    client_->SetStatic(true, super_static);
+    return CastSelf();
+  }
+
+  // See Actor::SetAutoSleep()
+  Ret& AutoSleep(int ticks) {
+    client_->SetAutoSleep(ticks);
+    return CastSelf();
+  }
+
   Ret& Texture(int slot, std::shared_ptr<Texture> tex) {
     texture_map_.emplace(slot, tex);
     return CastSelf(); 
@@ -315,6 +332,22 @@ class Cfg<Light> : public CfgActorBase<Light, Cfg<Light>> {
                                  std::get<1>(xyz),
                                  std::get<2>(xyz)));
   }
+
+  auto& Range(float range) {
+    client_->SetRange(range);
+    return *this;
+  }
+
+  auto& Intensity(float intensity) {
+    client_->SetIntensity(intensity);
+    return *this;
+  }
+
+  // Full cone, degrees
+  auto& SpotAngle(float angle) {
+    client_->SetSpotAngle(angle);
+    return *this;
+  }
   
   auto Done() {
     client_->transform->SetLocalPosition(position_);
@@ -82,6 +82,31 @@ class Cfg<RenderTarget> {
     return *this;
   }
 
+  // CPU occlusion culling buffer resolution, see RenderTarget
+  Ret OcclusionCulling(int width, int height) {
+    occlusion_width_ = width;
+    occlusion_height_ = height;
+    return *this;
+  }
+
+  // Clustered forward lighting grid, see RenderTarget
+  Ret ClusteredLighting(int grid_x, int grid_y, int grid_z) {
+    cluster_grid_ = glm::ivec3(grid_x, grid_y, grid_z);
+    return *this;
+  }
+
+  // Camera frustum culling for the 2D targets, see RenderTarget
+  Ret FrustumCulling(bool enable = true) {
+    frustum_culling_ = enable;
+    return *this;
+  }
+
+  // Single-pass or per face rendering for the cubemaps, see RenderTarget
+  Ret CubemapMode(RenderTarget::CubemapMode mode) {
+    cubemap_mode_ = mode;
+    return *this;
+  }
+
   Ret Clear(float r, float b, float g, float a) {
     clear_color_.reset(new Color(r, g, b, a));
     return *this;
@@ -98,6 +123,11 @@ class Cfg<RenderTarget> {
     }
     client_->SetTags(tags_);
     client_->SetCamera(camera_);
+    client_->SetOcclusionCulling(occlusion_width_, occlusion_height_);
+    client_->SetCubemapMode(cubemap_mode_);
+    client_->SetFrustumCulling(frustum_culling_);
+    client_->SetClusteredLighting(cluster_grid_.x, cluster_grid_.y, 
+                                  cluster_grid_.z);
     fb->Init();
     return fb;
   }
@@ -112,6 +142,11 @@ class Cfg<RenderTarget> {
   
   int                            width_ = 0;
   int                            height_ = 0;
+  int                            occlusion_width_ = 0;
+  int                            occlusion_height_ = 0;
+  RenderTarget::CubemapMode      cubemap_mode_ = RenderTarget::kCubemapPerFace;
+  bool                           frustum_culling_ = false;
+  glm::ivec3                     cluster_grid_ = glm::ivec3(0);
   std::string                    camera_ = "camera.main";
   std::vector<std::string>       tags_;
   FrameBuffer::Type              type_ = FrameBuffer::kScreen;
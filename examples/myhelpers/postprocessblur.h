@@ -0,0 +1,139 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _POSTPROCESSBLUR_H_3546707B_78F1_4D6E_9CE3_4F65FD950CC3_
+#define _POSTPROCESSBLUR_H_3546707B_78F1_4D6E_9CE3_4F65FD950CC3_ 
+
+////////////////////////////////////////////////////////////////////////////
+// Blur on the half resolution chain, the BlurChain stages appended to 
+// the postprocess pipeline.
+//
+// Usage:
+//  BlurChain blur(params, w, h);
+//  auto result = AddBlurChain(pp, blur, "blur.", "input.0");
+//  pp.Output(pp.GetStageNumber() - 1); // or more stages, the result last
+//
+// The source is a stage tag or "input.N", empty - the previous stage.
+// Returns the result stage tag, it is the last stage added.
+////////////////////////////////////////////////////////////////////////////
+struct BlurChainUniform: public Action {
+  BlurChain::StageType        type;
+  glm::vec2                   texel;
+  std::vector<BlurChain::Tap> taps;
+  BlurChain::Params           params;
+
+  BlurChainUniform(std::shared_ptr<Transformation> transform, 
+                   BlurChain::StageType a_type, glm::vec2 a_texel, 
+                   const BlurChain& chain)
+    :  Action(transform), type(a_type), texel(a_texel), 
+       taps(chain.GetTaps()), params(chain.GetParams()) {}
+
+  void PreDraw() override {
+    auto m = transform->GetActor().GetComponent<Material>();
+    if (!m) {
+      return;
+    }
+    switch (type) {
+      case BlurChain::kDownsample:
+        m->SetUniform("source_texel", texel);
+        m->SetUniform("threshold", params.threshold);
+        break;
+      case BlurChain::kBlurH:
+      case BlurChain::kBlurV:
+        m->SetUniform("texel_step", texel);
+        m->SetUniform("n_taps", (int)taps.size());
+        for (size_t i = 0; i < taps.size(); ++i) {
+          std::string tap = "taps[" + std::to_string(i) + "].";
+          m->SetUniform(tap + "offset", taps[i].offset);
+          m->SetUniform(tap + "weight", taps[i].weight);
+        }
+        break;
+      case BlurChain::kUpsample:
+        m->SetUniform("coarse_texel", texel);
+        m->SetUniform("scatter", params.scatter);
+        break;
+    }
+  }
+};
+
+inline std::string AddBlurChain(PostprocessPipeline& pp, 
+                                const BlurChain& chain,
+                                const std::string& prefix, 
+                                const std::string& source = "") {
+  using TagLs = PostprocessPipeline::TagLs;
+  using glm::vec2;
+  auto& stages = chain.GetStages();
+  int levels = chain.GetParams().levels;
+  auto size = [&stages](int level) {
+    return vec2(stages.at(level).width, stages.at(level).height);
+  };
+
+  std::string result;
+  for (auto& stage: stages) {
+    std::string level = std::to_string(stage.level);
+    std::string tag = prefix + stage.name;
+    vec2 texel(0);
+    TagLs reads;
+    switch (stage.type) {
+      case BlurChain::kDownsample:
+        // The source is twice as big as the stage
+        texel = 0.5f / size(stage.level);
+        if (stage.level > 0) {
+          reads = TagLs{prefix + "down" + std::to_string(stage.level - 1)};
+        } else if (!source.empty()) {
+          reads = TagLs{source};
+        }
+        break;
+      case BlurChain::kBlurH:
+        texel = vec2(1, 0) / size(stage.level);
+        reads = TagLs{prefix + "down" + level};
+        break;
+      case BlurChain::kBlurV:
+        texel = vec2(0, 1) / size(stage.level);
+        reads = TagLs{prefix + "hblur" + level};
+        break;
+      case BlurChain::kUpsample: {
+        int coarse = stage.level + 1;
+        texel = 1.0f / size(coarse);
+        reads = TagLs{prefix + "vblur" + level, 
+                      coarse == levels - 1 ? 
+                        prefix + "vblur" + std::to_string(coarse) : 
+                        prefix + "up" + std::to_string(coarse)};
+        break;
+      }
+    }
+
+    const char* mtrl = stage.type == BlurChain::kDownsample ? 
+                         "downsample.mat" : 
+                       stage.type == BlurChain::kUpsample ? 
+                         "upsample_combine.mat" : 
+                         "blur_linear.mat";
+    pp . Stage(tag, stage.width, stage.height, mtrl, reads)
+       . Action<BlurChainUniform>(stage.type, texel, chain);
+    result = tag;
+  }
+  return result;
+}
+
+#endif // _POSTPROCESSBLUR_H_3546707B_78F1_4D6E_9CE3_4F65FD950CC3_
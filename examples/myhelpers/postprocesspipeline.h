@@ -27,7 +27,7 @@
 
 ////////////////////////////////////////////////////////////////////////////
 // Postprocessing pipeline. 
-// Takes multiple inputs and provide multiple color / depth inputs.
+// Takes multiple inputs and provide multiple color outputs.
 // Between the stages uses only 0 color attachment for I/O.
 // I[...] -> A -> B -> C -> .... -> Final[...]
 //
@@ -43,12 +43,24 @@
 //  blur
 //    . Stage("vblur", w/8, h/8, "gauss_blur.mat")
 //    . Action<BlurUni>(w/8, h/8, vec2(0, 1));
+//  blur
+//    . Stage("combine", w, h, "combine.mat", TagLs{"input.0", "vblur"});
+//  blur.Output(0);
 //  blur.Done();
 //
 //  (...)
 //
 //  auto final_tex = blur.Tex();  // output of the final stage
-//  auto first_tex = blur.Tex(0); // output of the first stage
+//  auto first_tex = blur.Tex(0); // output of the first stage, see Output()
+//
+// A stage reads the previous stage by default (the inputs for the first 
+// one) or the listed stages and inputs ("input.N"), bound to the texture
+// slots in order.
+//
+// The stages are the passes of a RenderGraph: the stages nobody reads are 
+// culled and the textures of the dead stages are reused by the later ones
+// of the same size. So only the final stage and the Output() ones can be 
+// read after the pipeline. No depth layers, the stages draw a screen quad.
 //
 // It creates uniq names for tags out of stage names in order to prevent 
 // conflicts with other pipelines if they're using same stage name.
@@ -67,14 +79,20 @@ class PostprocessPipeline {
   // Getting stages/final results of the pipeline 
   ////////////////////////////////////////////////////////////////////////////
 
-  std::shared_ptr<Texture> Tex(int stage = kFinal, int layer = 0) {
-    if (stage == kFinal) stage = rt_ls_.size() - 1;
-    return Fb(stage)->GetLayerAsTexture(layer, Layer::kColor);
+  std::shared_ptr<Texture> Tex(int stage = kFinal) {
+    if (stage == kFinal) stage = stage_ls_.size() - 1;
+    if (!stage_ls_.at(stage).output) {
+      ABORT_F("Stage %d is recycled, see Output()", stage);
+    }
+    return graph_.GetTexture(stage_ls_.at(stage).tag);
   }
 
-  std::shared_ptr<Texture> Depth(int stage = kFinal) {
-    if (stage == kFinal) stage = rt_ls_.size() - 1;
-    return Fb(stage)->GetLayerAsTexture(0, Layer::kDepth);
+  const RenderGraph& Graph() const {
+    return graph_;
+  }
+
+  size_t GetStageNumber() const {
+    return stage_ls_.size();
   }
 
   ////////////////////////////////////////////////////////////////////////////
@@ -88,19 +106,23 @@ class PostprocessPipeline {
   }
 
   // Returns Cfg<Actor> reference in order to apply action
-  auto& Stage(std::string tag, int w, int h, std::string mtrl) { 
+  auto& Stage(std::string tag, int w, int h, std::string mtrl, 
+              const TagLs& reads = TagLs{}) { 
     auto it = alltags_.find(tag);
     if (it != alltags_.end()) {
       ABORT_F("Tag %s already exists!", tag.c_str());
     }
     alltags_.emplace(tag);
     auto idx = start_idx_ + stage_ls_.size();
+    TagLs stage_reads;
+    for (auto& read: reads) {
+      stage_reads.emplace_back(TgName(read));
+    }
     tag = TgName(tag);
     stage_ls_.emplace_back(
         StageInfo {
-        tag, w, h, MtName(mtrl),
-        Cfg<RenderTarget>(scene_, RtName(idx, tag), idx),
-        Cfg<Actor>       (scene_, AcName(idx, tag))
+        tag, w, h, MtName(mtrl), stage_reads, false,
+        Cfg<Actor>(scene_, AcName(idx, tag))
         });
     return stage_ls_.back().dcfg;
   }
@@ -110,39 +132,50 @@ class PostprocessPipeline {
     Find(TgName(tag)).dcfg.template Action<T>(std::forward<TArgs>(args)...);
   }
 
-  // For reconfiguration if necessary
-  Cfg<RenderTarget>& rcfg(const std::string& tag) {
-    return Find(TgName(tag)).rcfg;
-  }
-
   Cfg<Actor>& dcfg(const std::string& tag) {
     return Find(TgName(tag)).dcfg;
   }
 
+  // The stage output is read after the pipeline, it is not recycled
+  void Output(int stage) {
+    stage_ls_.at(stage).output = true;
+  }
+
   void Done() {
     assert(!input_.empty());
     assert(!stage_ls_.empty());
+    stage_ls_.back().output = true;
+
+    for (int slot = 0; slot < input_.size(); slot++) {
+      graph_.Import(TgName("input." + std::to_string(slot)), input_[slot]);
+    }
+
     // python like enumerate? for range-based loop? 
     for (int i = 0; i < stage_ls_.size(); i++) {
       auto& s = stage_ls_[i];
+      if (s.reads.empty()) {
+        s.reads = GetInput(i);
+      }
+      RenderGraph::Resource resource;
+      resource.width = s.w;
+      resource.height = s.h;
+      graph_.AddResource(s.tag, resource);
+      graph_.AddPass({s.tag, s.reads, TagLs{s.tag}, TagLs{s.tag}});
+      if (s.output) {
+        graph_.Output(s.tag);
+      }
+    }
+    graph_.Compile();
+    graph_.Build(scene_, start_idx_);
 
-      // RT
-      s.rcfg . Tags       (s.tag)
-             . Type       (FrameBuffer::kTexture2D)
-             . Resolution (s.w, s.h)
-             . Layer      (Layer::kColor, Layer::kReadWrite) 
-             . Layer      (Layer::kDepth, Layer::kWrite)    
-             . Clear      (.4, .4, .4, 1);
-      s.rcfg . Done();
-      rt_ls_.emplace_back(s.rcfg.GetClient());
-
+    // Display
+    for (auto& s: stage_ls_) {
       s.dcfg . Model("assets/models/screen.dsm", s.mtrl)
              . Tags (0, TagLs{s.tag});
-
-      // Display
-      auto input = GetInput(i);
-      for (int slot = 0; slot < input.size(); slot++) {
-        s.dcfg.Texture(slot, input[slot]);
+      if (!graph_.IsCulled(s.tag)) {
+        for (int slot = 0; slot < s.reads.size(); slot++) {
+          s.dcfg.Texture(slot, graph_.GetTexture(s.reads[slot]));
+        }
       }
       s.dcfg . Done();
     }
@@ -153,24 +186,12 @@ class PostprocessPipeline {
     std::string tag;
     int w, h;
     std::string mtrl;
-    Cfg<RenderTarget> rcfg; 
-    Cfg<Actor>        dcfg;
+    TagLs       reads;
+    bool        output;
+    Cfg<Actor>  dcfg;
   };
 
   using StageLs = std::vector<StageInfo>;
-  using FbPtr = std::shared_ptr<FrameBuffer>;
-  using RtPtr = std::shared_ptr<RenderTarget>;
-  using RtLs = std::vector<RtPtr>;
-
-  inline RtPtr Rt(int stage) const {
-    return rt_ls_.at(stage);
-  }
-
-  inline FbPtr Fb(int stage) const {
-    auto fb = Rt(stage)->GetFrameBuffer();
-    assert(fb);
-    return fb;
-  }
 
   inline StageInfo& Find(const std::string& tag) {
     auto it = std::find_if(
@@ -181,10 +202,6 @@ class PostprocessPipeline {
     return *it;
   }
 
-  inline std::string RtName(int idx, const std::string& tag) const {
-    return "rt." + std::to_string(idx) + "." + tag;
-  }
-
   inline std::string AcName(int idx, const std::string& tag) const {
     return "actor.display." + std::to_string(idx) + "." + tag;
   }
@@ -200,17 +217,21 @@ class PostprocessPipeline {
     return mat;
   }
   
-  TexLs GetInput(int stage) {
+  TagLs GetInput(int stage) {
     assert(stage >= 0);
     if (stage == 0) {
-      return input_;
+      TagLs inputs;
+      for (int slot = 0; slot < input_.size(); slot++) {
+        inputs.emplace_back(TgName("input." + std::to_string(slot)));
+      }
+      return inputs;
     }
-    return TexLs{Fb(stage-1)->GetLayerAsTexture(0, Layer::kColor)};
+    return TagLs{stage_ls_[stage-1].tag};
   }
 
   Scene&      scene_;
   std::string mtrl_path_;
-  RtLs        rt_ls_;
+  RenderGraph graph_;
   TexLs       input_;
   StageLs     stage_ls_;
   int         start_idx_ = 0;
@@ -32,7 +32,7 @@ struct Lifetime : public Action {
     : Action(t), life(l) {}
 
   void Update() override {
-    life -= GetTimer().GetTimeDelta();
+    life -= GetDeltaTime();
     if (life <= 0) {
       GetActor().Die();
     }
@@ -46,7 +46,7 @@ struct Spawner : public Action {
     : Action(t), timeout(Math::Random(1, 3)) {}
 
   void Update() override {
-    timeout -= GetTimer().GetTimeDelta();
+    timeout -= GetDeltaTime();
       //std::cerr << timeout << std::endl;
     if (timeout < 0) {
       //std::cerr << "yay!" << std::endl;
@@ -70,6 +70,7 @@ int main(int argc, char* argv[]) {
     . Perspective(60, (float)width/height, .1, 1500)
     . Position(0, 1, 4)
     . Action<FlyingCameraController>(20)
+    . Action<Picker>(scene)
     . Done();
   
   // Shadowmap camera
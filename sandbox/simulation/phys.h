@@ -25,12 +25,9 @@
 #ifndef _PHYS_H_82BF7FBE_D775_4DF8_9E24_6F20DB5D20A0_
 #define _PHYS_H_82BF7FBE_D775_4DF8_9E24_6F20DB5D20A0_ 
 
-namespace Phys {
+#include "phys/sweepandprune.h"
 
-struct Aabb {
-  glm::vec3 min;
-  glm::vec3 max;
-};
+namespace Phys {
 
 template <typename T, typename U>
 bool CheckCollision(const T&, const U&);
@@ -90,7 +87,15 @@ class SimulationPipeline {
   void UpdateWorldAabb() {}
 
   // Select pairs whose AABBs intersetcs
-  void BroadPhase() {}
+  void BroadPhase() {
+    for (size_t i = broadphase_.GetBodyCount(); i < world_aabb_ls_.size(); ++i) {
+      broadphase_.Add(world_aabb_ls_[i]);
+    }
+    for (size_t i = 0; i < world_aabb_ls_.size(); ++i) {
+      broadphase_.Update(i, world_aabb_ls_[i]);
+    }
+    pair_ls_ = broadphase_.FindPairs();
+  }
 
   // Calculates collisions information for each pair
   // such as normal, penetration, etc
@@ -105,6 +110,8 @@ class SimulationPipeline {
  private:
   std::vector<RigidBody3D> body_ls_;
   std::vector<Aabb>        world_aabb_ls_;
+  SweepAndPrune            broadphase_;
+  std::vector<SweepAndPrune::Pair> pair_ls_;
 };
 
 } // namespace Phys::
@@ -72,7 +72,7 @@ struct SetWaterSurfaceUniform: public Action {
     : Action(transform) {}
 
   void Update() override {
-    wave_moving_factor += wave_speed * GetTimer().GetTimeDelta();
+    wave_moving_factor += wave_speed * GetDeltaTime();
     if (wave_moving_factor > 1) {
       wave_moving_factor = 0;
     }
@@ -41,6 +41,12 @@ class Action {
     return transform;
   }
 
+  // The time since the previous Update() of the action: the frame time, or
+  // more for the actors which do not tick every frame (see Actor::SetTickInterval)
+  float GetDeltaTime() const {
+    return delta_time_;
+  }
+
  protected:
 
   auto& GetActor() {
@@ -65,6 +71,11 @@ class Action {
   }
 
   std::shared_ptr<Transformation> transform; 
+
+ private:
+  friend class Actor;
+
+  float delta_time_ = 0;
 };
 
 #endif // _ACTION_H_4D405188_755B_4E9D_A7B6_8A2D3596AD4E_
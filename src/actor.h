@@ -31,6 +31,7 @@
 #include <memory>
 #include <string>
 #include <algorithm>
+#include <atomic>
 #include <map>
 #include <type_traits>
 #include "transformation.h"
@@ -51,7 +52,9 @@ class Actor {
   std::shared_ptr<Transformation> transform;
 
   explicit Actor(const std::string& name) : 
-    transform(new Transformation(*this)), name_(name), alive_(true) {
+    transform(new Transformation(*this)), name_(name), alive_(true),
+    active_(true), visible_(true), occluder_(false), 
+    tick_phase_(NextTickPhase()) {
     LOG_F(INFO, "Actor added: %s", GetName().c_str());
   }
 
@@ -79,11 +82,142 @@ class Actor {
   //   and draws.
   ////////////////////////////////////////////////////////////////////////////
 
-  bool IsVisible() const;
-  bool IsActive() const;
+  bool IsVisible() const {return IsActive() && visible_;}
+  bool IsActive() const {return alive_ && active_;}
   bool IsAlive() const {return alive_;}
-  bool IsStatic() const;
-  bool IsSuperStatic() const;
+  bool IsStatic() const {return static_;}
+  bool IsSuperStatic() const {return static_ && super_static_;}
+
+  void SetVisible(bool visible) {visible_ = visible;}
+  void SetActive(bool active) {active_ = active;}
+
+  ////////////////////////////////////////////////////////////////////////////
+  // Static actors (the buildings, the props) are started, but their actions
+  // do not tick. The world matrix and bounds are computed once and cached
+  // until the transform or one of its parents changes. The super static 
+  // ones do not even check that, they never move.
+  ////////////////////////////////////////////////////////////////////////////
+  void SetStatic(bool is_static, bool super_static = false) {
+    static_ = is_static;
+    super_static_ = super_static;
+    world_valid_ = false;
+  }
+
+  ////////////////////////////////////////////////////////////////////////////
+  // Sleeping actors do not tick either, until woken up by a change of the 
+  // transform (by someone else) or by WakeUp() (an event). With the auto 
+  // sleep the actor falls asleep after the given number of ticks which did
+  // not change its transform, 0 - never.
+  ////////////////////////////////////////////////////////////////////////////
+  void SetAutoSleep(int ticks) {
+    auto_sleep_ = ticks;
+    still_ticks_ = 0;
+  }
+
+  void Sleep() {
+    sleeping_ = true;
+    sleep_version_ = transform->GetVersion();
+    ResetDeltaTime();
+  }
+
+  void WakeUp() {
+    sleeping_ = false;
+    still_ticks_ = 0;
+    ResetDeltaTime();
+  }
+
+  bool IsSleeping() const {return sleeping_;}
+
+  // The last Update() ran the actions
+  bool HasTicked() const {return ticked_;}
+
+  ////////////////////////////////////////////////////////////////////////////
+  // Tick rate buckets: the actions tick every Update() (1), or every 2nd, 
+  // 4th, 8th... of them. The actors are staggered over the frames by the 
+  // order of creation, so a bucket costs the same every frame. The pinned 
+  // interval is not changed by the scene (see Scene::SetTickRates).
+  //
+  // Update() gets the frame time, the actions get the sum since their last 
+  // tick in Action::GetDeltaTime(). The time does not pass while the actor
+  // is inactive, static or asleep: the first tick after gets one frame.
+  // The actions integrating the time use GetDeltaTime(), the timer delta is 
+  // one frame and moves a bucketed actor n times slower.
+  ////////////////////////////////////////////////////////////////////////////
+  void SetTickInterval(int frames, bool pinned = true) {
+    if (frames < 1) {
+      ABORT_F("Invalid tick interval %d", frames);
+    }
+    tick_interval_ = frames;
+    tick_pinned_ = pinned;
+  }
+
+  int GetTickInterval() const {return tick_interval_;}
+  bool IsTickIntervalPinned() const {return tick_pinned_;}
+
+  // Drops the time since the last tick, when the actor was not updated for
+  // a while (see ScenePartition)
+  void ResetDeltaTime() {elapsed_ = 0;}
+
+  ////////////////////////////////////////////////////////////////////////////
+  // Occluders are rasterized into the occlusion buffer of the render 
+  // targets which do the occlusion culling, the rest is tested against it.
+  // Big and simple meshes (terrain, walls, buildings).
+  ////////////////////////////////////////////////////////////////////////////
+  void SetOccluder(bool occluder) { occluder_ = occluder; }
+  bool IsOccluder() const { return occluder_; }
+
+  ////////////////////////////////////////////////////////////////////////////
+  // World AABB around the model space bounds of the MeshFilter. False if 
+  // there are none, or the mesh is not where its vertices are (instancing,
+  // tesselation).
+  ////////////////////////////////////////////////////////////////////////////
+  bool GetWorldBounds(glm::vec3& min, glm::vec3& max) const {
+    if (static_ && world_valid_ && bounds_valid_ && 
+        (super_static_ || transform->GetVersion() == world_version_)) {
+      min = world_min_;
+      max = world_max_;
+      return true;
+    }
+
+    auto mesh_filter = dynamic_cast<const MeshFilter*>(mesh_filter_.get());
+    if (!mesh_renderer_ || mesh_renderer_->n_instances != 1 ||
+        mesh_renderer_->primitive == MeshRenderer::kPtPatches ||
+        !mesh_filter || !mesh_filter->GetBounds(min, max)) {
+      return false;
+    }
+
+    glm::mat4 model;
+    GetWorldMatrix(model);
+    glm::vec3 half = (max - min) * 0.5f;
+    glm::vec3 center(model * glm::vec4((min + max) * 0.5f, 1));
+    glm::vec3 extent = glm::abs(glm::vec3(model[0])) * half.x + 
+                       glm::abs(glm::vec3(model[1])) * half.y + 
+                       glm::abs(glm::vec3(model[2])) * half.z;
+    min = center - extent;
+    max = center + extent;
+    if (static_) {
+      world_min_ = min;
+      world_max_ = max;
+      bounds_valid_ = true;
+    }
+    return true;
+  }
+
+  // The transform matrix, cached for the static actors
+  void GetWorldMatrix(glm::mat4& model) const {
+    if (!static_) {
+      transform->GetMatrix(model);
+      return;
+    }
+    if (!world_valid_ || 
+        (!super_static_ && transform->GetVersion() != world_version_)) {
+      world_version_ = transform->GetVersion();
+      transform->GetMatrix(world_);
+      world_valid_ = true;
+      bounds_valid_ = false;
+    }
+    model = world_;
+  }
 
   void Die() {
     alive_ = false;
@@ -101,7 +235,15 @@ class Actor {
     }
   }
 
-  virtual void Update() {
+  // dt - the frame time
+  virtual void Update(float dt) {
+    ticked_ = false;
+    if (!IsActive()) {
+      elapsed_ = 0;
+      return;
+    }
+    uint32_t tick = tick_count_++;
+
     if (!actions_remove_queue_.empty()) {
       for (auto id: actions_remove_queue_) {
         actions_start_queue_.erase(id);
@@ -116,9 +258,37 @@ class Actor {
       actions_start_queue_.clear();
     }
 
+    if (static_) {
+      elapsed_ = 0;
+      return;
+    }
+    if (sleeping_) {
+      if (transform->GetVersion() == sleep_version_) {
+        return;
+      }
+      WakeUp();
+    }
+    elapsed_ += dt;
+    if ((tick + tick_phase_) % tick_interval_ != 0) {
+      return;
+    }
+
     for (auto& kv: actions_) {
+      kv.second->delta_time_ = elapsed_;
       kv.second->Update();
     }
+    elapsed_ = 0;
+    ticked_ = true;
+
+    // Still since the last tick
+    if (auto_sleep_ > 0) {
+      uint64_t version = transform->GetVersion();
+      still_ticks_ = version == last_version_ ? still_ticks_ + 1 : 0;
+      last_version_ = version;
+      if (still_ticks_ >= auto_sleep_) {
+        Sleep();
+      }
+    }
   }
 
   virtual void PreDraw() {
@@ -222,6 +392,11 @@ class Actor {
 
 
  private: 
+  static uint32_t NextTickPhase() {
+    static std::atomic<uint32_t> counter(0);
+    return counter.fetch_add(1, std::memory_order_relaxed);
+  }
+
   using ActionPtr = std::shared_ptr<Action>;
   using ActionId  = std::size_t;
 
@@ -236,6 +411,32 @@ class Actor {
   glm::vec4                        extra_;
 
   bool                             alive_;
+  bool                             active_;
+  bool                             visible_;
+  bool                             occluder_;
+
+  bool                             static_ = false;
+  bool                             super_static_ = false;
+  bool                             sleeping_ = false;
+  bool                             ticked_ = false;
+  int                              auto_sleep_ = 0;
+  int                              still_ticks_ = 0;
+  uint64_t                         sleep_version_ = 0;
+  uint64_t                         last_version_ = 0;
+
+  int                              tick_interval_ = 1;
+  bool                             tick_pinned_ = false;
+  uint32_t                         tick_phase_;
+  uint32_t                         tick_count_ = 0;
+  float                            elapsed_ = 0; // Since the last tick
+
+  // The static actors' cache
+  mutable glm::mat4                world_;
+  mutable glm::vec3                world_min_;
+  mutable glm::vec3                world_max_;
+  mutable uint64_t                 world_version_ = 0;
+  mutable bool                     world_valid_ = false;
+  mutable bool                     bounds_valid_ = false;
 };
 
 #include "actor.inl"
@@ -33,6 +33,7 @@ inline auto Actor::AddComponent(TArgs&&... args) {
     //
     mesh_renderer_ = std::make_shared<MeshRenderer>(
         std::forward<TArgs>(args)...);
+    bounds_valid_ = false;
 
     return mesh_renderer_;
   } else 
@@ -44,6 +45,7 @@ inline auto Actor::AddComponent(TArgs&&... args) {
         std::forward<TArgs>(args)...);
 
     mesh_filter_ = ptr;
+    bounds_valid_ = false;
 
     return ptr;
   } else {
@@ -108,12 +110,14 @@ inline void Actor::SetComponent(std::shared_ptr<TComponent> component) {
     // MeshRenderer
     //
     mesh_renderer_ = component; 
+    bounds_valid_ = false;
   } else 
   if constexpr (std::is_base_of<MeshFilterBase, TComponent>::value) {
     //
     // MeshFilter
     //
     mesh_filter_ = component;
+    bounds_valid_ = false;
   } else {
     //
     // None of above 
@@ -93,7 +93,7 @@ namespace StdBatch {
     template <typename TActor>
       static void Update(TActor* a, DataType* data) {
         assert(a && data);
-        a->transform->GetMatrix(*data);
+        a->GetWorldMatrix(*data);
         // Pack extra information to the bottom row, shader will
         // replace it for the matrix by 0 0 0 1
         a->GetExtra( (*data)[0][3], 
@@ -69,6 +69,10 @@ class TActorPool : public Actor {
       actor->transform->SetLocalPosition(0, 0, 0);
       actor->transform->SetLocalEulerAngles(0, 0, 0);
       actor->transform->SetLocalScale(1, 1, 1);
+      // Nothing left from the previous life
+      actor->SetStatic(false);
+      actor->SetAutoSleep(0);
+      actor->WakeUp();
       actor->Alive();
 
       alive_.splice(alive_.end(), dead_, --dead_.end());
@@ -89,8 +93,8 @@ class TActorPool : public Actor {
     dead_.splice(dead_.end(), alive_);
   }
 
-  void Update() override {
-    Actor::Update();
+  void Update(float dt) override {
+    Actor::Update(dt);
 
     for (auto it = alive_.begin(); it != alive_.end(); ++it) {
       auto a = *it;
@@ -23,8 +23,40 @@
 //
 
 #include "appcontext.h"
+#include <iostream>
 
 //////////////////////////////////////////////////////////////////////////////
 // Yeah, this is C++ 
 //////////////////////////////////////////////////////////////////////////////
 AppContext* AppContext::instance = nullptr;
+
+void AppContext::StartReplay(const Replay& settings) {
+  replay = settings;
+  timer.SetFixedStep(replay.fixed_step);
+  if (!replay.input_play.empty()) {
+    InputTrack track;
+    track.Load(replay.input_play);
+    input.Play(std::move(track));
+  } else if (!replay.input_record.empty()) {
+    input.Record();
+  }
+  if (replay.IsMeasured()) {
+    frame_stats.reset(new FrameStats(replay.warmup));
+  }
+}
+
+void AppContext::FinishReplay() {
+  if (!replay.input_record.empty()) {
+    input.GetTrack().Save(replay.input_record);
+    LOG_F(INFO, "Input of %zu frames recorded to %s", 
+          input.GetTrack().GetLength(), replay.input_record.c_str());
+  }
+  if (!frame_stats) {
+    return;
+  }
+
+  frame_stats->PrintSummary(std::cerr);
+  if (!replay.report.empty()) {
+    frame_stats->WriteReport(replay.report, display.GetCaption());
+  }
+}
@@ -29,7 +29,11 @@
 #include "display.h"
 #include "input.h"
 #include "timer.h"
+#include "framestats.h"
+#include "replay.h"
 #include "common/logging.h"
+#include "profiler.h"
+#include <memory>
 #include <string>
 #include <exception>
 
@@ -42,6 +46,10 @@ class AppContext {
   Display display;
   Input   input;
   Timer   timer;
+  Replay  replay;
+
+  // Only for the measured runs, see Replay
+  std::unique_ptr<FrameStats> frame_stats;
 
   static AppContext& Instance() {
     if (!instance) {
@@ -50,15 +58,24 @@ class AppContext {
     return *instance;
   }
 
-  static void Init(int width, int height, std::string caption, const Profile& profile) {
+  // Headless - no visible window, see Display. The environment may turn
+  // it on too, see Replay.
+  static void Init(int width, int height, std::string caption, 
+                   const Profile& profile, bool headless = false) {
     if (instance) {
       ABORT_F("AppContext already initialized");
     }
-    instance = new AppContext(width, height, std::move(caption), profile);
+    Replay replay = Replay::FromEnvironment();
+    instance = new AppContext(width, height, std::move(caption), profile, 
+                              headless || replay.headless);
     instance->input.Init();
+    instance->StartReplay(replay);
   }
 
   static void Close() {
+    if (instance) {
+      instance->FinishReplay();
+    }
     delete instance;
     instance = nullptr;
   }
@@ -66,26 +83,52 @@ class AppContext {
   static bool Running() {
     auto& app = AppContext::Instance();
     auto window = app.display.GetWindow();
+    if (app.replay.frames > 0 && 
+        app.timer.GetFrameNumber() >= app.replay.frames) {
+      return false;
+    }
     return !app.input.GetKey(GLFW_KEY_ESCAPE) && glfwWindowShouldClose(window) == 0;
   }
 
+  // Frame phase for the measured runs, see FrameStats
+  static void MarkFrame(FrameStats::Phase phase) {
+    if (instance && instance->frame_stats) {
+      instance->frame_stats->Mark(phase);
+    }
+  }
+
   ////////////////////////////////////////////////////////////////////////////
   // One call per frame!
   ////////////////////////////////////////////////////////////////////////////
   static void BeginFrame() {
+#ifdef B3D_PROFILING
+    Profiler::Instance().BeginFrame();
+#endif
+    if (AppContext::Instance().frame_stats) {
+      AppContext::Instance().frame_stats->BeginFrame();
+    }
     AppContext::Instance().timer.Tick();
     AppContext::Instance().input.Update();
+    MarkFrame(FrameStats::kInput);
   }
 
   static void EndFrame(bool swap = true) {
-    if (swap)
+    if (swap && !AppContext::Instance().display.IsHeadless())
       glfwSwapBuffers(AppContext::Instance().display.GetWindow());
     glfwPollEvents();
+#ifdef B3D_PROFILING
+    Profiler::Instance().EndFrame();
+#endif
+    if (AppContext::Instance().frame_stats) {
+      AppContext::Instance().frame_stats->Mark(FrameStats::kPresent);
+      AppContext::Instance().frame_stats->EndFrame();
+    }
   }
  
  private:
-  AppContext(int width, int height, std::string caption, const Profile& profile)
-    : display     (width, height, std::move(caption), profile),
+  AppContext(int width, int height, std::string caption, const Profile& profile,
+             bool headless)
+    : display     (width, height, std::move(caption), profile, headless),
       input       () {
     display.Init();
   }
@@ -94,6 +137,9 @@ class AppContext {
     display.Close();
   }
 
+  void StartReplay(const Replay& replay);
+  void FinishReplay();
+
   static AppContext* instance;
 };
 #endif // _APPCONTEXT_H_4B227517_B140_479C_BD2E_01283044D3DA_
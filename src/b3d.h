@@ -30,10 +30,32 @@
 #include "appcontext.h"
 #include "scene.h"
 #include "material/material_loader.h"
+#include "material/program_cache.h"
 #include "texture2d.h"
 #include "texture_cube.h"
+#include "texture_buffer.h"
 #include "image/loader.h"
 #include "meshloader.h"
+#include "gridmesh.h"
+#include "occlusionbuffer.h"
+#include "shadowcascades.h"
+#include "lightclusters.h"
+#include "clusteredlighting.h"
+#include "rendergraph.h"
+#include "blurchain.h"
+#include "framecapture.h"
+#include "frameloop.h"
+#include "profiler.h"
+#include "camerapath.h"
+#include "terrain/quadtree.h"
+#include "terrain/tiledmap.h"
+#include "terrain/chunkstreamer.h"
+#include "phys/sweepandprune.h"
+#include "phys/bvh.h"
+#include "looseoctree.h"
+#include "scenepartition.h"
+#include "portalgraph.h"
+#include "resourcecache.h"
 #include "meshfilter_raw.h"
 #include "common/debug.h"
 
@@ -0,0 +1,110 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "blurchain.h"
+#include "common/logging.h"
+#include <algorithm>
+#include <cmath>
+
+std::vector<float> BlurChain::ComputeKernel(int radius, float sigma) {
+  if (sigma <= 0) {
+    sigma = radius / 2.0f;
+  }
+  std::vector<float> kernel(2 * radius + 1);
+  float sum = 0;
+  for (int i = -radius; i <= radius; ++i) {
+    kernel[i + radius] = std::exp(-0.5f * i * i / (sigma * sigma));
+    sum += kernel[i + radius];
+  }
+  for (auto& weight: kernel) {
+    weight /= sum;
+  }
+  return kernel;
+}
+
+std::vector<BlurChain::Tap> BlurChain::ComputeTaps(int radius, float sigma) {
+  std::vector<float> kernel = ComputeKernel(radius, sigma);
+  const float* w = &kernel[radius];
+
+  // Pairs (1, 2), (3, 4)... the odd radius pairs the last one with 0
+  std::vector<Tap> taps;
+  taps.push_back({0, w[0]});
+  for (int i = 1; i <= radius; i += 2) {
+    float w0 = w[i];
+    float w1 = i + 1 <= radius ? w[i + 1] : 0;
+    float weight = w0 + w1;
+    taps.push_back({(i * w0 + (i + 1) * w1) / weight, weight});
+  }
+  return taps;
+}
+
+BlurChain::BlurChain(const Params& params, int width, int height)
+  : params_(params) {
+  if (params_.radius < 1 || params_.levels < 1 || width < 2 || height < 2) {
+    ABORT_F("Invalid blur chain radius %d, levels %d, %d x %d", 
+            params_.radius, params_.levels, width, height);
+  }
+  taps_ = ComputeTaps(params_.radius, params_.sigma);
+  if (taps_.size() > kMaxTaps) {
+    ABORT_F("Blur radius %d is too big", params_.radius);
+  }
+  const int blur_fetches = 2 * taps_.size() - 1;
+
+  std::vector<int> widths, heights;
+  for (int k = 0; k < params_.levels; ++k) {
+    width = std::max(1, width / 2);
+    height = std::max(1, height / 2);
+    widths.push_back(width);
+    heights.push_back(height);
+    stages_.push_back({"down" + std::to_string(k), kDownsample, k, 
+                       width, height, 4});
+  }
+  for (int k = params_.levels - 1; k >= 0; --k) {
+    std::string level = std::to_string(k);
+    stages_.push_back({"hblur" + level, kBlurH, k, widths[k], heights[k], 
+                       blur_fetches});
+    stages_.push_back({"vblur" + level, kBlurV, k, widths[k], heights[k], 
+                       blur_fetches});
+    if (k < params_.levels - 1) {
+      stages_.push_back({"up" + level, kUpsample, k, widths[k], heights[k], 
+                         5});
+    }
+  }
+}
+
+size_t BlurChain::GetShadedPixels() const {
+  size_t pixels = 0;
+  for (auto& stage: stages_) {
+    pixels += (size_t)stage.width * stage.height;
+  }
+  return pixels;
+}
+
+size_t BlurChain::GetTextureFetches() const {
+  size_t fetches = 0;
+  for (auto& stage: stages_) {
+    fetches += (size_t)stage.width * stage.height * stage.fetches;
+  }
+  return fetches;
+}
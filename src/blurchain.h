@@ -0,0 +1,106 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _BLURCHAIN_H_7619EFD1_754D_487F_A2E7_67E2C3B043FB_
+#define _BLURCHAIN_H_7619EFD1_754D_487F_A2E7_67E2C3B043FB_ 
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+// Blur / bloom on a progressive half resolution chain, the plan.
+//
+//  input -> down0 (1/2) -> down1 (1/4) -> ... -> down[levels-1]
+//  every level is blurred by the separable Gaussian (h + v) and combined 
+//  with the upsampled coarser result, from the coarsest level up:
+//  up[k] = mix(blur[k], upsample(up[k + 1]), scatter)
+//  The result is up0 at the half resolution.
+//
+// The kernel weights are computed here, with the linear sampling: one 
+// bilinear fetch at the weighted offset between two texels reads both of
+// them, so a radius r kernel takes 1 + 2 * ceil(r / 2) fetches.
+//
+// The stages are drawn by the postprocess materials (blur_linear.mat,
+// downsample.mat, upsample_combine.mat), see myhelpers/postprocessblur.h.
+//////////////////////////////////////////////////////////////////////////////
+class BlurChain {
+ public:
+  enum { kMaxTaps = 16 }; // one side + center, radius up to 30
+
+  struct Params {
+    int   radius    = 4;   // Gaussian radius in texels of a level
+    float sigma     = 0;   // 0 - radius / 2
+    int   levels    = 5;   // Downsample depth
+    float scatter   = 0.5; // Share of the coarser levels
+    float threshold = 0;   // Bloom: luma threshold of the first downsample
+  };
+
+  struct Tap {
+    float offset; // texels
+    float weight;
+  };
+
+  enum StageType {
+    kDownsample,
+    kBlurH,
+    kBlurV,
+    kUpsample
+  };
+
+  struct Stage {
+    std::string name;
+    StageType   type;
+    int         level;
+    int         width;
+    int         height;
+    int         fetches; // per pixel
+  };
+
+  // The discrete kernel, 2 * radius + 1 weights summing to 1
+  static std::vector<float> ComputeKernel(int radius, float sigma);
+
+  // The center tap and the positive offsets, the negative ones mirror them
+  static std::vector<Tap> ComputeTaps(int radius, float sigma);
+
+  // Input width x height
+  BlurChain(const Params& params, int width, int height);
+
+  const Params& GetParams() const { return params_; }
+  const std::vector<Tap>& GetTaps() const { return taps_; }
+
+  // In the execution order
+  const std::vector<Stage>& GetStages() const { return stages_; }
+
+  // Fill rate per frame
+  size_t GetShadedPixels() const;
+  size_t GetTextureFetches() const;
+
+ private:
+  Params             params_;
+  std::vector<Tap>   taps_;
+  std::vector<Stage> stages_;
+};
+
+#endif // _BLURCHAIN_H_7619EFD1_754D_487F_A2E7_67E2C3B043FB_
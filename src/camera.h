@@ -146,17 +146,49 @@ class Frustum {
     return true; // inside, or intersetcs
   }
 
- private:
+  enum Containment {kOutside, kIntersects, kInside};
+
+  // Same as TestAabb() but tells the boxes entirely inside, so the things
+  // inside of them need no more tests (hierarchies)
+  Containment ClassifyAabb(const glm::vec3 &mins, const glm::vec3 &maxs) const {
+    Containment result = kInside;
+    for (int i = 0; i < 6; ++i) {
+      const glm::vec4& plane = planes_[i];
+      glm::vec3 n(plane);
+      // The corners the farthest along and against the normal
+      glm::vec3 positive(n.x < 0 ? mins.x : maxs.x,
+                         n.y < 0 ? mins.y : maxs.y,
+                         n.z < 0 ? mins.z : maxs.z);
+      glm::vec3 negative(n.x < 0 ? maxs.x : mins.x,
+                         n.y < 0 ? maxs.y : mins.y,
+                         n.z < 0 ? maxs.z : mins.z);
+      if (glm::dot(n, positive) + plane.w < 0) {
+        return kOutside;
+      }
+      if (glm::dot(n, negative) + plane.w < 0) {
+        result = kIntersects;
+      }
+    }
+    return result;
+  }
+
   enum {
     kNear = 0,
     kFar,
     kTop,
     kBottom,
     kLeft,
-    kRight
+    kRight,
+    kPlanes
   };
 
-  glm::vec4 planes_[6];
+  // Faces inside, normalized as vec4
+  const glm::vec4& GetPlane(int i) const {
+    return planes_[i];
+  }
+
+ private:
+  glm::vec4 planes_[kPlanes];
 };
 
 class Camera : public Actor {
@@ -226,8 +258,8 @@ class Camera : public Actor {
     return  far_;
   }
 
-  void Update() override {
-    Actor::Update();
+  void Update(float dt) override {
+    Actor::Update(dt);
     glm::mat4 p, v;
     GetProjectionMatrix(p);
     GetViewMatrix(v);
@@ -0,0 +1,106 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "camerapath.h"
+#include "common/logging.h"
+#include "yaml_main.h"
+#include <algorithm>
+#include <cmath>
+
+void CameraPath::AddKey(const Key& key) {
+  if (!keys_.empty() && key.time <= keys_.back().time) {
+    ABORT_F("Camera path keys must go in time order");
+  }
+  keys_.push_back(key);
+}
+
+static glm::vec3 CatmullRom(const glm::vec3& p0, const glm::vec3& p1, 
+                            const glm::vec3& p2, const glm::vec3& p3, 
+                            float t) {
+  float t2 = t * t;
+  float t3 = t2 * t;
+  return 0.5f * ((2.0f * p1) + (-p0 + p2) * t + 
+                 (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + 
+                 (-p0 + 3.0f * p1 - 3.0f * p2 + p3) * t3);
+}
+
+void CameraPath::Sample(float time, glm::vec3& position, 
+                        glm::vec3& euler) const {
+  if (keys_.empty()) {
+    ABORT_F("Empty camera path");
+  }
+  float duration = GetDuration();
+  if (loop_ && duration > 0) {
+    time = std::fmod(time, duration);
+    if (time < 0) {
+      time += duration;
+    }
+  }
+  if (time <= keys_.front().time || keys_.size() == 1) {
+    position = keys_.front().position;
+    euler = keys_.front().euler;
+    return;
+  }
+  if (time >= duration) {
+    position = keys_.back().position;
+    euler = keys_.back().euler;
+    return;
+  }
+
+  // The segment [i, i + 1] with the time
+  auto it = std::upper_bound(keys_.begin(), keys_.end(), time, 
+      [](float t, const Key& key) { return t < key.time; });
+  int i = (int)(it - keys_.begin()) - 1;
+  int last = (int)keys_.size() - 1;
+  const Key& k0 = keys_[std::max(i - 1, 0)];
+  const Key& k1 = keys_[i];
+  const Key& k2 = keys_[i + 1];
+  const Key& k3 = keys_[std::min(i + 2, last)];
+
+  float t = (time - k1.time) / (k2.time - k1.time);
+  position = CatmullRom(k0.position, k1.position, k2.position, k3.position, t);
+  euler = glm::mix(k1.euler, k2.euler, t);
+}
+
+CameraPath CameraPath::Load(const std::string& filename) {
+  YAML::Node root = YAML::LoadFile(filename);
+  CameraPath path;
+  if (root["loop"]) {
+    path.SetLoop(root["loop"].as<bool>());
+  }
+  for (auto node: root["keys"]) {
+    auto position = node["position"].as<std::vector<float>>();
+    auto euler = node["euler"].as<std::vector<float>>();
+    if (position.size() != 3 || euler.size() != 3) {
+      ABORT_F("Bad camera path key in %s", filename.c_str());
+    }
+    path.AddKey({node["time"].as<float>(), 
+                 glm::vec3(position[0], position[1], position[2]),
+                 glm::vec3(euler[0], euler[1], euler[2])});
+  }
+  if (path.keys_.empty()) {
+    ABORT_F("Camera path must have at least one key %s", filename.c_str());
+  }
+  return path;
+}
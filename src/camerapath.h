@@ -0,0 +1,71 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _CAMERAPATH_H_D945CF59_1AE8_470F_BDB5_6E6B27EB8680_
+#define _CAMERAPATH_H_D945CF59_1AE8_470F_BDB5_6E6B27EB8680_ 
+
+#include "glm_main.h"
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+// Scripted camera flight for the reproducible runs: keys of the position 
+// and the euler angles (degrees, as Transformation) in time. The positions
+// are a Catmull-Rom spline through the keys, the angles are interpolated 
+// linearly. A looped path wraps the time around the last key.
+//
+// YAML, like the materials:
+//  loop: on
+//  keys:
+//    - {time: 0, position: [0, 3, 3], euler: [-30, 0, 0]}
+//    - {time: 4, position: [3, 3, 0], euler: [-30, 90, 0]}
+//
+// See CameraPathController in the examples.
+//////////////////////////////////////////////////////////////////////////////
+class CameraPath {
+ public:
+  struct Key {
+    float     time;
+    glm::vec3 position;
+    glm::vec3 euler;
+  };
+
+  // The keys go in time order
+  void AddKey(const Key& key);
+  void SetLoop(bool loop) { loop_ = loop; }
+  bool IsLoop() const { return loop_; }
+
+  float GetDuration() const { return keys_.empty() ? 0 : keys_.back().time; }
+  size_t GetKeyCount() const { return keys_.size(); }
+
+  void Sample(float time, glm::vec3& position, glm::vec3& euler) const;
+
+  static CameraPath Load(const std::string& filename);
+
+ private:
+  std::vector<Key> keys_;
+  bool             loop_ = false;
+};
+
+#endif // _CAMERAPATH_H_D945CF59_1AE8_470F_BDB5_6E6B27EB8680_
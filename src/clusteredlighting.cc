@@ -0,0 +1,94 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "clusteredlighting.h"
+#include "camera.h"
+#include "material/pass.h"
+#include <cmath>
+
+ClusteredLighting::ClusteredLighting(const LightClusters::Params& params)
+  : clusters_(params),
+    lights_buffer_(TextureBuffer::kRgba32f),
+    clusters_buffer_(TextureBuffer::kRg32ui),
+    indices_buffer_(TextureBuffer::kR32ui),
+    grid_(0),
+    depth_(0) {
+}
+
+void ClusteredLighting::Update(
+    const std::vector<std::shared_ptr<Light>>& lights, const Camera& camera) {
+  cluster_lights_.resize(lights.size());
+  light_texels_.resize(4 * lights.size());
+  for (size_t i = 0; i < lights.size(); ++i) {
+    const Light& light = *lights[i];
+    bool spot = light.GetType() == Light::kSpot;
+    float half_angle = glm::radians(light.GetSpotAngle() * 0.5f);
+
+    LightClusters::Light& cluster_light = cluster_lights_[i];
+    cluster_light.position = light.GetPosition();
+    cluster_light.range = light.GetRange();
+    cluster_light.direction = light.GetDirection();
+    cluster_light.spot_angle = spot ? half_angle : 0;
+
+    glm::vec4* texels = &light_texels_[4 * i];
+    texels[0] = glm::vec4(cluster_light.position, cluster_light.range);
+    texels[1] = glm::vec4(glm::vec3(light.GetColor()) * light.GetIntensity(),
+                          spot ? std::cos(half_angle) : -1);
+    texels[2] = glm::vec4(cluster_light.direction, 0);
+    texels[3] = glm::vec4(light.GetAttenuation(), 0);
+  }
+
+  glm::mat4 view, proj;
+  camera.GetViewMatrix(view);
+  camera.GetProjectionMatrix(proj);
+  float near = camera.GetNear();
+  float far = camera.GetFar();
+  clusters_.Bin(cluster_lights_, view, proj, near, far);
+
+  lights_buffer_.SetData(light_texels_.data(), light_texels_.size());
+  clusters_buffer_.SetData(clusters_.GetClusters().data(), 
+                           clusters_.GetClusters().size());
+  indices_buffer_.SetData(clusters_.GetIndices().data(), 
+                          clusters_.GetIndices().size());
+
+  auto& params = clusters_.GetParams();
+  grid_ = glm::vec4(params.grid_x, params.grid_y, params.grid_z, lights.size());
+  depth_ = glm::vec2(near, params.grid_z / std::log(far / near));
+}
+
+void ClusteredLighting::Bind() {
+  lights_buffer_.Bind(kLightsSlot);
+  clusters_buffer_.Bind(kClustersSlot);
+  indices_buffer_.Bind(kIndicesSlot);
+}
+
+void ClusteredLighting::Unbind() {
+  lights_buffer_.Unbind(kLightsSlot);
+  clusters_buffer_.Unbind(kClustersSlot);
+  indices_buffer_.Unbind(kIndicesSlot);
+}
+
+void ClusteredLighting::SetUniforms(Pass& pass) const {
+  pass.SuClusters(kLightsSlot, kClustersSlot, kIndicesSlot, grid_, depth_);
+}
@@ -0,0 +1,89 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _CLUSTEREDLIGHTING_H_EA334F33_5937_4B83_9182_DB99FFD862C9_
+#define _CLUSTEREDLIGHTING_H_EA334F33_5937_4B83_9182_DB99FFD862C9_ 
+
+#include "lightclusters.h"
+#include "texture_buffer.h"
+#include "light.h"
+#include <memory>
+#include <vector>
+
+class Camera;
+class Pass;
+
+//////////////////////////////////////////////////////////////////////////////
+// Clustered forward lighting, the GL part. Bins the point and spot lights 
+// of the scene with LightClusters and uploads them to the buffer textures 
+// bound to the reserved texture units 29..31 (the materials should not use
+// TEXTURE_29..31 then):
+//
+//  - SU_CLUSTER_LIGHTS   samplerBuffer,  4 texels per light:
+//                        position, range | color * intensity, cos(half angle)
+//                        direction, 0    | attenuation, 0
+//                        cos = -1 for the point lights
+//  - SU_CLUSTER_CLUSTERS usamplerBuffer, offset and count per cluster
+//  - SU_CLUSTER_INDICES  usamplerBuffer, light indices
+//  - SU_CLUSTER_GRID     vec4 grid x, y, z, total lights
+//  - SU_CLUSTER_DEPTH    vec2 near, grid z / log(far / near)
+//
+// The cluster of a fragment (see assets/materials/clustered_lighting.mat):
+//   tile  = floor((ndc.xy * 0.5 + 0.5) * grid.xy)
+//   slice = floor(log(view_depth / near) * grid z / log(far / near))
+//
+// Enabled per render target, see RenderTarget::SetClusteredLighting().
+//////////////////////////////////////////////////////////////////////////////
+class ClusteredLighting {
+ public:
+  enum {
+    kLightsSlot   = 29,
+    kClustersSlot = 30,
+    kIndicesSlot  = 31
+  };
+
+  explicit ClusteredLighting(const LightClusters::Params& params);
+
+  void Update(const std::vector<std::shared_ptr<Light>>& lights, 
+              const Camera& camera);
+
+  void Bind();
+  void Unbind();
+
+  void SetUniforms(Pass& pass) const;
+
+  const LightClusters& GetClusters() const { return clusters_; }
+
+ private:
+  LightClusters                     clusters_;
+  std::vector<LightClusters::Light> cluster_lights_;
+  std::vector<glm::vec4>            light_texels_;
+  TextureBuffer                     lights_buffer_;
+  TextureBuffer                     clusters_buffer_;
+  TextureBuffer                     indices_buffer_;
+  glm::vec4                         grid_;
+  glm::vec2                         depth_;
+};
+
+#endif // _CLUSTEREDLIGHTING_H_EA334F33_5937_4B83_9182_DB99FFD862C9_
@@ -64,6 +64,7 @@ class Array2d {
   size_t GetHeight() const { return height_; }
   size_t GetLength() const { return width_ * height_; }
   const T* GetArray() const { return &array_.at(0); }
+  T* GetArray() { return &array_.at(0); }
 
  private:
   size_t Index(size_t x, size_t y) const {
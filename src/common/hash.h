@@ -0,0 +1,80 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _HASH_H_592C2047_2DFC_4800_BDEF_B5D9796DA6FD_
+#define _HASH_H_592C2047_2DFC_4800_BDEF_B5D9796DA6FD_ 
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+//////////////////////////////////////////////////////////////////////////////
+// FNV-1a 64 bit. Stable between runs and platforms (unlike std::hash), so
+// it can be used for keys which end up on disk.
+//////////////////////////////////////////////////////////////////////////////
+class Hash64 {
+ public:
+  Hash64() : value_(kOffsetBasis) {}
+
+  Hash64& Add(const void* data, size_t size) {
+    auto bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+      value_ ^= bytes[i];
+      value_ *= kPrime;
+    }
+    return *this;
+  }
+
+  Hash64& Add(const std::string& s) {
+    // Length goes first, so "ab"+"c" and "a"+"bc" are different
+    uint64_t len = s.size();
+    Add(&len, sizeof(len));
+    return Add(s.data(), s.size());
+  }
+
+  Hash64& Add(uint64_t v) {
+    return Add(&v, sizeof(v));
+  }
+
+  uint64_t Get() const { return value_; }
+
+  std::string ToString() const {
+    static const char kHex[] = "0123456789abcdef";
+    std::string s(16, '0');
+    for (int i = 0; i < 16; ++i) {
+      s[15 - i] = kHex[(value_ >> (i * 4)) & 0xf];
+    }
+    return s;
+  }
+
+ private:
+  enum : uint64_t {
+    kOffsetBasis = 14695981039346656037ull,
+    kPrime       = 1099511628211ull
+  };
+
+  uint64_t value_;
+};
+
+#endif // _HASH_H_592C2047_2DFC_4800_BDEF_B5D9796DA6FD_
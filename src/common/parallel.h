@@ -0,0 +1,75 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _PARALLEL_H_4103784C_B414_464C_A1E4_5832D1937C96_
+#define _PARALLEL_H_4103784C_B414_464C_A1E4_5832D1937C96_ 
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+// Splits [begin, end) into equal bands and calls func(band_begin, band_end)
+// for each one on its own thread, the calling thread takes the last band.
+// n_threads = 0 uses all the cores. Returns when all the bands are done.
+//
+// ParallelFor(0, height, 0, [&](int row_begin, int row_end) {
+//   ...
+// });
+//////////////////////////////////////////////////////////////////////////////
+template <typename TFunc>
+void ParallelFor(int begin, int end, int n_threads, TFunc&& func) {
+  int n = end - begin;
+  if (n <= 0) {
+    return;
+  }
+
+  if (n_threads <= 0) {
+    n_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  n_threads = std::min(n_threads, n);
+
+  if (n_threads == 1) {
+    func(begin, end);
+    return;
+  }
+
+  std::vector<std::thread> workers;
+  int band = (n + n_threads - 1) / n_threads;
+  for (int band_begin = begin; band_begin < end; band_begin += band) {
+    int band_end = std::min(end, band_begin + band);
+    if (band_end == end) {
+      func(band_begin, band_end);
+    } else {
+      workers.emplace_back([&func, band_begin, band_end]() {
+        func(band_begin, band_end);
+      });
+    }
+  }
+  for (auto& worker: workers) {
+    worker.join();
+  }
+}
+
+#endif // _PARALLEL_H_4103784C_B414_464C_A1E4_5832D1937C96_
@@ -42,9 +42,12 @@ struct Profile {
   int                      major_version;
   int                      minore_version;
   int                      profile;
+  int                      context_api;
   ////////////////////////////////////////////////////////////////////////////
-  // Comma-separated OpenGL version-profile
+  // Comma-separated OpenGL version-profile[-context api]
   // "4 5 core", "2 0 compatibility", "3 3 any", etc
+  // The context api is native by default, "3 3 core egl" or 
+  // "3 3 core osmesa" (Mesa llvmpipe, no GPU) for the headless rendering
   ////////////////////////////////////////////////////////////////////////////
   explicit Profile(const std::string& ctxt_as_str) {
     std::istringstream iss(ctxt_as_str);
@@ -53,7 +56,7 @@ struct Profile {
     // Since case insensitive string comparison is super cumbersome in std C++
     // and there are no one-two line solutions for this - the profile is
     // required to be in lower case for now.
-    if (tokens.size() != 3) {
+    if (tokens.size() != 3 && tokens.size() != 4) {
       ABORT_F("Invalid profile %s", ctxt_as_str.c_str());
     }
 
@@ -68,19 +71,37 @@ struct Profile {
     } else {
       ABORT_F("Invalid profile in %s", ctxt_as_str.c_str());
     }
+
+    context_api = GLFW_NATIVE_CONTEXT_API;
+    if (tokens.size() == 4) {
+      if (tokens[3] == "egl") {
+        context_api = GLFW_EGL_CONTEXT_API;
+      } else if (tokens[3] == "osmesa") {
+        context_api = GLFW_OSMESA_CONTEXT_API;
+      } else if (tokens[3] != "native") {
+        ABORT_F("Invalid context api in %s", ctxt_as_str.c_str());
+      }
+    }
   }
 };
 
 //////////////////////////////////////////////////////////////////////////////
 // Display with window
+//
+// Headless - the window is never shown and the frames are not swapped, 
+// render to the FrameBuffer::kTexture2D targets. No vsync, so the frames go
+// as fast as the GPU does (see FrameLoop). With the osmesa context api and 
+// GLFW built with OSMesa (B3D_HEADLESS_OSMESA) it needs no X server at all.
 //////////////////////////////////////////////////////////////////////////////
 class Display {
  public:
-  Display(int width, int height, std::string caption, const Profile& profile)
+  Display(int width, int height, std::string caption, const Profile& profile,
+          bool headless = false)
      :  width_                (width),
         height_               (height),
         caption_              (std::move(caption)),
         profile_              (profile),
+        headless_             (headless),
         glfw_window_          (nullptr) {
   }
 
@@ -97,10 +118,12 @@ class Display {
       ABORT_F("Failed to initialize GLFW");
     }
 
-    glfwWindowHint(GLFW_SAMPLES,               4);
+    glfwWindowHint(GLFW_SAMPLES,               headless_ ? 0 : 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, profile_.major_version);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, profile_.minore_version);
     glfwWindowHint(GLFW_OPENGL_PROFILE,        profile_.profile);
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API,  profile_.context_api);
+    glfwWindowHint(GLFW_VISIBLE,               headless_ ? GL_FALSE : GL_TRUE);
     // For OSX
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 
@@ -112,6 +135,9 @@ class Display {
     }
 
     glfwMakeContextCurrent(glfw_window_);
+    if (headless_) {
+      glfwSwapInterval(0);
+    }
 
     //glewExperimental = true; // Needed in core profile
     //if (glewInit() != GLEW_OK) {
@@ -161,6 +187,8 @@ class Display {
   int               GetWidth()       const { return width_; }
   int               GetHeight()      const { return height_; }
   const Profile&    GetProfile()     const { return profile_; }
+  bool              IsHeadless()     const { return headless_; }
+  const std::string& GetCaption()    const { return caption_; }
 
   GLFWwindow*       GetWindow() {
     if (!glfw_window_) {
@@ -174,6 +202,7 @@ class Display {
   int                     height_;
   std::string             caption_;
   Profile                 profile_;
+  bool                    headless_;
   GLFWwindow*             glfw_window_;
 };
 
@@ -26,6 +26,7 @@
 #include "appcontext.h"
 #include "framebuffer.h"
 #include "common/logging.h"
+#include "profiler.h"
 #include <string>
 #include <stdexcept>
 #include <iostream>
@@ -105,35 +106,40 @@ GLenum Layer::GetLayerTextureType() const {
 }
 
 void Layer::InitTexture2D(int layer_number, int width, int height) {
-  glGenTextures(1, &gl_id_);
-  glBindTexture(GL_TEXTURE_2D, gl_id_);
-
-  GLint internal_format = GetLayerFormat();
-  GLenum format = GL_RGBA;
-  GLenum data_type = GL_FLOAT;
-
-  if (type_ == kDepth) {
-    format = GL_DEPTH_COMPONENT;
-    data_type = GL_UNSIGNED_BYTE;
-  }
-  glTexImage2D(
-      GL_TEXTURE_2D, 
-      0,
-      internal_format, 
-      width, height, 
-      0, 
-      format, 
-      data_type, 
-      0);
+  // Shared layers (RenderGraph) are created once and attached to every
+  // framebuffer
+  if (!gl_id_) {
+    glGenTextures(1, &gl_id_);
+    glBindTexture(GL_TEXTURE_2D, gl_id_);
+
+    GLint internal_format = GetLayerFormat();
+    GLenum format = GL_RGBA;
+    GLenum data_type = GL_FLOAT;
+
+    if (type_ == kDepth) {
+      format = GL_DEPTH_COMPONENT;
+      data_type = GL_UNSIGNED_BYTE;
+    }
+    glTexImage2D(
+        GL_TEXTURE_2D, 
+        0,
+        internal_format, 
+        width, height, 
+        0, 
+        format, 
+        data_type, 
+        0);
  
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, Texture::ToOpenGL(tex_filter_));
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, Texture::ToOpenGL(tex_filter_)); 
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  if (type_ == kDepth) {
-    // For the shadow maps in order to use hardware PCF in sampler2DShadow
-    // https://stackoverflow.com/questions/22419682/glsl-sampler2dshadow-and-shadow2d-clarification
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_R_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, Texture::ToOpenGL(tex_filter_));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, Texture::ToOpenGL(tex_filter_)); 
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    if (type_ == kDepth) {
+      // For the shadow maps in order to use hardware PCF in sampler2DShadow
+      // https://stackoverflow.com/questions/22419682/glsl-sampler2dshadow-and-shadow2d-clarification
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_R_TO_TEXTURE);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
   }
 
   if (type_ == kColor) {
@@ -141,8 +147,6 @@ void Layer::InitTexture2D(int layer_number, int width, int height) {
   } else if (type_ == kDepth) {
     glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, gl_id_, 0);
   } 
-  
-  glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 void Layer::InitTextureCube(int layer_number, int width, int height) {
@@ -203,18 +207,19 @@ void Layer::InitRenderbuffer(int layer_number, int width, int height) {
   // Just one which we clear before rendering to every cube face.
   assert(hint_ != kHintCubeMap);
 
-  glGenRenderbuffers(1, &gl_id_);
-  glBindRenderbuffer(GL_RENDERBUFFER, gl_id_);
-  GLint internal_format = GetLayerFormat();
-  glRenderbufferStorage(GL_RENDERBUFFER, internal_format, width, height);
-    
+  if (!gl_id_) {
+    glGenRenderbuffers(1, &gl_id_);
+    glBindRenderbuffer(GL_RENDERBUFFER, gl_id_);
+    GLint internal_format = GetLayerFormat();
+    glRenderbufferStorage(GL_RENDERBUFFER, internal_format, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  }
+
   if (type_ == kColor) {
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + layer_number, GL_RENDERBUFFER, gl_id_);
   } else if (type_ == kDepth) {
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, gl_id_);
   } 
-
-  glBindRenderbuffer(GL_RENDERBUFFER, 0);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -291,6 +296,29 @@ void FrameBuffer::AddLayer(Layer::Type layer_type, Layer::Permission permission,
   }
 }
 
+void FrameBuffer::AddLayer(std::shared_ptr<Layer> layer) {
+  assert(layer);
+  if (type_ != kTexture2D || layer->hint_ != Layer::kHintTexture2D) {
+    ABORT_F("Shared layers are for the 2D texture framebuffers only");
+  }
+
+  switch (layer->type_) {
+    case Layer::kColor:
+      color_layers_.emplace_back(layer);
+      break;
+
+    case Layer::kDepth:
+      assert(not depth_layer_); // already added one?
+      depth_layer_ = layer;
+      SetDepthLayerClearValue(1.0f);
+      break;
+
+    default:
+      ABORT_F("Layer type %d not implemented", layer->type_);
+      break;
+  }
+}
+
 void FrameBuffer::Init() {
   if (type_ == kScreen) {
     // No need to Init anything for the screen framebuffer
@@ -339,6 +367,7 @@ void FrameBuffer::Bind() {
     glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_id_);
   }
   glViewport(0, 0, width_, height_); 
+  PROFILE_COUNT(kStateChanges, 1);
 
   // Defaults
   glEnable(GL_CULL_FACE);
@@ -371,6 +400,37 @@ void FrameBuffer::Unbind() {
   }
 }
 
+void FrameBuffer::BindCubemapLayered() {
+  assert(type_ == kCubeMap);
+  if (depth_layer_ && depth_layer_->hint_ != Layer::kHintCubeMap) {
+    ABORT_F("Layered cubemap needs kReadWrite depth layer");
+  }
+
+  for (int i = 0; i < color_layers_.size(); ++i) {
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, 
+                         color_layers_[i]->gl_id_, 0);
+  }
+  if (depth_layer_) {
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, 
+                         depth_layer_->gl_id_, 0);
+  }
+
+  // Clears all the layers of the layered attachments
+  GLbitfield clear_mask = 0;
+  if (clear_color_flag_ && !color_layers_.empty()) {
+    clear_mask |= GL_COLOR_BUFFER_BIT;
+    const Color& c = clear_color_value_;
+    glClearColor(c.r, c.g, c.b, c.a);
+  }
+  if (clear_depth_flag_ && depth_layer_) {
+    clear_mask |= GL_DEPTH_BUFFER_BIT;
+    glClearDepth((GLdouble)clear_depth_value_);
+  }
+  if (clear_mask) {
+    glClear(clear_mask);
+  }
+}
+
 std::shared_ptr<TextureRender> 
 FrameBuffer::GetLayerAsTexture(int layer_number, Layer::Type layer_type) const {
   return std::shared_ptr<TextureRender>(
@@ -409,3 +469,13 @@ void FrameBuffer::GetPixels(std::shared_ptr<Image::ColorMap> img) {
   glReadPixels(0, 0, img->GetWidth(), img->GetHeight(), GL_RGBA, GL_FLOAT, &img->At(0));
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
+
+void FrameBuffer::GetPixels(GLuint pack_buffer, int width, int height) {
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 
+                    type_ == kScreen ? 0 : framebuffer_id_);
+  glReadBuffer(type_ == kScreen ? GL_BACK : GL_COLOR_ATTACHMENT0);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, pack_buffer);
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
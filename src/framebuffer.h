@@ -206,6 +206,11 @@ class FrameBuffer {
 
   void AddLayer(Layer::Type layer_type, Layer::Permission permission,
                 Texture::FilterMode tex_filter = Texture::kFilterBilinear);
+
+  // The layer shared with other framebuffers of the same size (RenderGraph
+  // aliasing), created by the first Init(). kTexture2D only.
+  void AddLayer(std::shared_ptr<Layer> layer);
+
   void Init();
 
   // Need to be called manually, not happens by default after AddLayer
@@ -292,6 +297,11 @@ class FrameBuffer {
     // Just for consistancy
   }
 
+  // All the faces at once for the single-pass rendering with gl_Layer.
+  // Layered framebuffers cant mix with the renderbuffers, so the depth has 
+  // to be a cubemap too (kReadWrite).
+  void BindCubemapLayered();
+
   // For color layers
   std::shared_ptr<TextureRender> 
   GetLayerAsTexture(int layer_number, Layer::Type layer_type) const;
@@ -303,6 +313,10 @@ class FrameBuffer {
   // Color attachment 0
   void GetPixels(std::shared_ptr<Image::ColorMap> img);
 
+  // Color attachment 0 (the back buffer for kScreen) as RGBA8 into the pixel
+  // pack buffer, returns without waiting for the GPU. See FrameCapture.
+  void GetPixels(GLuint pack_buffer, int width, int height);
+
  private:
   std::shared_ptr<Layer> GetLayer(int layer_number, Layer::Type layer_type) const;
   Type                  type_;
@@ -0,0 +1,133 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "framecapture.h"
+#include "common/logging.h"
+#include "profiler.h"
+
+FrameCapture::FrameCapture(const Params& params, int width, int height)
+  : params_(params),
+    width_(width),
+    height_(height),
+    next_(0),
+    writer_(new Image::FrameWriter(params.writer, width, height)) {
+  if (params_.ring_size < 1) {
+    ABORT_F("Invalid capture ring size %d", params_.ring_size);
+  }
+
+  for (int i = 0; i < params_.ring_size; ++i) {
+    ring_.emplace_back(new Slot());
+    Slot& slot = *ring_.back();
+    glGenBuffers(1, &slot.pack_buffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pack_buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)width_ * height_ * 4, 
+                 nullptr, GL_STREAM_READ);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+FrameCapture::~FrameCapture() {
+  // The writer gives the mappings back before they go
+  Flush();
+  for (auto& slot: ring_) {
+    Unmap(*slot);
+    glDeleteBuffers(1, &slot->pack_buffer);
+  }
+}
+
+void FrameCapture::Capture(FrameBuffer& framebuffer) {
+  PROFILE_GPU_SCOPE("FrameCapture::Capture");
+  Collect(false);
+
+  Slot& slot = *ring_[next_];
+  if (slot.fence) {
+    // The whole ring is in flight
+    stats_.stalls++;
+    Collect(true);
+  }
+  if (slot.lent) {
+    stats_.skipped++;
+    return;
+  }
+  Unmap(slot);
+
+  framebuffer.GetPixels(slot.pack_buffer, width_, height_);
+  slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  next_ = (next_ + 1) % ring_.size();
+  stats_.captured++;
+}
+
+void FrameCapture::Flush() {
+  Collect(true);
+  writer_->Flush();
+}
+
+FrameCapture::Stats FrameCapture::GetStats() {
+  stats_.writer = writer_->GetStats();
+  return stats_;
+}
+
+void FrameCapture::Collect(bool wait) {
+  // From the oldest one, which is the next to reuse
+  for (size_t i = 0; i < ring_.size(); ++i) {
+    Slot& slot = *ring_[(next_ + i) % ring_.size()];
+    if (!slot.fence) {
+      continue;
+    }
+
+    GLuint64 timeout = wait ? 1000000000ull : 0;
+    GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 
+                                     timeout);
+    if (status == GL_TIMEOUT_EXPIRED && !wait) {
+      return;
+    }
+    if (status == GL_WAIT_FAILED || status == GL_TIMEOUT_EXPIRED) {
+      ABORT_F("Frame capture readback failed");
+    }
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    // Stays mapped until the slot is reused, the writer reads it meanwhile
+    size_t size = (size_t)width_ * height_ * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pack_buffer);
+    void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, 
+                                    GL_MAP_READ_BIT);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (pixels) {
+      slot.mapped = true;
+      slot.lent = true;
+      writer_->Push(static_cast<const Color32*>(pixels), 
+                    [&slot]() { slot.lent = false; });
+    }
+  }
+}
+
+void FrameCapture::Unmap(Slot& slot) {
+  if (slot.mapped) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pack_buffer);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.mapped = false;
+  }
+}
@@ -0,0 +1,105 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _FRAMECAPTURE_H_F8F0E713_EFA9_4BEA_9FA6_067AD6F879E3_
+#define _FRAMECAPTURE_H_F8F0E713_EFA9_4BEA_9FA6_067AD6F879E3_ 
+
+#include "gl_main.h"
+#include "framebuffer.h"
+#include "image/framewriter.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+// Frame capture without stalling the pipeline.
+//
+// Capture() starts glReadPixels into a pixel pack buffer of the ring, with
+// a fence behind it, and returns. The readbacks are mapped a few frames 
+// later, when their fences are signaled, and lent to the FrameWriter 
+// threads which convert them straight from the mapping, no copy on the 
+// render thread. A buffer is unmapped when its slot comes round again. The
+// render thread waits only if the whole ring is still in flight 
+// (Stats::stalls); a slot still being converted skips the frame 
+// (Stats::skipped).
+//
+// Call it after the frame is drawn and before the buffers are swapped:
+//
+//  FrameCapture capture(params, width, height);
+//  (...)
+//  scene.Draw();
+//  capture.Capture(*screen->GetFrameBuffer());
+//  AppContext::EndFrame();
+//////////////////////////////////////////////////////////////////////////////
+class FrameCapture {
+ public:
+  struct Params {
+    Image::FrameWriter::Params writer;
+    int ring_size = 3; // Frames in flight on the GPU
+  };
+
+  struct Stats {
+    size_t captured = 0;
+    size_t stalls   = 0;
+    size_t skipped  = 0; // The writer was still converting the slot
+    Image::FrameWriter::Stats writer;
+  };
+
+  FrameCapture(const Params& params, int width, int height);
+  // Collects the frames in flight and writes them
+  ~FrameCapture();
+
+  FrameCapture(const FrameCapture&) = delete;
+  FrameCapture& operator=(const FrameCapture&) = delete;
+
+  // Color attachment 0 of the framebuffer, the back buffer of the screen
+  void Capture(FrameBuffer& framebuffer);
+
+  // Blocks until every captured frame is on the disk
+  void Flush();
+
+  Stats GetStats();
+
+ private:
+  struct Slot {
+    GLuint            pack_buffer = 0;
+    GLsync            fence = nullptr;
+    bool              mapped = false;
+    std::atomic<bool> lent{false}; // The writer converts the mapping
+  };
+
+  // Lends the finished readbacks to the writer in order, oldest first
+  void Collect(bool wait);
+  void Unmap(Slot& slot);
+
+  Params                              params_;
+  int                                 width_;
+  int                                 height_;
+  std::vector<std::unique_ptr<Slot>>  ring_;
+  size_t                              next_;
+  Stats                               stats_;
+  std::unique_ptr<Image::FrameWriter> writer_;
+};
+
+#endif // _FRAMECAPTURE_H_F8F0E713_EFA9_4BEA_9FA6_067AD6F879E3_
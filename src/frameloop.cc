@@ -0,0 +1,66 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "frameloop.h"
+#include "appcontext.h"
+#include "scene.h"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+FrameLoop::Stats FrameLoop::Run(Scene& scene, int n_frames, 
+                                Callback after_draw) {
+  using Clock = std::chrono::steady_clock;
+  using Ms = std::chrono::duration<double, std::milli>;
+
+  Stats stats;
+  stats.ms_min = std::numeric_limits<double>::max();
+  auto start = Clock::now();
+  while ((n_frames == 0 || stats.frames < n_frames) && AppContext::Running()) {
+    auto frame_start = Clock::now();
+    AppContext::BeginFrame();
+    scene.Update();
+    scene.Draw();
+    if (after_draw) {
+      after_draw(stats.frames);
+    }
+    AppContext::EndFrame();
+
+    double ms = Ms(Clock::now() - frame_start).count();
+    stats.ms_min = std::min(stats.ms_min, ms);
+    stats.ms_max = std::max(stats.ms_max, ms);
+    stats.ms_avg += ms;
+    stats.frames++;
+  }
+  glFinish();
+
+  stats.seconds = Ms(Clock::now() - start).count() / 1000;
+  if (stats.frames > 0) {
+    stats.ms_avg /= stats.frames;
+    stats.fps = stats.frames / stats.seconds;
+  } else {
+    stats.ms_min = 0;
+  }
+  return stats;
+}
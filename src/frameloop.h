@@ -0,0 +1,59 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _FRAMELOOP_H_700090CB_99DD_4387_B52F_CF48239896B8_
+#define _FRAMELOOP_H_700090CB_99DD_4387_B52F_CF48239896B8_ 
+
+#include <functional>
+
+class Scene;
+
+//////////////////////////////////////////////////////////////////////////////
+// The main loop as a throughput driver: renders the frames back to back and
+// returns the frame rate. The GPU is drained with glFinish() at the end so 
+// the total time includes the queued frames.
+//
+//  auto stats = FrameLoop::Run(scene, 1000, [&](int frame) {
+//    capture.Capture(*target); // after Scene::Draw(), before the swap
+//  });
+//
+// n_frames = 0 runs until AppContext::Running() is false.
+//////////////////////////////////////////////////////////////////////////////
+class FrameLoop {
+ public:
+  using Callback = std::function<void(int frame)>;
+
+  struct Stats {
+    int    frames  = 0;
+    double seconds = 0;
+    double fps     = 0;
+    double ms_min  = 0; // CPU time of a frame, without the wait for the GPU
+    double ms_avg  = 0;
+    double ms_max  = 0;
+  };
+
+  static Stats Run(Scene& scene, int n_frames, Callback after_draw = nullptr);
+};
+
+#endif // _FRAMELOOP_H_700090CB_99DD_4387_B52F_CF48239896B8_
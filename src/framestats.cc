@@ -0,0 +1,217 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "framestats.h"
+#include "common/logging.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <sstream>
+
+#ifdef B3D_COUNT_ALLOCATIONS
+static std::atomic<uint64_t> allocations(0);
+
+void* operator new(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+  std::free(p);
+}
+
+uint64_t FrameStats::GetAllocations() {
+  return allocations.load(std::memory_order_relaxed);
+}
+#else
+uint64_t FrameStats::GetAllocations() {
+  return 0;
+}
+#endif
+
+static double Ms(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+void FrameStats::BeginFrame() {
+  frame_ = Frame();
+  frame_begin_ = last_mark_ = Clock::now();
+  allocations_begin_ = GetAllocations();
+  in_frame_ = true;
+}
+
+void FrameStats::Mark(Phase phase) {
+  if (!in_frame_) {
+    return;
+  }
+  auto now = Clock::now();
+  frame_.phase_ms[phase] += Ms(now - last_mark_);
+  last_mark_ = now;
+}
+
+void FrameStats::EndFrame() {
+  if (!in_frame_) {
+    return;
+  }
+  in_frame_ = false;
+  frame_.ms = Ms(Clock::now() - frame_begin_);
+  frame_.allocations = GetAllocations() - allocations_begin_;
+  if (frame_number_++ >= warmup_) {
+    frames_.push_back(frame_);
+  }
+}
+
+// Nearest rank
+static double GetPercentile(const std::vector<double>& sorted, double p) {
+  size_t rank = (size_t)std::ceil(p / 100 * sorted.size());
+  return sorted[std::min(std::max(rank, (size_t)1), sorted.size()) - 1];
+}
+
+FrameStats::Summary FrameStats::GetSummary() const {
+  Summary summary;
+  summary.frames = frames_.size();
+  if (frames_.empty()) {
+    return summary;
+  }
+
+  std::vector<double> ms;
+  ms.reserve(frames_.size());
+  for (auto& frame: frames_) {
+    ms.push_back(frame.ms);
+    summary.ms_avg += frame.ms;
+    summary.allocations += frame.allocations;
+    for (int i = 0; i < kPhases; ++i) {
+      summary.phase_ms[i] += frame.phase_ms[i];
+    }
+  }
+  std::sort(ms.begin(), ms.end());
+  summary.ms_p50 = GetPercentile(ms, 50);
+  summary.ms_p95 = GetPercentile(ms, 95);
+  summary.ms_p99 = GetPercentile(ms, 99);
+  summary.ms_max = ms.back();
+
+  summary.ms_avg /= frames_.size();
+  summary.allocations /= frames_.size();
+  for (int i = 0; i < kPhases; ++i) {
+    summary.phase_ms[i] /= frames_.size();
+  }
+  return summary;
+}
+
+const char* FrameStats::GetPhaseName(Phase phase) {
+  switch (phase) {
+    case kInput:   return "input";
+    case kUpdate:  return "update";
+    case kDraw:    return "draw";
+    case kPresent: return "present";
+    default:       return "unknown";
+  }
+}
+
+void FrameStats::PrintSummary(std::ostream& out) const {
+  Summary summary = GetSummary();
+  auto flags = out.flags();
+  auto precision = out.precision(2);
+  out << std::fixed
+      << "Frame stats, " << summary.frames << " frames:" << std::endl
+      << "  p50/p95/p99/max " << summary.ms_p50 << "/" << summary.ms_p95 
+      << "/" << summary.ms_p99 << "/" << summary.ms_max << " ms" << std::endl
+      << "  ";
+  for (int i = 0; i < kPhases; ++i) {
+    out << (i ? ", " : "") << GetPhaseName((Phase)i) << " " 
+        << summary.phase_ms[i];
+  }
+  out << " ms" << std::endl
+      << "  " << summary.allocations << " allocations per frame" << std::endl;
+  out.flags(flags);
+  out.precision(precision);
+}
+
+static std::string Escape(const std::string& s) {
+  std::string escaped;
+  for (char c: s) {
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+    }
+    escaped += c;
+  }
+  return escaped;
+}
+
+std::string FrameStats::GetReport(const std::string& name) const {
+  Summary summary = GetSummary();
+  std::ostringstream out;
+  out.precision(4);
+  out << std::fixed;
+  out << "{\n  \"name\": \"" << Escape(name) << "\",\n"
+      << "  \"frames\": " << summary.frames << ",\n"
+      << "  \"ms_p50\": " << summary.ms_p50 << ",\n"
+      << "  \"ms_p95\": " << summary.ms_p95 << ",\n"
+      << "  \"ms_p99\": " << summary.ms_p99 << ",\n"
+      << "  \"ms_max\": " << summary.ms_max << ",\n"
+      << "  \"ms_avg\": " << summary.ms_avg << ",\n"
+      << "  \"phase_ms\": {";
+  for (int i = 0; i < kPhases; ++i) {
+    out << (i ? ", " : "") << "\"" << GetPhaseName((Phase)i) << "\": " 
+        << summary.phase_ms[i];
+  }
+  out << "},\n  \"allocations\": " << summary.allocations << ",\n"
+      << "  \"frame_ms\": [";
+  for (size_t i = 0; i < frames_.size(); ++i) {
+    out << (i ? (i % 16 ? ", " : ",\n    ") : "\n    ") << frames_[i].ms;
+  }
+  out << "\n  ]\n}\n";
+  return out.str();
+}
+
+void FrameStats::WriteReport(const std::string& filename, 
+                             const std::string& name) const {
+  std::ofstream out(filename, std::ios::out | std::ios::binary);
+  if (!out.is_open()) {
+    ABORT_F("Cant open file %s", filename.c_str());
+  }
+  out << GetReport(name);
+}
@@ -0,0 +1,110 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _FRAMESTATS_H_74AC2F55_54F5_46E0_B7CE_B9D2F6A08510_
+#define _FRAMESTATS_H_74AC2F55_54F5_46E0_B7CE_B9D2F6A08510_ 
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+// Per frame CPU timings for the regression runs (see Replay): the frame 
+// time percentiles, the time per phase of the frame and the heap 
+// allocations.
+//
+// The phases are the spans between the marks, whatever runs between two
+// marks counts to the latter one:
+//  BeginFrame() ... Mark(kInput) ... Mark(kUpdate) ... Mark(kDraw) 
+//  ... Mark(kPresent) EndFrame()
+// AppContext and Scene put the marks.
+//
+// The allocations are counted by the operator new replacement, compiled in
+// with the B3D_COUNT_ALLOCATIONS CMake option, 0 otherwise.
+//////////////////////////////////////////////////////////////////////////////
+class FrameStats {
+ public:
+  enum Phase {
+    kInput,   // Timer, input, events
+    kUpdate,  // Scene::Update()
+    kDraw,    // Scene::Draw()
+    kPresent, // Swap, the wait for the GPU when it's behind
+    kPhases
+  };
+
+  struct Frame {
+    double   ms = 0;
+    double   phase_ms[kPhases] = {};
+    uint64_t allocations = 0;
+  };
+
+  struct Summary {
+    size_t   frames = 0;
+    double   ms_p50 = 0;
+    double   ms_p95 = 0;
+    double   ms_p99 = 0;
+    double   ms_max = 0;
+    double   ms_avg = 0;
+    double   phase_ms[kPhases] = {}; // Average
+    double   allocations = 0;        // Per frame
+  };
+
+  // Skips the first frames, the loading and the shader builds
+  explicit FrameStats(int warmup_frames = 0) : warmup_(warmup_frames) {}
+
+  void BeginFrame();
+  void Mark(Phase phase);
+  void EndFrame();
+  void Add(const Frame& frame) { frames_.push_back(frame); }
+
+  const std::vector<Frame>& GetFrames() const { return frames_; }
+  Summary GetSummary() const;
+  static const char* GetPhaseName(Phase phase);
+
+  // The summary in a few lines of text
+  void PrintSummary(std::ostream& out) const;
+
+  // JSON, the summary and the frame times
+  std::string GetReport(const std::string& name) const;
+  void WriteReport(const std::string& filename, const std::string& name) const;
+
+  // All the threads, since the start. 0 without B3D_COUNT_ALLOCATIONS.
+  static uint64_t GetAllocations();
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  int                warmup_;
+  int                frame_number_ = 0;
+  bool               in_frame_ = false;
+  Clock::time_point  frame_begin_;
+  Clock::time_point  last_mark_;
+  uint64_t           allocations_begin_ = 0;
+  Frame              frame_;
+  std::vector<Frame> frames_;
+};
+
+#endif // _FRAMESTATS_H_74AC2F55_54F5_46E0_B7CE_B9D2F6A08510_
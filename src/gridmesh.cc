@@ -0,0 +1,88 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "gridmesh.h"
+#include <map>
+#include <mutex>
+#include <tuple>
+
+using IndexKey = std::tuple<int, int, int>;
+
+static std::mutex index_mutex;
+static std::map<IndexKey, std::shared_ptr<const std::vector<uint32_t>>> index_cache;
+static std::map<IndexKey, std::weak_ptr<IndexBuffer>> buffer_cache;
+
+std::shared_ptr<const std::vector<uint32_t>> GridMesh::GetIndices(
+    int x_vertices, int z_vertices, RowDirection rows) {
+  std::lock_guard<std::mutex> lock(index_mutex);
+
+  IndexKey key(x_vertices, z_vertices, rows);
+  auto it = index_cache.find(key);
+  if (it != index_cache.end()) {
+    return it->second;
+  }
+
+  const int nx = x_vertices;
+  auto indices = std::make_shared<std::vector<uint32_t>>(
+      (size_t)(x_vertices - 1) * (z_vertices - 1) * 6);
+
+  // Same facing (counter-clockwise from above) for both row directions
+  for (int z = 0; z < z_vertices - 1; ++z) {
+    uint32_t* out = indices->data() + (size_t)z * (x_vertices - 1) * 6;
+    for (int x = 0; x < x_vertices - 1; ++x) {
+      uint32_t i = z * nx + x;
+      if (rows == kRowsToPositiveZ) {
+        *out++ = i; *out++ = i + nx;     *out++ = i + nx + 1;
+        *out++ = i; *out++ = i + nx + 1; *out++ = i + 1;
+      } else {
+        *out++ = i; *out++ = i + nx + 1; *out++ = i + nx;
+        *out++ = i; *out++ = i + 1;      *out++ = i + nx + 1;
+      }
+    }
+  }
+
+  index_cache.emplace(key, indices);
+  return indices;
+}
+
+std::shared_ptr<IndexBuffer> GridMesh::GetIndexBuffer(
+    int x_vertices, int z_vertices, RowDirection rows) {
+  auto indices = GetIndices(x_vertices, z_vertices, rows);
+  std::lock_guard<std::mutex> lock(index_mutex);
+
+  // Alive as long as a mesh has it, a GL buffer can't outlive the context
+  auto& cached = buffer_cache[IndexKey(x_vertices, z_vertices, rows)];
+  auto buffer = cached.lock();
+  if (!buffer) {
+    buffer = std::make_shared<IndexBuffer>(indices);
+    cached = buffer;
+  }
+  return buffer;
+}
+
+void GridMesh::ClearIndices() {
+  std::lock_guard<std::mutex> lock(index_mutex);
+  index_cache.clear();
+  buffer_cache.clear();
+}
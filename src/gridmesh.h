@@ -0,0 +1,170 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _GRIDMESH_H_F4F033A3_93AC_41B8_A14F_D1647873D633_
+#define _GRIDMESH_H_F4F033A3_93AC_41B8_A14F_D1647873D633_ 
+
+#include "mesh.h"
+#include "indexbuffer.h"
+#include "math_main.h"
+#include "common/logging.h"
+#include "common/parallel.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+// Regular XZ grid mesh (terrains, heightmaps).
+//
+// The samplers are any callables, no std::function in the vertex loop:
+//   float     sample_height(int x, int z);
+//   glm::vec4 sample_color(int x, int z);     // optional
+// x, z are the vertex column and row. The rows are filled in parallel bands,
+// so the samplers are called from several threads at once.
+//
+// Normals are analytic, from the height differences of the neighbours. The
+// index buffer only depends on the resolution and is generated once for all
+// the grids of the same size, and uploaded to vRAM once for all of them.
+// Mesh::indices still gets its own CPU copy on purpose: the code reading 
+// the triangles on the CPU (the raycasts, the occlusion rasterizer) sees a
+// regular mesh. Only the vRAM copy is shared.
+//
+// auto mesh = GridMesh::Build(params, [&](int x, int z) {
+//   return hmap.At(x, z);
+// });
+//////////////////////////////////////////////////////////////////////////////
+class GridMesh {
+ public:
+  enum RowDirection {
+    kRowsToNegativeZ,  // Row 0 is at +z_length/2
+    kRowsToPositiveZ   // Row 0 is at -z_length/2
+  };
+
+  struct Params {
+    int          x_vertices = 2;
+    int          z_vertices = 2;
+    float        x_length   = 1;
+    float        z_length   = 1;
+    RowDirection rows       = kRowsToNegativeZ;
+    int          n_threads  = 0; // 0 - all the cores
+  };
+
+  template <typename THeight>
+  static std::shared_ptr<Mesh> Build(const Params& params, 
+                                     THeight&& sample_height) {
+    return Build(params, std::forward<THeight>(sample_height), nullptr);
+  }
+
+  template <typename THeight, typename TColor>
+  static std::shared_ptr<Mesh> Build(const Params& params, 
+                                     THeight&& sample_height,
+                                     TColor&& sample_color);
+
+  // Triangle list for the grid, shared by all the grids of the same size
+  static std::shared_ptr<const std::vector<uint32_t>> GetIndices(
+      int x_vertices, int z_vertices, RowDirection rows);
+
+  // Same in vRAM (Mesh::index_buffer), while some mesh holds it
+  static std::shared_ptr<IndexBuffer> GetIndexBuffer(
+      int x_vertices, int z_vertices, RowDirection rows);
+
+  // Drops the cached index buffers
+  static void ClearIndices();
+};
+
+template <typename THeight, typename TColor>
+std::shared_ptr<Mesh> GridMesh::Build(const Params& params, 
+                                      THeight&& sample_height,
+                                      TColor&& sample_color) {
+  constexpr bool kHasColor = 
+      !std::is_same<std::decay_t<TColor>, std::nullptr_t>::value;
+
+  const int nx = params.x_vertices;
+  const int nz = params.z_vertices;
+  if (nx < 2 || nz < 2) {
+    ABORT_F("Grid must be at least 2x2, got %dx%d", nx, nz);
+  }
+
+  auto mesh = std::make_shared<Mesh>();
+  size_t n_vertices = (size_t)nx * nz;
+  mesh->vertices.resize(n_vertices);
+  mesh->normals.resize(n_vertices);
+  mesh->uv.resize(n_vertices);
+  if (kHasColor) {
+    mesh->colors.resize(n_vertices);
+  }
+
+  float z_sign = params.rows == kRowsToPositiveZ ? 1.0f : -1.0f;
+
+  // Positions first, the normals need the neighbours
+  ParallelFor(0, nz, params.n_threads, [&](int z_begin, int z_end) {
+    for (int z = z_begin; z < z_end; ++z) {
+      float tz = (float)z / (nz - 1);
+      float zpos = Math::Lerp(-0.5f * z_sign, 0.5f * z_sign, tz) * params.z_length;
+      size_t i = (size_t)z * nx;
+
+      for (int x = 0; x < nx; ++x, ++i) {
+        float tx = (float)x / (nx - 1);
+        float xpos = Math::Lerp(-0.5f, 0.5f, tx) * params.x_length;
+
+        mesh->vertices[i] = glm::vec3(xpos, sample_height(x, z), zpos);
+        mesh->uv[i] = glm::vec2(tx, tz);
+        if constexpr (kHasColor) {
+          mesh->colors[i] = sample_color(x, z);
+        }
+      }
+    }
+  });
+
+  // Central differences, one sided on the borders
+  float dx = params.x_length / (nx - 1);
+  float dz = z_sign * params.z_length / (nz - 1);
+  ParallelFor(0, nz, params.n_threads, [&](int z_begin, int z_end) {
+    const auto& v = mesh->vertices;
+    for (int z = z_begin; z < z_end; ++z) {
+      int z0 = std::max(z - 1, 0);
+      int z1 = std::min(z + 1, nz - 1);
+      size_t i = (size_t)z * nx;
+
+      for (int x = 0; x < nx; ++x, ++i) {
+        int x0 = std::max(x - 1, 0);
+        int x1 = std::min(x + 1, nx - 1);
+        float dhdx = (v[(size_t)z * nx + x1].y - v[(size_t)z * nx + x0].y) / 
+                     ((x1 - x0) * dx);
+        float dhdz = (v[(size_t)z1 * nx + x].y - v[(size_t)z0 * nx + x].y) / 
+                     ((z1 - z0) * dz);
+        mesh->normals[i] = glm::normalize(glm::vec3(-dhdx, 1, -dhdz));
+      }
+    }
+  });
+
+  mesh->index_buffer = GetIndexBuffer(nx, nz, params.rows);
+  mesh->indices = mesh->index_buffer->GetIndices();
+  return mesh;
+}
+
+#endif // _GRIDMESH_H_F4F033A3_93AC_41B8_A14F_D1647873D633_
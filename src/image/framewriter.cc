@@ -0,0 +1,305 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "framewriter.h"
+#include "common/logging.h"
+#include "profiler.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace Image {
+
+namespace {
+
+// Full range BT.601, 8 bit fixed point
+inline uint8_t GetY(int r, int g, int b) {
+  return (uint8_t)((77 * r + 150 * g + 29 * b + 128) >> 8);
+}
+
+inline uint8_t GetU(int r, int g, int b) {
+  return (uint8_t)std::min(255, (-43 * r - 85 * g + 128 * b + 32896) >> 8);
+}
+
+inline uint8_t GetV(int r, int g, int b) {
+  return (uint8_t)std::min(255, (128 * r - 107 * g - 21 * b + 32896) >> 8);
+}
+
+}
+
+FrameWriter::FrameWriter(const Params& params, int width, int height)
+  : params_(params), 
+    width_(width), 
+    height_(height), 
+    file_(nullptr),
+    n_file_(0),
+    busy_(0),
+    stop_(false) {
+  if (width_ <= 0 || height_ <= 0) {
+    ABORT_F("Invalid frame size %d x %d", width_, height_);
+  }
+  if (params_.max_queued < 1) {
+    ABORT_F("Invalid max queued frames %d", params_.max_queued);
+  }
+
+  if (params_.format == kY4m) {
+    file_ = std::fopen(params_.filename.c_str(), "wb");
+    if (!file_) {
+      ABORT_F("Cant open file %s", params_.filename.c_str());
+    }
+    std::string header = GetY4mHeader(width_, height_, params_.fps);
+    std::fwrite(header.data(), 1, header.size(), file_);
+  }
+
+  convert_thread_ = std::thread([this]() { Convert(); });
+  write_thread_ = std::thread([this]() { Write(); });
+}
+
+FrameWriter::~FrameWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  convert_cv_.notify_all();
+  write_cv_.notify_all();
+  convert_thread_.join();
+  write_thread_.join();
+
+  if (file_) {
+    std::fclose(file_);
+  }
+}
+
+std::shared_ptr<ColorMap32> FrameWriter::GetFrame() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (free_frames_.empty()) {
+    return std::make_shared<ColorMap32>(width_, height_);
+  }
+  auto frame = std::move(free_frames_.back());
+  free_frames_.pop_back();
+  return frame;
+}
+
+bool FrameWriter::Push(std::shared_ptr<ColorMap32> frame) {
+  assert(frame);
+  assert((int)frame->GetWidth() == width_);
+  assert((int)frame->GetHeight() == height_);
+  const Color32* pixels = frame->GetArray();
+  return Push(Job{std::move(frame), pixels, nullptr});
+}
+
+bool FrameWriter::Push(const Color32* pixels, std::function<void()> release) {
+  assert(pixels);
+  return Push(Job{nullptr, pixels, std::move(release)});
+}
+
+bool FrameWriter::Push(Job job) {
+  bool queued = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.pushed++;
+    if ((int)(frames_.size() + busy_) < params_.max_queued) {
+      frames_.push_back(std::move(job));
+      queued = true;
+    } else {
+      stats_.dropped++;
+      if (job.frame) {
+        free_frames_.push_back(std::move(job.frame));
+      }
+    }
+  }
+  if (!queued) {
+    if (job.release) {
+      job.release();
+    }
+    return false;
+  }
+  convert_cv_.notify_one();
+  return true;
+}
+
+void FrameWriter::Flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [this]() { 
+    return frames_.empty() && encoded_.empty() && busy_ == 0; 
+  });
+  if (file_) {
+    std::fflush(file_);
+  }
+}
+
+FrameWriter::Stats FrameWriter::GetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void FrameWriter::Convert() {
+  for (;;) {
+    Job job;
+    std::unique_ptr<Bytes> bytes;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      convert_cv_.wait(lock, [this]() { return stop_ || !frames_.empty(); });
+      if (frames_.empty()) {
+        return;
+      }
+      job = std::move(frames_.front());
+      frames_.pop_front();
+      busy_++;
+      if (!free_bytes_.empty()) {
+        bytes = std::move(free_bytes_.back());
+        free_bytes_.pop_back();
+      }
+    }
+
+    if (!bytes) {
+      bytes.reset(new Bytes());
+    }
+    {
+      PROFILE_SCOPE("FrameWriter::Encode");
+      if (params_.format == kY4m) {
+        EncodeY4mFrame(job.pixels, width_, height_, *bytes);
+      } else {
+        EncodePpm(job.pixels, width_, height_, *bytes);
+      }
+    }
+    if (job.release) {
+      job.release();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (job.frame) {
+        free_frames_.push_back(std::move(job.frame));
+      }
+      encoded_.push_back(std::move(bytes));
+    }
+    write_cv_.notify_one();
+  }
+}
+
+void FrameWriter::Write() {
+  for (;;) {
+    std::unique_ptr<Bytes> bytes;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      write_cv_.wait(lock, [this]() { 
+        return !encoded_.empty() || (stop_ && frames_.empty() && busy_ == 0);
+      });
+      if (encoded_.empty()) {
+        return;
+      }
+      bytes = std::move(encoded_.front());
+      encoded_.pop_front();
+    }
+
+    if (params_.format == kY4m) {
+      std::fwrite(bytes->data(), 1, bytes->size(), file_);
+    } else {
+      char filename[1024];
+      std::snprintf(filename, sizeof(filename), params_.filename.c_str(), 
+                    (int)n_file_++);
+      std::FILE* file = std::fopen(filename, "wb");
+      if (!file) {
+        ABORT_F("Cant open file %s", filename);
+      }
+      std::fwrite(bytes->data(), 1, bytes->size(), file);
+      std::fclose(file);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      busy_--;
+      stats_.written++;
+      stats_.bytes += bytes->size();
+      free_bytes_.push_back(std::move(bytes));
+    }
+    done_cv_.notify_all();
+    write_cv_.notify_all();
+  }
+}
+
+std::string FrameWriter::GetY4mHeader(int width, int height, int fps) {
+  return "YUV4MPEG2 W" + std::to_string(width) + " H" + std::to_string(height) +
+         " F" + std::to_string(fps) + ":1 Ip A1:1 C420jpeg\n";
+}
+
+void FrameWriter::EncodePpm(const Color32* pixels, size_t w, size_t h,
+                            std::vector<uint8_t>& out) {
+  std::string header = "P6\n" + std::to_string(w) + " " + 
+                       std::to_string(h) + "\n255\n";
+  out.resize(header.size() + w * h * 3);
+  std::memcpy(out.data(), header.data(), header.size());
+
+  uint8_t* rgb = out.data() + header.size();
+  for (size_t y = 0; y < h; ++y) {
+    const Color32* row = pixels + (h - 1 - y) * w;
+    for (size_t x = 0; x < w; ++x, rgb += 3) {
+      rgb[0] = row[x].r;
+      rgb[1] = row[x].g;
+      rgb[2] = row[x].b;
+    }
+  }
+}
+
+void FrameWriter::EncodeY4mFrame(const Color32* pixels, size_t w, size_t h,
+                                 std::vector<uint8_t>& out) {
+  static const char kFrame[] = "FRAME\n";
+  const size_t cw = (w + 1) / 2;
+  const size_t ch = (h + 1) / 2;
+  const size_t n_header = sizeof(kFrame) - 1;
+  out.resize(n_header + w * h + cw * ch * 2);
+  std::memcpy(out.data(), kFrame, n_header);
+
+  uint8_t* luma = out.data() + n_header;
+  uint8_t* u = luma + w * h;
+  uint8_t* v = u + cw * ch;
+  auto pixel = [pixels, w, h](size_t x, size_t y) -> const Color32& {
+    return pixels[(h - 1 - std::min(y, h - 1)) * w + std::min(x, w - 1)];
+  };
+
+  for (size_t y = 0; y < h; ++y) {
+    const Color32* row = pixels + (h - 1 - y) * w;
+    for (size_t x = 0; x < w; ++x) {
+      *luma++ = GetY(row[x].r, row[x].g, row[x].b);
+    }
+  }
+
+  // The chroma of the 2x2 block average
+  for (size_t y = 0; y < ch; ++y) {
+    for (size_t x = 0; x < cw; ++x) {
+      const Color32& c0 = pixel(x * 2,     y * 2);
+      const Color32& c1 = pixel(x * 2 + 1, y * 2);
+      const Color32& c2 = pixel(x * 2,     y * 2 + 1);
+      const Color32& c3 = pixel(x * 2 + 1, y * 2 + 1);
+      int r = (c0.r + c1.r + c2.r + c3.r + 2) / 4;
+      int g = (c0.g + c1.g + c2.g + c3.g + 2) / 4;
+      int b = (c0.b + c1.b + c2.b + c3.b + 2) / 4;
+      *u++ = GetU(r, g, b);
+      *v++ = GetV(r, g, b);
+    }
+  }
+}
+
+} // namespace Image
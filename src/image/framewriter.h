@@ -0,0 +1,154 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _FRAMEWRITER_H_212CCB50_0BCC_40FE_9D33_CA81DA467E3C_
+#define _FRAMEWRITER_H_212CCB50_0BCC_40FE_9D33_CA81DA467E3C_ 
+
+#include "colormap.h"
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Image {
+
+//////////////////////////////////////////////////////////////////////////////
+// Streams the captured frames to the disk off the render thread.
+//
+// The frames are RGBA8 with the bottom row first, as glReadPixels gives 
+// them. The convert thread flips and encodes them (RGB for PPM, YUV 4:2:0
+// for Y4M), the write thread writes every encoded frame with one fwrite.
+// The frame buffers are recycled: take one with GetFrame(), fill it and 
+// give it back with Push(). Or lend the pixels (a mapped readback), they 
+// are encoded in place and given back by the release callback. If the disk
+// can't keep up and max_queued frames are waiting the new ones are 
+// dropped, the render never waits.
+//
+//  kPpmSequence - filename is a printf pattern, "capture/frame%05d.ppm"
+//  kY4m         - YUV4MPEG2 video, 4:2:0 full range BT.601 (C420jpeg), 
+//                 plays with ffplay/mpv or encodes with ffmpeg -i
+//////////////////////////////////////////////////////////////////////////////
+class FrameWriter {
+ public:
+  enum Format {
+    kPpmSequence,
+    kY4m
+  };
+
+  struct Params {
+    Format      format     = kY4m;
+    std::string filename   = "capture.y4m";
+    int         fps        = 60; // Y4M header only
+    int         max_queued = 8;  // Frames waiting, then dropped
+  };
+
+  struct Stats {
+    size_t pushed  = 0;
+    size_t written = 0;
+    size_t dropped = 0;
+    size_t bytes   = 0;
+  };
+
+  FrameWriter(const Params& params, int width, int height);
+  // Writes whatever is queued
+  ~FrameWriter();
+
+  FrameWriter(const FrameWriter&) = delete;
+  FrameWriter& operator=(const FrameWriter&) = delete;
+
+  // A free width x height frame, recycled or new
+  std::shared_ptr<ColorMap32> GetFrame();
+
+  // Takes the frame from GetFrame(), false - dropped
+  bool Push(std::shared_ptr<ColorMap32> frame);
+
+  // Width x height pixels, valid until release() which is called from the
+  // convert thread once they are encoded, or right away if dropped
+  bool Push(const Color32* pixels, std::function<void()> release);
+
+  // Blocks until everything pushed is on the disk
+  void Flush();
+
+  Stats GetStats();
+  int GetWidth() const { return width_; }
+  int GetHeight() const { return height_; }
+
+  // The encoders, bottom up RGBA8 in
+  static void EncodePpm(const Color32* pixels, size_t width, size_t height,
+                        std::vector<uint8_t>& out);
+  static void EncodeY4mFrame(const Color32* pixels, size_t width, 
+                             size_t height, std::vector<uint8_t>& out);
+  static void EncodePpm(const ColorMap32& frame, std::vector<uint8_t>& out) {
+    EncodePpm(frame.GetArray(), frame.GetWidth(), frame.GetHeight(), out);
+  }
+  static void EncodeY4mFrame(const ColorMap32& frame, std::vector<uint8_t>& out) {
+    EncodeY4mFrame(frame.GetArray(), frame.GetWidth(), frame.GetHeight(), out);
+  }
+  static std::string GetY4mHeader(int width, int height, int fps);
+
+ private:
+  using Bytes = std::vector<uint8_t>;
+
+  // Owned or lent pixels
+  struct Job {
+    std::shared_ptr<ColorMap32> frame;
+    const Color32*              pixels = nullptr;
+    std::function<void()>       release;
+  };
+
+  bool Push(Job job);
+
+  void Convert();
+  void Write();
+
+  Params      params_;
+  int         width_;
+  int         height_;
+  std::FILE*  file_;   // Y4M
+  size_t      n_file_; // PPM sequence
+
+  std::mutex                               mutex_;
+  std::condition_variable                  convert_cv_;
+  std::condition_variable                  write_cv_;
+  std::condition_variable                  done_cv_;
+  std::deque<Job>                          frames_;  // To convert
+  std::deque<std::unique_ptr<Bytes>>       encoded_; // To write
+  std::vector<std::shared_ptr<ColorMap32>> free_frames_;
+  std::vector<std::unique_ptr<Bytes>>      free_bytes_;
+  size_t                                   busy_; // Being converted/written
+  Stats                                    stats_;
+  bool                                     stop_;
+
+  std::thread convert_thread_;
+  std::thread write_thread_;
+};
+
+} // namespace Image
+
+#endif // _FRAMEWRITER_H_212CCB50_0BCC_40FE_9D33_CA81DA467E3C_
@@ -192,18 +192,20 @@ void PortablePixMap::Write(const std::string& filename, const ColorMap& img) {
     ABORT_F("Cant open file %s", filename.c_str());
   }
 
-  out << "P6\n";
-  out << img.GetWidth() << " " << img.GetHeight() << "\n";
-  out << 255 << "\n";
+  std::string header = "P6\n" + std::to_string(img.GetWidth()) + " " + 
+                       std::to_string(img.GetHeight()) + "\n255\n";
+  out.write(header.data(), header.size());
 
+  // One write, not per pixel
   size_t sz = img.GetWidth() * img.GetHeight();
+  std::vector<uint8_t> rgb(sz * 3);
   for (size_t i = 0; i < sz; ++i) {
     const Color& c = img.At(i);
-    uint8_t rgb[3] = {(uint8_t)Math::Clamp(0.0f, 255.0f, c.r*255),
-                      (uint8_t)Math::Clamp(0.0f, 255.0f, c.g*255),
-                      (uint8_t)Math::Clamp(0.0f, 255.0f, c.b*255)};
-    out.write((char*)rgb, 3);
+    rgb[i * 3 + 0] = (uint8_t)Math::Clamp(0.0f, 255.0f, c.r*255);
+    rgb[i * 3 + 1] = (uint8_t)Math::Clamp(0.0f, 255.0f, c.g*255);
+    rgb[i * 3 + 2] = (uint8_t)Math::Clamp(0.0f, 255.0f, c.b*255);
   }
+  out.write((char*)rgb.data(), rgb.size());
 }
 
 } // namespace Image
@@ -0,0 +1,95 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _INDEXBUFFER_H_BC878A32_E338_4317_982F_F842E6B98F9C_
+#define _INDEXBUFFER_H_BC878A32_E338_4317_982F_F842E6B98F9C_ 
+
+#include "gl_main.h"
+#include "profiler.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+// Element buffer shared by the meshes with the same indices (the grids of
+// the same size). Made anywhere, uploaded once on the GL thread by the 
+// first MeshFilter which bakes a mesh with it. 16 bit if the indices fit.
+//////////////////////////////////////////////////////////////////////////////
+class IndexBuffer {
+ public:
+  explicit IndexBuffer(std::shared_ptr<const std::vector<uint32_t>> indices)
+    : indices_(indices), id_(0), type_(GL_UNSIGNED_INT) {
+    auto max = std::max_element(indices_->begin(), indices_->end());
+    if (max != indices_->end() && 
+        *max < std::numeric_limits<uint16_t>::max()) {
+      type_ = GL_UNSIGNED_SHORT;
+    }
+  }
+
+  ~IndexBuffer() {
+    if (id_) {
+      glDeleteBuffers(1, &id_);
+    }
+  }
+
+  IndexBuffer(const IndexBuffer&) = delete;
+  IndexBuffer& operator=(const IndexBuffer&) = delete;
+
+  // GL thread, the VAO to draw with is bound
+  GLuint Upload() {
+    if (id_) {
+      return id_;
+    }
+    glGenBuffers(1, &id_);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, id_);
+    if (type_ == GL_UNSIGNED_SHORT) {
+      std::vector<uint16_t> indices(indices_->begin(), indices_->end());
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint16_t) * indices.size(),
+                   indices.data(), GL_STATIC_DRAW);
+      PROFILE_COUNT(kUploadBytes, sizeof(uint16_t) * indices.size());
+    } else {
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t) * indices_->size(),
+                   indices_->data(), GL_STATIC_DRAW);
+      PROFILE_COUNT(kUploadBytes, sizeof(uint32_t) * indices_->size());
+    }
+    PROFILE_COUNT(kUploads, 1);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    return id_;
+  }
+
+  const std::vector<uint32_t>& GetIndices() const { return *indices_; }
+  GLenum GetType() const { return type_; }
+
+  // 0 until uploaded
+  GLuint GetId() const { return id_; }
+
+ private:
+  std::shared_ptr<const std::vector<uint32_t>> indices_;
+  GLuint                                       id_;
+  GLenum                                       type_;
+};
+
+#endif // _INDEXBUFFER_H_BC878A32_E338_4317_982F_F842E6B98F9C_
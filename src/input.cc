@@ -64,10 +64,16 @@ float Input::GetAxis(const std::string& axis) const {
 }
 
 bool Input::GetMouseButtonDown(int button) const {
+  if (mode_ == kPlay) {
+    return GetPlayedFrame().GetMouseButton(button);
+  }
   return glfwGetMouseButton(GetWindow(), button);
 }
 
 bool Input::GetKey(int key) const {
+  if (mode_ == kPlay) {
+    return GetPlayedFrame().GetKey(key);
+  }
   return glfwGetKey(GetWindow(), key) == GLFW_PRESS;
 }
 
@@ -82,12 +88,48 @@ bool Input::GetKeyUp(int key) const {
 }
 
 void Input::Update() {
+  old_mouse_position_ = mouse_position_;
+  ++frame_;
+  if (mode_ == kPlay) {
+    mouse_position_ = GetPlayedFrame().cursor;
+    return;
+  }
+
   double xpos, ypos;
   glfwGetCursorPos(GetWindow(), &xpos, &ypos);
-
-  old_mouse_position_ = mouse_position_;
   mouse_position_.x = xpos;
   mouse_position_.y = ypos;
+
+  if (mode_ == kRecord) {
+    InputTrack::Frame frame;
+    frame.cursor = mouse_position_;
+    for (int key = GLFW_KEY_SPACE; key <= GLFW_KEY_LAST; ++key) {
+      if (glfwGetKey(GetWindow(), key) == GLFW_PRESS) {
+        frame.keys.push_back(key);
+      }
+    }
+    for (int button = 0; button <= GLFW_MOUSE_BUTTON_LAST; ++button) {
+      if (glfwGetMouseButton(GetWindow(), button) == GLFW_PRESS) {
+        frame.buttons |= 1u << button;
+      }
+    }
+    track_.Add(std::move(frame));
+  }
+}
+
+void Input::Record() {
+  mode_ = kRecord;
+  track_ = InputTrack();
+}
+
+void Input::Play(InputTrack track) {
+  mode_ = kPlay;
+  track_ = std::move(track);
+  frame_ = 0;
+}
+
+const InputTrack::Frame& Input::GetPlayedFrame() const {
+  return track_.Get(frame_ > 0 ? frame_ - 1 : 0);
 }
 
 GLFWwindow* Input::GetWindow() const {
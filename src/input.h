@@ -28,6 +28,7 @@
 #include <string>
 #include "gl_main.h"
 #include "glm_main.h"
+#include "inputtrack.h"
 
 //////////////////////////////////////////////////////////////////////////////
 // Input class. Will contain stuff like Get("Jump"), etc...
@@ -49,13 +50,31 @@ class Input {
 
    void        Init();
 
+   ///////////////////////////////////////////////////////////////////////////
+   // Record() stores the state of every frame to the track, Play() takes 
+   // it from the track instead of GLFW. See Replay.
+   ///////////////////////////////////////////////////////////////////////////
+   void              Record            ();
+   void              Play              (InputTrack track);
+   const InputTrack& GetTrack          ()                        const { 
+     return track_; 
+   }
+
  private:
+   enum Mode { kLive, kRecord, kPlay };
+
    GLFWwindow* GetWindow               ()                        const;
 
    glm::vec2   GetMouseDelta           ()                        const;
 
+   const InputTrack::Frame& GetPlayedFrame()                     const;
+
    glm::vec2 mouse_position_ = glm::vec2(0, 0);
    glm::vec2 old_mouse_position_ = glm::vec2(0, 0);
+
+   Mode       mode_ = kLive;
+   InputTrack track_;
+   size_t     frame_ = 0;
 };
 
 #endif // _INPUT_H_77DB633C_2377_4682_95CD_F8B7C011ED94_
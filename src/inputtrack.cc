@@ -0,0 +1,83 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "inputtrack.h"
+#include "common/logging.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+bool InputTrack::Frame::GetKey(int key) const {
+  return std::find(keys.begin(), keys.end(), key) != keys.end();
+}
+
+const InputTrack::Frame& InputTrack::Get(size_t frame) const {
+  static const Frame kEmpty;
+  if (frames_.empty()) {
+    return kEmpty;
+  }
+  return frames_[std::min(frame, frames_.size() - 1)];
+}
+
+void InputTrack::Save(const std::string& filename) const {
+  std::ofstream out(filename, std::ios::out);
+  if (!out.is_open()) {
+    ABORT_F("Cant open file %s", filename.c_str());
+  }
+  for (auto& frame: frames_) {
+    out << frame.cursor.x << " " << frame.cursor.y << " " << frame.buttons 
+        << " " << frame.keys.size();
+    for (int key: frame.keys) {
+      out << " " << key;
+    }
+    out << "\n";
+  }
+}
+
+void InputTrack::Load(const std::string& filename) {
+  std::ifstream in(filename, std::ios::in);
+  if (!in.is_open()) {
+    ABORT_F("Cant open file %s", filename.c_str());
+  }
+  frames_.clear();
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    std::istringstream fields(line);
+    Frame frame;
+    size_t n_keys = 0;
+    fields >> frame.cursor.x >> frame.cursor.y >> frame.buttons >> n_keys;
+    frame.keys.resize(n_keys);
+    for (auto& key: frame.keys) {
+      fields >> key;
+    }
+    if (!fields) {
+      ABORT_F("Bad input track %s, frame %zu", filename.c_str(), 
+              frames_.size());
+    }
+    frames_.push_back(std::move(frame));
+  }
+}
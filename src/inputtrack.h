@@ -0,0 +1,66 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _INPUTTRACK_H_13EDDB68_8220_4F96_8AB0_570ECD000F69_
+#define _INPUTTRACK_H_13EDDB68_8220_4F96_8AB0_570ECD000F69_ 
+
+#include "glm_main.h"
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+// Recorded input, a state per frame: the cursor, the pressed keys and the
+// mouse buttons. Input records it from GLFW and plays it back instead of
+// GLFW (B3D_INPUT_RECORD/B3D_INPUT_PLAY, see Replay).
+//
+// Text file, a line per frame:
+//  <cursor x> <cursor y> <buttons mask> <n keys> <key>...
+//////////////////////////////////////////////////////////////////////////////
+class InputTrack {
+ public:
+  struct Frame {
+    glm::vec2        cursor = glm::vec2(0);
+    unsigned         buttons = 0; // Bit per mouse button
+    std::vector<int> keys;        // Pressed, GLFW_KEY_*
+
+    bool GetKey(int key) const;
+    bool GetMouseButton(int button) const { 
+      return button >= 0 && button < 32 && (buttons >> button) & 1;
+    }
+  };
+
+  void Add(Frame frame) { frames_.push_back(std::move(frame)); }
+
+  // The last one after the end of the track
+  const Frame& Get(size_t frame) const;
+  size_t GetLength() const { return frames_.size(); }
+
+  void Save(const std::string& filename) const;
+  void Load(const std::string& filename);
+
+ private:
+  std::vector<Frame> frames_;
+};
+
+#endif // _INPUTTRACK_H_13EDDB68_8220_4F96_8AB0_570ECD000F69_
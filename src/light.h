@@ -56,6 +56,20 @@ class Light: public Actor {
     attenuation_ = attenuation;
   }
 
+  // Point and spot lights do not reach further than the range
+  void SetRange(float range) {
+    range_ = range;
+  }
+
+  void SetIntensity(float intensity) {
+    intencity_ = intensity;
+  }
+
+  // The full cone angle in degrees
+  void SetSpotAngle(float angle) {
+    spot_angle_ = angle;
+  }
+
   Type GetType() const {return type_;}
   const glm::vec4& GetColor() const {return color_;}
   const glm::vec3& GetAttenuation() const {return attenuation_;}
@@ -0,0 +1,248 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "lightclusters.h"
+#include "common/logging.h"
+#include "common/parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+LightClusters::LightClusters(const Params& params) 
+  : params_(params),
+    proj_(1.0f),
+    near_(0),
+    far_(0) {
+  if (params_.grid_x <= 0 || params_.grid_y <= 0 || params_.grid_z <= 0) {
+    ABORT_F("Invalid light clusters grid %dx%dx%d", 
+            params_.grid_x, params_.grid_y, params_.grid_z);
+  }
+  slices_.resize(params_.grid_z);
+  clusters_.resize(GetClusterCount(), glm::uvec2(0));
+}
+
+void LightClusters::ComputeBounds(int z) {
+  // Tile edges in NDC, unprojected at both slice depths
+  const int gx = params_.grid_x;
+  const int gy = params_.grid_y;
+  Slice& slice = slices_[z];
+  slice.bounds.resize(2 * gx * gy);
+  for (int y = 0; y < gy; ++y) {
+    for (int x = 0; x < gx; ++x) {
+      float ndc_x[2] = {2.0f * x / gx - 1, 2.0f * (x + 1) / gx - 1};
+      float ndc_y[2] = {2.0f * y / gy - 1, 2.0f * (y + 1) / gy - 1};
+      glm::vec3 min(std::numeric_limits<float>::max());
+      glm::vec3 max(-min);
+      for (int i = 0; i < 8; ++i) {
+        float d = depths_[z + (i >> 2)];
+        glm::vec3 corner(d * (ndc_x[i & 1] + proj_[2][0]) / proj_[0][0],
+                         d * (ndc_y[(i >> 1) & 1] + proj_[2][1]) / proj_[1][1],
+                         -d);
+        min = glm::min(min, corner);
+        max = glm::max(max, corner);
+      }
+      slice.bounds[2 * (x + y * gx)] = min;
+      slice.bounds[2 * (x + y * gx) + 1] = max;
+    }
+  }
+}
+
+void LightClusters::BinSlice(int z) {
+  const int gx = params_.grid_x;
+  const int gy = params_.grid_y;
+  float d0 = depths_[z];
+  float d1 = depths_[z + 1];
+
+  ComputeBounds(z);
+  Slice& slice = slices_[z];
+  slice.pairs.clear();
+  slice.tiles.assign(gx * gy, glm::uvec2(0));
+
+  for (size_t i = 0; i < view_lights_.size(); ++i) {
+    const ViewLight& light = view_lights_[i];
+    float depth = -light.position.z;
+    float depth_min = std::max(d0, depth - light.range);
+    float depth_max = std::min(d1, depth + light.range);
+    if (depth_min > depth_max) {
+      continue;
+    }
+
+    // NDC = P * x / depth - offset, the extremes are at the depth ends
+    glm::vec2 ndc_min(std::numeric_limits<float>::max());
+    glm::vec2 ndc_max(-ndc_min);
+    for (float d: {depth_min, depth_max}) {
+      for (float s: {-light.range, light.range}) {
+        glm::vec2 ndc(proj_[0][0] * (light.position.x + s) / d - proj_[2][0],
+                      proj_[1][1] * (light.position.y + s) / d - proj_[2][1]);
+        ndc_min = glm::min(ndc_min, ndc);
+        ndc_max = glm::max(ndc_max, ndc);
+      }
+    }
+    if (ndc_min.x > 1 || ndc_min.y > 1 || ndc_max.x < -1 || ndc_max.y < -1) {
+      continue;
+    }
+    int x0 = glm::clamp((int)std::floor((ndc_min.x + 1) * 0.5f * gx), 0, gx - 1);
+    int x1 = glm::clamp((int)std::floor((ndc_max.x + 1) * 0.5f * gx), 0, gx - 1);
+    int y0 = glm::clamp((int)std::floor((ndc_min.y + 1) * 0.5f * gy), 0, gy - 1);
+    int y1 = glm::clamp((int)std::floor((ndc_max.y + 1) * 0.5f * gy), 0, gy - 1);
+
+    for (int y = y0; y <= y1; ++y) {
+      for (int x = x0; x <= x1; ++x) {
+        unsigned tile = x + y * gx;
+        const glm::vec3& min = slice.bounds[2 * tile];
+        const glm::vec3& max = slice.bounds[2 * tile + 1];
+
+        // Sphere vs AABB
+        glm::vec3 closest = glm::clamp(light.position, min, max);
+        glm::vec3 delta = closest - light.position;
+        if (glm::dot(delta, delta) > light.range * light.range) {
+          continue;
+        }
+
+        // Cone vs the cluster bounding sphere
+        if (light.cos_angle < 1) {
+          glm::vec3 center = (min + max) * 0.5f;
+          float radius = glm::length(max - center);
+          glm::vec3 v = center - light.position;
+          float v_len_sq = glm::dot(v, v);
+          float v1_len = glm::dot(v, light.direction);
+          float closest_distance = 
+              light.cos_angle * std::sqrt(std::max(0.0f, v_len_sq - v1_len * v1_len)) - 
+              v1_len * light.sin_angle;
+          if (closest_distance > radius || v1_len > radius + light.range || 
+              v1_len < -radius) {
+            continue;
+          }
+        }
+
+        slice.pairs.push_back(glm::uvec2(tile, i));
+        ++slice.tiles[tile].y;
+      }
+    }
+  }
+
+  // Counting sort by tile, stable - the lights stay in the input order
+  unsigned offset = 0;
+  for (auto& tile: slice.tiles) {
+    tile.x = offset;
+    offset += tile.y;
+    tile.y = 0;
+  }
+  slice.indices.resize(slice.pairs.size());
+  for (auto& pair: slice.pairs) {
+    glm::uvec2& tile = slice.tiles[pair.x];
+    slice.indices[tile.x + tile.y++] = pair.y;
+  }
+}
+
+void LightClusters::Bin(const std::vector<Light>& lights, 
+                        const glm::mat4& view, const glm::mat4& proj, 
+                        float near, float far) {
+  auto start = std::chrono::steady_clock::now();
+
+  if (proj[2][3] == 0) {
+    ABORT_F("Light clusters need a perspective projection");
+  }
+  proj_ = proj;
+  near_ = near;
+  far_ = far;
+  depths_.resize(params_.grid_z + 1);
+  for (int z = 0; z <= params_.grid_z; ++z) {
+    depths_[z] = near * std::pow(far / near, (float)z / params_.grid_z);
+  }
+  // Exactly, no rounding errors on the ends
+  depths_[0] = near;
+  depths_[params_.grid_z] = far;
+
+  view_lights_.resize(lights.size());
+  for (size_t i = 0; i < lights.size(); ++i) {
+    const Light& light = lights[i];
+    ViewLight& view_light = view_lights_[i];
+    view_light.position = glm::vec3(view * glm::vec4(light.position, 1));
+    view_light.range = light.range;
+    if (light.spot_angle > 0) {
+      view_light.direction = glm::normalize(
+          glm::vec3(view * glm::vec4(light.direction, 0)));
+      view_light.cos_angle = std::cos(light.spot_angle);
+      view_light.sin_angle = std::sin(light.spot_angle);
+    } else {
+      view_light.direction = glm::vec3(0);
+      view_light.cos_angle = 1;
+      view_light.sin_angle = 0;
+    }
+  }
+
+  ParallelFor(0, params_.grid_z, params_.n_threads, [this](int begin, int end) {
+    for (int z = begin; z < end; ++z) {
+      BinSlice(z);
+    }
+  });
+
+  // Concatenate the slices
+  const int n_tiles = params_.grid_x * params_.grid_y;
+  size_t n_indices = 0;
+  for (auto& slice: slices_) {
+    n_indices += slice.indices.size();
+  }
+  indices_.resize(n_indices);
+
+  stats_ = Stats();
+  unsigned offset = 0;
+  for (int z = 0; z < params_.grid_z; ++z) {
+    Slice& slice = slices_[z];
+    std::copy(slice.indices.begin(), slice.indices.end(), 
+              indices_.begin() + offset);
+    for (int tile = 0; tile < n_tiles; ++tile) {
+      glm::uvec2 cluster = slice.tiles[tile];
+      cluster.x += offset;
+      clusters_[tile + z * n_tiles] = cluster;
+      stats_.max_cluster = std::max(stats_.max_cluster, (size_t)cluster.y);
+    }
+    offset += slice.indices.size();
+  }
+
+  stats_.lights = lights.size();
+  stats_.indices = n_indices;
+  stats_.bin_ms = std::chrono::duration<float, std::milli>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+int LightClusters::GetCluster(const glm::vec3& view_position) const {
+  float depth = -view_position.z;
+  if (depth < near_ || depth > far_) {
+    return -1;
+  }
+  glm::vec4 clip = proj_ * glm::vec4(view_position, 1);
+  glm::vec2 ndc = glm::vec2(clip) / clip.w;
+  if (std::abs(ndc.x) > 1 || std::abs(ndc.y) > 1) {
+    return -1;
+  }
+  // The same math as in the shaders
+  int x = std::min((int)((ndc.x + 1) * 0.5f * params_.grid_x), params_.grid_x - 1);
+  int y = std::min((int)((ndc.y + 1) * 0.5f * params_.grid_y), params_.grid_y - 1);
+  int z = (int)(std::log(depth / near_) * params_.grid_z / std::log(far_ / near_));
+  z = glm::clamp(z, 0, params_.grid_z - 1);
+  return x + params_.grid_x * (y + params_.grid_y * z);
+}
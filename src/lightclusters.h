@@ -0,0 +1,124 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _LIGHTCLUSTERS_H_F12E1561_82BD_4B0C_9413_9364CF5FEBF8_
+#define _LIGHTCLUSTERS_H_F12E1561_82BD_4B0C_9413_9364CF5FEBF8_ 
+
+#include "glm_main.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+// Clustered forward lighting, the CPU light binning.
+//
+// The view frustum is split into grid_x * grid_y screen tiles and grid_z 
+// slices, exponential in the view depth. Every point and spot light is
+// listed in the clusters its sphere touches, the spot lights are tested 
+// against the cone too. The slices are binned in parallel, each one into 
+// its own list, concatenated after - the result does not depend on the 
+// number of threads and the lights are in the input order in every cluster.
+//
+// For the shaders:
+//  - GetClusters() - (offset, count) into GetIndices() per cluster, 
+//    cluster = x + grid_x * (y + grid_y * z), see GetCluster()
+//  - GetIndices()  - the light indices
+//
+// clusters.Bin(lights, view, proj, near, far);
+// for (i = 0; i < clusters.GetClusters()[c].y; ++i) 
+//   lights[clusters.GetIndices()[clusters.GetClusters()[c].x + i]]...
+//////////////////////////////////////////////////////////////////////////////
+class LightClusters {
+ public:
+  struct Params {
+    int grid_x    = 16;
+    int grid_y    = 9;
+    int grid_z    = 24;
+    int n_threads = 0; // 0 - all the cores
+  };
+
+  // World space
+  struct Light {
+    glm::vec3 position;
+    float     range;
+    glm::vec3 direction;       // Spot lights, unit
+    float     spot_angle = 0;  // Cone half angle, radians, 0 - point light
+  };
+
+  struct Stats {
+    size_t lights      = 0;
+    size_t indices     = 0;
+    size_t max_cluster = 0;    // The longest cluster list
+    float  bin_ms      = 0;
+  };
+
+  explicit LightClusters(const Params& params);
+
+  // Perspective projection only, near and far are its clip planes
+  void Bin(const std::vector<Light>& lights, const glm::mat4& view, 
+           const glm::mat4& proj, float near, float far);
+
+  // -1 if the view space point is out of the frustum
+  int GetCluster(const glm::vec3& view_position) const;
+
+  int GetClusterCount() const { 
+    return params_.grid_x * params_.grid_y * params_.grid_z; 
+  }
+  const Params& GetParams() const { return params_; }
+  const std::vector<glm::uvec2>& GetClusters() const { return clusters_; }
+  const std::vector<uint32_t>& GetIndices() const { return indices_; }
+  const Stats& GetStats() const { return stats_; }
+
+ private:
+  struct ViewLight {
+    glm::vec3 position;
+    float     range;
+    glm::vec3 direction;
+    float     cos_angle;
+    float     sin_angle;
+  };
+
+  struct Slice {
+    std::vector<glm::uvec2> pairs;   // tile, light - unsorted
+    std::vector<uint32_t>   indices; // sorted by tile
+    std::vector<glm::uvec2> tiles;   // offset into indices, count
+    std::vector<glm::vec3>  bounds;  // min, max per tile, view space
+  };
+
+  void BinSlice(int z);
+  void ComputeBounds(int z);
+
+  Params                 params_;
+  glm::mat4              proj_;
+  float                  near_;
+  float                  far_;
+  std::vector<float>     depths_;  // Slice planes, grid_z + 1
+  std::vector<ViewLight> view_lights_;
+  std::vector<Slice>     slices_;
+  std::vector<glm::uvec2> clusters_;
+  std::vector<uint32_t>  indices_;
+  Stats                  stats_;
+};
+
+#endif // _LIGHTCLUSTERS_H_F12E1561_82BD_4B0C_9413_9364CF5FEBF8_
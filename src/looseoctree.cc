@@ -0,0 +1,286 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "looseoctree.h"
+#include "camera.h"
+#include "common/logging.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+void GetCenterExtent(const glm::vec3& min, const glm::vec3& max, 
+                     glm::vec3& center, float& extent) {
+  center = (min + max) * 0.5f;
+  glm::vec3 half = (max - min) * 0.5f;
+  extent = std::max(half.x, std::max(half.y, half.z));
+}
+
+bool InCell(const glm::vec3& point, const glm::vec3& center, float half) {
+  glm::vec3 d = glm::abs(point - center);
+  return d.x <= half && d.y <= half && d.z <= half;
+}
+
+bool Overlap(const glm::vec3& a_min, const glm::vec3& a_max,
+             const glm::vec3& b_min, const glm::vec3& b_max) {
+  return a_min.x <= b_max.x && b_min.x <= a_max.x &&
+         a_min.y <= b_max.y && b_min.y <= a_max.y &&
+         a_min.z <= b_max.z && b_min.z <= a_max.z;
+}
+
+} // namespace
+
+LooseOctree::LooseOctree(const Params& params) : params_(params) {
+  if (!(params_.half_size > 0) || params_.max_depth < 0) {
+    ABORT_F("Invalid octree, half size %f, depth %d", params_.half_size, 
+            params_.max_depth);
+  }
+  Node root;
+  root.center = params_.center;
+  root.half = params_.half_size;
+  root.depth = 0;
+  root.parent = -1;
+  std::fill(root.children, root.children + 8, -1);
+  root.count = 0;
+  nodes_.push_back(root);
+  stats_.nodes = 1;
+}
+
+uint32_t LooseOctree::Add(const glm::vec3& min, const glm::vec3& max) {
+  uint32_t id;
+  if (!free_ids_.empty()) {
+    id = free_ids_.back();
+    free_ids_.pop_back();
+  } else {
+    id = objects_.size();
+    objects_.emplace_back();
+  }
+  objects_[id].min = min;
+  objects_[id].max = max;
+  Link(id, FindNode(min, max));
+  ++stats_.objects;
+  return id;
+}
+
+void LooseOctree::Remove(uint32_t id) {
+  if (objects_.at(id).node < 0) {
+    ABORT_F("Box %u is already removed", id);
+  }
+  Unlink(id);
+  free_ids_.push_back(id);
+  --stats_.objects;
+}
+
+void LooseOctree::Update(uint32_t id, const glm::vec3& min, 
+                         const glm::vec3& max) {
+  Object& object = objects_.at(id);
+  if (object.node < 0) {
+    ABORT_F("Box %u is removed", id);
+  }
+  object.min = min;
+  object.max = max;
+  if (Fits(nodes_[object.node], min, max)) {
+    return;
+  }
+  Unlink(id);
+  Link(id, FindNode(min, max));
+  ++stats_.moves;
+}
+
+// The box belongs to the node: the center is in the cell, it is not bigger
+// than the cell, and it cannot go deeper. The root also takes everything 
+// out of the world.
+bool LooseOctree::Fits(const Node& node, const glm::vec3& min, 
+                       const glm::vec3& max) const {
+  glm::vec3 center;
+  float extent;
+  GetCenterExtent(min, max, center, extent);
+  bool in_cell = InCell(center, node.center, node.half);
+  if (node.parent >= 0 && (!in_cell || extent > node.half)) {
+    return false;
+  }
+  return node.depth >= params_.max_depth || extent > node.half * 0.5f || 
+         !in_cell;
+}
+
+int LooseOctree::FindNode(const glm::vec3& min, const glm::vec3& max) {
+  glm::vec3 center;
+  float extent;
+  GetCenterExtent(min, max, center, extent);
+  int index = 0;
+  while (!Fits(nodes_[index], min, max)) {
+    const Node& node = nodes_[index];
+    int octant = (center.x > node.center.x ? 1 : 0) | 
+                 (center.y > node.center.y ? 2 : 0) | 
+                 (center.z > node.center.z ? 4 : 0);
+    int child = node.children[octant];
+    if (child < 0) {
+      Node next;
+      next.half = node.half * 0.5f;
+      next.center = node.center + glm::vec3(octant & 1 ? next.half : -next.half,
+                                            octant & 2 ? next.half : -next.half,
+                                            octant & 4 ? next.half : -next.half);
+      next.depth = node.depth + 1;
+      next.parent = index;
+      std::fill(next.children, next.children + 8, -1);
+      next.count = 0;
+      if (!free_nodes_.empty()) {
+        child = free_nodes_.back();
+        free_nodes_.pop_back();
+        nodes_[child] = std::move(next);
+      } else {
+        child = nodes_.size();
+        nodes_.push_back(std::move(next)); // The node reference is gone
+      }
+      nodes_[index].children[octant] = child;
+      ++stats_.nodes;
+    }
+    index = child;
+  }
+  return index;
+}
+
+void LooseOctree::Link(uint32_t id, int node) {
+  Object& object = objects_[id];
+  object.node = node;
+  object.slot = nodes_[node].objects.size();
+  nodes_[node].objects.push_back(id);
+  for (int i = node; i >= 0; i = nodes_[i].parent) {
+    ++nodes_[i].count;
+  }
+}
+
+void LooseOctree::Unlink(uint32_t id) {
+  Object& object = objects_[id];
+  int node = object.node;
+  auto& objects = nodes_[node].objects;
+  uint32_t last = objects.back();
+  objects[object.slot] = last;
+  objects_[last].slot = object.slot;
+  objects.pop_back();
+  object.node = -1;
+  for (int i = node; i >= 0; i = nodes_[i].parent) {
+    --nodes_[i].count;
+  }
+
+  // The empty nodes go, the empty subtrees are gone already
+  while (node > 0 && nodes_[node].count == 0) {
+    Node& empty = nodes_[node];
+    int parent = empty.parent;
+    std::replace(nodes_[parent].children, nodes_[parent].children + 8, node, 
+                 -1);
+    std::vector<uint32_t>().swap(empty.objects);
+    free_nodes_.push_back(node);
+    --stats_.nodes;
+    node = parent;
+  }
+}
+
+void LooseOctree::AddSubtree(int node, std::vector<uint32_t>& ids) {
+  const Node& n = nodes_[node];
+  ids.insert(ids.end(), n.objects.begin(), n.objects.end());
+  stats_.found += n.objects.size();
+  for (int child: n.children) {
+    if (child >= 0) {
+      AddSubtree(child, ids);
+    }
+  }
+}
+
+template <typename TClassify, typename TTest>
+void LooseOctree::Search(TClassify&& classify, TTest&& test, 
+                         std::vector<uint32_t>& ids) {
+  stack_.clear();
+  stack_.push_back(0);
+  while (!stack_.empty()) {
+    int index = stack_.back();
+    stack_.pop_back();
+    const Node& node = nodes_[index];
+    if (node.count == 0) {
+      continue;
+    }
+
+    // The root has the boxes out of its bounds too
+    if (index != 0) {
+      ++stats_.node_tests;
+      glm::vec3 loose(node.half * 2);
+      auto containment = classify(node.center - loose, node.center + loose);
+      if (containment == Frustum::kOutside) {
+        continue;
+      }
+      if (containment == Frustum::kInside) {
+        AddSubtree(index, ids);
+        continue;
+      }
+    }
+
+    for (uint32_t id: node.objects) {
+      const Object& object = objects_[id];
+      ++stats_.object_tests;
+      if (test(object.min, object.max)) {
+        ids.push_back(id);
+        ++stats_.found;
+      }
+    }
+    for (int child: node.children) {
+      if (child >= 0) {
+        stack_.push_back(child);
+      }
+    }
+  }
+}
+
+void LooseOctree::Query(const Frustum& frustum, std::vector<uint32_t>& ids) {
+  Search([&](const glm::vec3& min, const glm::vec3& max) {
+          return frustum.ClassifyAabb(min, max);
+        },
+         [&](const glm::vec3& min, const glm::vec3& max) {
+          return frustum.TestAabb(min, max);
+         }, ids);
+}
+
+void LooseOctree::Query(const glm::vec3& min, const glm::vec3& max, 
+                        std::vector<uint32_t>& ids) {
+  Search([&](const glm::vec3& node_min, const glm::vec3& node_max) {
+          if (!Overlap(min, max, node_min, node_max)) {
+            return Frustum::kOutside;
+          }
+          if (min.x <= node_min.x && min.y <= node_min.y && 
+              min.z <= node_min.z && node_max.x <= max.x && 
+              node_max.y <= max.y && node_max.z <= max.z) {
+            return Frustum::kInside;
+          }
+          return Frustum::kIntersects;
+        },
+         [&](const glm::vec3& object_min, const glm::vec3& object_max) {
+          return Overlap(min, max, object_min, object_max);
+         }, ids);
+}
+
+void LooseOctree::ResetStats() {
+  stats_.moves = 0;
+  stats_.node_tests = 0;
+  stats_.object_tests = 0;
+  stats_.found = 0;
+}
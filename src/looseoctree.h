@@ -0,0 +1,128 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _LOOSEOCTREE_H_068CC92E_A47A_41DF_9DE1_8F4B2AF00D08_
+#define _LOOSEOCTREE_H_068CC92E_A47A_41DF_9DE1_8F4B2AF00D08_ 
+
+#include "glm_main.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Frustum;
+
+//////////////////////////////////////////////////////////////////////////////
+// Loose octree of the world boxes (the actor bounds), for the queries of 
+// the big worlds: what is in the frustum, what is around the cameras.
+//
+// A box lives in the deepest node whose cell is at least as big as the box,
+// the one which has the box center. The node bounds are the cell grown by 
+// half of its size on every side (the looseness of 2), so they contain all
+// the boxes of the node and a box moving inside of the cell stays in the 
+// node. The nodes are made on the demand and dropped once empty. The boxes
+// out of the root cell live in the root.
+//
+// LooseOctree octree(params);
+// uint32_t id = octree.Add(min, max);
+// ... when it moves:
+// octree.Update(id, min, max);
+// octree.Query(frustum, ids);
+//////////////////////////////////////////////////////////////////////////////
+class LooseOctree {
+ public:
+  struct Params {
+    glm::vec3 center    = glm::vec3(0);
+    float     half_size = 4096; // Of the root cell
+    int       max_depth = 8;  // The cells of half_size / 256
+  };
+
+  // The queries accumulate until ResetStats()
+  struct Stats {
+    size_t objects      = 0;
+    size_t nodes        = 0;
+    size_t moves        = 0; // Updates which changed the node
+    size_t node_tests   = 0;
+    size_t object_tests = 0; // Boxes tested, the rest of the found ones 
+    size_t found        = 0; // were in the nodes entirely inside
+  };
+
+  LooseOctree() : LooseOctree(Params()) {}
+  explicit LooseOctree(const Params& params);
+
+  // Returns the id, the ids of the removed boxes are reused
+  uint32_t Add(const glm::vec3& min, const glm::vec3& max);
+  void Remove(uint32_t id);
+  void Update(uint32_t id, const glm::vec3& min, const glm::vec3& max);
+
+  void GetBounds(uint32_t id, glm::vec3& min, glm::vec3& max) const {
+    min = objects_.at(id).min;
+    max = objects_.at(id).max;
+  }
+
+  // The ids of the boxes which intersect, appended
+  void Query(const Frustum& frustum, std::vector<uint32_t>& ids);
+  void Query(const glm::vec3& min, const glm::vec3& max, 
+             std::vector<uint32_t>& ids);
+
+  const Stats& GetStats() const { return stats_; }
+  void ResetStats();
+
+ private:
+  struct Node {
+    glm::vec3             center;
+    float                 half;        // Of the cell
+    int                   depth;
+    int                   parent;
+    int                   children[8]; // -1 - none
+    size_t                count;       // Boxes in the subtree
+    std::vector<uint32_t> objects;
+  };
+
+  struct Object {
+    glm::vec3 min;
+    glm::vec3 max;
+    int       node;  // -1 - removed
+    uint32_t  slot;  // In the node objects
+  };
+
+  int  FindNode(const glm::vec3& min, const glm::vec3& max);
+  bool Fits(const Node& node, const glm::vec3& min, 
+            const glm::vec3& max) const;
+  void Link(uint32_t id, int node);
+  void Unlink(uint32_t id);
+  void AddSubtree(int node, std::vector<uint32_t>& ids);
+
+  template <typename TClassify, typename TTest>
+  void Search(TClassify&& classify, TTest&& test, std::vector<uint32_t>& ids);
+
+  Params                params_;
+  std::vector<Node>     nodes_;
+  std::vector<int>      free_nodes_;
+  std::vector<Object>   objects_;
+  std::vector<uint32_t> free_ids_;
+  std::vector<int>      stack_;
+  Stats                 stats_;
+};
+
+#endif // _LOOSEOCTREE_H_068CC92E_A47A_41DF_9DE1_8F4B2AF00D08_
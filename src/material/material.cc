@@ -24,6 +24,7 @@
 
 #include "material/material.h"
 #include "common/logging.h"
+#include "profiler.h"
 #include <algorithm>
   
 //////////////////////////////////////////////////////////////////////////////
@@ -34,6 +35,7 @@ void Material::Bind() {
   for (int i = 0; i < (int)textures_.size(); ++i) {
     if (textures_[i]) {
       textures_[i]->Bind(i);
+      PROFILE_COUNT(kStateChanges, 1);
     }
   }
 }
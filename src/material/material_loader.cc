@@ -31,7 +31,10 @@
 #include "common/logging.h"
 #include "yaml_main.h"
 #include "image/loader.h"
+#include "resourcecache.h"
+#include "common/hash.h"
 #include <exception>
+#include <utility>
 #include <vector>
 
 static void LoadTextures(Material& material, YAML::Node node) {
@@ -39,20 +42,29 @@ static void LoadTextures(Material& material, YAML::Node node) {
   for (auto kv: node) {
     int slot = kv.first.as<int>();
     std::shared_ptr<Texture> texture;
+    auto& cache = ResourceCache::Instance();
     if (!kv.second.IsSequence()) {
       std::string filename = kv.second.as<std::string>();
-      texture = std::make_shared<Texture2D>(Image::Load(filename));
+      texture = cache.GetTexture(ResourceCache::FileKey(filename), [&]() {
+        return std::make_shared<Texture2D>(Image::Load(filename));
+      });
     } else {
       auto ls = kv.second.as<std::vector<std::string>>();
-      std::shared_ptr<Image::ColorMap> cubemap[6] = {
-        Image::Load(ls.at(0)), 
-        Image::Load(ls.at(1)), 
-        Image::Load(ls.at(2)), 
-        Image::Load(ls.at(3)), 
-        Image::Load(ls.at(4)), 
-        Image::Load(ls.at(5))
-      };
-      texture = std::make_shared<TextureCube>(cubemap);
+      std::string key;
+      for (int i = 0; i < 6; ++i) {
+        key += ResourceCache::FileKey(ls.at(i)) + ";";
+      }
+      texture = cache.GetTexture(key, [&]() {
+        std::shared_ptr<Image::ColorMap> cubemap[6] = {
+          Image::Load(ls.at(0)), 
+          Image::Load(ls.at(1)), 
+          Image::Load(ls.at(2)), 
+          Image::Load(ls.at(3)), 
+          Image::Load(ls.at(4)), 
+          Image::Load(ls.at(5))
+        };
+        return std::make_shared<TextureCube>(cubemap);
+      });
     }
 
     if (texture) {
@@ -116,9 +128,12 @@ static BlendOp::Value StringToBlendOp(const std::string& s) {
 }
 
 
+// Passes with the shader still being built
+static std::vector<std::weak_ptr<Pass>> pending_passes;
+
 static std::shared_ptr<Pass> LoadPass(YAML::Node node) {
   std::shared_ptr<Pass> pass(new Pass());
-  std::shared_ptr<Shader> shader(new Shader());
+  std::vector<std::pair<ShaderCompiler::ShaderType, std::string>> stages;
 
   static const std::string kNameKey           = "name";
   static const std::string kTagsKey           = "tags";
@@ -165,35 +180,64 @@ static std::shared_ptr<Pass> LoadPass(YAML::Node node) {
       pass->options.SetSrcBlendFactor(StringToBlendFactor(factors[0]));
       pass->options.SetDstBlendFactor(StringToBlendFactor(factors[1]));
     } else if (key == kVertexShaderKey) {
-      shader->Compile(ShaderCompiler::ShaderType::kVertexShader,
-                      ReadShaderSourceCode(subnode.second));
+      stages.emplace_back(ShaderCompiler::ShaderType::kVertexShader,
+                          ReadShaderSourceCode(subnode.second));
     } else if (key == kFragmentShaderKey) {
-      shader->Compile(ShaderCompiler::ShaderType::kFragmentShader,
-                      ReadShaderSourceCode(subnode.second));
+      stages.emplace_back(ShaderCompiler::ShaderType::kFragmentShader,
+                          ReadShaderSourceCode(subnode.second));
     } else if (key == kGeometryShaderKey) {
-      shader->Compile(ShaderCompiler::ShaderType::kGeometryShader, 
-                      ReadShaderSourceCode(subnode.second));
+      stages.emplace_back(ShaderCompiler::ShaderType::kGeometryShader,
+                          ReadShaderSourceCode(subnode.second));
     } else if (key == kTessControlShaderKey) {
-      shader->Compile(ShaderCompiler::ShaderType::kTessControlShader,
-                      ReadShaderSourceCode(subnode.second));
+      stages.emplace_back(ShaderCompiler::ShaderType::kTessControlShader,
+                          ReadShaderSourceCode(subnode.second));
     } else if (key == kTessEvaluationShaderKey) {
-      shader->Compile(ShaderCompiler::ShaderType::kTessEvaluationShader,
-                      ReadShaderSourceCode(subnode.second));
+      stages.emplace_back(ShaderCompiler::ShaderType::kTessEvaluationShader,
+                          ReadShaderSourceCode(subnode.second));
     }
   }
 
-  shader->Link();
-  LOG_SCOPE_F(INFO, "Pass: %s", pass->GetName().c_str());
-  LOG_F(INFO, "Queue: %d", pass->GetQueue());
-  shader->PrintInfo();
+  // Passes with the same sources share one program
+  Hash64 hash;
+  for (auto& stage: stages) {
+    hash.Add(static_cast<uint64_t>(stage.first)).Add(stage.second);
+  }
+
+  auto shader = ResourceCache::Instance().GetShader(hash.Get(), [&]() {
+    std::shared_ptr<Shader> shader(new Shader());
+    if (!shader->LoadBinary(hash.Get())) {
+      for (auto& stage: stages) {
+        shader->Compile(stage.first, stage.second);
+      }
+      // Dont wait here, the rest of the materials can compile meanwhile
+      shader->LinkAsync();
+    }
+    return shader;
+  });
+
   pass->SetShader(shader);
+  if (!shader->IsLinked()) {
+    pending_passes.push_back(pass);
+  }
   return pass;
 }
 
+// Parsed material files. They are tiny, so kept for the whole run.
+static YAML::Node LoadDocument(const std::string& filename) {
+  static std::map<std::string, YAML::Node> documents;
+
+  auto key = ResourceCache::FileKey(filename);
+  auto it = documents.find(key);
+  if (it == documents.end()) {
+    it = documents.emplace(key, YAML::LoadFile(filename)).first;
+  }
+  return it->second;
+}
+
 std::shared_ptr<Material> MaterialLoader::Load(const std::string& filename) {
   std::shared_ptr<Material> material(new Material());
 
-  YAML::Node root = YAML::LoadFile(filename);
+  YAML::Node root = LoadDocument(filename);
 
   const std::string kNameKey     = "name";
   const std::string kTexturesKey = "textures";
@@ -220,3 +264,26 @@ std::shared_ptr<Material> MaterialLoader::Load(const std::string& filename) {
 
   return material;
 }
+
+size_t MaterialLoader::Poll() {
+  size_t n_pending = 0;
+  for (auto it = pending_passes.begin(); it != pending_passes.end(); ) {
+    auto pass = it->lock();
+    if (!pass || pass->IsReady()) {
+      it = pending_passes.erase(it);
+    } else {
+      ++n_pending;
+      ++it;
+    }
+  }
+  return n_pending;
+}
+
+void MaterialLoader::Wait() {
+  for (auto& weak_pass: pending_passes) {
+    if (auto pass = weak_pass.lock()) {
+      pass->Wait();
+    }
+  }
+  pending_passes.clear();
+}
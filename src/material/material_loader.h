@@ -32,10 +32,21 @@
 
 //////////////////////////////////////////////////////////////////////////////
 // Load material stored in YAML file
+//
+// Shaders are compiled and linked in the background (Shader::LinkAsync()).
+// Load() returns right away and the passes which are not built yet are
+// skipped by the render queue. So loading many materials in a row lets the 
+// driver build them in parallel, while the frame loop keeps running.
 //////////////////////////////////////////////////////////////////////////////
 class MaterialLoader {
  public:
   static std::shared_ptr<Material> Load(const std::string& filename);
+
+  // Finishes the passes which are done, returns how many are still building
+  static size_t Poll();
+
+  // Blocks until all the passes are done
+  static void Wait();
 };
 
 #endif // _MATERIAL_LOADER_H_1F3034F9_92C2_44C5_9A84_73CF8F2D9552_
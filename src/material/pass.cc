@@ -24,6 +24,7 @@
 
 #include "material/pass.h"
 #include "gl_main.h"
+#include "profiler.h"
 #include <exception>
 
 //////////////////////////////////////////////////////////////////////////////
@@ -153,8 +154,10 @@ void Pass::Bind() {
   if (!shader_) {
     ABORT_F("Shader not set");
   }
+  Wait();
   shader_->Bind();
   options.Bind();
+  PROFILE_COUNT(kStateChanges, 1);
 }
 
 void Pass::Unbind() {
@@ -167,17 +170,60 @@ void Pass::Unbind() {
 
 void Pass::SetShader(std::shared_ptr<Shader> shader) {
   shader_ = shader;
+  ready_ = false;
+  if (shader_->IsLinked()) {
+    IsReady();
+  }
+}
 
-  su_pvm_location_ = shader->GetUniformLocation("SU_PVM_MATRIX");
-  su_p_location_ = shader->GetUniformLocation("SU_P_MATRIX");
-  su_v_location_ = shader->GetUniformLocation("SU_V_MATRIX");
-  su_m_location_ = shader->GetUniformLocation("SU_M_MATRIX");
-  su_dirlight_dir_ = shader->GetUniformLocation("SU_DIRECTIONAL_LIGHT_DIRECTION_0");
-  su_dirlight_col_ = shader->GetUniformLocation("SU_DIRECTIONAL_LIGHT_COLOR_0");
+bool Pass::IsReady() {
+  if (ready_) {
+    return true;
+  }
+  if (!shader_) {
+    ABORT_F("Shader not set");
+  }
+
+  if (!shader_->IsLinked()) {
+    if (!shader_->IsReady()) {
+      return false;
+    }
+    shader_->Finish();
+  }
+
+  su_pvm_location_ = shader_->GetUniformLocation("SU_PVM_MATRIX");
+  su_p_location_ = shader_->GetUniformLocation("SU_P_MATRIX");
+  su_v_location_ = shader_->GetUniformLocation("SU_V_MATRIX");
+  su_m_location_ = shader_->GetUniformLocation("SU_M_MATRIX");
+  su_dirlight_dir_ = shader_->GetUniformLocation("SU_DIRECTIONAL_LIGHT_DIRECTION_0");
+  su_dirlight_col_ = shader_->GetUniformLocation("SU_DIRECTIONAL_LIGHT_COLOR_0");
   for (int i = 0; i < sizeof(su_textures)/sizeof(int); ++i) {
-    su_textures[i] = shader->GetUniformLocation("TEXTURE_" + std::to_string(i));
+    su_textures[i] = shader_->GetUniformLocation("TEXTURE_" + std::to_string(i));
+  }
+  su_time_location_ = shader_->GetUniformLocation("SU_TIME");
+  for (int i = 0; i < 6; ++i) {
+    su_cube_pv_locations_[i] = 
+      shader_->GetUniformLocation("SU_CUBE_PV_MATRIX_" + std::to_string(i));
+  }
+  su_cube_faces_location_ = shader_->GetUniformLocation("SU_CUBE_FACES");
+  su_cluster_lights_location_ = shader_->GetUniformLocation("SU_CLUSTER_LIGHTS");
+  su_cluster_clusters_location_ = shader_->GetUniformLocation("SU_CLUSTER_CLUSTERS");
+  su_cluster_indices_location_ = shader_->GetUniformLocation("SU_CLUSTER_INDICES");
+  su_cluster_grid_location_ = shader_->GetUniformLocation("SU_CLUSTER_GRID");
+  su_cluster_depth_location_ = shader_->GetUniformLocation("SU_CLUSTER_DEPTH");
+
+  LOG_SCOPE_F(INFO, "Pass: %s", name_.c_str());
+  shader_->PrintInfo();
+
+  ready_ = true;
+  return true;
+}
+
+void Pass::Wait() {
+  if (!IsReady()) {
+    shader_->Finish();
+    IsReady();
   }
-  su_time_location_ = shader->GetUniformLocation("SU_TIME");
 }
   
 void Pass::SuPvmMatrix(const glm::mat4& pvm) {
@@ -210,3 +256,20 @@ void Pass::SuTextures() {
 void Pass::SuTime(float time) {
   shader_->SetUniform(su_time_location_, time);
 }
+
+void Pass::SuCubePvMatrix(int face, const glm::mat4& pv) {
+  shader_->SetUniform(su_cube_pv_locations_[face], pv);
+}
+
+void Pass::SuCubeFaces(int faces) {
+  shader_->SetUniform(su_cube_faces_location_, faces);
+}
+
+void Pass::SuClusters(int lights_slot, int clusters_slot, int indices_slot,
+                      const glm::vec4& grid, const glm::vec2& depth) {
+  shader_->SetUniform(su_cluster_lights_location_, lights_slot);
+  shader_->SetUniform(su_cluster_clusters_location_, clusters_slot);
+  shader_->SetUniform(su_cluster_indices_location_, indices_slot);
+  shader_->SetUniform(su_cluster_grid_location_, grid);
+  shader_->SetUniform(su_cluster_depth_location_, depth);
+}
@@ -207,7 +207,15 @@ class Pass {
   void SetQueue(int queue) {queue_ = queue;}
   int  GetQueue() const {return queue_;}
 
+  // Shader may be still linking (see Shader::LinkAsync()), the pass is not
+  // ready to draw until it is done.
   void SetShader(std::shared_ptr<Shader> shader);
+
+  // Non-blocking, finishes the shader if the driver is done with it
+  bool IsReady();
+
+  // Blocks until the shader is done
+  void Wait();
   
   void SetTags(const std::vector<std::string>& tags) {
     tags_.Set(tags);
@@ -247,11 +255,23 @@ class Pass {
   void SuTextures();
   void SuTime(float time);
 
+  // Single-pass cubemap rendering: per-face projection * view matrices and
+  // the bit mask of the faces the actor is visible on (+x -x +y -y +z -z)
+  void SuCubePvMatrix(int face, const glm::mat4& pv);
+  void SuCubeFaces(int faces);
+
+  // Clustered forward lighting, see ClusteredLighting: the texture units of
+  // the light, cluster and index buffers, the grid (x, y, z, lights) and 
+  // the depth slicing (near, grid z / log(far / near))
+  void SuClusters(int lights_slot, int clusters_slot, int indices_slot,
+                  const glm::vec4& grid, const glm::vec2& depth);
+
  public:
   std::string             name_;
   int                     queue_;
   std::shared_ptr<Shader> shader_;
   Tags                    tags_;
+  bool                    ready_ = false;
 
   // STD uniforms locations 
   int su_pvm_location_ = -1;
@@ -262,6 +282,13 @@ class Pass {
   int su_dirlight_col_ = -1;
   int su_textures[32] = {-1};
   int su_time_location_ = -1;
+  int su_cube_pv_locations_[6] = {-1, -1, -1, -1, -1, -1};
+  int su_cube_faces_location_ = -1;
+  int su_cluster_lights_location_ = -1;
+  int su_cluster_clusters_location_ = -1;
+  int su_cluster_indices_location_ = -1;
+  int su_cluster_grid_location_ = -1;
+  int su_cluster_depth_location_ = -1;
 };
 
 
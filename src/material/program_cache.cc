@@ -0,0 +1,212 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "material/program_cache.h"
+#include "common/hash.h"
+#include "common/logging.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+// File layout: header, then the binary as is
+struct ProgramBinaryHeader {
+  char     magic[4];
+  uint32_t version;
+  uint64_t key;
+  uint32_t format;
+  uint32_t length;
+};
+
+static const char     kMagic[4] = {'B', '3', 'D', 'P'};
+static const uint32_t kVersion  = 1;
+
+static void MakeDirectory(const std::string& directory) {
+#ifdef _WIN32
+  _mkdir(directory.c_str());
+#else
+  mkdir(directory.c_str(), 0755);
+#endif
+}
+
+static std::string GetGlString(GLenum name) {
+  auto s = reinterpret_cast<const char*>(glGetString(name));
+  return s ? s : "";
+}
+
+void ProgramCache::SetDirectory(const std::string& directory) {
+  directory_ = directory;
+  if (!directory_.empty()) {
+    MakeDirectory(directory_);
+  }
+}
+
+bool ProgramCache::IsEnabled() {
+  if (directory_.empty()) {
+    return false;
+  }
+
+  if (supported_ < 0) {
+    GLint n_formats = 0;
+    if (GLAD_GL_VERSION_4_1 || GLAD_GL_ARB_get_program_binary) {
+      glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &n_formats);
+    }
+    supported_ = n_formats > 0 ? 1 : 0;
+    if (!supported_) {
+      LOG_F(INFO, "Program binaries are not supported by the driver");
+    }
+
+    driver_hash_ = Hash64().Add(GetGlString(GL_VENDOR))
+                           .Add(GetGlString(GL_RENDERER))
+                           .Add(GetGlString(GL_VERSION))
+                           .Get();
+  }
+
+  return supported_ == 1;
+}
+
+uint64_t ProgramCache::GetKey(uint64_t source_hash) const {
+  return Hash64().Add(driver_hash_).Add(source_hash).Get();
+}
+
+std::string ProgramCache::GetFilename(uint64_t key) const {
+  return directory_ + "/" + Hash64().Add(key).ToString() + ".bin";
+}
+
+bool ProgramCache::Load(uint64_t source_hash, GLuint program) {
+  if (!IsEnabled()) {
+    return false;
+  }
+
+  auto key = GetKey(source_hash);
+  auto filename = GetFilename(key);
+
+  GLenum format;
+  std::vector<char> binary;
+  if (!ReadFile(filename, key, format, binary)) {
+    stats_.misses++;
+    return false;
+  }
+
+  glProgramBinary(program, format, binary.data(), 
+                  static_cast<GLsizei>(binary.size()));
+
+  GLint result = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &result);
+  if (result == GL_FALSE) {
+    LOG_F(INFO, "Stale program binary %s", filename.c_str());
+    std::remove(filename.c_str());
+    stats_.rejected++;
+    return false;
+  }
+
+  stats_.hits++;
+  return true;
+}
+
+void ProgramCache::Store(uint64_t source_hash, GLuint program) {
+  if (!IsEnabled()) {
+    return;
+  }
+
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) {
+    return;
+  }
+
+  GLenum format = 0;
+  std::vector<char> binary(length);
+  glGetProgramBinary(program, length, &length, &format, binary.data());
+  binary.resize(length);
+
+  auto key = GetKey(source_hash);
+  WriteFile(GetFilename(key), key, format, binary);
+  stats_.stored++;
+}
+
+bool ProgramCache::ReadFile(const std::string& filename, uint64_t key,
+                            GLenum& format, std::vector<char>& binary) const {
+  std::ifstream in(filename, std::ios::in | std::ios::binary);
+  if (!in.is_open()) {
+    return false;
+  }
+
+  ProgramBinaryHeader header;
+  in.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!in || memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion || header.key != key) {
+    return false;
+  }
+
+  binary.resize(header.length);
+  in.read(binary.data(), binary.size());
+  if (!in) {
+    return false;
+  }
+
+  format = header.format;
+  return true;
+}
+
+void ProgramCache::WriteFile(const std::string& filename, uint64_t key,
+                             GLenum format, 
+                             const std::vector<char>& binary) const {
+  // Write aside and rename, so a crash never leaves a truncated file
+  std::string temp = filename + ".tmp";
+  {
+    std::ofstream out(temp, std::ios::out | std::ios::binary);
+    if (!out.is_open()) {
+      LOG_F(INFO, "Cant write %s", temp.c_str());
+      return;
+    }
+
+    ProgramBinaryHeader header;
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.key     = key;
+    header.format  = format;
+    header.length  = static_cast<uint32_t>(binary.size());
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(binary.data(), binary.size());
+  }
+
+  std::remove(filename.c_str());
+  std::rename(temp.c_str(), filename.c_str());
+}
+
+void ProgramCache::PrintStats(std::ostream& out) const {
+  size_t total = stats_.hits + stats_.misses + stats_.rejected;
+  out << "Program binary cache: hits " << stats_.hits 
+      << ", misses " << stats_.misses
+      << ", rejected " << stats_.rejected
+      << ", stored " << stats_.stored;
+  if (total) {
+    out << " (hit rate " << (100 * stats_.hits / total) << "%)";
+  }
+  out << std::endl;
+}
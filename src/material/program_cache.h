@@ -0,0 +1,87 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _PROGRAM_CACHE_H_71688D64_E186_4B93_89A7_52C4CB89A6E4_
+#define _PROGRAM_CACHE_H_71688D64_E186_4B93_89A7_52C4CB89A6E4_ 
+
+#include "gl_main.h"
+#include "singleton.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+// On-disk cache of linked program binaries (glGetProgramBinary). Skips
+// compiling and linking GLSL on the next start.
+//
+// A file is named after the hash of the stage sources and the driver
+// (vendor, renderer and version strings), so a driver update just misses.
+// A file the driver refuses to load is deleted and the program is built
+// from sources again.
+//
+// Off by default. Turn it on right after AppContext::Init():
+//   ProgramCache::Instance().SetDirectory("shader_cache");
+//////////////////////////////////////////////////////////////////////////////
+class ProgramCache : public Singleton<ProgramCache> {
+ public:
+  struct Stats {
+    size_t hits     = 0;
+    size_t misses   = 0;
+    size_t rejected = 0; // Present on disk, but refused by the driver
+    size_t stored   = 0;
+  };
+
+  // Creates the directory if needed. Empty string turns the cache off.
+  void SetDirectory(const std::string& directory);
+
+  // Directory is set and the driver can give out program binaries
+  bool IsEnabled();
+
+  // Loads the binary into the program. False if there is no usable binary,
+  // the program must be built from the sources then.
+  bool Load(uint64_t source_hash, GLuint program);
+
+  // Program must be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+  void Store(uint64_t source_hash, GLuint program);
+
+  const Stats& GetStats() const { return stats_; }
+  void PrintStats(std::ostream& out) const;
+
+ private:
+  uint64_t    GetKey(uint64_t source_hash) const;
+  std::string GetFilename(uint64_t key) const;
+  bool ReadFile(const std::string& filename, uint64_t key, 
+                GLenum& format, std::vector<char>& binary) const;
+  void WriteFile(const std::string& filename, uint64_t key, 
+                 GLenum format, const std::vector<char>& binary) const;
+
+  std::string directory_;
+  uint64_t    driver_hash_ = 0;
+  int         supported_   = -1; // -1 is not checked yet
+  Stats       stats_;
+};
+
+#endif // _PROGRAM_CACHE_H_71688D64_E186_4B93_89A7_52C4CB89A6E4_
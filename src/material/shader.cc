@@ -23,6 +23,7 @@
 //
 
 #include "shader.h"
+#include "program_cache.h"
 #include "common/logging.h"
 
 #include <typeinfo>
@@ -50,10 +51,14 @@ ShaderCompiler::ShaderCompiler(ShaderCompiler::ShaderType type,
   // Beauty separator
   shader_id_ = glCreateShader(type);
 
+  // No status query here, it would wait for the compilation. Let the driver
+  // overlap it with the others, the errors are checked in CheckStatus().
   const char* code_ptr = source_code.c_str();
   glShaderSource(shader_id_, 1, &code_ptr, nullptr);
   glCompileShader(shader_id_);
+}
 
+void ShaderCompiler::CheckStatus() {
   GLint result = GL_FALSE;
   glGetShaderiv(shader_id_, GL_COMPILE_STATUS, &result);
   if (result == GL_FALSE) {
@@ -76,7 +81,7 @@ ShaderCompiler::~ShaderCompiler() {
 // Shader. 
 //////////////////////////////////////////////////////////////////////////////
 
-Shader::Shader() : program_id_(0) {}
+Shader::Shader() : program_id_(0), linked_(false), binary_key_(0) {}
 
 Shader::~Shader() {
   if (program_id_) {
@@ -84,12 +89,35 @@ Shader::~Shader() {
   }
 }
 
+// Lets the driver use as many threads as it wants for the compilation
+static bool HasParallelCompile() {
+  static int enabled = -1;
+  if (enabled < 0) {
+    if (GLAD_GL_KHR_parallel_shader_compile) {
+      glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+      enabled = 1;
+    } else if (GLAD_GL_ARB_parallel_shader_compile) {
+      glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+      enabled = 1;
+    } else {
+      enabled = 0;
+    }
+  }
+  return enabled == 1;
+}
+
 void Shader::Compile(ShaderCompiler::ShaderType type, const std::string& code) {
+  HasParallelCompile();
   ShaderCompilerPtr compiler(new ShaderCompiler(type, code));
   shader_compilers_[compiler->GetShaderId()] = compiler;
 }
 
 void Shader::Link() {
+  LinkAsync();
+  Finish();
+}
+
+void Shader::LinkAsync() {
   if (shader_compilers_.empty()) {
     ABORT_F("Shader is not compiled");
   }
@@ -98,18 +126,54 @@ void Shader::Link() {
     glDeleteProgram(program_id_);
   }
   program_id_ = glCreateProgram();
+  linked_ = false;
 
   // Attach shader pieces (way clearer than for_each + lambda!)
   for (auto& kv : shader_compilers_) {
     glAttachShader(program_id_, kv.second->GetShaderId());
   }
 
+  // Otherwise the driver may refuse to give out the binary
+  if (binary_key_ && ProgramCache::Instance().IsEnabled()) {
+    glProgramParameteri(program_id_, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
 
-  // Linking happens here
-  GLint result;
+  // Linking starts here, the status is checked in Finish()
   glLinkProgram(program_id_);
+}
+
+bool Shader::IsReady() const {
+  if (linked_) {
+    return true;
+  }
+  if (program_id_ == 0) {
+    return false;
+  }
+  // Without the extension there is no way to ask, Finish() just waits
+  if (!HasParallelCompile()) {
+    return true;
+  }
+
+  GLint completed = GL_FALSE;
+  glGetProgramiv(program_id_, GL_COMPLETION_STATUS_KHR, &completed);
+  return completed == GL_TRUE;
+}
+
+void Shader::Finish() {
+  if (linked_) {
+    return;
+  }
+  if (program_id_ == 0) {
+    ABORT_F("Shader is not compiled");
+  }
+
+  GLint result;
   glGetProgramiv(program_id_, GL_LINK_STATUS, &result);
   if (result == GL_FALSE) {
+    // Most likely one of the stages did not compile, report that first
+    for (auto& kv : shader_compilers_) {
+      kv.second->CheckStatus();
+    }
 
     std::string error = GetProgramInfoLog(program_id_, true);
 
@@ -130,6 +194,38 @@ void Shader::Link() {
 
   // Dont need the compiled parts anymore
   shader_compilers_.clear();
+  linked_ = true;
+
+  if (binary_key_) {
+    StoreBinary(binary_key_);
+  }
+}
+
+bool Shader::LoadBinary(uint64_t source_hash) {
+  binary_key_ = source_hash;
+
+  GLuint program_id = glCreateProgram();
+  if (!ProgramCache::Instance().Load(source_hash, program_id)) {
+    glDeleteProgram(program_id);
+    return false;
+  }
+
+  if (program_id_) {
+    glDeleteProgram(program_id_);
+  }
+  program_id_ = program_id;
+  RebuildUniforms();
+  shader_compilers_.clear();
+  linked_ = true;
+  binary_key_ = 0;
+  return true;
+}
+
+void Shader::StoreBinary(uint64_t source_hash) const {
+  if (program_id_ == 0) {
+    ABORT_F("Shader is not compiled");
+  }
+  ProgramCache::Instance().Store(source_hash, program_id_);
 }
 
 void Shader::PrintInfo() const {
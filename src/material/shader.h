@@ -114,6 +114,9 @@ class ShaderCompiler {
   ShaderCompiler(ShaderType type, const std::string& source_code);
   virtual ~ShaderCompiler();
 
+  // Waits for the compilation, aborts on error
+  void CheckStatus();
+
   ShaderType GetShaderType() const { return type_; }
   uint32_t   GetShaderId()   const { return shader_id_; }
 
@@ -153,6 +156,7 @@ class Shader {
 
   /////////////////////////////////////////////////////////////////////////////
   // Compiles part of shader (VS, GS, FS). Replaces if exist. 
+  // Does not wait for the driver, errors are reported by Link() / Finish().
   /////////////////////////////////////////////////////////////////////////////
   void Compile(ShaderCompiler::ShaderType type, const std::string& code);
 
@@ -164,6 +168,28 @@ class Shader {
   /////////////////////////////////////////////////////////////////////////////
   void Link();
 
+  /////////////////////////////////////////////////////////////////////////////
+  // Same as Link(), but split in two, so many programs can be built at the
+  // same time (GL_KHR_parallel_shader_compile).
+  // LinkAsync() starts linking and returns immediately.
+  // IsReady() tells if Finish() would not block. Always true without the
+  // extension.
+  // Finish() waits, checks errors and makes the program usable.
+  /////////////////////////////////////////////////////////////////////////////
+  void LinkAsync();
+  bool IsReady() const;
+  void Finish();
+  bool IsLinked() const { return linked_; }
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Program binary cache, see ProgramCache. Key is the hash of all the stage 
+  // sources. 
+  // LoadBinary() replaces Compile() + Link() if returns true. Otherwise the
+  // key is kept and the binary is stored by Link() / Finish().
+  /////////////////////////////////////////////////////////////////////////////
+  bool LoadBinary(uint64_t source_hash);
+  void StoreBinary(uint64_t source_hash) const;
+
   ////////////////////////////////////////////////////////////////////////////
   // Make it active / deactive for draw call
   ////////////////////////////////////////////////////////////////////////////
@@ -245,6 +271,8 @@ class Shader {
   std::map<GLuint, ShaderCompilerPtr>    shader_compilers_;
   std::map<std::string, UniformInfo>     uniforms_;
   GLuint                                 program_id_; 
+  bool                                   linked_;
+  uint64_t                               binary_key_;
 };
 
 #endif // _SHADER_H_13CCC4E1_0635_4DB7_8334_A8318AFB89F8_
@@ -28,6 +28,9 @@
 #include "glm_main.h"
 #include <vector>
 #include <functional>
+#include <memory>
+
+class IndexBuffer;
 
 //////////////////////////////////////////////////////////////////////////////
 // Just instead of full-inheritence-virtualization 
@@ -144,6 +147,10 @@ class Mesh {
   std::vector< glm::vec3 >      normals;
   std::vector< glm::vec4 >      colors;
   std::vector< glm::vec2 >      uv;
+
+  // Same as the indices, uploaded once for all the meshes which share it.
+  // MeshFilter::UpdateIndices() drops it, the indices are not shared then.
+  std::shared_ptr<IndexBuffer>  index_buffer;
 };
 
 #endif // _MESH_H_0DBCC8DE_F0FB_4E34_A4EC_505710111974_
@@ -30,7 +30,9 @@
   
 MeshFilter::MeshFilter() 
     : bake_mode_(kStatic),
-      index_type_(GL_UNSIGNED_INT) {
+      index_type_(GL_UNSIGNED_INT),
+      bounds_min_(0),
+      bounds_max_(0) {
   vao_.reset(new VertexArrayObject());
   attrib_slots_.flip();
 }
@@ -47,6 +49,12 @@ void MeshFilter::Bake() {
   AdjustSlots();
   RecalculateIndexType();
 
+  bounds_min_ = bounds_max_ = mesh_->vertices.empty() ? glm::vec3(0) : mesh_->vertices[0];
+  for (auto& v: mesh_->vertices) {
+    bounds_min_ = glm::min(bounds_min_, v);
+    bounds_max_ = glm::max(bounds_max_, v);
+  }
+
   auto usage = GetUsage();
 
   vao_->Bind();
@@ -66,7 +74,10 @@ void MeshFilter::Bake() {
     vao_->Upload(3, VertexArrayObject::PackedData::Pack(mesh_->uv), usage);
   }
   
-  if (attrib_slots_[MeshFilterBase::kIndices] && !mesh_->indices.empty()) {
+  if (attrib_slots_[MeshFilterBase::kIndices] && mesh_->index_buffer) {
+    index_type_ = mesh_->index_buffer->GetType();
+    vao_->SetIndices(mesh_->index_buffer);
+  } else if (attrib_slots_[MeshFilterBase::kIndices] && !mesh_->indices.empty()) {
     if (index_type_ == GL_UNSIGNED_SHORT) {
       std::vector<uint16_t> indices(mesh_->indices.begin(), mesh_->indices.end());
       vao_->UploadIndices(VertexArrayObject::PackedData::Pack(indices), usage);
@@ -81,6 +92,24 @@ void MeshFilter::Bake() {
   vao_->Unbind();
 }
 
+void MeshFilter::UpdateIndices() {
+  if (!mesh_ || mesh_->indices.empty()) {
+    ABORT_F("Mesh has no indices");
+  }
+  mesh_->index_buffer.reset();
+
+  RecalculateIndexType();
+
+  vao_->Bind();
+  if (index_type_ == GL_UNSIGNED_SHORT) {
+    std::vector<uint16_t> indices(mesh_->indices.begin(), mesh_->indices.end());
+    vao_->UploadIndices(VertexArrayObject::PackedData::Pack(indices), GetUsage());
+  } else {
+    vao_->UploadIndices(VertexArrayObject::PackedData::Pack(mesh_->indices), GetUsage());
+  }
+  vao_->Unbind();
+}
+
 void MeshFilter::AdjustSlots() {
   if (attrib_slots_[MeshFilterBase::kNormal] && mesh_->normals.empty()) {
     attrib_slots_[MeshFilterBase::kNormal] = 0;
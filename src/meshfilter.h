@@ -76,6 +76,24 @@ class MeshFilter : public MeshFilterBase {
     }
   }
 
+  ////////////////////////////////////////////////////////////////////////////
+  // Re-uploads the index buffer only, when just the mesh indices changed
+  // (same vertices, e.g. stitched terrain edges).
+  ////////////////////////////////////////////////////////////////////////////
+  void UpdateIndices();
+
+  ////////////////////////////////////////////////////////////////////////////
+  // Model space AABB of the baked mesh, false if there is no mesh
+  ////////////////////////////////////////////////////////////////////////////
+  bool GetBounds(glm::vec3& min, glm::vec3& max) const {
+    if (!mesh_ || mesh_->vertices.empty()) {
+      return false;
+    }
+    min = bounds_min_;
+    max = bounds_max_;
+    return true;
+  }
+
   std::shared_ptr<Mesh> GetMesh() {
     return mesh_;
   }
@@ -110,6 +128,12 @@ class MeshFilter : public MeshFilterBase {
     vao_->Upload<TLayout>(std::forward<TArgs>(args)...);
   }
 
+  template <typename TLayout, typename... TArgs>
+  void UploadRange(TArgs&&... args) {
+    assert(vao_);
+    vao_->UploadRange<TLayout>(std::forward<TArgs>(args)...);
+  }
+
  private:
   ////////////////////////////////////////////////////////////////////////////
   // Mesh bakery ....
@@ -135,6 +159,8 @@ class MeshFilter : public MeshFilterBase {
   std::shared_ptr<VertexArrayObject>    vao_;
   std::bitset<MeshFilterBase::kTotal>   attrib_slots_;
   int                                   index_type_;
+  glm::vec3                             bounds_min_;
+  glm::vec3                             bounds_max_;
 };
 
 #endif // _MESHFILTER_H_B169C760_F9D6_42B9_81B7_91955A69A250_
@@ -27,16 +27,22 @@
 
 #include "meshfilter.h"
 #include "glm_main.h"
+#include "resourcecache.h"
 #include <memory>
 #include <string>
 
 class MeshLoader {
  public:
+  // The mesh is shared between all the callers with the same file, copy it
+  // before modifying.
   static
   std::shared_ptr<Mesh> Load(const std::string& filename) {
     std::string ext = GetFileExt(filename);
     if (ext == "dsm") {
-      return LoadDsm(filename);
+      auto key = ResourceCache::FileKey(filename);
+      return ResourceCache::Instance().GetMesh(key, [&]() {
+        return LoadDsm(filename);
+      });
     }
 
     return nullptr;
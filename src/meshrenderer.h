@@ -28,6 +28,8 @@
 #include "gl_main.h"
 #include "meshfilter.h"
 #include "material/material.h"
+#include "profiler.h"
+#include <algorithm>
 #include <memory>
 
 //////////////////////////////////////////////////////////////////////////////
@@ -110,6 +112,22 @@ class MeshRenderer {
       glDrawArraysInstanced(ToOpenGL(primitive), 0, mf_view.n_vertices, 
                             n_instances);
     }
+    PROFILE_COUNT(kDrawCalls, 1);
+    PROFILE_COUNT(kTriangles, GetTriangles(use_indices ? mf_view.n_indices : 
+                                           mf_view.n_vertices) * n_instances);
+  }
+
+  // Patches count as triangles, before the tesselation
+  int64_t GetTriangles(int64_t n_elements) const {
+    switch(primitive) {
+      case  kPtTriangleStrip:          
+      case  kPtTriangleFan:            return std::max<int64_t>(0, n_elements - 2);
+      case  kPtTriangles:              return n_elements / 3;
+      case  kPtTriangleStripAdjacency: return std::max<int64_t>(0, n_elements / 2 - 2);
+      case  kPtTrianglesAdjacency:     return n_elements / 6;
+      case  kPtPatches:                return n_elements / patch_size;
+      default:                         return 0;
+    }
   }
 
   GLenum ToOpenGL(PrimitiveType prim_type) {
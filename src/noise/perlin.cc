@@ -23,7 +23,18 @@
 //
 
 #include "perlin.h"
+#include "common/parallel.h"
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define B3D_PERLIN_X86
+#include <immintrin.h>
+#endif
 
 namespace Noise {
 
@@ -96,12 +107,385 @@ float Perlin::Get(float x, float y, float z) {
   return res;
 }
 
+// 2D version of the above (z = 0 face only). The batch kernels below repeat
+// exactly the same operations in the same order, so the results match bit
+// to bit. Keep them in sync!
+static float grad2(int hash, float x, float y) {
+  int h = hash & 15;
+  float u = h<8 ? x : y;
+  float v = h<4 ? y : h==12||h==14 ? x : 0.0f;
+  return ((h&1) == 0 ? u : -u) + ((h&2) == 0 ? v : -v);
+}
+
+static float Noise2(const int* p, float x, float y) {
+  float fx = std::floor(x);
+  float fy = std::floor(y);
+  int X = (int)fx & 255;
+  int Y = (int)fy & 255;
+  x -= fx;
+  y -= fy;
+  float u = fade(x);
+  float v = fade(y);
+
+  int A = p[X] + Y;
+  int B = p[X + 1] + Y;
+  int AA = p[A];
+  int AB = p[A + 1];
+  int BA = p[B];
+  int BB = p[B + 1];
+
+  return lerp(v, lerp(u, grad2(p[AA], x  , y  ), 
+                          grad2(p[BA], x-1, y  )),
+                 lerp(u, grad2(p[AB], x  , y-1),
+                          grad2(p[BB], x-1, y-1)));
+}
+
 float Perlin::Get(float x, float y) {
-  return Get(x, y, 0.0f);
+  return Noise2(permutation, x, y);
 }
 
 float Perlin::Get(float x) {
   return Get(x, 0.0f, 0.0f);
 }
 
+void Perlin::Seed(int seed) {
+  // Hand-made shuffle, std::shuffle differs between the std libraries
+  std::mt19937 rng(static_cast<uint32_t>(seed));
+  int p[256];
+  for (int i = 0; i < 256; ++i) {
+    p[i] = i;
+  }
+  for (int i = 255; i > 0; --i) {
+    std::swap(p[i], p[rng() % (i + 1)]);
+  }
+  for (int i = 0; i < 512; ++i) {
+    permutation[i] = p[i & 255];
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Batch kernels. One row of n samples at x = (x0 + i*step) * freq + ox and
+// fixed y. Stores amp * noise into out, or adds it if accumulate is set.
+//////////////////////////////////////////////////////////////////////////////
+struct RowParams {
+  float x0;
+  float step;
+  float freq;
+  float ox;
+  float y;
+  float amp;
+  bool  accumulate;
+};
+
+static void RowScalar(const int* p, float* out, int begin, int n, 
+                      const RowParams& r) {
+  for (int i = begin; i < n; ++i) {
+    float x = (r.x0 + (float)i * r.step) * r.freq + r.ox;
+    float value = r.amp * Noise2(p, x, r.y);
+    out[i] = r.accumulate ? out[i] + value : value;
+  }
+}
+
+#ifdef B3D_PERLIN_X86
+
+__attribute__((target("sse2")))
+static __m128 FloorSse2(__m128 x) {
+  // Truncate, then step down where it went up (negative numbers)
+  __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+  return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x), _mm_set1_ps(1.0f)));
+}
+
+__attribute__((target("sse2")))
+static __m128 FadeSse2(__m128 t) {
+  __m128 t3 = _mm_mul_ps(_mm_mul_ps(t, t), t);
+  __m128 a = _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f));
+  __m128 b = _mm_add_ps(_mm_mul_ps(t, a), _mm_set1_ps(10.0f));
+  return _mm_mul_ps(t3, b);
+}
+
+__attribute__((target("sse2")))
+static __m128 LerpSse2(__m128 t, __m128 a, __m128 b) {
+  return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+}
+
+__attribute__((target("sse2")))
+static __m128 SelectSse2(__m128 mask, __m128 a, __m128 b) {
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+__attribute__((target("sse2")))
+static __m128 Grad2Sse2(__m128i hash, __m128 x, __m128 y) {
+  __m128i h = _mm_and_si128(hash, _mm_set1_epi32(15));
+  __m128 lt8 = _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(8)));
+  __m128 lt4 = _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(4)));
+  __m128 vx = _mm_castsi128_ps(
+      _mm_or_si128(_mm_cmpeq_epi32(h, _mm_set1_epi32(12)),
+                   _mm_cmpeq_epi32(h, _mm_set1_epi32(14))));
+  __m128 u = SelectSse2(lt8, x, y);
+  __m128 v = SelectSse2(lt4, y, _mm_and_ps(vx, x));
+
+  // Negation is a flip of the sign bit
+  __m128i sign = _mm_set1_epi32(0x80000000);
+  __m128i zero = _mm_setzero_si128();
+  __m128 u_sign = _mm_castsi128_ps(_mm_andnot_si128(
+      _mm_cmpeq_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), zero), sign));
+  __m128 v_sign = _mm_castsi128_ps(_mm_andnot_si128(
+      _mm_cmpeq_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), zero), sign));
+  return _mm_add_ps(_mm_xor_ps(u, u_sign), _mm_xor_ps(v, v_sign));
+}
+
+// No gather in SSE2, the lookups go through memory
+__attribute__((target("sse2")))
+static __m128i LookupSse2(const int* p, __m128i index) {
+  alignas(16) int i[4];
+  _mm_store_si128(reinterpret_cast<__m128i*>(i), index);
+  return _mm_setr_epi32(p[i[0]], p[i[1]], p[i[2]], p[i[3]]);
+}
+
+__attribute__((target("sse2")))
+static int RowSse2(const int* p, float* out, int n, const RowParams& r) {
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128i one_i = _mm_set1_epi32(1);
+  const __m128i mask = _mm_set1_epi32(255);
+
+  // y is the same for the whole row
+  float fy_s = std::floor(r.y);
+  __m128i Y = _mm_set1_epi32((int)fy_s & 255);
+  __m128 y = _mm_set1_ps(r.y - fy_s);
+  __m128 v = _mm_set1_ps(fade(r.y - fy_s));
+  __m128 y1 = _mm_sub_ps(y, one);
+
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128 fi = _mm_cvtepi32_ps(_mm_setr_epi32(i, i + 1, i + 2, i + 3));
+    __m128 x = _mm_add_ps(_mm_set1_ps(r.x0), _mm_mul_ps(fi, _mm_set1_ps(r.step)));
+    x = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(r.freq)), _mm_set1_ps(r.ox));
+
+    __m128 fx = FloorSse2(x);
+    __m128i X = _mm_and_si128(_mm_cvttps_epi32(fx), mask);
+    x = _mm_sub_ps(x, fx);
+    __m128 u = FadeSse2(x);
+    __m128 x1 = _mm_sub_ps(x, one);
+
+    __m128i A  = _mm_add_epi32(LookupSse2(p, X), Y);
+    __m128i B  = _mm_add_epi32(LookupSse2(p, _mm_add_epi32(X, one_i)), Y);
+    __m128i AA = LookupSse2(p, A);
+    __m128i AB = LookupSse2(p, _mm_add_epi32(A, one_i));
+    __m128i BA = LookupSse2(p, B);
+    __m128i BB = LookupSse2(p, _mm_add_epi32(B, one_i));
+
+    __m128 res = LerpSse2(v, 
+        LerpSse2(u, Grad2Sse2(LookupSse2(p, AA), x,  y), 
+                    Grad2Sse2(LookupSse2(p, BA), x1, y)),
+        LerpSse2(u, Grad2Sse2(LookupSse2(p, AB), x,  y1),
+                    Grad2Sse2(LookupSse2(p, BB), x1, y1)));
+    res = _mm_mul_ps(_mm_set1_ps(r.amp), res);
+    if (r.accumulate) {
+      res = _mm_add_ps(_mm_loadu_ps(out + i), res);
+    }
+    _mm_storeu_ps(out + i, res);
+  }
+  return i;
+}
+
+__attribute__((target("avx2")))
+static __m256 FloorAvx2(__m256 x) {
+  return _mm256_floor_ps(x);
+}
+
+__attribute__((target("avx2")))
+static __m256 FadeAvx2(__m256 t) {
+  __m256 t3 = _mm256_mul_ps(_mm256_mul_ps(t, t), t);
+  __m256 a = _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6.0f)), 
+                           _mm256_set1_ps(15.0f));
+  __m256 b = _mm256_add_ps(_mm256_mul_ps(t, a), _mm256_set1_ps(10.0f));
+  return _mm256_mul_ps(t3, b);
+}
+
+__attribute__((target("avx2")))
+static __m256 LerpAvx2(__m256 t, __m256 a, __m256 b) {
+  return _mm256_add_ps(a, _mm256_mul_ps(t, _mm256_sub_ps(b, a)));
+}
+
+__attribute__((target("avx2")))
+static __m256 Grad2Avx2(__m256i hash, __m256 x, __m256 y) {
+  __m256i h = _mm256_and_si256(hash, _mm256_set1_epi32(15));
+  __m256 lt8 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(8), h));
+  __m256 lt4 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(4), h));
+  __m256 vx = _mm256_castsi256_ps(
+      _mm256_or_si256(_mm256_cmpeq_epi32(h, _mm256_set1_epi32(12)),
+                      _mm256_cmpeq_epi32(h, _mm256_set1_epi32(14))));
+  __m256 u = _mm256_blendv_ps(y, x, lt8);
+  __m256 v = _mm256_blendv_ps(_mm256_and_ps(vx, x), y, lt4);
+
+  __m256i sign = _mm256_set1_epi32(0x80000000);
+  __m256i zero = _mm256_setzero_si256();
+  __m256 u_sign = _mm256_castsi256_ps(_mm256_andnot_si256(
+      _mm256_cmpeq_epi32(_mm256_and_si256(h, _mm256_set1_epi32(1)), zero), sign));
+  __m256 v_sign = _mm256_castsi256_ps(_mm256_andnot_si256(
+      _mm256_cmpeq_epi32(_mm256_and_si256(h, _mm256_set1_epi32(2)), zero), sign));
+  return _mm256_add_ps(_mm256_xor_ps(u, u_sign), _mm256_xor_ps(v, v_sign));
+}
+
+__attribute__((target("avx2")))
+static __m256i LookupAvx2(const int* p, __m256i index) {
+  return _mm256_i32gather_epi32(p, index, 4);
+}
+
+__attribute__((target("avx2")))
+static int RowAvx2(const int* p, float* out, int n, const RowParams& r) {
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256i one_i = _mm256_set1_epi32(1);
+  const __m256i mask = _mm256_set1_epi32(255);
+
+  float fy_s = std::floor(r.y);
+  __m256i Y = _mm256_set1_epi32((int)fy_s & 255);
+  __m256 y = _mm256_set1_ps(r.y - fy_s);
+  __m256 v = _mm256_set1_ps(fade(r.y - fy_s));
+  __m256 y1 = _mm256_sub_ps(y, one);
+
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 fi = _mm256_cvtepi32_ps(
+        _mm256_add_epi32(_mm256_set1_epi32(i), 
+                         _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+    __m256 x = _mm256_add_ps(_mm256_set1_ps(r.x0), 
+                             _mm256_mul_ps(fi, _mm256_set1_ps(r.step)));
+    x = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(r.freq)), 
+                      _mm256_set1_ps(r.ox));
+
+    __m256 fx = FloorAvx2(x);
+    __m256i X = _mm256_and_si256(_mm256_cvttps_epi32(fx), mask);
+    x = _mm256_sub_ps(x, fx);
+    __m256 u = FadeAvx2(x);
+    __m256 x1 = _mm256_sub_ps(x, one);
+
+    __m256i A  = _mm256_add_epi32(LookupAvx2(p, X), Y);
+    __m256i B  = _mm256_add_epi32(LookupAvx2(p, _mm256_add_epi32(X, one_i)), Y);
+    __m256i AA = LookupAvx2(p, A);
+    __m256i AB = LookupAvx2(p, _mm256_add_epi32(A, one_i));
+    __m256i BA = LookupAvx2(p, B);
+    __m256i BB = LookupAvx2(p, _mm256_add_epi32(B, one_i));
+
+    __m256 res = LerpAvx2(v, 
+        LerpAvx2(u, Grad2Avx2(LookupAvx2(p, AA), x,  y), 
+                    Grad2Avx2(LookupAvx2(p, BA), x1, y)),
+        LerpAvx2(u, Grad2Avx2(LookupAvx2(p, AB), x,  y1),
+                    Grad2Avx2(LookupAvx2(p, BB), x1, y1)));
+    res = _mm256_mul_ps(_mm256_set1_ps(r.amp), res);
+    if (r.accumulate) {
+      res = _mm256_add_ps(_mm256_loadu_ps(out + i), res);
+    }
+    _mm256_storeu_ps(out + i, res);
+  }
+  return i;
+}
+
+#endif // B3D_PERLIN_X86
+
+static Perlin::Isa isa = Perlin::Isa::kBest;
+
+static Perlin::Isa ResolveIsa(Perlin::Isa wanted) {
+#ifdef B3D_PERLIN_X86
+  __builtin_cpu_init();
+  bool has_avx2 = __builtin_cpu_supports("avx2");
+  bool has_sse2 = __builtin_cpu_supports("sse2");
+  switch (wanted) {
+    case Perlin::Isa::kBest:
+      return has_avx2 ? Perlin::Isa::kAvx2 :
+             has_sse2 ? Perlin::Isa::kSse2 : Perlin::Isa::kScalar;
+    case Perlin::Isa::kAvx2:
+      return has_avx2 ? wanted : Perlin::Isa::kScalar;
+    case Perlin::Isa::kSse2:
+      return has_sse2 ? wanted : Perlin::Isa::kScalar;
+    default:
+      return Perlin::Isa::kScalar;
+  }
+#else
+  return Perlin::Isa::kScalar;
+#endif
+}
+
+void Perlin::SetIsa(Isa wanted) {
+  isa = ResolveIsa(wanted);
+}
+
+Perlin::Isa Perlin::GetIsa() {
+  if (isa == Isa::kBest) {
+    isa = ResolveIsa(Isa::kBest);
+  }
+  return isa;
+}
+
+static void Row(Perlin::Isa isa, float* out, int n, const RowParams& r) {
+  const int* p = permutation;
+  int done = 0;
+#ifdef B3D_PERLIN_X86
+  if (isa == Perlin::Isa::kAvx2) {
+    done = RowAvx2(p, out, n, r);
+  } else if (isa == Perlin::Isa::kSse2) {
+    done = RowSse2(p, out, n, r);
+  }
+#endif
+  // The tail
+  RowScalar(p, out, done, n, r);
+}
+
+static float OctaveOffset(const std::vector<float>& offsets, int octave) {
+  return octave < (int)offsets.size() ? offsets[octave] : 0.0f;
+}
+
+float Perlin::Fbm(float x, float y, const FbmParams& params) {
+  float value = 0;
+  float amplitude = 1;
+  float frequency = 1;
+  for (int i = 0; i < params.octaves; ++i) {
+    float sx = x * frequency + OctaveOffset(params.offset_x, i);
+    float sy = y * frequency + OctaveOffset(params.offset_y, i);
+    float octave = amplitude * Noise2(permutation, sx, sy);
+    value = i == 0 ? octave : value + octave;
+
+    frequency *= params.lacunarity;
+    amplitude *= params.persistance;
+  }
+  return value;
+}
+
+void Perlin::FillFbm(float* out, int width, int height, 
+                     float x0, float y0, float step, 
+                     const FbmParams& params, int n_threads) {
+  Isa row_isa = GetIsa();
+
+  auto fill_rows = [&](int row_begin, int row_end) {
+    for (int j = row_begin; j < row_end; ++j) {
+      float y = y0 + (float)j * step;
+      float* row = out + (size_t)j * width;
+
+      RowParams r;
+      r.x0 = x0;
+      r.step = step;
+      r.freq = 1;
+      r.amp = 1;
+      for (int i = 0; i < params.octaves; ++i) {
+        r.ox = OctaveOffset(params.offset_x, i);
+        r.y = y * r.freq + OctaveOffset(params.offset_y, i);
+        r.accumulate = i > 0;
+        Row(row_isa, row, width, r);
+
+        r.freq *= params.lacunarity;
+        r.amp *= params.persistance;
+      }
+    }
+  };
+
+  ParallelFor(0, height, n_threads, fill_rows);
+}
+
+void Perlin::Fill(float* out, int width, int height, 
+                  float x0, float y0, float step, int n_threads) {
+  FbmParams params;
+  params.octaves = 1;
+  FillFbm(out, width, height, x0, y0, step, params, n_threads);
+}
+
 } // namespace Noise
@@ -25,15 +25,56 @@
 #ifndef _PERLIN_H_70188051_A979_4111_8E96_3EF2E49EE868_
 #define _PERLIN_H_70188051_A979_4111_8E96_3EF2E49EE868_ 
 
+#include <vector>
+
 namespace Noise {
 
+//////////////////////////////////////////////////////////////////////////////
+// Ken Perlin's improved noise.
+//
+// Get() evaluates a single point. Fill() and FillFbm() evaluate a whole grid,
+// vectorized (SSE2 or AVX2, picked at runtime) and split between threads.
+// All the instruction sets give bit-identical results, the same as Get(x, y)
+// and Fbm() for every sample.
+//
+// Seed() reshuffles the permutation table, the default is Ken Perlin's one.
+// Not thread safe, don't call it while a grid is being filled.
+//////////////////////////////////////////////////////////////////////////////
 class Perlin {
  public:
+  enum class Isa { kBest, kScalar, kSse2, kAvx2 };
+
+  struct FbmParams {
+    int   octaves     = 5;
+    float lacunarity  = 2.0f; // Frequency multiplier per octave
+    float persistance = 0.5f; // Amplitude multiplier per octave
+
+    // Optional shift per octave, decorrelates the octaves. Missing ones are 0.
+    std::vector<float> offset_x;
+    std::vector<float> offset_y;
+  };
+
   static void Seed(int seed);
 
   static float Get(float x, float y, float z);
   static float Get(float x, float t);
   static float Get(float x);
+
+  // Fractal Brownian motion, sum of octaves of Get(x, y)
+  static float Fbm(float x, float y, const FbmParams& params);
+
+  // Row-major width x height grid, sample (i, j) is taken at 
+  // (x0 + i*step, y0 + j*step). n_threads = 0 uses all the cores.
+  static void Fill(float* out, int width, int height, 
+                   float x0, float y0, float step, int n_threads = 0);
+  static void FillFbm(float* out, int width, int height, 
+                      float x0, float y0, float step, 
+                      const FbmParams& params, int n_threads = 0);
+
+  // kBest by default. The rest are for the tests and benchmarks, fall back 
+  // to kScalar if the CPU does not support them.
+  static void SetIsa(Isa isa);
+  static Isa  GetIsa();
 };
 
 }
@@ -0,0 +1,354 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "occlusionbuffer.h"
+#include "common/logging.h"
+#include "common/parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define B3D_OCCLUSION_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Closer than this to the eye counts as crossing the near plane
+const float kMinW = 1e-5f;
+
+// Per triangle constants, the edge functions and the depth are 
+// a * px + b * py + c for the pixel center (px, py)
+struct Setup {
+  float ea[3], eb[3], ec[3];
+  float za, zb, zc;
+  int   x0, x1, y0, y1;
+};
+
+bool MakeSetup(const glm::vec3* v, int width, int y_begin, int y_end, 
+               Setup& s) {
+  float min_x = std::min(v[0].x, std::min(v[1].x, v[2].x));
+  float max_x = std::max(v[0].x, std::max(v[1].x, v[2].x));
+  float min_y = std::min(v[0].y, std::min(v[1].y, v[2].y));
+  float max_y = std::max(v[0].y, std::max(v[1].y, v[2].y));
+  s.x0 = std::max(0, (int)std::floor(min_x));
+  s.x1 = std::min(width - 1, (int)std::ceil(max_x));
+  s.y0 = std::max(y_begin, (int)std::floor(min_y));
+  s.y1 = std::min(y_end - 1, (int)std::ceil(max_y));
+  if (s.x0 > s.x1 || s.y0 > s.y1) {
+    return false;
+  }
+
+  // Counter-clockwise on the screen, the inside is >= 0
+  for (int i = 0; i < 3; ++i) {
+    const glm::vec3& a = v[i];
+    const glm::vec3& b = v[(i + 1) % 3];
+    s.ea[i] = a.y - b.y;
+    s.eb[i] = b.x - a.x;
+    s.ec[i] = -(s.ea[i] * a.x + s.eb[i] * a.y);
+  }
+
+  float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - 
+               (v[1].y - v[0].y) * (v[2].x - v[0].x);
+  s.za = ((v[1].z - v[0].z) * (v[2].y - v[0].y) - 
+          (v[2].z - v[0].z) * (v[1].y - v[0].y)) / area;
+  s.zb = ((v[2].z - v[0].z) * (v[1].x - v[0].x) - 
+          (v[1].z - v[0].z) * (v[2].x - v[0].x)) / area;
+  s.zc = v[0].z - s.za * v[0].x - s.zb * v[0].y;
+  return true;
+}
+
+void RasterizeScalar(const Setup& s, int width, float* depth) {
+  for (int y = s.y0; y <= s.y1; ++y) {
+    float py = y + 0.5f;
+    float e0 = s.eb[0] * py + s.ec[0];
+    float e1 = s.eb[1] * py + s.ec[1];
+    float e2 = s.eb[2] * py + s.ec[2];
+    float z = s.zb * py + s.zc;
+    float* row = depth + (size_t)y * width;
+    for (int x = s.x0 & ~3; x <= (s.x1 | 3); ++x) {
+      float px = x + 0.5f;
+      if (s.ea[0] * px + e0 >= 0 && s.ea[1] * px + e1 >= 0 && 
+          s.ea[2] * px + e2 >= 0) {
+        row[x] = std::min(row[x], s.za * px + z);
+      }
+    }
+  }
+}
+
+#ifdef B3D_OCCLUSION_X86
+
+// Same math as the scalar one, bit exact
+__attribute__((target("sse2")))
+void RasterizeSse2(const Setup& s, int width, float* depth) {
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 lanes = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+  const __m128 ea0 = _mm_set1_ps(s.ea[0]);
+  const __m128 ea1 = _mm_set1_ps(s.ea[1]);
+  const __m128 ea2 = _mm_set1_ps(s.ea[2]);
+  const __m128 za = _mm_set1_ps(s.za);
+
+  for (int y = s.y0; y <= s.y1; ++y) {
+    float py = y + 0.5f;
+    __m128 e0 = _mm_set1_ps(s.eb[0] * py + s.ec[0]);
+    __m128 e1 = _mm_set1_ps(s.eb[1] * py + s.ec[1]);
+    __m128 e2 = _mm_set1_ps(s.eb[2] * py + s.ec[2]);
+    __m128 z = _mm_set1_ps(s.zb * py + s.zc);
+    float* row = depth + (size_t)y * width;
+
+    // The buffer width is a multiple of 4, no tail
+    for (int x = s.x0 & ~3; x <= s.x1; x += 4) {
+      __m128 px = _mm_add_ps(_mm_set1_ps((float)x), lanes);
+      __m128 inside = _mm_and_ps(
+          _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(ea0, px), e0), zero),
+          _mm_and_ps(
+              _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(ea1, px), e1), zero),
+              _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(ea2, px), e2), zero)));
+      if (_mm_movemask_ps(inside) == 0) {
+        continue;
+      }
+      __m128 old = _mm_loadu_ps(row + x);
+      __m128 d = _mm_min_ps(old, _mm_add_ps(_mm_mul_ps(za, px), z));
+      _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, d), 
+                                       _mm_andnot_ps(inside, old)));
+    }
+  }
+}
+
+#endif // B3D_OCCLUSION_X86
+
+OcclusionBuffer::Isa ResolveIsa(OcclusionBuffer::Isa wanted) {
+#ifdef B3D_OCCLUSION_X86
+  __builtin_cpu_init();
+  bool has_sse2 = __builtin_cpu_supports("sse2");
+  if (wanted == OcclusionBuffer::Isa::kScalar || !has_sse2) {
+    return OcclusionBuffer::Isa::kScalar;
+  }
+  return OcclusionBuffer::Isa::kSse2;
+#else
+  return OcclusionBuffer::Isa::kScalar;
+#endif
+}
+
+}
+
+OcclusionBuffer::OcclusionBuffer(const Params& params) 
+    : params_(params), 
+      isa_(ResolveIsa(params.isa)),
+      pv_(1.0f) {
+  if (params_.width <= 0 || params_.height <= 0 || 
+      params_.width % kTileSize || params_.height % kTileSize) {
+    ABORT_F("Occlusion buffer must be a multiple of %d, got %dx%d", 
+            kTileSize, params_.width, params_.height);
+  }
+  tiles_x_ = params_.width / kTileSize;
+  tiles_y_ = params_.height / kTileSize;
+  depth_.assign((size_t)params_.width * params_.height, 1.0f);
+  tile_max_.assign((size_t)tiles_x_ * tiles_y_, 1.0f);
+}
+
+void OcclusionBuffer::Begin(const glm::mat4& pv) {
+  pv_ = pv;
+  triangles_.clear();
+  stats_ = Stats();
+  std::fill(depth_.begin(), depth_.end(), 1.0f);
+  std::fill(tile_max_.begin(), tile_max_.end(), 1.0f);
+}
+
+void OcclusionBuffer::AddOccluder(const std::vector<glm::vec3>& vertices,
+                                  const std::vector<uint32_t>& indices,
+                                  const glm::mat4& model) {
+  glm::mat4 mvp = pv_ * model;
+  const float w = (float)params_.width;
+  const float h = (float)params_.height;
+
+  stats_.occluders++;
+  // Shared vertices are transformed once
+  clip_.resize(vertices.size());
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    clip_[i] = mvp * glm::vec4(vertices[i], 1);
+  }
+
+  size_t n = indices.empty() ? vertices.size() : indices.size();
+  for (size_t i = 0; i + 2 < n; i += 3) {
+    glm::vec4 clip[3];
+    for (int k = 0; k < 3; ++k) {
+      clip[k] = clip_[indices.empty() ? i + k : indices[i + k]];
+    }
+
+    // Crossing the near plane, skipped
+    if (clip[0].w < kMinW || clip[1].w < kMinW || clip[2].w < kMinW ||
+        clip[0].z < -clip[0].w || clip[1].z < -clip[1].w || 
+        clip[2].z < -clip[2].w) {
+      continue;
+    }
+    // All out on one side
+    bool out = false;
+    for (int axis = 0; axis < 2 && !out; ++axis) {
+      out = (clip[0][axis] < -clip[0].w && clip[1][axis] < -clip[1].w && 
+             clip[2][axis] < -clip[2].w) ||
+            (clip[0][axis] >  clip[0].w && clip[1][axis] >  clip[1].w && 
+             clip[2][axis] >  clip[2].w);
+    }
+    if (out) {
+      continue;
+    }
+
+    Triangle t;
+    for (int k = 0; k < 3; ++k) {
+      float iw = 1.0f / clip[k].w;
+      t.v[k] = glm::vec3((clip[k].x * iw * 0.5f + 0.5f) * w,
+                         (clip[k].y * iw * 0.5f + 0.5f) * h,
+                         clip[k].z * iw * 0.5f + 0.5f);
+    }
+    float area = (t.v[1].x - t.v[0].x) * (t.v[2].y - t.v[0].y) - 
+                 (t.v[1].y - t.v[0].y) * (t.v[2].x - t.v[0].x);
+    if (area == 0) {
+      continue;
+    }
+    // Both sides occlude
+    if (area < 0) {
+      std::swap(t.v[1], t.v[2]);
+    }
+    triangles_.push_back(t);
+  }
+}
+
+void OcclusionBuffer::RasterizeBand(int y_begin, int y_end) {
+  float* depth = depth_.data();
+  for (auto& t: triangles_) {
+    Setup s;
+    if (!MakeSetup(t.v, params_.width, y_begin, y_end, s)) {
+      continue;
+    }
+#ifdef B3D_OCCLUSION_X86
+    if (isa_ == Isa::kSse2) {
+      RasterizeSse2(s, params_.width, depth);
+      continue;
+    }
+#endif
+    RasterizeScalar(s, params_.width, depth);
+  }
+
+  // Farthest depth per tile
+  for (int ty = y_begin / kTileSize; ty < y_end / kTileSize; ++ty) {
+    for (int tx = 0; tx < tiles_x_; ++tx) {
+      float tile_max = 0;
+      for (int y = ty * kTileSize; y < (ty + 1) * kTileSize; ++y) {
+        const float* row = depth + (size_t)y * params_.width + tx * kTileSize;
+        for (int x = 0; x < kTileSize; ++x) {
+          tile_max = std::max(tile_max, row[x]);
+        }
+      }
+      tile_max_[ty * tiles_x_ + tx] = tile_max;
+    }
+  }
+}
+
+void OcclusionBuffer::Rasterize() {
+  auto start = std::chrono::steady_clock::now();
+
+  ParallelFor(0, tiles_y_, params_.n_threads, [this](int ty_begin, int ty_end) {
+    RasterizeBand(ty_begin * kTileSize, ty_end * kTileSize);
+  });
+
+  stats_.triangles = triangles_.size();
+  stats_.raster_ms = std::chrono::duration<float, std::milli>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+bool OcclusionBuffer::TestAabb(const glm::vec3& min, const glm::vec3& max) {
+  return TestAabb(min, max, glm::mat4(1.0f));
+}
+
+bool OcclusionBuffer::TestAabb(const glm::vec3& min, const glm::vec3& max, 
+                               const glm::mat4& model) {
+  glm::mat4 mvp = pv_ * model;
+  glm::vec4 corners[8];
+  for (int i = 0; i < 8; ++i) {
+    corners[i] = mvp * glm::vec4(i & 1 ? max.x : min.x, 
+                                 i & 2 ? max.y : min.y, 
+                                 i & 4 ? max.z : min.z, 1);
+  }
+  return TestClip(corners);
+}
+
+bool OcclusionBuffer::TestClip(const glm::vec4* corners) {
+  stats_.tested++;
+
+  float min_x = std::numeric_limits<float>::max();
+  float min_y = std::numeric_limits<float>::max();
+  float min_z = std::numeric_limits<float>::max();
+  float max_x = std::numeric_limits<float>::lowest();
+  float max_y = std::numeric_limits<float>::lowest();
+  for (int i = 0; i < 8; ++i) {
+    const glm::vec4& c = corners[i];
+    if (c.w < kMinW || c.z < -c.w) {
+      return true;
+    }
+    float iw = 1.0f / c.w;
+    float x = (c.x * iw * 0.5f + 0.5f) * params_.width;
+    float y = (c.y * iw * 0.5f + 0.5f) * params_.height;
+    min_x = std::min(min_x, x);
+    max_x = std::max(max_x, x);
+    min_y = std::min(min_y, y);
+    max_y = std::max(max_y, y);
+    min_z = std::min(min_z, c.z * iw * 0.5f + 0.5f);
+  }
+
+  int x0 = std::max(0, (int)std::floor(min_x));
+  int x1 = std::min(params_.width - 1, (int)std::ceil(max_x));
+  int y0 = std::max(0, (int)std::floor(min_y));
+  int y1 = std::min(params_.height - 1, (int)std::ceil(max_y));
+  // Off the screen is the frustum culling business
+  if (x0 > x1 || y0 > y1) {
+    return true;
+  }
+
+  for (int ty = y0 / kTileSize; ty <= y1 / kTileSize; ++ty) {
+    for (int tx = x0 / kTileSize; tx <= x1 / kTileSize; ++tx) {
+      if (tile_max_[ty * tiles_x_ + tx] < min_z) {
+        continue; // The whole tile is in front
+      }
+      int px0 = std::max(x0, tx * kTileSize);
+      int px1 = std::min(x1, tx * kTileSize + kTileSize - 1);
+      int py0 = std::max(y0, ty * kTileSize);
+      int py1 = std::min(y1, ty * kTileSize + kTileSize - 1);
+      for (int y = py0; y <= py1; ++y) {
+        const float* row = depth_.data() + (size_t)y * params_.width;
+        for (int x = px0; x <= px1; ++x) {
+          if (row[x] >= min_z) {
+            return true;
+          }
+        }
+      }
+    }
+  }
+
+  stats_.occluded++;
+  return false;
+}
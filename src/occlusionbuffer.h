@@ -0,0 +1,117 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _OCCLUSIONBUFFER_H_C62C466D_6233_4F43_8E79_6A3600DF3B85_
+#define _OCCLUSIONBUFFER_H_C62C466D_6233_4F43_8E79_6A3600DF3B85_ 
+
+#include "glm_main.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+// Low resolution software depth buffer for the occlusion culling.
+//
+// The big occluders (terrain, buildings) are rasterized on the CPU, 4 
+// pixels at a time, the screen is split into bands of tile rows which are
+// rasterized in parallel. Every 8x8 tile keeps the farthest depth of its 
+// pixels, so most of the AABB tests are decided per tile.
+//
+// Conservative on the safe side: triangles crossing the near plane are not
+// rasterized and boxes crossing it are visible. Depth is z/w in [0, 1], 
+// 1 is empty.
+//
+// buffer.Begin(proj * view);
+// buffer.AddOccluder(mesh->vertices, mesh->indices, model);
+// buffer.Rasterize();
+// if (buffer.TestAabb(min, max, model)) { draw... }
+//////////////////////////////////////////////////////////////////////////////
+class OcclusionBuffer {
+ public:
+  enum class Isa { kBest, kScalar, kSse2 };
+
+  static const int kTileSize = 8;
+
+  struct Params {
+    int width     = 256; // Multiple of kTileSize
+    int height    = 128;
+    int n_threads = 0;   // 0 - all the cores
+    Isa isa       = Isa::kBest;
+  };
+
+  struct Stats {
+    size_t occluders = 0;
+    size_t triangles = 0; // Rasterized
+    size_t tested    = 0;
+    size_t occluded  = 0;
+    float  raster_ms = 0;
+  };
+
+  explicit OcclusionBuffer(const Params& params);
+
+  // Clears the buffer, pv - projection * view
+  void Begin(const glm::mat4& pv);
+
+  void AddOccluder(const std::vector<glm::vec3>& vertices,
+                   const std::vector<uint32_t>& indices,
+                   const glm::mat4& model);
+
+  void Rasterize();
+
+  // True if the box can be visible, world space
+  bool TestAabb(const glm::vec3& min, const glm::vec3& max);
+  // Same for the model space box
+  bool TestAabb(const glm::vec3& min, const glm::vec3& max, 
+                const glm::mat4& model);
+
+  int GetWidth() const { return params_.width; }
+  int GetHeight() const { return params_.height; }
+  float GetDepth(int x, int y) const { return depth_[y * params_.width + x]; }
+  float GetTileMax(int tx, int ty) const { 
+    return tile_max_[ty * tiles_x_ + tx]; 
+  }
+  const Stats& GetStats() const { return stats_; }
+  Isa GetIsa() const { return isa_; }
+
+ private:
+  struct Triangle {
+    glm::vec3 v[3]; // Screen x, y and depth
+  };
+
+  bool TestClip(const glm::vec4* corners);
+  void RasterizeBand(int y_begin, int y_end);
+
+  Params                 params_;
+  Isa                    isa_;
+  int                    tiles_x_;
+  int                    tiles_y_;
+  glm::mat4              pv_;
+  std::vector<float>     depth_;
+  std::vector<float>     tile_max_;
+  std::vector<Triangle>  triangles_;
+  std::vector<glm::vec4> clip_;
+  Stats                  stats_;
+};
+
+#endif // _OCCLUSIONBUFFER_H_C62C466D_6233_4F43_8E79_6A3600DF3B85_
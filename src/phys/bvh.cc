@@ -0,0 +1,740 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "phys/bvh.h"
+#include "common/logging.h"
+#include "common/parallel.h"
+#include <algorithm>
+#include <thread>
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define B3D_BVH_X86
+#include <immintrin.h>
+#endif
+
+namespace Phys {
+
+namespace {
+
+// Smaller subtrees are built by one thread
+const uint32_t kMinTrianglesPerTask = 4096;
+
+// Deeper nodes are leaves whatever the size, it bounds the traversal stack
+const int kMaxDepth = 64;
+
+const int kMaxBins = 64;
+
+Bvh::Isa ResolveIsa(Bvh::Isa wanted) {
+#ifdef B3D_BVH_X86
+  __builtin_cpu_init();
+  bool has_sse2 = __builtin_cpu_supports("sse2");
+  if (wanted == Bvh::Isa::kScalar || !has_sse2) {
+    return Bvh::Isa::kScalar;
+  }
+  return Bvh::Isa::kSse2;
+#else
+  return Bvh::Isa::kScalar;
+#endif
+}
+
+Aabb EmptyBox() {
+  return {glm::vec3(std::numeric_limits<float>::max()),
+          glm::vec3(std::numeric_limits<float>::lowest())};
+}
+
+void Grow(Aabb& box, const glm::vec3& point) {
+  box.min = glm::min(box.min, point);
+  box.max = glm::max(box.max, point);
+}
+
+void Grow(Aabb& box, const Aabb& other) {
+  box.min = glm::min(box.min, other.min);
+  box.max = glm::max(box.max, other.max);
+}
+
+float Area(const Aabb& box) {
+  glm::vec3 d = glm::max(box.max - box.min, glm::vec3(0));
+  return 2 * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+uint32_t PackCount(uint32_t triangles) {
+  return (triangles + 3) / 4;
+}
+
+size_t GetTriangleCount(const Mesh& mesh) {
+  return mesh.indices.empty() ? mesh.vertices.size() / 3 
+                              : mesh.indices.size() / 3;
+}
+
+void GetTriangle(const Mesh& mesh, size_t triangle, glm::vec3 v[3]) {
+  for (int k = 0; k < 3; ++k) {
+    size_t i = 3 * triangle + k;
+    v[k] = mesh.vertices[mesh.indices.empty() ? i : mesh.indices[i]];
+  }
+}
+
+// Moller-Trumbore, both sides of the triangle
+bool IntersectTriangle(const glm::vec3& v0, const glm::vec3& e1, 
+                       const glm::vec3& e2, const Ray& ray, 
+                       float& t, float& u, float& v) {
+  glm::vec3 pv = glm::cross(ray.direction, e2);
+  float det = glm::dot(e1, pv);
+  if (det == 0) {
+    return false;
+  }
+  float inv_det = 1 / det;
+  glm::vec3 tv = ray.origin - v0;
+  u = glm::dot(tv, pv) * inv_det;
+  if (!(u >= 0 && u <= 1)) {
+    return false;
+  }
+  glm::vec3 qv = glm::cross(tv, e1);
+  v = glm::dot(ray.direction, qv) * inv_det;
+  if (!(v >= 0 && u + v <= 1)) {
+    return false;
+  }
+  t = glm::dot(e2, qv) * inv_det;
+  return true;
+}
+
+// The nearest hit in (t_min, t_max) to hit, t_max becomes its distance
+bool PackScalar(const Bvh::Pack& pack, const Ray& ray, float t_min, 
+                float& t_max, Bvh::Hit& hit) {
+  bool found = false;
+  for (int k = 0; k < 4; ++k) {
+    glm::vec3 v0(pack.v0[0][k], pack.v0[1][k], pack.v0[2][k]);
+    glm::vec3 e1(pack.e1[0][k], pack.e1[1][k], pack.e1[2][k]);
+    glm::vec3 e2(pack.e2[0][k], pack.e2[1][k], pack.e2[2][k]);
+    float t, u, v;
+    if (IntersectTriangle(v0, e1, e2, ray, t, u, v) && 
+        t > t_min && t < t_max) {
+      t_max = t;
+      hit = {t, pack.id[k], u, v};
+      found = true;
+    }
+  }
+  return found;
+}
+
+bool BoxScalar(const Bvh::Node& node, const float origin[4], 
+               const float inv[4], float t_min, float t_max, float& t_near) {
+  for (int k = 0; k < 3; ++k) {
+    float t0 = ((&node.min.x)[k] - origin[k]) * inv[k];
+    float t1 = ((&node.max.x)[k] - origin[k]) * inv[k];
+    t_min = std::max(t_min, std::min(t0, t1));
+    t_max = std::min(t_max, std::max(t0, t1));
+  }
+  t_near = t_min;
+  return t_min <= t_max;
+}
+
+#ifdef B3D_BVH_X86
+__attribute__((target("sse2")))
+bool PackSse2(const Bvh::Pack& pack, const Ray& ray, float t_min, 
+              float& t_max, Bvh::Hit& hit) {
+  __m128 dx = _mm_set1_ps(ray.direction.x);
+  __m128 dy = _mm_set1_ps(ray.direction.y);
+  __m128 dz = _mm_set1_ps(ray.direction.z);
+  __m128 e1x = _mm_load_ps(pack.e1[0]);
+  __m128 e1y = _mm_load_ps(pack.e1[1]);
+  __m128 e1z = _mm_load_ps(pack.e1[2]);
+  __m128 e2x = _mm_load_ps(pack.e2[0]);
+  __m128 e2y = _mm_load_ps(pack.e2[1]);
+  __m128 e2z = _mm_load_ps(pack.e2[2]);
+
+  // pv = d x e2, det = e1 . pv
+  __m128 pvx = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(e2y, dz));
+  __m128 pvy = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(e2z, dx));
+  __m128 pvz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(e2x, dy));
+  __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, pvx), 
+                                     _mm_mul_ps(e1y, pvy)), 
+                          _mm_mul_ps(e1z, pvz));
+  __m128 zero = _mm_setzero_ps();
+  __m128 one = _mm_set1_ps(1);
+  __m128 inv_det = _mm_div_ps(one, det);
+  __m128 mask = _mm_cmpneq_ps(det, zero);
+
+  // u = tv . pv / det
+  __m128 tvx = _mm_sub_ps(_mm_set1_ps(ray.origin.x), _mm_load_ps(pack.v0[0]));
+  __m128 tvy = _mm_sub_ps(_mm_set1_ps(ray.origin.y), _mm_load_ps(pack.v0[1]));
+  __m128 tvz = _mm_sub_ps(_mm_set1_ps(ray.origin.z), _mm_load_ps(pack.v0[2]));
+  __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tvx, pvx), 
+                                              _mm_mul_ps(tvy, pvy)), 
+                                   _mm_mul_ps(tvz, pvz)), inv_det);
+  mask = _mm_and_ps(mask, _mm_cmpge_ps(u, zero));
+  mask = _mm_and_ps(mask, _mm_cmple_ps(u, one));
+
+  // qv = tv x e1, v = d . qv / det, t = e2 . qv / det
+  __m128 qvx = _mm_sub_ps(_mm_mul_ps(tvy, e1z), _mm_mul_ps(e1y, tvz));
+  __m128 qvy = _mm_sub_ps(_mm_mul_ps(tvz, e1x), _mm_mul_ps(e1z, tvx));
+  __m128 qvz = _mm_sub_ps(_mm_mul_ps(tvx, e1y), _mm_mul_ps(e1x, tvy));
+  __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qvx), 
+                                              _mm_mul_ps(dy, qvy)), 
+                                   _mm_mul_ps(dz, qvz)), inv_det);
+  mask = _mm_and_ps(mask, _mm_cmpge_ps(v, zero));
+  mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), one));
+  __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qvx), 
+                                              _mm_mul_ps(e2y, qvy)), 
+                                   _mm_mul_ps(e2z, qvz)), inv_det);
+  mask = _mm_and_ps(mask, _mm_cmpgt_ps(t, _mm_set1_ps(t_min)));
+  mask = _mm_and_ps(mask, _mm_cmplt_ps(t, _mm_set1_ps(t_max)));
+
+  int bits = _mm_movemask_ps(mask);
+  if (!bits) {
+    return false;
+  }
+  alignas(16) float ts[4], us[4], vs[4];
+  _mm_store_ps(ts, t);
+  _mm_store_ps(us, u);
+  _mm_store_ps(vs, v);
+  bool found = false;
+  for (int k = 0; k < 4; ++k) {
+    if ((bits & (1 << k)) && ts[k] < t_max) {
+      t_max = ts[k];
+      hit = {ts[k], pack.id[k], us[k], vs[k]};
+      found = true;
+    }
+  }
+  return found;
+}
+
+// The node box is min, offset, max, count: the offset and the count lanes 
+// are masked out and replaced by the ray range
+__attribute__((target("sse2")))
+bool BoxSse2(const Bvh::Node& node, const float origin[4], 
+             const float inv[4], float t_min, float t_max, float& t_near) {
+  const __m128 xyz = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+  __m128 o = _mm_loadu_ps(origin);
+  __m128 i = _mm_loadu_ps(inv);
+  __m128 t0 = _mm_and_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&node.min.x), o), 
+                                    i), xyz);
+  __m128 t1 = _mm_and_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&node.max.x), o), 
+                                    i), xyz);
+  __m128 lo = _mm_or_ps(_mm_min_ps(t0, t1), _mm_set_ps(t_min, 0, 0, 0));
+  __m128 hi = _mm_or_ps(_mm_max_ps(t0, t1), _mm_set_ps(t_max, 0, 0, 0));
+  lo = _mm_max_ps(lo, _mm_shuffle_ps(lo, lo, _MM_SHUFFLE(1, 0, 3, 2)));
+  lo = _mm_max_ps(lo, _mm_shuffle_ps(lo, lo, _MM_SHUFFLE(2, 3, 0, 1)));
+  hi = _mm_min_ps(hi, _mm_shuffle_ps(hi, hi, _MM_SHUFFLE(1, 0, 3, 2)));
+  hi = _mm_min_ps(hi, _mm_shuffle_ps(hi, hi, _MM_SHUFFLE(2, 3, 0, 1)));
+  t_near = _mm_cvtss_f32(lo);
+  return t_near <= _mm_cvtss_f32(hi);
+}
+#endif
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////
+// Builder
+//////////////////////////////////////////////////////////////////////////////
+struct Bvh::Builder {
+  // The triangles, reordered by the splits. Moved together with their 
+  // bounds, the splits read them in a row.
+  struct Triangle {
+    Aabb      box;
+    glm::vec3 center;
+    uint32_t  id;
+  };
+
+  // The triangle boxes by the center, for the 3 axes
+  struct Bins {
+    Aabb     boxes[3][kMaxBins];
+    uint32_t counts[3][kMaxBins];
+  };
+
+  // Top of the tree, built on the calling thread. The subtrees are tasks.
+  struct TopNode {
+    Node     node;
+    int      task;
+    uint32_t left;
+    uint32_t right;
+  };
+
+  struct Task {
+    uint32_t          begin;
+    uint32_t          end;
+    Aabb              box;
+    int               depth;
+    int               max_depth;
+    std::vector<Node> nodes;
+  };
+
+  const Params&         params;
+  int                   n_bins;
+  int                   n_threads;
+  std::vector<Triangle> triangles;
+
+  Builder(const Params& params, int n_threads) 
+      : params(params), 
+        n_bins(std::max(2, std::min(kMaxBins, params.n_bins))),
+        n_threads(n_threads) {
+  }
+
+  Aabb GetBounds(uint32_t begin, uint32_t end) const {
+    Aabb box = EmptyBox();
+    for (uint32_t i = begin; i < end; ++i) {
+      Grow(box, triangles[i].box);
+    }
+    return box;
+  }
+
+  int GetBin(float center, float min, float scale) const {
+    int bin = (int)((center - min) * scale);
+    return std::max(0, std::min(n_bins - 1, bin));
+  }
+
+  void Fill(Bins& bins, uint32_t begin, uint32_t end, const Aabb& center_box,
+            const float scale[3]) const {
+    for (int axis = 0; axis < 3; ++axis) {
+      std::fill(bins.boxes[axis], bins.boxes[axis] + n_bins, EmptyBox());
+      std::fill(bins.counts[axis], bins.counts[axis] + n_bins, 0);
+    }
+    for (uint32_t i = begin; i < end; ++i) {
+      const Triangle& t = triangles[i];
+      for (int axis = 0; axis < 3; ++axis) {
+        int bin = GetBin(t.center[axis], center_box.min[axis], scale[axis]);
+        Grow(bins.boxes[axis][bin], t.box);
+        ++bins.counts[axis][bin];
+      }
+    }
+  }
+
+  // The big ranges at the top of the tree are binned by all the threads
+  void Fill(Bins& bins, uint32_t begin, uint32_t end, const Aabb& center_box,
+            const float scale[3], int threads) const {
+    int n_bands = std::min<int>(threads, (end - begin) / kMinTrianglesPerTask);
+    if (n_bands <= 1) {
+      Fill(bins, begin, end, center_box, scale);
+      return;
+    }
+    std::vector<Bins> bands(n_bands);
+    uint32_t band = (end - begin + n_bands - 1) / n_bands;
+    ParallelFor(0, n_bands, n_bands, [&](int first, int last) {
+      for (int i = first; i < last; ++i) {
+        uint32_t band_begin = begin + i * band;
+        Fill(bands[i], band_begin, std::min(end, band_begin + band), 
+             center_box, scale);
+      }
+    });
+    bins = bands[0];
+    for (int i = 1; i < n_bands; ++i) {
+      for (int axis = 0; axis < 3; ++axis) {
+        for (int bin = 0; bin < n_bins; ++bin) {
+          Grow(bins.boxes[axis][bin], bands[i].boxes[axis][bin]);
+          bins.counts[axis][bin] += bands[i].counts[axis][bin];
+        }
+      }
+    }
+  }
+
+  // Returns the first triangle of the second child and the boxes of the
+  // children, end - a leaf
+  uint32_t Split(uint32_t begin, uint32_t end, const Aabb& box, int depth,
+                 int threads, Aabb& left_box, Aabb& right_box) {
+    uint32_t n = end - begin;
+    if (n <= 1 || depth >= kMaxDepth) {
+      return end;
+    }
+
+    Aabb center_box = EmptyBox();
+    for (uint32_t i = begin; i < end; ++i) {
+      Grow(center_box, triangles[i].center);
+    }
+    float scale[3];
+    for (int axis = 0; axis < 3; ++axis) {
+      float extent = center_box.max[axis] - center_box.min[axis];
+      scale[axis] = extent > 0 ? n_bins / extent : 0;
+    }
+    Bins bins;
+    Fill(bins, begin, end, center_box, scale, threads);
+
+    // Binned SAH, the cost of the children as if they were leaves
+    float best_cost = std::numeric_limits<float>::max();
+    int best_axis = -1, best_bin = 0;
+    for (int axis = 0; axis < 3; ++axis) {
+      if (scale[axis] == 0) {
+        continue;
+      }
+      float right_area[kMaxBins];
+      uint32_t right_count[kMaxBins];
+      Aabb acc = EmptyBox();
+      uint32_t count = 0;
+      for (int bin = n_bins - 1; bin > 0; --bin) {
+        Grow(acc, bins.boxes[axis][bin]);
+        count += bins.counts[axis][bin];
+        right_area[bin] = Area(acc);
+        right_count[bin] = count;
+      }
+      acc = EmptyBox();
+      count = 0;
+      for (int bin = 0; bin < n_bins - 1; ++bin) {
+        Grow(acc, bins.boxes[axis][bin]);
+        count += bins.counts[axis][bin];
+        if (count == 0 || right_count[bin + 1] == 0) {
+          continue;
+        }
+        float cost = Area(acc) * PackCount(count) + 
+                     right_area[bin + 1] * PackCount(right_count[bin + 1]);
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_axis = axis;
+          best_bin = bin;
+        }
+      }
+    }
+
+    float leaf_cost = PackCount(n);
+    float split_cost = params.traversal_cost + 
+                       best_cost / std::max(Area(box), 1e-30f);
+    if ((int)n <= params.max_leaf_size && 
+        (best_axis < 0 || leaf_cost <= split_cost)) {
+      return end;
+    }
+
+    // All the centers in one point, the halves
+    if (best_axis < 0) {
+      uint32_t mid = begin + n / 2;
+      left_box = GetBounds(begin, mid);
+      right_box = GetBounds(mid, end);
+      return mid;
+    }
+
+    float min = center_box.min[best_axis];
+    uint32_t mid = std::partition(
+        triangles.begin() + begin, triangles.begin() + end,
+        [&](const Triangle& t) {
+          return GetBin(t.center[best_axis], min, scale[best_axis]) <= best_bin;
+        }) - triangles.begin();
+    left_box = EmptyBox();
+    right_box = EmptyBox();
+    for (int bin = 0; bin < n_bins; ++bin) {
+      Grow(bin <= best_bin ? left_box : right_box, 
+           bins.boxes[best_axis][bin]);
+    }
+    return mid;
+  }
+
+  // Depth first, the leaves refer to the triangles [offset, offset + count)
+  void Build(std::vector<Node>& nodes, uint32_t begin, uint32_t end, 
+             const Aabb& box, int depth, int& max_depth) {
+    uint32_t index = nodes.size();
+    nodes.push_back({box.min, begin, box.max, end - begin});
+    max_depth = std::max(max_depth, depth);
+    Aabb left_box, right_box;
+    uint32_t mid = Split(begin, end, box, depth, 1, left_box, right_box);
+    if (mid == end) {
+      return;
+    }
+    nodes[index].count = 0;
+    Build(nodes, begin, mid, left_box, depth + 1, max_depth);
+    nodes[index].offset = nodes.size();
+    Build(nodes, mid, end, right_box, depth + 1, max_depth);
+  }
+
+  // Same splits as Build() down to the tasks
+  uint32_t BuildTop(std::vector<TopNode>& top, std::vector<Task>& tasks, 
+                    uint32_t begin, uint32_t end, const Aabb& box, 
+                    int depth, uint32_t task_size) {
+    uint32_t index = top.size();
+    top.push_back({Node(), -1, 0, 0});
+    if (end - begin > task_size) {
+      Aabb left_box, right_box;
+      uint32_t mid = Split(begin, end, box, depth, n_threads, 
+                           left_box, right_box);
+      if (mid != end) {
+        top[index].node = {box.min, 0, box.max, 0};
+        uint32_t left = BuildTop(top, tasks, begin, mid, left_box, 
+                                 depth + 1, task_size);
+        uint32_t right = BuildTop(top, tasks, mid, end, right_box, 
+                                  depth + 1, task_size);
+        top[index].left = left;
+        top[index].right = right;
+        return index;
+      }
+    }
+    top[index].task = tasks.size();
+    tasks.push_back({begin, end, box, depth, depth, {}});
+    return index;
+  }
+
+  void Emit(const std::vector<TopNode>& top, const std::vector<Task>& tasks,
+            uint32_t index, std::vector<Node>& nodes) {
+    const TopNode& t = top[index];
+    if (t.task >= 0) {
+      uint32_t base = nodes.size();
+      for (Node node: tasks[t.task].nodes) {
+        if (node.count == 0) {
+          node.offset += base;
+        }
+        nodes.push_back(node);
+      }
+      return;
+    }
+    uint32_t i = nodes.size();
+    nodes.push_back(t.node);
+    Emit(top, tasks, t.left, nodes);
+    nodes[i].offset = nodes.size();
+    Emit(top, tasks, t.right, nodes);
+  }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// Bvh
+//////////////////////////////////////////////////////////////////////////////
+Bvh::Bvh(const Mesh& mesh, const Params& params) 
+    : isa_(ResolveIsa(params.isa)) {
+  size_t n = GetTriangleCount(mesh);
+  for (auto index: mesh.indices) {
+    if (index >= mesh.vertices.size()) {
+      ABORT_F("Bvh: index %u out of %zu vertices", index, 
+              mesh.vertices.size());
+    }
+  }
+  if (n >= std::numeric_limits<uint32_t>::max()) {
+    ABORT_F("Bvh: too many triangles %zu", n);
+  }
+  stats_.triangles = n;
+  if (n == 0) {
+    return;
+  }
+
+  int n_threads = params.n_threads;
+  if (n_threads <= 0) {
+    n_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  Builder builder(params, n_threads);
+  builder.triangles.resize(n);
+  ParallelFor(0, n, n_threads, [&](int first, int last) {
+    glm::vec3 v[3];
+    for (int i = first; i < last; ++i) {
+      GetTriangle(mesh, i, v);
+      Aabb box = {v[0], v[0]};
+      Grow(box, v[1]);
+      Grow(box, v[2]);
+      builder.triangles[i] = {box, (box.min + box.max) * 0.5f, (uint32_t)i};
+    }
+  });
+
+  // ~4 tasks per thread to even out the subtree sizes
+  uint32_t task_size = n;
+  if (n_threads > 1) {
+    task_size = std::max<uint32_t>(kMinTrianglesPerTask, n / (4 * n_threads));
+  }
+  std::vector<Builder::TopNode> top;
+  std::vector<Builder::Task> tasks;
+  builder.BuildTop(top, tasks, 0, n, builder.GetBounds(0, n), 0, task_size);
+  ParallelFor(0, tasks.size(), n_threads, [&](int first, int last) {
+    for (int i = first; i < last; ++i) {
+      auto& task = tasks[i];
+      builder.Build(task.nodes, task.begin, task.end, task.box, task.depth, 
+                    task.max_depth);
+    }
+  });
+  builder.Emit(top, tasks, 0, nodes_);
+  for (auto& task: tasks) {
+    stats_.depth = std::max(stats_.depth, task.max_depth);
+  }
+
+  // The leaves to the packs
+  std::vector<uint32_t> leaves;
+  std::vector<uint32_t> first_pack(1, 0);
+  for (uint32_t i = 0; i < nodes_.size(); ++i) {
+    if (nodes_[i].count) {
+      leaves.push_back(i);
+      first_pack.push_back(first_pack.back() + PackCount(nodes_[i].count));
+    }
+  }
+  packs_.resize(first_pack.back());
+  ParallelFor(0, leaves.size(), n_threads, [&](int first, int last) {
+    glm::vec3 v[3];
+    for (int l = first; l < last; ++l) {
+      Node& node = nodes_[leaves[l]];
+      for (uint32_t k = 0; k < PackCount(node.count) * 4; ++k) {
+        Pack& pack = packs_[first_pack[l] + k / 4];
+        int lane = k % 4;
+        if (k >= node.count) {
+          pack.id[lane] = ~0u;
+          continue;
+        }
+        uint32_t id = builder.triangles[node.offset + k].id;
+        GetTriangle(mesh, id, v);
+        for (int c = 0; c < 3; ++c) {
+          pack.v0[c][lane] = v[0][c];
+          pack.e1[c][lane] = v[1][c] - v[0][c];
+          pack.e2[c][lane] = v[2][c] - v[0][c];
+        }
+        pack.id[lane] = id;
+      }
+      node.offset = first_pack[l];
+      node.count = PackCount(node.count);
+    }
+  });
+
+  stats_.nodes = nodes_.size();
+  stats_.leaves = leaves.size();
+  stats_.packs = packs_.size();
+  float root_area = std::max(Area(GetBounds()), 1e-30f);
+  for (auto& node: nodes_) {
+    float p = Area({node.min, node.max}) / root_area;
+    stats_.sah_cost += p * (node.count ? node.count : params.traversal_cost);
+  }
+}
+
+Aabb Bvh::GetBounds() const {
+  if (nodes_.empty()) {
+    return EmptyBox();
+  }
+  return {nodes_[0].min, nodes_[0].max};
+}
+
+bool Bvh::Raycast(const Ray& ray, Hit& hit, float t_min, float t_max) const {
+  return Traverse<false>(ray, hit, t_min, t_max);
+}
+
+bool Bvh::Occluded(const Ray& ray, float t_min, float t_max) const {
+  Hit hit;
+  return Traverse<true>(ray, hit, t_min, t_max);
+}
+
+template <bool kAny>
+bool Bvh::Traverse(const Ray& ray, Hit& hit, float t_min, 
+                   float t_max) const {
+  if (nodes_.empty()) {
+    return false;
+  }
+
+  auto intersect_pack = PackScalar;
+  auto intersect_box = BoxScalar;
+#ifdef B3D_BVH_X86
+  if (isa_ == Isa::kSse2) {
+    intersect_pack = PackSse2;
+    intersect_box = BoxSse2;
+  }
+#endif
+
+  glm::vec3 inv_direction = 1.0f / ray.direction;
+  const float origin[4] = {ray.origin.x, ray.origin.y, ray.origin.z, 0};
+  const float inv[4] = {inv_direction.x, inv_direction.y, inv_direction.z, 0};
+
+  // The far children to visit, with the distance to their boxes
+  struct Entry {
+    uint32_t node;
+    float    t;
+  };
+  Entry stack[kMaxDepth + 1];
+  int size = 0;
+
+  bool found = false;
+  float t_near;
+  if (!intersect_box(nodes_[0], origin, inv, t_min, t_max, t_near)) {
+    return false;
+  }
+  uint32_t i = 0;
+  for (;;) {
+    const Node& node = nodes_[i];
+    if (node.count) {
+      for (uint32_t p = node.offset; p < node.offset + node.count; ++p) {
+        if (intersect_pack(packs_[p], ray, t_min, t_max, hit)) {
+          found = true;
+          if (kAny) {
+            return true;
+          }
+        }
+      }
+    } else {
+      uint32_t a = i + 1, b = node.offset;
+      float t_a, t_b;
+      bool hit_a = intersect_box(nodes_[a], origin, inv, t_min, t_max, t_a);
+      bool hit_b = intersect_box(nodes_[b], origin, inv, t_min, t_max, t_b);
+      if (hit_a && hit_b) {
+        if (t_b < t_a) {
+          std::swap(a, b);
+          std::swap(t_a, t_b);
+        }
+        stack[size++] = {b, t_b};
+        i = a;
+        continue;
+      } else if (hit_a || hit_b) {
+        i = hit_a ? a : b;
+        continue;
+      }
+    }
+
+    // The next one which is not behind the hit
+    while (size > 0 && stack[size - 1].t > t_max) {
+      --size;
+    }
+    if (size == 0) {
+      break;
+    }
+    i = stack[--size].node;
+  }
+  return found;
+}
+
+bool Bvh::RaycastBruteForce(const Mesh& mesh, const Ray& ray, Hit& hit,
+                            float t_min, float t_max) {
+  bool found = false;
+  size_t n = GetTriangleCount(mesh);
+  glm::vec3 v[3];
+  for (size_t i = 0; i < n; ++i) {
+    GetTriangle(mesh, i, v);
+    float t, u, w;
+    if (IntersectTriangle(v[0], v[1] - v[0], v[2] - v[0], ray, t, u, w) &&
+        t > t_min && t < t_max) {
+      t_max = t;
+      hit = {t, (uint32_t)i, u, w};
+      found = true;
+    }
+  }
+  return found;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// BvhCache
+//////////////////////////////////////////////////////////////////////////////
+std::shared_ptr<const Bvh> BvhCache::Get(const std::shared_ptr<Mesh>& mesh) {
+  if (!mesh) {
+    return nullptr;
+  }
+  auto it = entries_.find(mesh.get());
+  if (it != entries_.end() && it->second.mesh.lock() == mesh) {
+    return it->second.bvh;
+  }
+
+  // A new mesh may have the address of a dead one
+  for (it = entries_.begin(); it != entries_.end();) {
+    if (it->second.mesh.expired()) {
+      it = entries_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  auto bvh = std::make_shared<const Bvh>(*mesh, params_);
+  entries_[mesh.get()] = {mesh, bvh};
+  return bvh;
+}
+
+} // namespace Phys
@@ -0,0 +1,159 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _BVH_H_AC476FCF_6AED_40C5_AA8C_F3931659B3E9_
+#define _BVH_H_AC476FCF_6AED_40C5_AA8C_F3931659B3E9_ 
+
+#include "phys/ray.h"
+#include "mesh.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace Phys {
+
+//////////////////////////////////////////////////////////////////////////////
+// Bounding volume hierarchy over the triangles of a mesh, for the raycasts
+// (picking, line of sight). Model space, the mesh is copied in, so it can
+// change or go away afterwards.
+//
+// Built top-down with the surface area heuristic over the binned triangle
+// centers. The top of the tree is split on the calling thread, the 
+// subtrees are built in parallel; the tree is the same for any number of 
+// threads. The nodes are flattened depth first to one array of 32 bytes 
+// nodes, the first child right after its parent. The leaves refer to the 
+// packs of 4 triangles in SoA layout, the rays test the 4 at once (SSE2) 
+// and a node box in one go.
+//
+// Phys::Bvh bvh(*mesh);
+// Phys::Bvh::Hit hit;
+// if (bvh.Raycast(ray, hit)) { ray.At(hit.t)... }
+//////////////////////////////////////////////////////////////////////////////
+class Bvh {
+ public:
+  enum class Isa { kBest, kScalar, kSse2 };
+
+  struct Params {
+    int   max_leaf_size  = 8;  // Triangles, the bigger leaves are split
+    int   n_bins         = 16; // Per axis, for the SAH
+    float traversal_cost = 1;  // Of a node, relative to a pack of triangles
+    int   n_threads      = 0;  // 0 - all the cores
+    Isa   isa            = Isa::kBest;
+  };
+
+  // 4 triangles, v0 and the edges v1 - v0 and v2 - v0. The padding is 
+  // degenerate and never hit.
+  struct alignas(16) Pack {
+    float    v0[3][4];
+    float    e1[3][4];
+    float    e2[3][4];
+    uint32_t id[4];
+  };
+
+  struct Node {
+    glm::vec3 min;
+    uint32_t  offset; // Leaf - the first pack, inner - the second child
+    glm::vec3 max;
+    uint32_t  count;  // Packs in the leaf, 0 - inner node
+  };
+
+  struct Hit {
+    float    t;        // Along the ray
+    uint32_t triangle; // Indices 3 * triangle... of the mesh
+    float    u;        // Barycentric of the second vertex
+    float    v;        // Barycentric of the third vertex
+  };
+
+  struct Stats {
+    size_t triangles = 0;
+    size_t nodes     = 0;
+    size_t leaves    = 0;
+    size_t packs     = 0; // Includes the padding
+    int    depth     = 0;
+    float  sah_cost  = 0; // Expected cost of a ray, in packs tested
+  };
+
+  explicit Bvh(const Mesh& mesh) : Bvh(mesh, Params()) {}
+  Bvh(const Mesh& mesh, const Params& params);
+
+  // The nearest hit in (t_min, t_max), both sides of the triangles
+  bool Raycast(const Ray& ray, Hit& hit, float t_min = 0,
+               float t_max = std::numeric_limits<float>::max()) const;
+
+  // Any hit in (t_min, t_max), for the line of sight
+  bool Occluded(const Ray& ray, float t_min = 0,
+                float t_max = std::numeric_limits<float>::max()) const;
+
+  Aabb GetBounds() const;
+  const std::vector<Node>& GetNodes() const { return nodes_; }
+  const Stats& GetStats() const { return stats_; }
+  Isa GetIsa() const { return isa_; }
+
+  // Every triangle, for the reference
+  static bool RaycastBruteForce(const Mesh& mesh, const Ray& ray, Hit& hit,
+      float t_min = 0, float t_max = std::numeric_limits<float>::max());
+
+ private:
+  struct Builder;
+
+  template <bool kAny>
+  bool Traverse(const Ray& ray, Hit& hit, float t_min, float t_max) const;
+
+  Isa               isa_;
+  std::vector<Node> nodes_;
+  std::vector<Pack> packs_;
+  Stats             stats_;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// The BVHs of the meshes, built on the first request. Only weak references
+// to the meshes are kept, the BVHs of the dead meshes are dropped. A mesh 
+// changed in place needs Invalidate().
+//////////////////////////////////////////////////////////////////////////////
+class BvhCache {
+ public:
+  BvhCache() : BvhCache(Bvh::Params()) {}
+  explicit BvhCache(const Bvh::Params& params) : params_(params) {}
+
+  std::shared_ptr<const Bvh> Get(const std::shared_ptr<Mesh>& mesh);
+  void Invalidate(const Mesh* mesh) { entries_.erase(mesh); }
+  void Clear() { entries_.clear(); }
+  size_t GetSize() const { return entries_.size(); }
+
+ private:
+  struct Entry {
+    std::weak_ptr<Mesh>        mesh;
+    std::shared_ptr<const Bvh> bvh;
+  };
+
+  Bvh::Params                   params_;
+  std::map<const Mesh*, Entry>  entries_;
+};
+
+} // namespace Phys
+
+#endif // _BVH_H_AC476FCF_6AED_40C5_AA8C_F3931659B3E9_
@@ -0,0 +1,68 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _RAY_H_3243B469_67C3_4DEC_A2F5_D2A3411B90E3_
+#define _RAY_H_3243B469_67C3_4DEC_A2F5_D2A3411B90E3_ 
+
+#include "phys/aabb.h"
+#include <algorithm>
+
+namespace Phys {
+
+// The distances along the ray are in the units of the direction, it does 
+// not have to be normalized (a ray moved to the local space of a scaled
+// actor keeps the distances).
+struct Ray {
+  glm::vec3 origin;
+  glm::vec3 direction;
+
+  glm::vec3 At(float t) const { return origin + direction * t; }
+};
+
+// The ray from the near plane through the point of the screen. pv - the
+// projection * view of the camera, ndc - [-1, 1], y is up.
+inline Ray ScreenPointToRay(const glm::mat4& pv, const glm::vec2& ndc) {
+  glm::mat4 inv = glm::inverse(pv);
+  glm::vec4 near = inv * glm::vec4(ndc, -1, 1);
+  glm::vec4 far = inv * glm::vec4(ndc, 1, 1);
+  glm::vec3 origin = glm::vec3(near) / near.w;
+  return {origin, glm::normalize(glm::vec3(far) / far.w - origin)};
+}
+
+// Slab test, t_near - where the ray enters the box, clamped to t_min
+inline bool Intersect(const Ray& ray, const Aabb& box, float t_min, 
+                      float t_max, float& t_near) {
+  glm::vec3 inv = 1.0f / ray.direction;
+  glm::vec3 t0 = (box.min - ray.origin) * inv;
+  glm::vec3 t1 = (box.max - ray.origin) * inv;
+  glm::vec3 lo = glm::min(t0, t1);
+  glm::vec3 hi = glm::max(t0, t1);
+  t_near = std::max(std::max(lo.x, lo.y), std::max(lo.z, t_min));
+  float t_far = std::min(std::min(hi.x, hi.y), std::min(hi.z, t_max));
+  return t_near <= t_far;
+}
+
+} // namespace Phys
+
+#endif // _RAY_H_3243B469_67C3_4DEC_A2F5_D2A3411B90E3_
@@ -0,0 +1,351 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "phys/sweepandprune.h"
+#include "common/logging.h"
+#include "common/parallel.h"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define B3D_SAP_X86
+#include <immintrin.h>
+#endif
+
+namespace Phys {
+
+namespace {
+
+// Fewer bodies are swept on the calling thread
+const int kMinBodiesPerThread = 4096;
+
+// More new bodies are sorted in by the full sort
+const size_t kMaxInsertions = 256;
+
+SweepAndPrune::Isa ResolveIsa(SweepAndPrune::Isa wanted) {
+#ifdef B3D_SAP_X86
+  __builtin_cpu_init();
+  bool has_sse2 = __builtin_cpu_supports("sse2");
+  if (wanted == SweepAndPrune::Isa::kScalar || !has_sse2) {
+    return SweepAndPrune::Isa::kScalar;
+  }
+  return SweepAndPrune::Isa::kSse2;
+#else
+  return SweepAndPrune::Isa::kScalar;
+#endif
+}
+
+// a - the sort axis, b and c - the other two. Returns the candidates 
+// overlapping along the axis.
+size_t SweepScalar(const std::vector<float>* min, const std::vector<float>* max,
+                   const std::vector<uint32_t>& order, int begin, int end, 
+                   std::vector<SweepAndPrune::Pair>& pairs) {
+  const float* min_a = min[0].data();
+  const float* max_a = max[0].data();
+  const float* min_b = min[1].data();
+  const float* max_b = max[1].data();
+  const float* min_c = min[2].data();
+  const float* max_c = max[2].data();
+  size_t tests = 0;
+  for (int i = begin; i < end; ++i) {
+    // The padding stops the loop, its min is +inf
+    for (int j = i + 1; min_a[j] <= max_a[i]; ++j) {
+      ++tests;
+      if (min_b[j] <= max_b[i] && min_b[i] <= max_b[j] &&
+          min_c[j] <= max_c[i] && min_c[i] <= max_c[j]) {
+        uint32_t a = order[i], b = order[j];
+        pairs.push_back({std::min(a, b), std::max(a, b)});
+      }
+    }
+  }
+  return tests;
+}
+
+#ifdef B3D_SAP_X86
+
+// Same tests as the scalar one, 4 candidates at a time
+__attribute__((target("sse2")))
+size_t SweepSse2(const std::vector<float>* min, const std::vector<float>* max,
+                 const std::vector<uint32_t>& order, int begin, int end, 
+                 std::vector<SweepAndPrune::Pair>& pairs) {
+  const float* min_a = min[0].data();
+  const float* max_a = max[0].data();
+  const float* min_b = min[1].data();
+  const float* max_b = max[1].data();
+  const float* min_c = min[2].data();
+  const float* max_c = max[2].data();
+  size_t tests = 0;
+  for (int i = begin; i < end; ++i) {
+    const __m128 i_max_a = _mm_set1_ps(max_a[i]);
+    const __m128 i_min_b = _mm_set1_ps(min_b[i]);
+    const __m128 i_max_b = _mm_set1_ps(max_b[i]);
+    const __m128 i_min_c = _mm_set1_ps(min_c[i]);
+    const __m128 i_max_c = _mm_set1_ps(max_c[i]);
+    for (int j = i + 1; ; j += 4) {
+      // Sorted, so the lanes overlapping along the axis come first
+      int along = _mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(min_a + j), 
+                                               i_max_a));
+      if (along == 0) {
+        break;
+      }
+      __m128 overlap = _mm_and_ps(
+          _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(min_b + j), i_max_b),
+                     _mm_cmple_ps(i_min_b, _mm_loadu_ps(max_b + j))),
+          _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(min_c + j), i_max_c),
+                     _mm_cmple_ps(i_min_c, _mm_loadu_ps(max_c + j))));
+      int mask = _mm_movemask_ps(overlap) & along;
+      tests += __builtin_popcount(along);
+      while (mask) {
+        int lane = __builtin_ctz(mask);
+        mask &= mask - 1;
+        uint32_t a = order[i], b = order[j + lane];
+        pairs.push_back({std::min(a, b), std::max(a, b)});
+      }
+      if (along != 0xf) {
+        break;
+      }
+    }
+  }
+  return tests;
+}
+
+#endif // B3D_SAP_X86
+
+Aabb Clamp(const Aabb& bounds) {
+  const float k = SweepAndPrune::kMaxCoord;
+  return {glm::clamp(bounds.min, -k, k), glm::clamp(bounds.max, -k, k)};
+}
+
+// Reaches out to the clamp, the center says nothing about where it is
+bool IsUnbounded(const Aabb& bounds) {
+  const float k = SweepAndPrune::kMaxCoord;
+  for (int i = 0; i < 3; ++i) {
+    if (bounds.min[i] <= -k || bounds.max[i] >= k) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}
+
+constexpr float SweepAndPrune::kMaxCoord;
+
+SweepAndPrune::SweepAndPrune(const Params& params) 
+    : params_(params), 
+      isa_(ResolveIsa(params.isa)), 
+      axis_(0), 
+      removed_(false) {
+}
+
+uint32_t SweepAndPrune::Add(const Aabb& bounds) {
+  uint32_t id;
+  if (!free_ids_.empty()) {
+    id = free_ids_.back();
+    free_ids_.pop_back();
+    bounds_[id] = Clamp(bounds);
+    alive_[id] = true;
+    // Still in the order if removed since the last FindPairs()
+    if (in_order_[id]) {
+      return id;
+    }
+  } else {
+    id = bounds_.size();
+    bounds_.push_back(Clamp(bounds));
+    alive_.push_back(true);
+    in_order_.push_back(false);
+  }
+  added_.push_back(id);
+  return id;
+}
+
+void SweepAndPrune::Update(uint32_t id, const Aabb& bounds) {
+  bounds_.at(id) = Clamp(bounds);
+}
+
+void SweepAndPrune::Remove(uint32_t id) {
+  if (id >= alive_.size() || !alive_[id]) {
+    ABORT_F("No body %u", id);
+  }
+  alive_[id] = false;
+  free_ids_.push_back(id);
+  removed_ = true;
+}
+
+void SweepAndPrune::UpdateOrder() {
+  // The axis with the biggest spread of the centers separates best
+  glm::vec3 sum(0), sum2(0);
+  size_t n = 0;
+  for (size_t id = 0; id < bounds_.size(); ++id) {
+    if (alive_[id] && !IsUnbounded(bounds_[id])) {
+      glm::vec3 c = bounds_[id].min + bounds_[id].max;
+      sum += c;
+      sum2 += c * c;
+      ++n;
+    }
+  }
+  glm::vec3 variance = n ? sum2 / (float)n - (sum / (float)n) * (sum / (float)n) 
+                         : glm::vec3(0);
+  int axis = variance.x >= variance.y ? (variance.x >= variance.z ? 0 : 2) 
+                                      : (variance.y >= variance.z ? 1 : 2);
+  // Hysteresis, the full sort is not for free
+  bool resort = axis != axis_ && variance[axis] > 1.5f * variance[axis_];
+  if (resort) {
+    axis_ = axis;
+  }
+
+  if (removed_) {
+    order_.erase(std::remove_if(order_.begin(), order_.end(), 
+        [this](uint32_t id) { 
+          in_order_[id] = alive_[id];
+          return !alive_[id]; 
+        }), order_.end());
+    removed_ = false;
+  }
+  // An id may be added, removed and added again
+  for (uint32_t id: added_) {
+    if (alive_[id] && !in_order_[id]) {
+      order_.push_back(id);
+      in_order_[id] = true;
+    }
+  }
+  resort |= added_.size() > kMaxInsertions;
+  added_.clear();
+
+  keys_.resize(order_.size());
+  for (size_t i = 0; i < order_.size(); ++i) {
+    keys_[i] = bounds_[order_[i]].min[axis_];
+  }
+
+  stats_.swaps = 0;
+  stats_.resorted = resort;
+  if (resort) {
+    std::vector<uint32_t> index(order_.size());
+    std::iota(index.begin(), index.end(), 0);
+    std::sort(index.begin(), index.end(), [this](uint32_t a, uint32_t b) {
+      return keys_[a] < keys_[b];
+    });
+    std::vector<uint32_t> order(order_.size());
+    std::vector<float> keys(order_.size());
+    for (size_t i = 0; i < index.size(); ++i) {
+      order[i] = order_[index[i]];
+      keys[i] = keys_[index[i]];
+    }
+    order_.swap(order);
+    keys_.swap(keys);
+    return;
+  }
+
+  // Insertion sort, the bodies moved a little since the last time
+  for (size_t i = 1; i < order_.size(); ++i) {
+    float key = keys_[i];
+    uint32_t id = order_[i];
+    size_t j = i;
+    while (j > 0 && keys_[j - 1] > key) {
+      keys_[j] = keys_[j - 1];
+      order_[j] = order_[j - 1];
+      --j;
+    }
+    keys_[j] = key;
+    order_[j] = id;
+    stats_.swaps += i - j;
+  }
+}
+
+void SweepAndPrune::Sweep(int begin, int end, std::vector<Pair>& pairs, 
+                          size_t& tests) {
+#ifdef B3D_SAP_X86
+  if (isa_ == Isa::kSse2) {
+    tests = SweepSse2(min_, max_, order_, begin, end, pairs);
+    return;
+  }
+#endif
+  tests = SweepScalar(min_, max_, order_, begin, end, pairs);
+}
+
+const std::vector<SweepAndPrune::Pair>& SweepAndPrune::FindPairs() {
+  UpdateOrder();
+
+  // The sort axis first
+  const int axes[3] = {axis_, (axis_ + 1) % 3, (axis_ + 2) % 3};
+  const size_t n = order_.size();
+  for (int k = 0; k < 3; ++k) {
+    min_[k].resize(n + 4);
+    max_[k].resize(n + 4);
+    for (size_t i = 0; i < n; ++i) {
+      const Aabb& bounds = bounds_[order_[i]];
+      min_[k][i] = bounds.min[axes[k]];
+      max_[k][i] = bounds.max[axes[k]];
+    }
+    std::fill(min_[k].begin() + n, min_[k].end(), 
+              std::numeric_limits<float>::infinity());
+    std::fill(max_[k].begin() + n, max_[k].end(), 
+              -std::numeric_limits<float>::infinity());
+  }
+
+  int n_threads = params_.n_threads;
+  if (n_threads <= 0) {
+    n_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  n_threads = std::max(1, std::min(n_threads, (int)n / kMinBodiesPerThread));
+
+  // A band per thread, the pairs of the bands go in order
+  std::vector<std::vector<Pair>> band_pairs(n_threads);
+  std::vector<size_t> band_tests(n_threads);
+  int band = n_threads ? ((int)n + n_threads - 1) / n_threads : 0;
+  ParallelFor(0, n_threads, n_threads, [&](int first, int last) {
+    for (int t = first; t < last; ++t) {
+      int begin = std::min((int)n, t * band);
+      int end = std::min((int)n, begin + band);
+      Sweep(begin, end, band_pairs[t], band_tests[t]);
+    }
+  });
+
+  pairs_.clear();
+  stats_.tests = 0;
+  for (int t = 0; t < n_threads; ++t) {
+    pairs_.insert(pairs_.end(), band_pairs[t].begin(), band_pairs[t].end());
+    stats_.tests += band_tests[t];
+  }
+  stats_.bodies = n;
+  stats_.pairs = pairs_.size();
+  stats_.axis = axis_;
+  return pairs_;
+}
+
+void SweepAndPrune::FindPairsBruteForce(const std::vector<Aabb>& boxes, 
+                                        std::vector<Pair>& pairs) {
+  pairs.clear();
+  for (size_t i = 0; i < boxes.size(); ++i) {
+    for (size_t j = i + 1; j < boxes.size(); ++j) {
+      if (Overlap(boxes[i], boxes[j])) {
+        pairs.push_back({(uint32_t)i, (uint32_t)j});
+      }
+    }
+  }
+}
+
+} // namespace Phys
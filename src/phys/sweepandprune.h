@@ -0,0 +1,129 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _SWEEPANDPRUNE_H_A8BEB1FD_4E2A_4AE1_8FFB_0A9520FF95E7_
+#define _SWEEPANDPRUNE_H_A8BEB1FD_4E2A_4AE1_8FFB_0A9520FF95E7_ 
+
+#include "phys/aabb.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Phys {
+
+//////////////////////////////////////////////////////////////////////////////
+// Sweep and prune broadphase: the pairs of bodies whose AABBs overlap.
+//
+// The bodies are kept sorted by the box min along one axis, the one with 
+// the biggest spread of the centers. From frame to frame the bodies move a
+// little, so the order is restored by an insertion sort in about linear 
+// time (the temporal coherence). The sweep walks the sorted array and tests
+// every body against the following ones until their min passes its max, 4
+// at a time with SSE2. The sweep is split into bands for the threads, the 
+// pairs come in the same order whatever the threads and the ISA.
+//
+// Phys::SweepAndPrune sap;
+// uint32_t id = sap.Add(bounds);
+// ... every step:
+// sap.Update(id, bounds);
+// for (auto& pair: sap.FindPairs()) { narrow phase... }
+//////////////////////////////////////////////////////////////////////////////
+class SweepAndPrune {
+ public:
+  enum class Isa { kBest, kScalar, kSse2 };
+
+  // Finite, the +inf padding must stop the sweep of every box
+  static constexpr float kMaxCoord = 1e15f;
+
+  struct Params {
+    int n_threads = 0;   // 0 - all the cores
+    Isa isa       = Isa::kBest;
+  };
+
+  // a < b, the body ids
+  struct Pair {
+    uint32_t a;
+    uint32_t b;
+  };
+
+  struct Stats {
+    size_t bodies   = 0;
+    size_t swaps    = 0; // Insertion sort moves
+    size_t tests    = 0; // Boxes overlapping along the sort axis
+    size_t pairs    = 0;
+    int    axis     = 0;
+    bool   resorted = false; // Full sort: axis change or many new bodies
+  };
+
+  SweepAndPrune() : SweepAndPrune(Params()) {}
+  explicit SweepAndPrune(const Params& params);
+
+  // Returns the id, the ids of the removed bodies are reused. The bounds
+  // are clamped to +-kMaxCoord, the infinite ones too (a ground plane).
+  uint32_t Add(const Aabb& bounds);
+  void Remove(uint32_t id);
+  void Update(uint32_t id, const Aabb& bounds);
+  const Aabb& GetBounds(uint32_t id) const { return bounds_.at(id); }
+  size_t GetBodyCount() const { return bounds_.size() - free_ids_.size(); }
+
+  const std::vector<Pair>& FindPairs();
+  const std::vector<Pair>& GetPairs() const { return pairs_; }
+  const Stats& GetStats() const { return stats_; }
+  Isa GetIsa() const { return isa_; }
+
+  // Every box against every box, for the reference. The ids are the 
+  // indices, in the order of i then j.
+  static void FindPairsBruteForce(const std::vector<Aabb>& boxes, 
+                                  std::vector<Pair>& pairs);
+
+ private:
+  void UpdateOrder();
+  void Sweep(int begin, int end, std::vector<Pair>& pairs, size_t& tests);
+
+  Params                 params_;
+  Isa                    isa_;
+  int                    axis_;
+  std::vector<Aabb>      bounds_;   // By id
+  std::vector<bool>      alive_;
+  std::vector<bool>      in_order_;
+  std::vector<uint32_t>  free_ids_;
+  std::vector<uint32_t>  added_;    // Not in the order yet
+  bool                   removed_;
+
+  // Sorted by the min along the axis
+  std::vector<uint32_t>  order_;
+  std::vector<float>     keys_;
+
+  // Sweep data in the sorted order: the axis and the other two, padded
+  // by 4 empty boxes
+  std::vector<float>     min_[3];
+  std::vector<float>     max_[3];
+
+  std::vector<Pair>      pairs_;
+  Stats                  stats_;
+};
+
+} // namespace Phys
+
+#endif // _SWEEPANDPRUNE_H_A8BEB1FD_4E2A_4AE1_8FFB_0A9520FF95E7_
@@ -0,0 +1,320 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "portalgraph.h"
+#include "camera.h"
+#include "common/logging.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// The eye closer to the portal plane sees through it with the same frustum
+const float kEpsilon = 1e-4f;
+
+bool TestAabb(const glm::vec4* planes, size_t count, const glm::vec3& min, 
+              const glm::vec3& max) {
+  for (size_t i = 0; i < count; ++i) {
+    const glm::vec4& plane = planes[i];
+    glm::vec3 positive(plane.x < 0 ? min.x : max.x,
+                       plane.y < 0 ? min.y : max.y,
+                       plane.z < 0 ? min.z : max.z);
+    if (glm::dot(glm::vec3(plane), positive) + plane.w < 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Overlap(const glm::vec3& a_min, const glm::vec3& a_max,
+             const glm::vec3& b_min, const glm::vec3& b_max) {
+  return a_min.x <= b_max.x && b_min.x <= a_max.x &&
+         a_min.y <= b_max.y && b_min.y <= a_max.y &&
+         a_min.z <= b_max.z && b_min.z <= a_max.z;
+}
+
+// Sutherland-Hodgman, the part of the polygon in front of the plane
+void ClipPolygon(const glm::vec4& plane, const std::vector<glm::vec3>& in,
+                 std::vector<glm::vec3>& out) {
+  out.clear();
+  for (size_t i = 0; i < in.size(); ++i) {
+    const glm::vec3& a = in[i];
+    const glm::vec3& b = in[(i + 1) % in.size()];
+    float da = glm::dot(glm::vec3(plane), a) + plane.w;
+    float db = glm::dot(glm::vec3(plane), b) + plane.w;
+    if (da >= 0) {
+      out.push_back(a);
+    }
+    if ((da >= 0) != (db >= 0)) {
+      out.push_back(a + (b - a) * (da / (da - db)));
+    }
+  }
+}
+
+void RemoveId(std::vector<uint32_t>& ids, uint32_t id) {
+  auto it = std::find(ids.begin(), ids.end(), id);
+  *it = ids.back();
+  ids.pop_back();
+}
+
+} // namespace
+
+PortalGraph::PortalGraph(const Params& params) : params_(params) {}
+
+int PortalGraph::AddCell(const glm::vec3& min, const glm::vec3& max) {
+  if (!objects_.empty()) {
+    ABORT_F("Cells after the boxes");
+  }
+  Cell cell;
+  cell.min = min;
+  cell.max = max;
+  cells_.push_back(cell);
+  return cells_.size() - 1;
+}
+
+void PortalGraph::AddPortal(int cell_a, int cell_b, 
+                            const std::vector<glm::vec3>& polygon) {
+  int n_cells = cells_.size();
+  if (cell_a < 0 || cell_a >= n_cells || cell_b < 0 || cell_b >= n_cells || 
+      cell_a == cell_b) {
+    ABORT_F("Invalid portal cells %d, %d", cell_a, cell_b);
+  }
+  if (polygon.size() < 3 || glm::length(glm::cross(polygon[1] - polygon[0], 
+                                                   polygon[2] - polygon[0])) 
+                            < kEpsilon) {
+    ABORT_F("Invalid portal polygon, %zu vertices", polygon.size());
+  }
+  Portal portal;
+  portal.cells[0] = cell_a;
+  portal.cells[1] = cell_b;
+  portal.polygon = polygon;
+  portals_.push_back(portal);
+  cells_[cell_a].portals.push_back(portals_.size() - 1);
+  cells_[cell_b].portals.push_back(portals_.size() - 1);
+}
+
+int PortalGraph::FindCell(const glm::vec3& point) const {
+  for (size_t i = 0; i < cells_.size(); ++i) {
+    if (Overlap(point, point, cells_[i].min, cells_[i].max)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+uint32_t PortalGraph::Add(const glm::vec3& min, const glm::vec3& max) {
+  uint32_t id;
+  if (!free_ids_.empty()) {
+    id = free_ids_.back();
+    free_ids_.pop_back();
+  } else {
+    id = objects_.size();
+    objects_.emplace_back();
+  }
+  Object& object = objects_[id];
+  object.min = min;
+  object.max = max;
+  object.alive = true;
+  Link(id);
+  ++n_alive_;
+  return id;
+}
+
+void PortalGraph::Remove(uint32_t id) {
+  if (!objects_.at(id).alive) {
+    ABORT_F("Box %u is already removed", id);
+  }
+  Unlink(id);
+  objects_[id].alive = false;
+  free_ids_.push_back(id);
+  --n_alive_;
+}
+
+void PortalGraph::Update(uint32_t id, const glm::vec3& min, 
+                         const glm::vec3& max) {
+  Object& object = objects_.at(id);
+  if (!object.alive) {
+    ABORT_F("Box %u is removed", id);
+  }
+  object.min = min;
+  object.max = max;
+
+  // Still inside of the only cell
+  if (object.cells.size() == 1) {
+    const Cell& cell = cells_[object.cells[0]];
+    if (cell.min.x <= min.x && cell.min.y <= min.y && cell.min.z <= min.z &&
+        max.x <= cell.max.x && max.y <= cell.max.y && max.z <= cell.max.z) {
+      return;
+    }
+  }
+  Unlink(id);
+  Link(id);
+}
+
+void PortalGraph::Link(uint32_t id) {
+  Object& object = objects_[id];
+  for (size_t i = 0; i < cells_.size(); ++i) {
+    if (Overlap(object.min, object.max, cells_[i].min, cells_[i].max)) {
+      object.cells.push_back(i);
+      cells_[i].objects.push_back(id);
+    }
+  }
+  if (object.cells.empty()) {
+    outside_.push_back(id);
+  }
+}
+
+void PortalGraph::Unlink(uint32_t id) {
+  Object& object = objects_[id];
+  for (int cell: object.cells) {
+    RemoveId(cells_[cell].objects, id);
+  }
+  if (object.cells.empty()) {
+    RemoveId(outside_, id);
+  }
+  object.cells.clear();
+}
+
+void PortalGraph::FindViews(const glm::vec3& eye, const Frustum& frustum) {
+  stats_ = Stats();
+  views_.clear();
+  planes_.clear();
+  for (int i = 0; i < Frustum::kPlanes; ++i) {
+    planes_.push_back(frustum.GetPlane(i));
+  }
+  int cell = FindCell(eye);
+  if (cell < 0) {
+    stats_.outside = true;
+    return;
+  }
+  on_path_.assign(cells_.size(), 0);
+  Visit(eye, cell, 0, Frustum::kPlanes, 0, frustum.GetPlane(Frustum::kFar));
+}
+
+void PortalGraph::Visit(const glm::vec3& eye, int cell, size_t first, 
+                        size_t count, int depth, const glm::vec4& far) {
+  views_.push_back({cell, depth, first, count});
+  ++stats_.cells_visited;
+  if (depth >= params_.max_depth) {
+    return;
+  }
+
+  on_path_[cell] = 1;
+  for (int index: cells_[cell].portals) {
+    const Portal& portal = portals_[index];
+    int next = portal.cells[0] == cell ? portal.cells[1] : portal.cells[0];
+    if (on_path_[next]) {
+      continue;
+    }
+    ++stats_.portals_tested;
+
+    // What is left of the portal in the frustum
+    clip_[0] = portal.polygon;
+    for (size_t i = first; i < first + count && clip_[0].size() >= 3; ++i) {
+      ClipPolygon(planes_[i], clip_[0], clip_[1]);
+      clip_[0].swap(clip_[1]);
+    }
+    if (clip_[0].size() < 3) {
+      continue;
+    }
+    ++stats_.portals_passed;
+
+    // The portal plane faces away from the eye
+    const auto& polygon = portal.polygon;
+    glm::vec3 normal = glm::normalize(glm::cross(polygon[1] - polygon[0], 
+                                                 polygon[2] - polygon[0]));
+    float distance = glm::dot(normal, eye - polygon[0]);
+    if (distance > 0) {
+      normal = -normal;
+      distance = -distance;
+    }
+    if (-distance < kEpsilon) {
+      Visit(eye, next, first, count, depth + 1, far);
+      continue;
+    }
+
+    size_t next_first = planes_.size();
+    glm::vec3 center(0);
+    for (auto& v: clip_[0]) {
+      center += v;
+    }
+    center /= (float)clip_[0].size();
+    for (size_t i = 0; i < clip_[0].size(); ++i) {
+      const glm::vec3& a = clip_[0][i];
+      const glm::vec3& b = clip_[0][(i + 1) % clip_[0].size()];
+      glm::vec3 n = glm::cross(a - eye, b - eye);
+      float side = glm::dot(n, center - eye);
+      if (std::abs(side) < kEpsilon * glm::length(n) || 
+          glm::length(n) < kEpsilon) {
+        continue; // Degenerate edge
+      }
+      n = side < 0 ? -n : n;
+      planes_.push_back(glm::vec4(n, -glm::dot(n, eye)));
+    }
+    planes_.push_back(glm::vec4(normal, -glm::dot(normal, polygon[0])));
+    planes_.push_back(far);
+    Visit(eye, next, next_first, planes_.size() - next_first, depth + 1, far);
+  }
+  on_path_[cell] = 0;
+}
+
+void PortalGraph::Query(const glm::vec3& eye, const Frustum& frustum, 
+                        std::vector<uint32_t>& ids) {
+  FindViews(eye, frustum);
+  if (marks_.size() < objects_.size()) {
+    marks_.resize(objects_.size(), 0);
+  }
+  ++query_;
+
+  auto test = [&](uint32_t id, size_t first, size_t count) {
+    if (marks_[id] == query_) {
+      return;
+    }
+    const Object& object = objects_[id];
+    ++stats_.objects_tested;
+    if (TestAabb(&planes_[first], count, object.min, object.max)) {
+      marks_[id] = query_;
+      ids.push_back(id);
+      ++stats_.objects_found;
+    }
+  };
+
+  if (stats_.outside) {
+    for (uint32_t id = 0; id < objects_.size(); ++id) {
+      if (objects_[id].alive) {
+        test(id, 0, Frustum::kPlanes);
+      }
+    }
+  } else {
+    for (auto& view: views_) {
+      for (uint32_t id: cells_[view.cell].objects) {
+        test(id, view.first, view.count);
+      }
+    }
+    for (uint32_t id: outside_) {
+      test(id, 0, Frustum::kPlanes);
+    }
+  }
+  stats_.objects_culled = n_alive_ - stats_.objects_found;
+}
@@ -0,0 +1,153 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _PORTALGRAPH_H_63EECA84_4202_4459_9353_11F7FB4640FA_
+#define _PORTALGRAPH_H_63EECA84_4202_4459_9353_11F7FB4640FA_ 
+
+#include "glm_main.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Frustum;
+
+//////////////////////////////////////////////////////////////////////////////
+// Cells and portals of the indoor levels. The cells are boxes (the rooms,
+// not overlapping), the portals are convex polygons between two of them
+// (the doors, the windows), both ways.
+//
+// The visible cells are found from the cell of the eye: the camera frustum
+// clips the polygon of every portal of the cell, the rest of the polygon 
+// makes the narrowed frustum (the planes through the eye and its edges, 
+// the portal plane and the far plane) to look into the next cell with, and
+// so on. A cell seen through several portals has several views.
+//
+// The boxes (the actor bounds, added after the cells) are kept in the cells
+// they overlap, the queries return the ones inside of a view of a visible 
+// cell. The boxes out of all the cells are tested against the camera 
+// frustum only, so are all of them when the eye is out of all the cells.
+//
+// PortalGraph graph;
+// int hall = graph.AddCell(min, max);
+// int room = graph.AddCell(...);
+// graph.AddPortal(hall, room, door_polygon);
+// uint32_t id = graph.Add(box_min, box_max);
+// graph.Query(eye, frustum, ids);
+//////////////////////////////////////////////////////////////////////////////
+class PortalGraph {
+ public:
+  struct Params {
+    int max_depth = 32; // Portals in a row
+  };
+
+  // The last Query()
+  struct Stats {
+    size_t cells_visited  = 0; // Views, a cell can be seen more than once
+    size_t portals_tested = 0;
+    size_t portals_passed = 0; // Something left after the clipping
+    size_t objects_tested = 0;
+    size_t objects_found  = 0;
+    size_t objects_culled = 0; // The rest of the alive ones
+    bool   outside        = false; // The eye is out of all the cells
+  };
+
+  // A visible cell, the planes (faces inside) are in GetPlanes()
+  struct View {
+    int    cell;
+    int    depth;    // Portals on the way
+    size_t first;
+    size_t count;
+  };
+
+  PortalGraph() : PortalGraph(Params()) {}
+  explicit PortalGraph(const Params& params);
+
+  int AddCell(const glm::vec3& min, const glm::vec3& max);
+  void AddPortal(int cell_a, int cell_b, 
+                 const std::vector<glm::vec3>& polygon);
+
+  // -1 if out of all the cells
+  int FindCell(const glm::vec3& point) const;
+  size_t GetCellCount() const { return cells_.size(); }
+  size_t GetPortalCount() const { return portals_.size(); }
+
+  // Returns the id, the ids of the removed boxes are reused
+  uint32_t Add(const glm::vec3& min, const glm::vec3& max);
+  void Remove(uint32_t id);
+  void Update(uint32_t id, const glm::vec3& min, const glm::vec3& max);
+
+  // The views of the last FindViews() or Query()
+  void FindViews(const glm::vec3& eye, const Frustum& frustum);
+  const std::vector<View>& GetViews() const { return views_; }
+  const std::vector<glm::vec4>& GetPlanes() const { return planes_; }
+
+  // The ids of the visible boxes, appended
+  void Query(const glm::vec3& eye, const Frustum& frustum, 
+             std::vector<uint32_t>& ids);
+
+  const Stats& GetStats() const { return stats_; }
+
+ private:
+  struct Portal {
+    int                    cells[2];
+    std::vector<glm::vec3> polygon;
+  };
+
+  struct Cell {
+    glm::vec3             min;
+    glm::vec3             max;
+    std::vector<int>      portals;
+    std::vector<uint32_t> objects;
+  };
+
+  struct Object {
+    glm::vec3        min;
+    glm::vec3        max;
+    std::vector<int> cells; // None - out of all the cells
+    bool             alive;
+  };
+
+  void Visit(const glm::vec3& eye, int cell, size_t first, size_t count, 
+             int depth, const glm::vec4& far);
+  void Link(uint32_t id);
+  void Unlink(uint32_t id);
+
+  Params                              params_;
+  std::vector<Cell>                   cells_;
+  std::vector<Portal>                 portals_;
+  std::vector<Object>                 objects_;
+  std::vector<uint32_t>               free_ids_;
+  std::vector<uint32_t>               outside_; // Out of all the cells
+  size_t                              n_alive_ = 0;
+
+  std::vector<View>                   views_;
+  std::vector<glm::vec4>              planes_;
+  std::vector<char>                   on_path_; // By the cell
+  std::vector<uint32_t>               marks_;   // By the object, found
+  uint32_t                            query_ = 0;
+  std::vector<glm::vec3>              clip_[2];
+  Stats                               stats_;
+};
+
+#endif // _PORTALGRAPH_H_63EECA84_4202_4459_9353_11F7FB4640FA_
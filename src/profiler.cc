@@ -0,0 +1,291 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "profiler.h"
+#include "gl_main.h"
+#include "common/logging.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+std::string Escape(const char* name) {
+  std::string escaped;
+  for (const char* c = name; *c; ++c) {
+    if (*c == '"' || *c == '\\') {
+      escaped += '\\';
+    }
+    escaped += *c;
+  }
+  return escaped;
+}
+
+}
+
+Profiler& Profiler::Instance() {
+  static Profiler instance;
+  return instance;
+}
+
+Profiler::Profiler() 
+  : frame_number_(0),
+    frame_begin_ns_(0),
+    gpu_collecting_frame_(0),
+    gpu_offset_ns_(0),
+    gpu_calibrated_(false),
+    tracing_(false),
+    trace_frames_(0) {
+  for (auto& counter: counters_) {
+    counter = 0;
+  }
+}
+
+int64_t Profiler::Now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const char* Profiler::GetCounterName(Counter counter) {
+  switch (counter) {
+    case kDrawCalls:    return "draw_calls";
+    case kTriangles:    return "triangles";
+    case kStateChanges: return "state_changes";
+    case kUploads:      return "uploads";
+    case kUploadBytes:  return "upload_bytes";
+    default:            return "unknown";
+  }
+}
+
+const char* Profiler::Intern(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return names_.insert(name).first->c_str();
+}
+
+Profiler::ThreadBuffer& Profiler::GetThreadBuffer() {
+  thread_local ThreadBuffer* buffer = nullptr;
+  if (!buffer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    threads_.emplace_back(new ThreadBuffer());
+    buffer = threads_.back().get();
+    buffer->thread = threads_.size() - 1;
+  }
+  return *buffer;
+}
+
+void Profiler::AddEvent(const char* name, int64_t begin_ns, int64_t end_ns) {
+  ThreadBuffer& buffer = GetThreadBuffer();
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  buffer.events.push_back({name, begin_ns, end_ns, buffer.thread});
+}
+
+void Profiler::BeginFrame() {
+  frame_begin_ns_ = Now();
+}
+
+void Profiler::EndFrame() {
+  int64_t end_ns = Now();
+  AddEvent("Frame", frame_begin_ns_, end_ns);
+
+  Frame& frame = last_frame_;
+  frame.number = frame_number_++;
+  frame.begin_ns = frame_begin_ns_;
+  frame.end_ns = end_ns;
+  for (int i = 0; i < kCounters; ++i) {
+    frame.counters[i] = counters_[i].exchange(0, std::memory_order_relaxed);
+  }
+
+  frame.cpu.clear();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& buffer: threads_) {
+      std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+      frame.cpu.insert(frame.cpu.end(), buffer->events.begin(), 
+                       buffer->events.end());
+      buffer->events.clear();
+    }
+  }
+
+  for (auto& scope: gpu_scopes_) {
+    scope.frame = frame.number;
+    gpu_pending_.push_back(scope);
+  }
+  gpu_scopes_.clear();
+  if (!gpu_pending_.empty()) {
+    CollectGpu();
+  }
+
+  if (tracing_) {
+    trace_events_.insert(trace_events_.end(), frame.cpu.begin(), 
+                         frame.cpu.end());
+    Frame counters;
+    counters.number = frame.number;
+    counters.begin_ns = frame.begin_ns;
+    counters.end_ns = frame.end_ns;
+    std::copy(frame.counters, frame.counters + kCounters, counters.counters);
+    trace_counters_.push_back(std::move(counters));
+    if (--trace_frames_ <= 0) {
+      tracing_ = false;
+    }
+  }
+}
+
+unsigned Profiler::GetQuery() {
+  if (free_queries_.empty()) {
+    GLuint queries[64];
+    glGenQueries(64, queries);
+    free_queries_.assign(queries, queries + 64);
+  }
+  unsigned query = free_queries_.back();
+  free_queries_.pop_back();
+  return query;
+}
+
+int Profiler::BeginGpu(const char* name) {
+  if (!gpu_calibrated_) {
+    GLint64 gpu_ns = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpu_ns);
+    gpu_offset_ns_ = Now() - gpu_ns;
+    gpu_calibrated_ = true;
+  }
+  GpuScope scope = {name, GetQuery(), 0, 0};
+  glQueryCounter(scope.begin_query, GL_TIMESTAMP);
+  gpu_scopes_.push_back(scope);
+  return gpu_scopes_.size() - 1;
+}
+
+void Profiler::EndGpu(int query) {
+  GpuScope& scope = gpu_scopes_.at(query);
+  scope.end_query = GetQuery();
+  glQueryCounter(scope.end_query, GL_TIMESTAMP);
+}
+
+void Profiler::CollectGpu() {
+  // In order. All the scopes of a frame are pending after its EndFrame(), 
+  // so it is complete when the next frame starts or nothing is pending.
+  while (!gpu_pending_.empty()) {
+    GpuScope& scope = gpu_pending_.front();
+    if (!gpu_collecting_.empty() && scope.frame != gpu_collecting_frame_) {
+      FinishGpuFrame();
+    }
+    GLuint available = 0;
+    glGetQueryObjectuiv(scope.end_query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+      return;
+    }
+    GLuint64 begin_ns = 0, end_ns = 0;
+    glGetQueryObjectui64v(scope.begin_query, GL_QUERY_RESULT, &begin_ns);
+    glGetQueryObjectui64v(scope.end_query, GL_QUERY_RESULT, &end_ns);
+    gpu_collecting_.push_back({scope.name, (int64_t)begin_ns + gpu_offset_ns_,
+                               (int64_t)end_ns + gpu_offset_ns_, kGpuThread});
+    gpu_collecting_frame_ = scope.frame;
+    free_queries_.push_back(scope.begin_query);
+    free_queries_.push_back(scope.end_query);
+    gpu_pending_.pop_front();
+  }
+  if (!gpu_collecting_.empty()) {
+    FinishGpuFrame();
+  }
+}
+
+void Profiler::FinishGpuFrame() {
+  if (tracing_) {
+    trace_events_.insert(trace_events_.end(), gpu_collecting_.begin(), 
+                         gpu_collecting_.end());
+  }
+  last_frame_.gpu.swap(gpu_collecting_);
+  gpu_collecting_.clear();
+}
+
+void Profiler::StartTrace(int max_frames) {
+  trace_events_.clear();
+  trace_counters_.clear();
+  trace_frames_ = max_frames;
+  tracing_ = max_frames > 0;
+}
+
+void Profiler::StopTrace() {
+  tracing_ = false;
+}
+
+std::string Profiler::GetTrace() {
+  int64_t origin_ns = trace_counters_.empty() ? 0 : 
+                      trace_counters_.front().begin_ns;
+  auto us = [origin_ns](int64_t ns) { return (ns - origin_ns) / 1000.0; };
+
+  std::ostringstream out;
+  out.precision(3);
+  out << std::fixed;
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+  // Thread names
+  size_t n_threads = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    n_threads = threads_.size();
+  }
+  for (size_t i = 0; i < n_threads; ++i) {
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i 
+        << ",\"args\":{\"name\":\"" << (i ? "Thread " + std::to_string(i) : 
+                                          std::string("Main")) << "\"}},\n";
+  }
+  out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" 
+      << kGpuThread << ",\"args\":{\"name\":\"GPU\"}}";
+
+  for (auto& event: trace_events_) {
+    if (event.end_ns < origin_ns) {
+      continue;
+    }
+    out << ",\n{\"name\":\"" << Escape(event.name) << "\",\"cat\":\"" 
+        << (event.thread == kGpuThread ? "gpu" : "cpu") 
+        << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread 
+        << ",\"ts\":" << us(event.begin_ns) 
+        << ",\"dur\":" << (event.end_ns - event.begin_ns) / 1000.0 << "}";
+  }
+
+  for (auto& frame: trace_counters_) {
+    out << ",\n{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"ts\":" 
+        << us(frame.begin_ns) << ",\"args\":{";
+    for (int i = 0; i < kCounters; ++i) {
+      out << (i ? "," : "") << "\"" << GetCounterName((Counter)i) << "\":" 
+          << frame.counters[i];
+    }
+    out << "}}";
+  }
+  out << "\n]}\n";
+  return out.str();
+}
+
+void Profiler::WriteTrace(const std::string& filename) {
+  std::ofstream out(filename, std::ios::out | std::ios::binary);
+  if (!out.is_open()) {
+    ABORT_F("Cant open file %s", filename.c_str());
+  }
+  std::string trace = GetTrace();
+  out.write(trace.data(), trace.size());
+  LOG_F(INFO, "Profiler trace: %zu events, %zu frames to %s", 
+        trace_events_.size(), trace_counters_.size(), filename.c_str());
+}
@@ -0,0 +1,209 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _PROFILER_H_74404D87_3271_4618_A8AF_7ADE32ABD9CD_
+#define _PROFILER_H_74404D87_3271_4618_A8AF_7ADE32ABD9CD_ 
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+// Frame profiler, compiled in with the B3D_PROFILING CMake option. 
+// Without it the macros below are empty.
+//
+//  PROFILE_SCOPE("Scene::Update");     // CPU time of the scope, any thread
+//  PROFILE_GPU_SCOPE(name);            // GL timestamps too, render thread
+//  PROFILE_COUNT(kDrawCalls, 1);       // Per frame counters
+//
+// The scope names are not copied, they must live as long as the profiler:
+// literals or Intern()-ed strings.
+//
+// CPU scopes go to a buffer of the calling thread, the lock is only taken
+// by the owner and by EndFrame(), so it's never contended. GPU scopes are
+// pairs of glQueryCounter(GL_TIMESTAMP) queries, they nest and they are 
+// read back when ready, a few frames later, never waiting for the GPU.
+// The GPU clock is mapped to the CPU one at the first frame.
+//
+// AppContext::BeginFrame()/EndFrame() mark the frames. The last finished 
+// frame is in GetLastFrame() (see ProfilerOverlay in the examples), 
+// StartTrace()/WriteTrace() record the frames to the Chrome trace JSON, 
+// chrome://tracing or https://ui.perfetto.dev
+//////////////////////////////////////////////////////////////////////////////
+class Profiler {
+ public:
+  enum Counter {
+    kDrawCalls,
+    kTriangles,    // Triangles and patches, times the instances
+    kStateChanges, // Program, framebuffer and texture binds
+    kUploads,      // Buffer and texture uploads
+    kUploadBytes,
+    kCounters
+  };
+
+  struct Event {
+    const char* name;
+    int64_t     begin_ns;
+    int64_t     end_ns;
+    int         thread; // kGpuThread for the GPU scopes
+  };
+
+  enum { kGpuThread = 1000 };
+
+  struct Frame {
+    uint64_t           number = 0;
+    int64_t            begin_ns = 0;
+    int64_t            end_ns = 0;
+    int64_t            counters[kCounters] = {};
+    std::vector<Event> cpu; // All the threads
+    std::vector<Event> gpu; // The latest frame with the GPU results ready
+  };
+
+  static Profiler& Instance();
+
+  void BeginFrame();
+  void EndFrame();
+  const Frame& GetLastFrame() const { return last_frame_; }
+
+  // Steady clock
+  static int64_t Now();
+
+  void AddEvent(const char* name, int64_t begin_ns, int64_t end_ns);
+  int BeginGpu(const char* name);
+  void EndGpu(int query);
+
+  void Count(Counter counter, int64_t n) {
+    counters_[counter].fetch_add(n, std::memory_order_relaxed);
+  }
+  static const char* GetCounterName(Counter counter);
+
+  // The name pointer lives as long as the profiler
+  const char* Intern(const std::string& name);
+
+  // Records up to max_frames, then stops
+  void StartTrace(int max_frames = 600);
+  void StopTrace();
+  bool IsTracing() const { return tracing_; }
+  std::string GetTrace();
+  void WriteTrace(const std::string& filename);
+
+ private:
+  struct ThreadBuffer {
+    std::mutex         mutex;
+    std::vector<Event> events;
+    int                thread;
+  };
+
+  struct GpuScope {
+    const char* name;
+    unsigned    begin_query;
+    unsigned    end_query;
+    uint64_t    frame;
+  };
+
+  Profiler();
+  ThreadBuffer& GetThreadBuffer();
+  void CollectGpu();
+  void FinishGpuFrame();
+  unsigned GetQuery();
+
+  std::atomic<int64_t>                       counters_[kCounters];
+  std::mutex                                 mutex_; // Threads and names
+  std::vector<std::unique_ptr<ThreadBuffer>> threads_;
+  std::unordered_set<std::string>            names_;
+
+  uint64_t                                   frame_number_;
+  int64_t                                    frame_begin_ns_;
+  Frame                                      last_frame_;
+
+  std::vector<unsigned>                      free_queries_;
+  std::vector<GpuScope>                      gpu_scopes_; // Being recorded
+  std::deque<GpuScope>                       gpu_pending_;
+  std::vector<Event>                         gpu_collecting_;
+  uint64_t                                   gpu_collecting_frame_;
+  int64_t                                    gpu_offset_ns_;
+  bool                                       gpu_calibrated_;
+
+  bool                                       tracing_;
+  int                                        trace_frames_;
+  std::vector<Event>                         trace_events_;
+  std::vector<Frame>                         trace_counters_; // No events
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// The scopes behind the macros
+//////////////////////////////////////////////////////////////////////////////
+class ProfileScope {
+ public:
+  explicit ProfileScope(const char* name) 
+    : name_(name), begin_ns_(Profiler::Now()) {}
+  ~ProfileScope() {
+    Profiler::Instance().AddEvent(name_, begin_ns_, Profiler::Now());
+  }
+
+ private:
+  const char* name_;
+  int64_t     begin_ns_;
+};
+
+// The CPU time too
+class GpuProfileScope {
+ public:
+  explicit GpuProfileScope(const char* name) 
+    : name_(name), 
+      begin_ns_(Profiler::Now()), 
+      query_(Profiler::Instance().BeginGpu(name)) {}
+  ~GpuProfileScope() {
+    Profiler::Instance().EndGpu(query_);
+    Profiler::Instance().AddEvent(name_, begin_ns_, Profiler::Now());
+  }
+
+ private:
+  const char* name_;
+  int64_t     begin_ns_;
+  int         query_;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#ifdef B3D_PROFILING
+#define PROFILE_SCOPE(name) \
+  ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) \
+  GpuProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define PROFILE_COUNT(counter, n) \
+  Profiler::Instance().Count(Profiler::counter, n)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_GPU_SCOPE(name)
+#define PROFILE_COUNT(counter, n)
+#endif
+
+#endif // _PROFILER_H_74404D87_3271_4618_A8AF_7ADE32ABD9CD_
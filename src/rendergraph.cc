@@ -0,0 +1,366 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "rendergraph.h"
+#include "rendertarget.h"
+#include "scene.h"
+#include "common/logging.h"
+#include <algorithm>
+#include <set>
+
+size_t RenderGraph::GetBytes(const Resource& resource) {
+  return (size_t)resource.width * resource.height * 4;
+}
+
+int RenderGraph::FindResource(const std::string& name) const {
+  for (size_t i = 0; i < resources_.size(); ++i) {
+    if (resources_[i].name == name) return i;
+  }
+  return -1;
+}
+
+int RenderGraph::FindPass(const std::string& name) const {
+  for (size_t i = 0; i < passes_.size(); ++i) {
+    if (passes_[i].name == name) return i;
+  }
+  return -1;
+}
+
+void RenderGraph::AddResource(const std::string& name, 
+                              const Resource& resource) {
+  if (FindResource(name) >= 0) {
+    ABORT_F("Render graph resource %s already exists", name.c_str());
+  }
+  if (resource.width <= 0 || resource.height <= 0) {
+    ABORT_F("Render graph resource %s is %d x %d", name.c_str(), 
+            resource.width, resource.height);
+  }
+  if (resource.type != Layer::kColor && resource.type != Layer::kDepth) {
+    ABORT_F("Render graph resource %s type %d not supported", name.c_str(),
+            resource.type);
+  }
+  ResourceInfo info;
+  info.name = name;
+  info.desc = resource;
+  resources_.push_back(info);
+  compiled_ = false;
+}
+
+void RenderGraph::Import(const std::string& name, 
+                         std::shared_ptr<Texture> texture) {
+  if (FindResource(name) >= 0) {
+    ABORT_F("Render graph resource %s already exists", name.c_str());
+  }
+  if (!texture) {
+    ABORT_F("Render graph import %s is nullptr", name.c_str());
+  }
+  ResourceInfo info;
+  info.name = name;
+  info.imported = texture;
+  resources_.push_back(info);
+  compiled_ = false;
+}
+
+void RenderGraph::AddPass(const Pass& pass) {
+  if (FindPass(pass.name) >= 0) {
+    ABORT_F("Render graph pass %s already exists", pass.name.c_str());
+  }
+  if (pass.writes.empty()) {
+    ABORT_F("Render graph pass %s writes nothing", pass.name.c_str());
+  }
+  passes_.push_back(pass);
+  compiled_ = false;
+}
+
+void RenderGraph::Output(const std::string& name) {
+  int r = FindResource(name);
+  if (r < 0) {
+    ABORT_F("Render graph resource %s not found", name.c_str());
+  }
+  resources_[r].output = true;
+  compiled_ = false;
+}
+
+void RenderGraph::Compile() {
+  const int n_passes = passes_.size();
+
+  // Who writes what
+  std::vector<std::vector<int>> pass_reads(n_passes);
+  for (auto& resource: resources_) {
+    resource.producer = -1;
+    resource.sampled = false;
+    resource.first = resource.last = resource.physical = -1;
+  }
+  for (int p = 0; p < n_passes; ++p) {
+    const Pass& pass = passes_[p];
+    int n_depth = 0;
+    for (auto& name: pass.writes) {
+      int r = FindResource(name);
+      if (r < 0) {
+        ABORT_F("Pass %s writes unknown %s", pass.name.c_str(), name.c_str());
+      }
+      ResourceInfo& resource = resources_[r];
+      if (resource.imported) {
+        ABORT_F("Pass %s writes imported %s", pass.name.c_str(), name.c_str());
+      }
+      if (resource.producer >= 0) {
+        ABORT_F("Pass %s writes %s, already written by %s", pass.name.c_str(), 
+                name.c_str(), passes_[resource.producer].name.c_str());
+      }
+      const Resource& first = resources_[FindResource(pass.writes[0])].desc;
+      if (resource.desc.width != first.width || 
+          resource.desc.height != first.height) {
+        ABORT_F("Pass %s writes different sizes", pass.name.c_str());
+      }
+      n_depth += resource.desc.type == Layer::kDepth;
+      resource.producer = p;
+    }
+    if (n_depth > 1) {
+      ABORT_F("Pass %s writes %d depth layers", pass.name.c_str(), n_depth);
+    }
+    for (auto& name: pass.reads) {
+      int r = FindResource(name);
+      if (r < 0) {
+        ABORT_F("Pass %s reads unknown %s", pass.name.c_str(), name.c_str());
+      }
+      pass_reads[p].push_back(r);
+    }
+  }
+  for (auto& resource: resources_) {
+    if (resource.output && !resource.imported && resource.producer < 0) {
+      ABORT_F("Output %s is never written", resource.name.c_str());
+    }
+  }
+
+  // Culling, the producers of the outputs and of what the live passes read
+  live_.assign(n_passes, false);
+  std::vector<int> stack;
+  for (auto& resource: resources_) {
+    if (resource.output && resource.producer >= 0 && !live_[resource.producer]) {
+      live_[resource.producer] = true;
+      stack.push_back(resource.producer);
+    }
+  }
+  while (!stack.empty()) {
+    int p = stack.back();
+    stack.pop_back();
+    for (int r: pass_reads[p]) {
+      int producer = resources_[r].producer;
+      if (producer < 0 && !resources_[r].imported) {
+        ABORT_F("Pass %s reads %s, nobody writes it", passes_[p].name.c_str(), 
+                resources_[r].name.c_str());
+      }
+      if (producer >= 0 && !live_[producer]) {
+        live_[producer] = true;
+        stack.push_back(producer);
+      }
+    }
+  }
+
+  // Topological order, the declaration order among the ready ones
+  std::vector<int> n_deps(n_passes, 0);
+  std::vector<std::vector<int>> dependents(n_passes);
+  for (int p = 0; p < n_passes; ++p) {
+    if (!live_[p]) continue;
+    for (int r: pass_reads[p]) {
+      int producer = resources_[r].producer;
+      if (producer >= 0) {
+        if (producer == p) {
+          ABORT_F("Pass %s reads its own %s", passes_[p].name.c_str(),
+                  resources_[r].name.c_str());
+        }
+        ++n_deps[p];
+        dependents[producer].push_back(p);
+      }
+    }
+  }
+  std::set<int> ready;
+  for (int p = 0; p < n_passes; ++p) {
+    if (live_[p] && n_deps[p] == 0) ready.insert(p);
+  }
+  std::vector<int> order;
+  while (!ready.empty()) {
+    int p = *ready.begin();
+    ready.erase(ready.begin());
+    order.push_back(p);
+    for (int dependent: dependents[p]) {
+      if (--n_deps[dependent] == 0) ready.insert(dependent);
+    }
+  }
+  int n_live = std::count(live_.begin(), live_.end(), true);
+  if ((int)order.size() != n_live) {
+    ABORT_F("Render graph has a cycle");
+  }
+
+  // Lifetimes in the execution order, the outputs live to the end
+  order_.clear();
+  for (int i = 0; i < (int)order.size(); ++i) {
+    int p = order[i];
+    order_.push_back(passes_[p].name);
+    for (auto& name: passes_[p].writes) {
+      ResourceInfo& resource = resources_[FindResource(name)];
+      resource.first = i;
+      resource.last = std::max(resource.last, i);
+    }
+    for (int r: pass_reads[p]) {
+      resources_[r].last = std::max(resources_[r].last, i);
+      resources_[r].sampled = true;
+    }
+  }
+  for (auto& resource: resources_) {
+    resource.sampled |= resource.output;
+  }
+
+  // Aliasing, first fit in the order of the first use
+  std::vector<int> transient;
+  for (int r = 0; r < (int)resources_.size(); ++r) {
+    ResourceInfo& resource = resources_[r];
+    if (resource.imported || resource.first < 0) continue;
+    if (resource.output) {
+      resource.last = order.size();
+    }
+    transient.push_back(r);
+  }
+  std::stable_sort(transient.begin(), transient.end(), [this](int a, int b) {
+    return resources_[a].first < resources_[b].first;
+  });
+
+  physicals_.clear();
+  stats_ = Stats();
+  for (int r: transient) {
+    ResourceInfo& resource = resources_[r];
+    stats_.bytes_unaliased += GetBytes(resource.desc);
+    for (int i = 0; i < (int)physicals_.size(); ++i) {
+      Physical& physical = physicals_[i];
+      if (physical.last < resource.first &&
+          physical.sampled == resource.sampled &&
+          physical.desc.width == resource.desc.width &&
+          physical.desc.height == resource.desc.height &&
+          physical.desc.type == resource.desc.type &&
+          physical.desc.filter == resource.desc.filter) {
+        resource.physical = i;
+        physical.last = resource.last;
+        break;
+      }
+    }
+    if (resource.physical < 0) {
+      resource.physical = physicals_.size();
+      physicals_.push_back({resource.desc, resource.sampled, resource.last});
+      stats_.bytes += GetBytes(resource.desc);
+    }
+  }
+
+  stats_.passes = order.size();
+  stats_.culled = n_passes - order.size();
+  stats_.resources = transient.size();
+  stats_.textures = physicals_.size();
+  compiled_ = true;
+}
+
+void RenderGraph::Build(Scene& scene, int first_priority) {
+  if (!compiled_) {
+    Compile();
+  }
+
+  for (auto& physical: physicals_) {
+    // Created by the first framebuffer Init(), attached to the others
+    physical.layer = std::make_shared<Layer>(
+        physical.desc.type, 
+        physical.sampled ? Layer::kReadWrite : Layer::kWrite,
+        Layer::kHintTexture2D, 
+        physical.desc.filter);
+  }
+
+  for (int i = 0; i < (int)order_.size(); ++i) {
+    const Pass& pass = passes_[FindPass(order_[i])];
+    const Resource& size = resources_[FindResource(pass.writes[0])].desc;
+    auto rt = scene.Add<RenderTarget>("rt.graph." + pass.name, 
+                                      first_priority + i);
+    auto fb = rt->SetFrameBuffer(FrameBuffer::kTexture2D, size.width, 
+                                 size.height);
+    for (auto& name: pass.writes) {
+      fb->AddLayer(physicals_[resources_[FindResource(name)].physical].layer);
+    }
+    // Aliased, the previous content is garbage
+    fb->SetColorLayerClearValue(Color(0, 0, 0, 1));
+    rt->SetTags(pass.tags);
+    rt->SetCamera(pass.camera);
+    fb->Init();
+    render_targets_[pass.name] = rt;
+  }
+}
+
+void RenderGraph::PrintStats(std::ostream& out) const {
+  out << "Render graph:" << std::endl
+      << "  passes    " << stats_.passes 
+      << ", culled " << stats_.culled << std::endl
+      << "  resources " << stats_.resources 
+      << " in " << stats_.textures << " textures" << std::endl
+      << "  bytes     " << stats_.bytes 
+      << ", unaliased " << stats_.bytes_unaliased << std::endl;
+}
+
+bool RenderGraph::IsCulled(const std::string& pass) const {
+  int p = FindPass(pass);
+  if (p < 0 || !compiled_) {
+    ABORT_F("Render graph pass %s not found or not compiled", pass.c_str());
+  }
+  return !live_[p];
+}
+
+int RenderGraph::GetPhysical(const std::string& resource) const {
+  int r = FindResource(resource);
+  if (r < 0 || !compiled_) {
+    ABORT_F("Render graph resource %s not found or not compiled", 
+            resource.c_str());
+  }
+  return resources_[r].physical;
+}
+
+std::shared_ptr<Texture> 
+RenderGraph::GetTexture(const std::string& resource) const {
+  int r = FindResource(resource);
+  if (r < 0) {
+    ABORT_F("Render graph resource %s not found", resource.c_str());
+  }
+  const ResourceInfo& info = resources_[r];
+  if (info.imported) {
+    return info.imported;
+  }
+  if (info.physical < 0 || !physicals_[info.physical].layer) {
+    ABORT_F("Render graph resource %s is culled or not built", 
+            resource.c_str());
+  }
+  const Physical& physical = physicals_[info.physical];
+  if (!physical.sampled && !info.output) {
+    ABORT_F("Render graph resource %s is not sampled", resource.c_str());
+  }
+  return std::make_shared<TextureRender>(physical.layer);
+}
+
+std::shared_ptr<RenderTarget> 
+RenderGraph::GetRenderTarget(const std::string& pass) const {
+  auto it = render_targets_.find(pass);
+  return it == render_targets_.end() ? nullptr : it->second;
+}
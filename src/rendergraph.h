@@ -0,0 +1,152 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _RENDERGRAPH_H_DB769D08_6FB7_46D1_A17D_B11E8A8F3F5B_
+#define _RENDERGRAPH_H_DB769D08_6FB7_46D1_A17D_B11E8A8F3F5B_ 
+
+#include "framebuffer.h"
+#include "texture.h"
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class Scene;
+class RenderTarget;
+
+//////////////////////////////////////////////////////////////////////////////
+// Render graph for the offscreen passes. 
+//
+// The passes declare the named resources they read and write, the graph
+// orders them by the dependencies (declaration order otherwise), culls the
+// passes nobody needs and lets the transient resources with non-overlapping
+// lifetimes share one texture. The resources read outside of the graph 
+// (Output()) live the whole frame, the imported textures are not managed.
+//
+// Compile() is the bookkeeping only, Build() creates the textures and a
+// render target per live pass with the priorities first_priority, +1, ...
+// in the execution order. A pass writes the color attachments in order and
+// at most one depth, the depth nobody reads is a renderbuffer.
+//
+// RenderGraph graph;
+// graph.Import("scene", scene_tex);
+// graph.AddResource("bright", {w/8, h/8});
+// graph.AddResource("final", {w, h});
+// graph.AddPass({"highlight", {"scene"}, {"bright"}, {"pp.highlight"}});
+// graph.AddPass({"combine", {"scene", "bright"}, {"final"}, {"pp.combine"}});
+// graph.Output("final");
+// graph.Compile();
+// graph.Build(scene, 10);
+// auto tex = graph.GetTexture("final");
+//////////////////////////////////////////////////////////////////////////////
+class RenderGraph {
+ public:
+  struct Resource {
+    int                 width  = 0;
+    int                 height = 0;
+    Layer::Type         type   = Layer::kColor;
+    Texture::FilterMode filter = Texture::kFilterBilinear;
+  };
+
+  struct Pass {
+    std::string              name;
+    std::vector<std::string> reads;
+    std::vector<std::string> writes;
+    std::vector<std::string> tags;    // of the render target
+    std::string              camera = "camera.main";
+  };
+
+  struct Stats {
+    size_t passes          = 0; // live
+    size_t culled          = 0;
+    size_t resources       = 0; // transient, live
+    size_t textures        = 0; // after aliasing
+    size_t bytes           = 0; // after aliasing
+    size_t bytes_unaliased = 0; // a texture per resource
+  };
+
+  void AddResource(const std::string& name, const Resource& resource);
+  void Import(const std::string& name, std::shared_ptr<Texture> texture);
+  void AddPass(const Pass& pass);
+
+  // Read outside of the graph
+  void Output(const std::string& name);
+
+  void Compile();
+  void Build(Scene& scene, int first_priority);
+
+  // The live passes in the execution order
+  const std::vector<std::string>& GetOrder() const { return order_; }
+  bool IsCulled(const std::string& pass) const;
+
+  // Index of the texture the transient resource lives in, -1 for the 
+  // imported and the culled ones
+  int GetPhysical(const std::string& resource) const;
+
+  // After Build(). A transient resource is valid for the passes reading it
+  // only, the textures are recycled.
+  std::shared_ptr<Texture> GetTexture(const std::string& resource) const;
+  std::shared_ptr<RenderTarget> GetRenderTarget(const std::string& pass) const;
+
+  const Stats& GetStats() const { return stats_; }
+  void PrintStats(std::ostream& out) const;
+
+  // RGBA8 color, 24 bit depth padded to 32
+  static size_t GetBytes(const Resource& resource);
+
+ private:
+  struct ResourceInfo {
+    std::string              name;
+    Resource                 desc;
+    std::shared_ptr<Texture> imported;
+    bool                     output   = false;
+    bool                     sampled  = false; // read by a live pass
+    int                      producer = -1;
+    int                      first    = -1;    // execution order positions
+    int                      last     = -1;
+    int                      physical = -1;
+  };
+
+  struct Physical {
+    Resource               desc;
+    bool                   sampled;
+    int                    last;
+    std::shared_ptr<Layer> layer;
+  };
+
+  int FindResource(const std::string& name) const;
+  int FindPass(const std::string& name) const;
+
+  std::vector<ResourceInfo>  resources_;
+  std::vector<Pass>          passes_;
+  std::vector<bool>          live_;
+  std::vector<std::string>   order_;
+  std::vector<Physical>      physicals_;
+  std::map<std::string, std::shared_ptr<RenderTarget>> render_targets_;
+  bool                       compiled_ = false;
+  Stats                      stats_;
+};
+
+#endif // _RENDERGRAPH_H_DB769D08_6FB7_46D1_A17D_B11E8A8F3F5B_
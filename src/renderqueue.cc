@@ -24,6 +24,7 @@
 
 #include "renderqueue.h"
 #include "scene.h"
+#include "profiler.h"
 
 ////////////////////////////////////////////////////////////////////////////
 // RenderPassSubQueue 
@@ -37,50 +38,123 @@ void RenderPassSubQueue::AddActor(std::shared_ptr<Actor> actor) {
     } else if (material != material_) {
       ABORT_F("Material mistmatch");
     }
-    actors_.push_back(actor);
+    actors_.push_back({actor, ~0u});
   }
 }
 
-void RenderPassSubQueue::Draw(Scene& scene, Camera& camera) {
+bool RenderPassSubQueue::DrawActor(Scene& scene, Camera& camera, Actor& actor) {
   glm::mat4 pvm_matrix(1.0f);
   glm::mat4 model_matrix(1.0f);
   glm::mat4 view_matrix(1.0f);
   glm::mat4 proj_matrix(1.0f);
-  material_->Bind();
-  pass_->Bind();
 
-  for (auto& actor: actors_) {
-    auto mesh_renderer = actor->GetComponent<MeshRenderer>();
-    auto mesh_filter = actor->GetComponent<MeshFilterBase>();
+  auto mesh_renderer = actor.GetComponent<MeshRenderer>();
+  auto mesh_filter = actor.GetComponent<MeshFilterBase>();
+
+  if (mesh_renderer && mesh_filter) {
+    actor.PreDraw();
 
-    if (mesh_renderer && mesh_filter) {
-      actor->PreDraw();
+    scene.SetSceneUniforms(*pass_, camera);
 
-      scene.SetSceneUniforms(*pass_, camera);
+    // TODO is there a better way of doing this without getting view matrix each time?
+    camera.GetViewMatrix(view_matrix);
+    camera.GetProjectionMatrix(proj_matrix);
+    actor.GetWorldMatrix(model_matrix);
+    pvm_matrix = proj_matrix * view_matrix * model_matrix;
+    pass_->SuPvmMatrix(pvm_matrix);
+    pass_->SuMMatrix(model_matrix);
+    pass_->SuVMatrix(view_matrix);
+    pass_->SuPMatrix(proj_matrix);
+
+    mesh_renderer->DrawCall(mesh_filter->GetView());
+
+    actor.PostDraw();
+    return true;
+  } 
+  return false;
+}
+
+const char* RenderPassSubQueue::GetProfileName() {
+  if (!profile_name_) {
+    profile_name_ = Profiler::Instance().Intern(
+        material_->GetName() + "/" + pass_->GetName());
+  }
+  return profile_name_;
+}
+
+int RenderPassSubQueue::Draw(Scene& scene, Camera& camera, int face) {
+  // The program is still being built, draw it next time
+  if (!pass_->IsReady()) {
+    return 0;
+  }
+  PROFILE_GPU_SCOPE(GetProfileName());
 
-      // TODO is there a better way of doing this without getting view matrix each time?
-      camera.GetViewMatrix(view_matrix);
-      camera.GetProjectionMatrix(proj_matrix);
-      actor->transform->GetMatrix(model_matrix);
-      pvm_matrix = proj_matrix * view_matrix * model_matrix;
-      pass_->SuPvmMatrix(pvm_matrix);
-      pass_->SuMMatrix(model_matrix);
-      pass_->SuVMatrix(view_matrix);
-      pass_->SuPMatrix(proj_matrix);
+  material_->Bind();
+  pass_->Bind();
+
+  int draws = 0;
+  for (auto& entry: actors_) {
+    if (face >= 0 && !(entry.faces & (1u << face))) {
+      continue;
+    }
+    draws += DrawActor(scene, camera, *entry.actor);
+  }
+  pass_->Unbind();
+  material_->Unbind();
+  return draws;
+}
+
+int RenderPassSubQueue::DrawLayered(Scene& scene, Camera& camera, 
+                                    const glm::mat4 cube_pv[6], unsigned mask) {
+  if (!pass_->IsReady()) {
+    return 0;
+  }
+  PROFILE_GPU_SCOPE(GetProfileName());
 
-      mesh_renderer->DrawCall(mesh_filter->GetView());
+  material_->Bind();
+  pass_->Bind();
+  for (int i = 0; i < 6; ++i) {
+    pass_->SuCubePvMatrix(i, cube_pv[i]);
+  }
 
-      actor->PostDraw();
-    } 
+  int draws = 0;
+  for (auto& entry: actors_) {
+    unsigned faces = entry.faces & mask;
+    if (!faces) {
+      continue;
+    }
+    pass_->SuCubeFaces(faces);
+    draws += DrawActor(scene, camera, *entry.actor);
   }
   pass_->Unbind();
   material_->Unbind();
+  return draws;
+}
+
+int RenderPassSubQueue::CullFaces(const Frustum frustums[6], unsigned mask) {
+  int culled = 0;
+  glm::vec3 min, max;
+  for (auto& entry: actors_) {
+    entry.faces = mask;
+    if (!entry.actor->GetWorldBounds(min, max)) {
+      continue;
+    }
+
+    for (int i = 0; i < 6; ++i) {
+      if ((mask & (1u << i)) && !frustums[i].TestAabb(min, max)) {
+        entry.faces &= ~(1u << i);
+        ++culled;
+      }
+    }
+  }
+  return culled;
 }
 
 ////////////////////////////////////////////////////////////////////////////
 // RenderQueue 
 ////////////////////////////////////////////////////////////////////////////
-void RenderQueue::AddActor(std::shared_ptr<Actor> actor, const Tags& tags) {
+bool RenderQueue::AddActor(std::shared_ptr<Actor> actor, const Tags& tags) {
+  bool added = false;
   if (auto mrend = actor->GetComponent<MeshRenderer>()) {
     if (auto mtrl = mrend->GetMaterial()) {
       for (auto it = mtrl->begin(); it != mtrl->end(); ++it) {
@@ -89,21 +163,46 @@ void RenderQueue::AddActor(std::shared_ptr<Actor> actor, const Tags& tags) {
           RenderPassQueue& pass_q = GetRenderPassQueue(pass);
           RenderPassSubQueue& pass_sq = GetRenderPassSubQueue(pass, pass_q);
           pass_sq.AddActor(actor);
+          added = true;
         }
       }
     }
   }
+  return added;
 }
   
-void RenderQueue::Draw(Scene& scene, Camera& camera) {
+int RenderQueue::Draw(Scene& scene, Camera& camera, int face) {
   // The order should be OK, from min priority to max
+  int draws = 0;
   for (auto& kv: the_queue_) {
     RenderPassQueue& pass_q = kv.second;
     for (auto& sub_kv: pass_q) {
       RenderPassSubQueue& pass_sq = sub_kv.second;
-      pass_sq.Draw(scene, camera);
+      draws += pass_sq.Draw(scene, camera, face);
+    }
+  }
+  return draws;
+}
+
+int RenderQueue::DrawLayered(Scene& scene, Camera& camera, 
+                             const glm::mat4 cube_pv[6], unsigned mask) {
+  int draws = 0;
+  for (auto& kv: the_queue_) {
+    for (auto& sub_kv: kv.second) {
+      draws += sub_kv.second.DrawLayered(scene, camera, cube_pv, mask);
+    }
+  }
+  return draws;
+}
+
+int RenderQueue::CullFaces(const Frustum frustums[6], unsigned mask) {
+  int culled = 0;
+  for (auto& kv: the_queue_) {
+    for (auto& sub_kv: kv.second) {
+      culled += sub_kv.second.CullFaces(frustums, mask);
     }
   }
+  return culled;
 }
   
 RenderQueue::RenderPassQueue& 
@@ -32,9 +32,11 @@
 #include "common/logging.h"
 #include <memory>
 #include <map>
+#include <vector>
 
 class Scene;
 class Camera;
+class Frustum;
 
 ////////////////////////////////////////////////////////////////////////////
 // Unites many actors under one render pass 
@@ -44,7 +46,18 @@ class RenderPassSubQueue {
   RenderPassSubQueue(std::shared_ptr<Pass> pass) : pass_(pass) {
   }
   void AddActor(std::shared_ptr<Actor> actor);
-  void Draw(Scene& scene, Camera& camera);
+
+  // Returns the number of the draw calls. The face >= 0 skips the actors
+  // culled away from that cubemap face by CullFaces().
+  int Draw(Scene& scene, Camera& camera, int face = -1);
+
+  // All the cubemap faces of the mask at once, the pass is expected to have
+  // a geometry shader broadcasting the primitives to gl_Layer by SU_CUBE_FACES
+  int DrawLayered(Scene& scene, Camera& camera, const glm::mat4 cube_pv[6],
+                  unsigned mask);
+
+  // Returns the number of the culled actor/face pairs
+  int CullFaces(const Frustum frustums[6], unsigned mask);
 
   int GetPriority() const {
     if (!pass_) {
@@ -54,9 +67,21 @@ class RenderPassSubQueue {
   }
 
  private:
+  // Returns false if there is nothing to draw
+  bool DrawActor(Scene& scene, Camera& camera, Actor& actor);
+
+  // "material/pass" for the profiler scopes
+  const char* GetProfileName();
+
+  struct Entry {
+    std::shared_ptr<Actor> actor;
+    unsigned               faces; // visible cubemap faces, bit per face
+  };
+
   std::shared_ptr<Pass>             pass_;
   std::shared_ptr<Material>         material_;
-  std::list<std::shared_ptr<Actor>> actors_;
+  std::vector<Entry>                actors_;
+  const char*                       profile_name_ = nullptr;
 };
 
 ////////////////////////////////////////////////////////////////////////////
@@ -65,9 +90,18 @@ class RenderPassSubQueue {
 class RenderQueue {
  public:
   // TODO need to be optimized!
-  void AddActor(std::shared_ptr<Actor> actor, const Tags& tags);
+  // Returns false if none of the passes matches the tags
+  bool AddActor(std::shared_ptr<Actor> actor, const Tags& tags);
   void Clear() {the_queue_.clear();}
-  void Draw(Scene& scene, Camera& camera);
+  int  Draw(Scene& scene, Camera& camera, int face = -1);
+  int  DrawLayered(Scene& scene, Camera& camera, const glm::mat4 cube_pv[6],
+                   unsigned mask = 0x3f);
+
+  // Per-face frustum culling for the cubemaps, frustums[i] for the face bit
+  // i of the mask, the 2D targets use the face 0. The bounds are from 
+  // MeshFilter. Actors without the bounds (no MeshFilter, instancing, 
+  // tesselation) stay on all the faces of the mask.
+  int  CullFaces(const Frustum frustums[6], unsigned mask = 0x3f);
 
  private:
   typedef std::map< std::shared_ptr<Pass>, RenderPassSubQueue > RenderPassQueue;
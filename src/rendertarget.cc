@@ -24,9 +24,12 @@
 
 #include "rendertarget.h"
 #include "scene.h"
+#include "profiler.h"
+#include <chrono>
   
 RenderTarget::RenderTarget(const std::string& name) :
     name_(name),
+    profile_name_(Profiler::Instance().Intern(name)),
     camera_name_("camera.main") {
   LOG_F(INFO, "RenderTarget added: %s", name_.c_str());
 }
@@ -49,6 +52,78 @@ inline glm::vec3 GetCubeCameraRotation(int face) {
   }
 }
 
+void RenderTarget::CullOccluded(const Camera& camera) {
+  glm::mat4 view, proj, model;
+  camera.GetViewMatrix(view);
+  camera.GetProjectionMatrix(proj);
+  occlusion_->Begin(proj * view);
+
+  // Only the occluders drawn by this target occlude
+  for (auto& actor: occlusion_actors_) {
+    if (actor->IsOccluder() && render_queue_.AddActor(actor, tags_)) {
+      auto mesh = actor->GetComponent<Mesh>();
+      if (mesh) {
+        actor->GetWorldMatrix(model);
+        occlusion_->AddOccluder(mesh->vertices, mesh->indices, model);
+      }
+    }
+  }
+  occlusion_->Rasterize();
+
+  glm::vec3 min, max;
+  for (auto& actor: occlusion_actors_) {
+    if (actor->IsOccluder()) {
+      continue;
+    }
+    // Instanced and tesselated meshes are not where their vertices are
+    auto mesh_renderer = actor->GetComponent<MeshRenderer>();
+    auto mesh_filter = actor->GetComponent<MeshFilter>();
+    if (mesh_renderer && mesh_renderer->n_instances == 1 && 
+        mesh_renderer->primitive != MeshRenderer::kPtPatches &&
+        mesh_filter && mesh_filter->GetBounds(min, max)) {
+      actor->GetWorldMatrix(model);
+      if (!occlusion_->TestAabb(min, max, model)) {
+        continue;
+      }
+    }
+    render_queue_.AddActor(actor, tags_);
+  }
+  occlusion_actors_.clear();
+}
+
+void RenderTarget::DrawCubemap(Scene& scene, Camera& camera) {
+  unsigned mask = cubemap_mask_.to_ulong();
+
+  glm::mat4 view, proj;
+  glm::mat4 cube_pv[6];
+  Frustum frustums[6];
+  camera.GetProjectionMatrix(proj);
+  for (int i = 0; i < 6; ++i) {
+    camera.transform->SetLocalEulerAngles(GetCubeCameraRotation(i));
+    camera.GetViewMatrix(view);
+    cube_pv[i] = proj * view;
+    frustums[i].Calculate(cube_pv[i]);
+  }
+
+  if (cubemap_culling_) {
+    draw_stats_.culled = render_queue_.CullFaces(frustums, mask);
+  }
+
+  if (cubemap_mode_ == kCubemapLayered) {
+    framebuffer_->BindCubemapLayered();
+    draw_stats_.draws = render_queue_.DrawLayered(scene, camera, cube_pv, mask);
+  } else {
+    for (int i = 0; i < 6; i++) {
+      if (!cubemap_mask_[i]) continue;
+      camera.transform->SetLocalEulerAngles(GetCubeCameraRotation(i));
+      framebuffer_->BindCubemapFace(i);
+      // Face culling off leaves the faces bits all set
+      draw_stats_.draws += render_queue_.Draw(scene, camera, i);
+      framebuffer_->UnbindCubemapFace(i);
+    }
+  }
+}
+
 void RenderTarget::Draw(Scene& scene) {
   auto camera = scene.Get<Camera>(camera_name_);
   if (!camera) {
@@ -59,19 +134,52 @@ void RenderTarget::Draw(Scene& scene) {
     ABORT_F("Framebuffer not configured");
   }
 
+  draw_stats_ = DrawStats();
+  if (!enabled_) {
+    return;
+  }
+  draw_stats_.drawn = true;
+  auto start = std::chrono::steady_clock::now();
+  PROFILE_GPU_SCOPE(profile_name_);
+
+  if (occlusion_) {
+    if (framebuffer_->GetType() == FrameBuffer::kCubeMap) {
+      ABORT_F("Occlusion culling is not supported for the cubemaps");
+    }
+    CullOccluded(*camera);
+  }
+
+  if (clustered_lighting_) {
+    if (framebuffer_->GetType() == FrameBuffer::kCubeMap) {
+      ABORT_F("Clustered lighting is not supported for the cubemaps");
+    }
+    clustered_lighting_->Update(scene.GetLocalLights(), *camera);
+    clustered_lighting_->Bind();
+    scene.SetClusteredLighting(clustered_lighting_.get());
+  }
 
   framebuffer_->Bind();
   if (framebuffer_->GetType() == FrameBuffer::kCubeMap) {
-    for (int i = 0; i < 6; i++) {
-      if (!cubemap_mask_[i]) continue;
-      camera->transform->SetLocalEulerAngles(GetCubeCameraRotation(i));
-      framebuffer_->BindCubemapFace(i);
-      render_queue_.Draw(scene, *camera);
-      framebuffer_->UnbindCubemapFace(i);
-    }
+    DrawCubemap(scene, *camera);
+  } else if (frustum_culling_) {
+    // The camera frustum is from Scene::Update, before the actions moved it
+    glm::mat4 view, proj;
+    camera->GetViewMatrix(view);
+    camera->GetProjectionMatrix(proj);
+    Frustum frustum;
+    frustum.Calculate(proj * view);
+    draw_stats_.culled = render_queue_.CullFaces(&frustum, 0x1);
+    draw_stats_.draws = render_queue_.Draw(scene, *camera, 0);
   } else {
-    render_queue_.Draw(scene, *camera);
+    draw_stats_.draws = render_queue_.Draw(scene, *camera);
   }
   framebuffer_->Unbind();
 
+  if (clustered_lighting_) {
+    scene.SetClusteredLighting(nullptr);
+    clustered_lighting_->Unbind();
+  }
+
+  draw_stats_.cpu_ms = std::chrono::duration<float, std::milli>(
+      std::chrono::steady_clock::now() - start).count();
 }
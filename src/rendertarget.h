@@ -29,6 +29,8 @@
 #include "framebuffer.h"
 #include "actor.h"
 #include "camera.h"
+#include "occlusionbuffer.h"
+#include "clusteredlighting.h"
 #include "common/tags.h"
 #include "common/logging.h"
 #include <memory>
@@ -49,6 +51,10 @@ class RenderTarget {
     camera_name_ = name;
   }
 
+  const std::string& GetCameraName() const {
+    return camera_name_;
+  }
+
   // The defaults width=0 and height=0 are for the most common case of 
   // having single screen-attached render target.
   std::shared_ptr<FrameBuffer> 
@@ -79,10 +85,123 @@ class RenderTarget {
 
   void StartNewFrame() {
     render_queue_.Clear();
+    occlusion_actors_.clear();
   }
 
   void AddActor(std::shared_ptr<Actor> actor) {
-    render_queue_.AddActor(actor, tags_);
+    if (!actor->IsVisible()) {
+      return;
+    }
+    if (occlusion_) {
+      // Queued after the occlusion test, in Draw()
+      occlusion_actors_.push_back(actor);
+    } else {
+      render_queue_.AddActor(actor, tags_);
+    }
+  }
+
+  ////////////////////////////////////////////////////////////////////////////
+  // CPU occlusion culling with the width x height depth buffer, the actors
+  // hidden behind the occluders (Actor::SetOccluder) do not reach the render
+  // queue. 0 x 0 turns it off. Not for the cubemaps.
+  ////////////////////////////////////////////////////////////////////////////
+  void SetOcclusionCulling(int width, int height, int n_threads = 0) {
+    if (width == 0 && height == 0) {
+      occlusion_.reset();
+      return;
+    }
+    OcclusionBuffer::Params params;
+    params.width = width;
+    params.height = height;
+    params.n_threads = n_threads;
+    occlusion_ = std::make_shared<OcclusionBuffer>(params);
+  }
+
+  // nullptr if the occlusion culling is off
+  std::shared_ptr<const OcclusionBuffer> GetOcclusionBuffer() const {
+    return occlusion_;
+  }
+
+  ////////////////////////////////////////////////////////////////////////////
+  // Clustered forward lighting, the scene point and spot lights are binned
+  // into the grid_x * grid_y * grid_z clusters of the camera frustum every
+  // frame and are available to the shaders, see ClusteredLighting. 
+  // 0 x 0 x 0 turns it off. Not for the cubemaps.
+  ////////////////////////////////////////////////////////////////////////////
+  void SetClusteredLighting(int grid_x, int grid_y, int grid_z, 
+                            int n_threads = 0) {
+    if (grid_x == 0 && grid_y == 0 && grid_z == 0) {
+      clustered_lighting_.reset();
+      return;
+    }
+    LightClusters::Params params;
+    params.grid_x = grid_x;
+    params.grid_y = grid_y;
+    params.grid_z = grid_z;
+    params.n_threads = n_threads;
+    clustered_lighting_ = std::make_shared<ClusteredLighting>(params);
+  }
+
+  // nullptr if the clustered lighting is off
+  std::shared_ptr<const ClusteredLighting> GetClusteredLighting() const {
+    return clustered_lighting_;
+  }
+
+  ////////////////////////////////////////////////////////////////////////////
+  // Cubemaps. kCubemapPerFace redraws the render queue for every face, 
+  // kCubemapLayered draws it once and the geometry shader of the pass 
+  // broadcasts the primitives to the faces with gl_Layer (SU_CUBE_PV_MATRIX_N,
+  // SU_CUBE_FACES, see assets/shaders/cubemap_layered.gs). Either way the
+  // actors are culled against each face frustum unless the culling is off.
+  ////////////////////////////////////////////////////////////////////////////
+  enum CubemapMode {
+    kCubemapPerFace,
+    kCubemapLayered
+  };
+
+  void SetCubemapMode(CubemapMode mode) {
+    cubemap_mode_ = mode;
+  }
+
+  CubemapMode GetCubemapMode() const {
+    return cubemap_mode_;
+  }
+
+  void SetCubemapCulling(bool enable) {
+    cubemap_culling_ = enable;
+  }
+
+  // Culls the actors against the camera frustum, for the 2D targets. Off by
+  // default - the overlays and the sky do not draw where their bounds are.
+  void SetFrustumCulling(bool enable) {
+    frustum_culling_ = enable;
+  }
+
+  bool IsFrustumCulling() const {
+    return frustum_culling_;
+  }
+
+  // The disabled target is not drawn and keeps the previous frame content
+  // (cached shadow cascades)
+  void SetEnabled(bool enable) {
+    enabled_ = enable;
+  }
+
+  bool IsEnabled() const {
+    return enabled_;
+  }
+
+  // The last Draw(). The time is the CPU side only - culling and the GL 
+  // commands submission.
+  struct DrawStats {
+    bool  drawn  = false; // not disabled
+    int   draws  = 0;     // draw calls
+    int   culled = 0;     // actors (actor/face pairs for the cubemaps) culled
+    float cpu_ms = 0;
+  };
+
+  const DrawStats& GetDrawStats() const {
+    return draw_stats_;
   }
 
   void Draw(Scene& scene);
@@ -106,14 +225,26 @@ class RenderTarget {
   }
 
  private:
+  void CullOccluded(const Camera& camera);
+  void DrawCubemap(Scene& scene, Camera& camera);
+
   Tags                          tags_;
   std::string                   name_;
+  const char*                   profile_name_; // name_, interned
   std::string                   camera_name_;
   RenderQueue                   render_queue_;
+  std::shared_ptr<OcclusionBuffer>     occlusion_;
+  std::vector<std::shared_ptr<Actor>>  occlusion_actors_;
+  std::shared_ptr<ClusteredLighting>   clustered_lighting_;
   std::shared_ptr<FrameBuffer>  framebuffer_;
 
   std::shared_ptr<RenderTarget> cubemap_rt_[6];
   std::bitset<6>                cubemap_mask_;
+  CubemapMode                   cubemap_mode_ = kCubemapPerFace;
+  bool                          cubemap_culling_ = true;
+  bool                          frustum_culling_ = false;
+  bool                          enabled_ = true;
+  DrawStats                     draw_stats_;
 };
 
 #endif // _RENDERTARGET_H_402867F5_8866_46E7_B227_CC234EC053AD_
@@ -0,0 +1,59 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "replay.h"
+#include "common/logging.h"
+#include <cstdlib>
+
+static std::string GetVariable(const char* name) {
+  const char* value = std::getenv(name);
+  return value ? value : "";
+}
+
+Replay Replay::FromEnvironment() {
+  Replay replay;
+  std::string value;
+  if (!(value = GetVariable("B3D_FRAMES")).empty()) {
+    replay.frames = std::atoi(value.c_str());
+  }
+  if (!(value = GetVariable("B3D_WARMUP")).empty()) {
+    replay.warmup = std::atoi(value.c_str());
+  }
+  if (!(value = GetVariable("B3D_FIXED_STEP")).empty()) {
+    replay.fixed_step = std::atof(value.c_str());
+  }
+  value = GetVariable("B3D_HEADLESS");
+  replay.headless = !value.empty() && value != "0";
+  replay.input_record = GetVariable("B3D_INPUT_RECORD");
+  replay.input_play = GetVariable("B3D_INPUT_PLAY");
+  replay.report = GetVariable("B3D_REPORT");
+
+  if (replay.frames < 0 || replay.warmup < 0 || replay.fixed_step < 0) {
+    ABORT_F("Bad B3D_FRAMES, B3D_WARMUP or B3D_FIXED_STEP");
+  }
+  if (!replay.input_record.empty() && !replay.input_play.empty()) {
+    ABORT_F("B3D_INPUT_RECORD and B3D_INPUT_PLAY at once");
+  }
+  return replay;
+}
@@ -0,0 +1,60 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _REPLAY_H_EAB42BFC_4E2A_4040_9CF4_5D285B387B98_
+#define _REPLAY_H_EAB42BFC_4E2A_4040_9CF4_5D285B387B98_ 
+
+#include <string>
+
+//////////////////////////////////////////////////////////////////////////////
+// The regression run settings, from the environment, so any example runs 
+// unchanged. AppContext::Init() reads them:
+//
+//  B3D_FRAMES=600          Running() is false after 600 frames
+//  B3D_WARMUP=60           The first frames are not in the report
+//  B3D_FIXED_STEP=0.0166   Simulated clock, Timer::SetFixedStep()
+//  B3D_HEADLESS=1          No visible window, see Display
+//  B3D_INPUT_RECORD=file   Records the input, written by AppContext::Close()
+//  B3D_INPUT_PLAY=file     Plays the recorded input back
+//  B3D_REPORT=file.json    Frame time percentiles, phases and allocations,
+//                          see FrameStats
+//
+// With B3D_FRAMES or B3D_REPORT the frame stats are collected and logged at
+// AppContext::Close(). tools/replay.sh runs the examples this way.
+//////////////////////////////////////////////////////////////////////////////
+struct Replay {
+  int         frames = 0;
+  int         warmup = 0;
+  double      fixed_step = 0;
+  bool        headless = false;
+  std::string input_record;
+  std::string input_play;
+  std::string report;
+
+  bool IsMeasured() const { return frames > 0 || !report.empty(); }
+
+  static Replay FromEnvironment();
+};
+
+#endif // _REPLAY_H_EAB42BFC_4E2A_4040_9CF4_5D285B387B98_
@@ -0,0 +1,63 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "resourcecache.h"
+#include <sys/stat.h>
+
+template <typename TMap>
+static void PurgeExpired(TMap& cache) {
+  for (auto it = cache.begin(); it != cache.end(); ) {
+    if (it->second.expired()) {
+      it = cache.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void ResourceCache::Purge() {
+  PurgeExpired(shaders_);
+  PurgeExpired(textures_);
+  PurgeExpired(meshes_);
+}
+
+void ResourceCache::PrintStats(std::ostream& out) const {
+  out << "Resource cache:" << std::endl
+      << "  shaders  built "  << stats_.shader_builds 
+      << ", shared " << stats_.shader_hits << std::endl
+      << "  textures loaded " << stats_.texture_loads 
+      << ", shared " << stats_.texture_hits << std::endl
+      << "  meshes   loaded " << stats_.mesh_loads 
+      << ", shared " << stats_.mesh_hits << std::endl;
+}
+
+std::string ResourceCache::FileKey(const std::string& filename) {
+  struct stat st;
+  if (stat(filename.c_str(), &st) != 0) {
+    return filename;
+  }
+
+  return filename + "|" + std::to_string(static_cast<long long>(st.st_size)) + 
+                    "|" + std::to_string(static_cast<long long>(st.st_mtime));
+}
@@ -0,0 +1,130 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _RESOURCECACHE_H_E755D20D_F0C5_4FFF_B833_9D1961759B5F_
+#define _RESOURCECACHE_H_E755D20D_F0C5_4FFF_B833_9D1961759B5F_ 
+
+#include "singleton.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+
+class Shader;
+class Texture;
+class Mesh;
+
+//////////////////////////////////////////////////////////////////////////////
+// Shares heavy resources between everything which loads them.
+//
+// Shader programs are keyed by a hash of all the stage sources, so two
+// materials with the same GLSL share one program. Textures and meshes are
+// keyed by the file path(s) plus the file stamp (size and modification time),
+// so an edited file is loaded again.
+//
+// Only weak references are kept. The resource is freed together with its
+// last user and is loaded again on the next request. Dead entries are
+// dropped lazily, or by Purge().
+//
+// NOTE A shared shader program shares its uniform values as well. Actions
+// set the uniforms in PreDraw() before every draw call, so this is fine as
+// long as that convention is kept.
+//
+// NOTE A shared mesh must not be modified in place, copy it first.
+//
+// Usage:
+//   auto shader = ResourceCache::Instance().GetShader(hash, [&]() {
+//     ...compile and link...
+//     return shader;
+//   });
+//////////////////////////////////////////////////////////////////////////////
+class ResourceCache : public Singleton<ResourceCache> {
+ public:
+  struct Stats {
+    size_t shader_builds = 0; // Programs compiled and linked
+    size_t shader_hits   = 0;
+    size_t texture_loads = 0; // Images read and uploaded to vRAM
+    size_t texture_hits  = 0;
+    size_t mesh_loads    = 0; // Mesh files parsed
+    size_t mesh_hits     = 0;
+  };
+
+  template <typename TBuild>
+  std::shared_ptr<Shader> GetShader(uint64_t source_hash, TBuild&& build) {
+    return Get(shaders_, source_hash, build, 
+               stats_.shader_builds, stats_.shader_hits);
+  }
+
+  template <typename TLoad>
+  std::shared_ptr<Texture> GetTexture(const std::string& key, TLoad&& load) {
+    return Get(textures_, key, load, 
+               stats_.texture_loads, stats_.texture_hits);
+  }
+
+  template <typename TLoad>
+  std::shared_ptr<Mesh> GetMesh(const std::string& key, TLoad&& load) {
+    return Get(meshes_, key, load, stats_.mesh_loads, stats_.mesh_hits);
+  }
+
+  // Drops the entries which are not referenced anymore
+  void Purge();
+
+  const Stats& GetStats() const { return stats_; }
+  void PrintStats(std::ostream& out) const;
+
+  // Cache key for a file: path, size and modification time. Just the path
+  // if the file can't be stat'ed.
+  static std::string FileKey(const std::string& filename);
+
+ private:
+  template <typename TKey, typename T, typename TLoad>
+  static std::shared_ptr<T> Get(std::map<TKey, std::weak_ptr<T>>& cache,
+                                const TKey& key, TLoad& load, 
+                                size_t& loads, size_t& hits) {
+    auto it = cache.find(key);
+    if (it != cache.end()) {
+      if (auto resource = it->second.lock()) {
+        ++hits;
+        return resource;
+      }
+      cache.erase(it);
+    }
+
+    std::shared_ptr<T> resource = load();
+    ++loads;
+    if (resource) {
+      cache.emplace(key, resource);
+    }
+    return resource;
+  }
+
+  std::map<uint64_t,    std::weak_ptr<Shader>>  shaders_;
+  std::map<std::string, std::weak_ptr<Texture>> textures_;
+  std::map<std::string, std::weak_ptr<Mesh>>    meshes_;
+  Stats stats_;
+};
+
+#endif // _RESOURCECACHE_H_E755D20D_F0C5_4FFF_B833_9D1961759B5F_
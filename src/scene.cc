@@ -23,36 +23,62 @@
 //
 
 #include "scene.h"
+#include "profiler.h"
+#include <algorithm>
 #include <exception>
 
 // TODO: it is growing bigger... Need to redesign.
 void Scene::Update() {
+  Update(AppContext::Instance().timer.GetTimeDelta());
+}
+
+void Scene::Update(float frame_time) {
+  PROFILE_SCOPE("Scene::Update");
   for (auto& rt: render_targets_) {
     rt.second->StartNewFrame();
   }
 
+  frame_time_ = frame_time;
   for (auto& kv: cameras_) {
-    kv.second->Update();
+    kv.second->Update(frame_time_);
+  }
+  if (tick_rates_) {
+    auto camera = Get<Camera>(tick_rates_->camera);
+    tick_eye_valid_ = camera != nullptr;
+    if (camera) {
+      tick_eye_ = camera->transform->GetGlobalPosition();
+    }
   }
 
+  // Split by type, the scene uniforms need the directional ones only
+  directional_lights_.clear();
+  local_lights_.clear();
   for (auto& kv: lights_) {
-    kv.second->Update();
+    kv.second->Update(frame_time_);
+    if (kv.second->GetType() == Light::kDirectional) {
+      directional_lights_.push_back(kv.second);
+    } else {
+      local_lights_.push_back(kv.second);
+    }
   }
 
   // Regular actors
-  for (auto& kv: actors_) {
-    kv.second->Update();
-    for (auto& rt: render_targets_) {
-      rt.second->AddActor(kv.second);
+  update_stats_ = UpdateStats();
+  if (partition_) {
+    UpdatePartitioned();
+  } else {
+    for (auto& kv: actors_) {
+      UpdateActor(*kv.second);
     }
   }
+  QueueActors();
 
   // Update and draw pools ...
   for (auto& kv: actor_pools_) {
-    kv.second->Update();
+    kv.second->Update(frame_time_);
 
     for (auto& a: *kv.second) {
-      a->Update();
+      UpdateActor(*a);
       for (auto& rt: render_targets_) {
         rt.second->AddActor(a);
       }
@@ -61,7 +87,7 @@ void Scene::Update() {
 
   // Update all batched actors
   for (auto& kv: std_batch_.actors_) {
-    kv.second->Update();
+    kv.second->Update(frame_time_);
   }
 
   // Update all batches
@@ -69,29 +95,212 @@ void Scene::Update() {
     if (kv.second->BatchSize() == 0) 
       continue;
 
-    kv.second->Update();
+    kv.second->Update(frame_time_);
     kv.second->UploadInstances();
 
     for (auto& rt: render_targets_) {
       rt.second->AddActor(kv.second);
     }
   }
+  AppContext::MarkFrame(FrameStats::kUpdate);
+}
+
+void Scene::SetPartitioning(const ScenePartition::Params& params) {
+  partition_.reset(new ScenePartition(params));
+  for (auto& kv: actors_) {
+    partition_->Add(kv.second);
+  }
+}
+
+void Scene::SetTickRates(const TickRates& rates) {
+  tick_rates_.reset(new TickRates(rates));
+}
+
+void Scene::UpdateActor(Actor& actor) {
+  if (tick_rates_ && tick_eye_valid_ && !actor.IsTickIntervalPinned() && 
+      !actor.IsStatic() && !actor.IsSleeping()) {
+    float distance = glm::length(actor.transform->GetGlobalPosition() - 
+                                 tick_eye_);
+    actor.SetTickInterval(tick_rates_->GetInterval(distance), false);
+  }
+  actor.Update(frame_time_);
+  ++update_stats_.actors;
+  update_stats_.ticked += actor.HasTicked();
+  update_stats_.sleeping += actor.IsSleeping();
+  update_stats_.statics += actor.IsStatic();
+}
+
+void Scene::UpdatePartitioned() {
+  std::vector<glm::vec3> eyes;
+  for (auto& kv: cameras_) {
+    eyes.push_back(kv.second->transform->GetGlobalPosition());
+  }
+  partition_->Activate(eyes, active_actors_);
+  for (auto& actor: active_actors_) {
+    UpdateActor(*actor);
+  }
+  partition_->Refresh();
+}
+
+void Scene::SetPortals(std::shared_ptr<PortalGraph> portals) {
+  portals_ = portals;
+  portal_actors_.clear();
+  portal_ids_.clear();
+}
+
+// The bounds of all the actors, the ones without them are always visible
+void Scene::SyncPortals() {
+  portal_unbounded_.clear();
+  for (auto& kv: actors_) {
+    auto& actor = kv.second;
+    auto it = portal_ids_.find(actor.get());
+    glm::vec3 min, max;
+    if (!actor->IsAlive() || !actor->GetWorldBounds(min, max)) {
+      if (it != portal_ids_.end()) {
+        portals_->Remove(it->second);
+        portal_actors_[it->second].reset();
+        portal_ids_.erase(it);
+      }
+      if (actor->IsAlive()) {
+        portal_unbounded_.push_back(actor);
+      }
+    } else if (it != portal_ids_.end()) {
+      portals_->Update(it->second, min, max);
+    } else {
+      uint32_t id = portals_->Add(min, max);
+      if (id >= portal_actors_.size()) {
+        portal_actors_.resize(id + 1);
+      }
+      portal_actors_[id] = actor;
+      portal_ids_[actor.get()] = id;
+    }
+  }
+}
+
+// The frustum is the same as in RenderTarget::Draw()
+void Scene::QueueActors() {
+  if (portals_) {
+    SyncPortals();
+  }
+  for (auto& rt: render_targets_) {
+    auto camera = Get<Camera>(rt.second->GetCameraName());
+    auto framebuffer = rt.second->GetFrameBuffer();
+    if ((!partition_ && !portals_) || !camera || 
+        !rt.second->IsFrustumCulling() || 
+        (framebuffer && framebuffer->GetType() == FrameBuffer::kCubeMap)) {
+      for (auto& kv: actors_) {
+        rt.second->AddActor(kv.second);
+      }
+      continue;
+    }
+    glm::mat4 view, proj;
+    camera->GetViewMatrix(view);
+    camera->GetProjectionMatrix(proj);
+    Frustum frustum;
+    frustum.Calculate(proj * view);
+    visible_actors_.clear();
+    if (portals_) {
+      portal_found_.clear();
+      portals_->Query(camera->transform->GetGlobalPosition(), frustum, 
+                      portal_found_);
+      for (uint32_t id: portal_found_) {
+        visible_actors_.push_back(portal_actors_[id]);
+      }
+      visible_actors_.insert(visible_actors_.end(), portal_unbounded_.begin(),
+                             portal_unbounded_.end());
+    } else {
+      partition_->Query(frustum, visible_actors_);
+    }
+    for (auto& actor: visible_actors_) {
+      rt.second->AddActor(actor);
+    }
+  }
 }
 
 void Scene::Draw() {
+  PROFILE_SCOPE("Scene::Draw");
   for (auto& rt: render_targets_) {
     rt.second->Draw(*this);
   }
+  AppContext::MarkFrame(FrameStats::kDraw);
 }
 
 void Scene::SetSceneUniforms(Pass& pass, const Camera& camera) {
   pass.SuTime(AppContext::Instance().timer.GetTime());
   pass.SuTextures();
 
-  for (auto& kv: lights_) {
-    Light& light = *kv.second;
-    if (light.GetType() == Light::kDirectional) {
-      pass.SuDirLight(light.GetDirection(), light.GetColor());
+  for (auto& light: directional_lights_) {
+    pass.SuDirLight(light->GetDirection(), light->GetColor());
+  }
+
+  if (clustered_lighting_) {
+    clustered_lighting_->SetUniforms(pass);
+  }
+}
+
+bool Scene::Raycast(const Phys::Ray& ray, RaycastHit& hit, 
+                    float max_distance) {
+  // The actors whose world AABB is on the way, the nearest first
+  struct Candidate {
+    float                  distance;
+    std::shared_ptr<Actor> actor;
+  };
+  std::vector<Candidate> candidates;
+  auto add = [&](const std::shared_ptr<Actor>& actor) {
+    glm::vec3 min, max;
+    float distance;
+    if (actor->IsAlive() && actor->GetWorldBounds(min, max) &&
+        Phys::Intersect(ray, {min, max}, 0, max_distance, distance)) {
+      candidates.push_back({distance, actor});
+    }
+  };
+  for (auto& kv: actors_) {
+    add(kv.second);
+  }
+  for (auto& kv: actor_pools_) {
+    for (auto& actor: *kv.second) {
+      add(actor);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(), 
+            [](const Candidate& a, const Candidate& b) {
+              return a.distance < b.distance;
+            });
+
+  // The ray moves to the model space as is, the distances stay the same
+  bool found = false;
+  for (auto& candidate: candidates) {
+    if (candidate.distance > max_distance) {
+      break;
+    }
+    auto mesh = candidate.actor->GetComponent<Mesh>();
+    auto bvh = bvh_cache_.Get(mesh);
+    glm::mat4 model;
+    candidate.actor->GetWorldMatrix(model);
+    glm::mat4 inv_model = glm::inverse(model);
+    Phys::Ray local = {glm::vec3(inv_model * glm::vec4(ray.origin, 1)),
+                       glm::vec3(inv_model * glm::vec4(ray.direction, 0))};
+    Phys::Bvh::Hit bvh_hit;
+    if (!bvh || !bvh->Raycast(local, bvh_hit, 0, max_distance)) {
+      continue;
+    }
+
+    max_distance = bvh_hit.t;
+    found = true;
+    hit.actor = candidate.actor;
+    hit.distance = bvh_hit.t;
+    hit.point = ray.At(bvh_hit.t);
+    hit.triangle = bvh_hit.triangle;
+
+    size_t i = 3 * (size_t)bvh_hit.triangle;
+    glm::vec3 v[3];
+    for (int k = 0; k < 3; ++k) {
+      v[k] = mesh->vertices[mesh->indices.empty() ? i + k : mesh->indices[i + k]];
     }
+    glm::vec3 normal = glm::transpose(glm::mat3(inv_model)) * 
+                       glm::cross(v[1] - v[0], v[2] - v[0]);
+    normal = glm::normalize(normal);
+    hit.normal = glm::dot(normal, ray.direction) > 0 ? -normal : normal;
   }
+  return found;
 }
@@ -34,10 +34,17 @@
 #include "material/material.h"
 #include "material/pass.h"
 #include "rendertarget.h"
+#include "clusteredlighting.h"
+#include "scenepartition.h"
+#include "portalgraph.h"
+#include "phys/bvh.h"
 #include "common/util.h"
+#include <limits>
 #include <memory>
 #include <map>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 ////////////////////////////////////////////////////////////////////////////
 // The scene for our actors...
@@ -66,10 +73,15 @@
 // This about sector based scene management, such as octree, portals, etc.
 // In order to cut off big chunks of world from processing. Integration with
 // batching and simulation required.
+//  -> The loose octree of the actors is there, see SetPartitioning(), and
+//     the cells and portals for the indoors, see SetPortals(). The pools 
+//     and the batches are not partitioned yet.
 ////////////////////////////////////////////////////////////////////////////
 class Scene {
  public:
+  // The frame time of the timer, or the given one (the tests, the replays)
   void Update();
+  void Update(float frame_time);
   void Draw();
 
   template <typename TComponent, typename... TArgs>
@@ -80,10 +92,110 @@ class Scene {
   
   void SetSceneUniforms(Pass& pass, const Camera& camera);
 
+  // The regular and the pool actors of the last Update(), see 
+  // Actor::SetStatic() and Actor::SetAutoSleep()
+  struct UpdateStats {
+    size_t actors   = 0;
+    size_t ticked   = 0; // Ran the actions
+    size_t sleeping = 0;
+    size_t statics  = 0;
+  };
+
+  const UpdateStats& GetUpdateStats() const {
+    return update_stats_;
+  }
+
+  ////////////////////////////////////////////////////////////////////////////
+  // Tick rate buckets by the distance to the camera: the actors further 
+  // than distances[0] tick every 2nd frame, [1] - every 4th, [2] - every 
+  // 8th. The actors with the pinned interval, the static and the sleeping 
+  // ones are left as they are. See Actor::SetTickInterval().
+  ////////////////////////////////////////////////////////////////////////////
+  struct TickRates {
+    std::string camera       = "camera.main";
+    float       distances[3] = {50, 100, 200};
+
+    int GetInterval(float distance) const {
+      int interval = 1;
+      for (float d: distances) {
+        if (distance > d) {
+          interval *= 2;
+        }
+      }
+      return interval;
+    }
+  };
+
+  void SetTickRates(const TickRates& rates);
+
+  // The point and spot lights as of the last Update()
+  const std::vector<std::shared_ptr<Light>>& GetLocalLights() const {
+    return local_lights_;
+  }
+
+  ////////////////////////////////////////////////////////////////////////////
+  // The nearest actor hit by the world space ray, for the picking and the
+  // line of sight. The alive actors and the pools with a MeshFilter mesh,
+  // not instanced nor tesselated. The world AABBs are tested first, then 
+  // the BVH of the mesh (built on the first raycast) in the model space.
+  ////////////////////////////////////////////////////////////////////////////
+  struct RaycastHit {
+    std::shared_ptr<Actor> actor;
+    float                  distance; // Along the ray
+    glm::vec3              point;
+    glm::vec3              normal;   // Faces the ray
+    uint32_t               triangle; // Of the mesh
+  };
+
+  bool Raycast(const Phys::Ray& ray, RaycastHit& hit, 
+               float max_distance = std::numeric_limits<float>::max());
+
+  // A mesh changed in place needs its BVH rebuilt
+  Phys::BvhCache& GetBvhCache() { return bvh_cache_; }
+
+  ////////////////////////////////////////////////////////////////////////////
+  // The actors (not the pools nor the batches) in the loose octree, the 
+  // ones far from all the cameras are not updated and the frustum culled 2D
+  // render targets get only the ones in the frustum. See ScenePartition.
+  ////////////////////////////////////////////////////////////////////////////
+  void SetPartitioning(const ScenePartition::Params& params);
+
+  // nullptr if the partitioning is off
+  ScenePartition* GetPartition() { return partition_.get(); }
+
+  ////////////////////////////////////////////////////////////////////////////
+  // Portal visibility for the indoor levels: the frustum culled 2D render 
+  // targets get only the actors in the cells seen from the camera through
+  // the portals, see PortalGraph. The cells and the portals are set up by 
+  // the caller, the actors (not the pools nor the batches) are added and 
+  // kept in sync by the scene. Goes instead of the partition frustum query,
+  // nullptr turns it off.
+  ////////////////////////////////////////////////////////////////////////////
+  void SetPortals(std::shared_ptr<PortalGraph> portals);
+  std::shared_ptr<const PortalGraph> GetPortals() const { return portals_; }
+
+  // Set by the render target for its Draw(), nullptr - none
+  void SetClusteredLighting(const ClusteredLighting* clustered_lighting) {
+    clustered_lighting_ = clustered_lighting;
+  }
+
  private:
+  void UpdatePartitioned();
+  void UpdateActor(Actor& actor);
+  void SyncPortals();
+  void QueueActors();
+
   std::map<std::string, std::shared_ptr<Camera>> cameras_;
   std::map<std::string, std::shared_ptr<Actor>>  actors_;
   std::map<std::string, std::shared_ptr<Light>>  lights_;
+  std::vector<std::shared_ptr<Light>>            directional_lights_;
+  std::vector<std::shared_ptr<Light>>            local_lights_;
+  const ClusteredLighting*                       clustered_lighting_ = nullptr;
+  UpdateStats                                    update_stats_;
+  float                                          frame_time_ = 0;
+  std::unique_ptr<TickRates>                     tick_rates_;
+  glm::vec3                                      tick_eye_;
+  bool                                           tick_eye_valid_ = false;
 
   std::map<std::string, std::shared_ptr<ActorPool>> actor_pools_;
 
@@ -93,6 +205,18 @@ class Scene {
   StdBatch::Storage std_batch_;
 
   std::map<int, std::shared_ptr<RenderTarget>>   render_targets_;
+
+  Phys::BvhCache                                 bvh_cache_;
+
+  std::unique_ptr<ScenePartition>                partition_;
+  std::vector<std::shared_ptr<Actor>>            active_actors_;
+  std::vector<std::shared_ptr<Actor>>            visible_actors_;
+
+  std::shared_ptr<PortalGraph>                   portals_;
+  std::vector<std::shared_ptr<Actor>>            portal_actors_; // By the id
+  std::unordered_map<const Actor*, uint32_t>     portal_ids_;
+  std::vector<std::shared_ptr<Actor>>            portal_unbounded_;
+  std::vector<uint32_t>                          portal_found_;
 };
 
 #include "scene.inl"
@@ -30,9 +30,13 @@ auto Scene::Add(const std::string& name, TArgs&&... args) {
     // Actor
     //
     auto thing = std::make_shared<TComponent>(name, std::forward<TArgs>(args)...);
-    return cppness
+    cppness
       ::MapForSharedPtr<decltype(actors_)>
       ::JustPutToMap(name, thing, actors_);
+    if (partition_) {
+      partition_->Add(thing);
+    }
+    return thing;
   } else
   if constexpr (std::is_same<TComponent, Light>::value) {
     // 
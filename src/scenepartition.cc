@@ -0,0 +1,148 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "scenepartition.h"
+#include "camera.h"
+#include <algorithm>
+
+ScenePartition::ScenePartition(const Params& params) 
+    : params_(params), octree_(params.octree) {}
+
+void ScenePartition::Add(const std::shared_ptr<Actor>& actor) {
+  pending_.push_back(actor);
+}
+
+void ScenePartition::Moved(const std::shared_ptr<Actor>& actor) {
+  auto it = ids_.find(actor.get());
+  glm::vec3 min, max;
+  if (it != ids_.end() && actor->GetWorldBounds(min, max)) {
+    octree_.Update(it->second, min, max);
+  }
+}
+
+void ScenePartition::Insert(const std::shared_ptr<Actor>& actor) {
+  glm::vec3 min, max;
+  if (!actor->GetWorldBounds(min, max)) {
+    unbounded_.push_back(actor);
+    return;
+  }
+  uint32_t id = octree_.Add(min, max);
+  if (id >= actors_.size()) {
+    actors_.resize(id + 1);
+    marks_.resize(id + 1, 0);
+  }
+  actors_[id] = actor;
+  ids_[actor.get()] = id;
+}
+
+void ScenePartition::Erase(uint32_t id) {
+  ++stats_.removed;
+  octree_.Remove(id);
+  ids_.erase(actors_[id].get());
+  actors_[id].reset();
+}
+
+void ScenePartition::Activate(const std::vector<glm::vec3>& eyes, 
+                              std::vector<std::shared_ptr<Actor>>& active) {
+  octree_.ResetStats();
+  stats_ = Stats();
+  active.clear();
+  active_ids_.clear();
+  for (auto& actor: pending_) {
+    Insert(actor);
+  }
+  pending_.clear();
+
+  // The boxes around the eyes overlap, the actors are marked once a frame
+  ++frame_;
+  glm::vec3 distance(params_.active_distance);
+  for (auto& eye: eyes) {
+    found_.clear();
+    octree_.Query(eye - distance, eye + distance, found_);
+    for (uint32_t id: found_) {
+      if (marks_[id] == frame_) {
+        continue;
+      }
+      // Back in the active area, the time did not pass out there
+      if (marks_[id] != frame_ - 1) {
+        actors_[id]->ResetDeltaTime();
+      }
+      marks_[id] = frame_;
+      if (!actors_[id]->IsAlive()) {
+        Erase(id);
+        continue;
+      }
+      active.push_back(actors_[id]);
+      active_ids_.push_back(id);
+    }
+  }
+
+  // The dead far away would stay in the octree forever
+  size_t sweep = std::min(params_.dead_sweep, actors_.size());
+  for (size_t i = 0; i < sweep; ++i) {
+    if (sweep_ >= actors_.size()) {
+      sweep_ = 0;
+    }
+    uint32_t id = sweep_++;
+    if (actors_[id] && !actors_[id]->IsAlive()) {
+      Erase(id);
+    }
+  }
+
+  unbounded_.erase(std::remove_if(unbounded_.begin(), unbounded_.end(), 
+                                  [](const std::shared_ptr<Actor>& actor) {
+                                    return !actor->IsAlive();
+                                  }), unbounded_.end());
+  active.insert(active.end(), unbounded_.begin(), unbounded_.end());
+
+  stats_.actors = ids_.size() + unbounded_.size();
+  stats_.unbounded = unbounded_.size();
+  stats_.active = active.size();
+}
+
+void ScenePartition::Refresh() {
+  for (uint32_t id: active_ids_) {
+    glm::vec3 min, max;
+    if (actors_[id]->GetWorldBounds(min, max)) {
+      octree_.Update(id, min, max);
+    }
+  }
+  stats_.moved = octree_.GetStats().moves;
+  stats_.tested = octree_.GetStats().object_tests;
+}
+
+void ScenePartition::Query(const Frustum& frustum, 
+                           std::vector<std::shared_ptr<Actor>>& actors) {
+  found_.clear();
+  octree_.Query(frustum, found_);
+  size_t size = actors.size();
+  for (uint32_t id: found_) {
+    if (actors_[id]->IsAlive()) {
+      actors.push_back(actors_[id]);
+    }
+  }
+  stats_.tested = octree_.GetStats().object_tests;
+  stats_.visible += actors.size() - size;
+  actors.insert(actors.end(), unbounded_.begin(), unbounded_.end());
+}
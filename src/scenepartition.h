@@ -0,0 +1,104 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _SCENEPARTITION_H_3B672FB0_E3E2_431A_972E_A002DB48CD63_
+#define _SCENEPARTITION_H_3B672FB0_E3E2_431A_972E_A002DB48CD63_ 
+
+#include "actor.h"
+#include "looseoctree.h"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+// The actors of the scene in the loose octree by their world bounds, for 
+// the big worlds: the actors far from all the cameras are not updated, the
+// frustum culled render targets get only what is in the frustum.
+//
+// The bounds (Actor::GetWorldBounds) of the updated actors are synced after
+// their Update(), the sleeping actors are expected to stay where they are, 
+// Moved() for the ones moved by someone else. The actors without bounds 
+// are always updated and drawn.
+//////////////////////////////////////////////////////////////////////////////
+class ScenePartition {
+ public:
+  struct Params {
+    LooseOctree::Params octree;
+    float               active_distance = 500; // From a camera, along axes
+    size_t              dead_sweep = 256;      // Ids checked for the dead a frame
+  };
+
+  // The last frame
+  struct Stats {
+    size_t actors    = 0;
+    size_t unbounded = 0;
+    size_t active    = 0; // Updated
+    size_t moved     = 0; // Changed the octree node
+    size_t tested    = 0; // Bounds tested by the queries
+    size_t visible   = 0; // Found by the frustum queries, all the targets
+    size_t removed   = 0; // The dead ones out of the octree
+  };
+
+  ScenePartition() : ScenePartition(Params()) {}
+  explicit ScenePartition(const Params& params);
+
+  // The bounds are taken on the next Activate(), the components are there
+  void Add(const std::shared_ptr<Actor>& actor);
+  void Moved(const std::shared_ptr<Actor>& actor);
+
+  // Starts the frame: the alive actors around the eyes (the cameras), the 
+  // unbounded and the new ones. The dead ones leave the octree when found
+  // there, or by the sweep over all the ids wherever they are.
+  void Activate(const std::vector<glm::vec3>& eyes, 
+                std::vector<std::shared_ptr<Actor>>& active);
+
+  // The bounds of the active actors, after their Update()
+  void Refresh();
+
+  // The alive actors in the frustum and the unbounded ones, appended
+  void Query(const Frustum& frustum, 
+             std::vector<std::shared_ptr<Actor>>& actors);
+
+  const Stats& GetStats() const { return stats_; }
+  const LooseOctree& GetOctree() const { return octree_; }
+
+ private:
+  void Insert(const std::shared_ptr<Actor>& actor);
+  void Erase(uint32_t id);
+
+  Params                                         params_;
+  LooseOctree                                    octree_;
+  std::vector<std::shared_ptr<Actor>>            actors_;  // By the octree id
+  std::unordered_map<const Actor*, uint32_t>     ids_;
+  std::vector<std::shared_ptr<Actor>>            unbounded_;
+  std::vector<std::shared_ptr<Actor>>            pending_;
+  std::vector<uint32_t>                          marks_;   // By the octree id
+  uint32_t                                       frame_ = 0;
+  uint32_t                                       sweep_ = 0;   // Next id
+  std::vector<uint32_t>                          active_ids_;
+  std::vector<uint32_t>                          found_;
+  Stats                                          stats_;
+};
+
+#endif // _SCENEPARTITION_H_3B672FB0_E3E2_431A_972E_A002DB48CD63_
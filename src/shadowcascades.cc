@@ -0,0 +1,153 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "shadowcascades.h"
+#include "camera.h"
+#include "common/logging.h"
+#include <algorithm>
+#include <cmath>
+
+ShadowCascades::ShadowCascades(const Params& params) 
+  : params_(params),
+    light_direction_(0),
+    light_euler_(0),
+    light_view_(1.0f) {
+  if (params_.n_cascades <= 0 || params_.resolution <= 0 || 
+      params_.cache_frames <= 0) {
+    ABORT_F("Invalid shadow cascades params");
+  }
+  cascades_.resize(params_.n_cascades);
+}
+
+void ShadowCascades::ComputeSplits(int n, float near, float far, 
+                                   float lambda, float* splits) {
+  for (int i = 0; i <= n; ++i) {
+    float t = (float)i / n;
+    float log_split = near * std::pow(far / near, t);
+    float uniform_split = near + (far - near) * t;
+    splits[i] = lambda * log_split + (1 - lambda) * uniform_split;
+  }
+  // Exactly, no rounding errors on the ends
+  splits[0] = near;
+  splits[n] = far;
+}
+
+void ShadowCascades::SetLight(const glm::vec3& direction) {
+  // The camera looks at -z, Transformation rotates yaw * pitch * roll
+  glm::vec3 d = glm::normalize(direction);
+  float pitch = std::asin(glm::clamp(d.y, -1.0f, 1.0f));
+  float yaw = std::atan2(-d.x, -d.z);
+  light_direction_ = d;
+  light_euler_ = glm::degrees(glm::vec3(pitch, yaw, 0));
+  light_view_ = glm::transpose(glm::eulerAngleYXZ(yaw, pitch, 0.0f));
+}
+
+void ShadowCascades::Fit(Cascade& cascade, const glm::mat4& proj,
+                         const glm::mat4& inv_view) {
+  // Slice corners in the view space, off-center and ortho projections too
+  bool perspective = proj[2][3] != 0;
+  glm::vec3 corners[8];
+  glm::vec3 center(0);
+  for (int i = 0; i < 8; ++i) {
+    float d = i < 4 ? cascade.split_near : cascade.split_far;
+    float scale = perspective ? d : 1;
+    float ndc_x = i & 1 ? 1 : -1;
+    float ndc_y = i & 2 ? 1 : -1;
+    if (perspective) {
+      corners[i].x = scale * (ndc_x + proj[2][0]) / proj[0][0];
+      corners[i].y = scale * (ndc_y + proj[2][1]) / proj[1][1];
+    } else {
+      corners[i].x = (ndc_x - proj[3][0]) / proj[0][0];
+      corners[i].y = (ndc_y - proj[3][1]) / proj[1][1];
+    }
+    corners[i].z = -d;
+    center += corners[i];
+  }
+  center /= 8.0f;
+
+  // In the view space the radius does not depend on the camera movement,
+  // rounded up to absorb the float noise anyway
+  float radius = 0;
+  for (auto& corner: corners) {
+    radius = std::max(radius, glm::length(corner - center));
+  }
+  radius = std::ceil(radius * 16) / 16;
+
+  // Moving by the whole texels only
+  float texel = 2 * radius / params_.resolution;
+  glm::vec3 c(light_view_ * inv_view * glm::vec4(center, 1));
+  c.x = std::floor(c.x / texel) * texel;
+  c.y = std::floor(c.y / texel) * texel;
+
+  cascade.box_min = glm::vec3(c.x - radius, c.y - radius, c.z - radius);
+  cascade.box_max = glm::vec3(c.x + radius, c.y + radius, 
+                              c.z + radius + params_.z_extension);
+  cascade.proj = glm::ortho(cascade.box_min.x, cascade.box_max.x, 
+                            cascade.box_min.y, cascade.box_max.y,
+                            -cascade.box_max.z, -cascade.box_min.z);
+  cascade.pv = cascade.proj * light_view_;
+}
+
+void ShadowCascades::Update(const glm::mat4& view, const glm::mat4& proj, 
+                            float near, float far, 
+                            const glm::vec3& light_direction) {
+  int n = params_.n_cascades;
+  if (params_.max_distance > 0) {
+    far = std::min(far, params_.max_distance);
+  }
+
+  // Everything is stale once the light moves
+  if (glm::dot(glm::normalize(light_direction), light_direction_) < 0.99999f) {
+    SetLight(light_direction);
+    invalid_ = true;
+  }
+
+  glm::mat4 inv_view = glm::affineInverse(view);
+  std::vector<float> splits(n + 1);
+  ComputeSplits(n, near, far, params_.lambda, splits.data());
+
+  stats_ = Stats();
+  for (int i = 0; i < n; ++i) {
+    Cascade& cascade = cascades_[i];
+    bool cached = i >= params_.cache_from;
+    cascade.update = invalid_ || !cached || 
+                     (frame_ + i) % params_.cache_frames == 0;
+    if (cascade.update) {
+      cascade.split_near = splits[i];
+      cascade.split_far = splits[i + 1];
+      Fit(cascade, proj, inv_view);
+      ++stats_.updated;
+    }
+  }
+  invalid_ = false;
+  ++frame_;
+}
+
+void ShadowCascades::Update(const Camera& camera, 
+                            const glm::vec3& light_direction) {
+  glm::mat4 view, proj;
+  camera.GetViewMatrix(view);
+  camera.GetProjectionMatrix(proj);
+  Update(view, proj, camera.GetNear(), camera.GetFar(), light_direction);
+}
@@ -0,0 +1,114 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _SHADOWCASCADES_H_5FECC3D9_4F62_4049_B75D_BB39F341CB07_
+#define _SHADOWCASCADES_H_5FECC3D9_4F62_4049_B75D_BB39F341CB07_ 
+
+#include "glm_main.h"
+#include <vector>
+
+class Camera;
+
+//////////////////////////////////////////////////////////////////////////////
+// Cascaded shadow maps for a directional light, the math part.
+//
+// The view distance is split into n slices, blending the uniform and the 
+// logarithmic schemes by lambda. Each slice gets an orthographic light 
+// space box around its bounding sphere. The sphere does not change with 
+// the camera rotation and the box is snapped to the shadow map texels, so
+// the shadow edges do not shimmer. The box is extended towards the light 
+// to keep the casters outside of the slice.
+//
+// The far cascades can be cached: they are refitted and redrawn every 
+// cache_frames frames (staggered), when the light direction changes or 
+// after Invalidate() (static geometry changed).
+//
+// Light space: the camera at the origin looking along the light direction
+// with the yaw/pitch of GetLightEulerAngles(), so the engine Camera can be
+// set up with SetOrtho(box) and SetLocalEulerAngles().
+//////////////////////////////////////////////////////////////////////////////
+class ShadowCascades {
+ public:
+  struct Params {
+    int   n_cascades   = 4;
+    int   resolution   = 2048; // Shadow map side, texels
+    float lambda       = 0.75; // 0 - uniform, 1 - logarithmic splits
+    float max_distance = 0;    // Shadows range, 0 - the camera far
+    float z_extension  = 100;  // Casters behind the box, towards the light
+    int   cache_from   = 2;    // The first cached cascade, n_cascades - none
+    int   cache_frames = 4;    // Cached cascades update period
+  };
+
+  struct Cascade {
+    float     split_near = 0;  // View distance range
+    float     split_far  = 0;
+    glm::vec3 box_min;         // Light space box, looking at -z 
+    glm::vec3 box_max;
+    glm::mat4 proj;
+    glm::mat4 pv;              // proj * light view
+    bool      update = true;   // Has to be redrawn this frame
+  };
+
+  struct Stats {
+    int updated = 0;           // Cascades refitted on the last Update()
+  };
+
+  explicit ShadowCascades(const Params& params);
+
+  // Splits n slices of [near, far], n + 1 distances
+  static void ComputeSplits(int n, float near, float far, float lambda, 
+                            float* splits);
+
+  // view, proj - the camera matrices, near/far - its clip planes. The split
+  // distances are the view depths, not the distances to the eye.
+  void Update(const glm::mat4& view, const glm::mat4& proj, 
+              float near, float far, const glm::vec3& light_direction);
+  void Update(const Camera& camera, const glm::vec3& light_direction);
+
+  // Redraw all the cascades on the next Update()
+  void Invalidate() { invalid_ = true; }
+
+  const Params& GetParams() const { return params_; }
+  int GetCount() const { return (int)cascades_.size(); }
+  const Cascade& GetCascade(int i) const { return cascades_[i]; }
+  const glm::mat4& GetLightView() const { return light_view_; }
+  // Degrees, for Transformation::SetLocalEulerAngles()
+  glm::vec3 GetLightEulerAngles() const { return light_euler_; }
+  const Stats& GetStats() const { return stats_; }
+
+ private:
+  void SetLight(const glm::vec3& direction);
+  void Fit(Cascade& cascade, const glm::mat4& proj, const glm::mat4& inv_view);
+
+  Params               params_;
+  std::vector<Cascade> cascades_;
+  glm::vec3            light_direction_;
+  glm::vec3            light_euler_;
+  glm::mat4            light_view_;
+  bool                 invalid_ = true;
+  unsigned             frame_ = 0;
+  Stats                stats_;
+};
+
+#endif // _SHADOWCASCADES_H_5FECC3D9_4F62_4049_B75D_BB39F341CB07_
@@ -0,0 +1,456 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "chunkstreamer.h"
+#include "gridmesh.h"
+#include "common/logging.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <tuple>
+
+namespace Terrain {
+
+namespace {
+
+std::mutex index_mutex;
+std::map<std::pair<int, uint32_t>, 
+         std::shared_ptr<const std::vector<uint32_t>>> index_cache;
+
+int Ring(int x, int z, int cx, int cz) {
+  return std::max(std::abs(x - cx), std::abs(z - cz));
+}
+
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// ChunkStreamer
+//////////////////////////////////////////////////////////////////////////////
+ChunkStreamer::ChunkStreamer(const Params& params, Generator generator,
+                             Colorizer colorizer)
+    : params_(params), 
+      generator_(std::move(generator)),
+      colorizer_(std::move(colorizer)),
+      frame_(0),
+      stop_(false) {
+  int quads = params_.chunk_vertices - 1;
+  if (params_.lod_levels < 1 || quads < (1 << (params_.lod_levels - 1)) ||
+      (quads & (quads - 1)) != 0) {
+    ABORT_F("Chunk vertices must be 2^k + 1 with k >= %d, got %d",
+            params_.lod_levels - 1, params_.chunk_vertices);
+  }
+  if (params_.lod_distance < 1 || params_.view_distance < 0) {
+    ABORT_F("Invalid lod distance %d or view distance %d", 
+            params_.lod_distance, params_.view_distance);
+  }
+  if (!generator_) {
+    ABORT_F("Chunk generator not set");
+  }
+
+  for (int i = 0; i < params_.n_workers; ++i) {
+    workers_.emplace_back([this]() { Work(); });
+  }
+}
+
+ChunkStreamer::~ChunkStreamer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+  for (auto& worker: workers_) {
+    worker.join();
+  }
+}
+
+int ChunkStreamer::GetLod(int ring) const {
+  if (ring < params_.lod_distance) {
+    return 0;
+  }
+  int lod = 1;
+  while (lod < params_.lod_levels - 1 && 
+         ring >= (params_.lod_distance << lod)) {
+    ++lod;
+  }
+  return std::min(lod, params_.lod_levels - 1);
+}
+
+std::shared_ptr<const std::vector<uint32_t>> ChunkStreamer::GetIndices(
+    int n, uint32_t stitch) {
+  std::lock_guard<std::mutex> lock(index_mutex);
+
+  auto key = std::make_pair(n, stitch);
+  auto it = index_cache.find(key);
+  if (it != index_cache.end()) {
+    return it->second;
+  }
+
+  // Odd border vertices go to the previous even one, which is a vertex of
+  // the coarser neighbour. The triangles along the edge collapse or stretch,
+  // drop the collapsed ones.
+  auto snap = [n, stitch](uint32_t index) {
+    int i = index % n;
+    int j = index / n;
+    if ((j == 0     && (stitch & kStitchNegZ)) || 
+        (j == n - 1 && (stitch & kStitchPosZ))) {
+      i &= ~1;
+    }
+    if ((i == 0     && (stitch & kStitchNegX)) || 
+        (i == n - 1 && (stitch & kStitchPosX))) {
+      j &= ~1;
+    }
+    return (uint32_t)(j * n + i);
+  };
+
+  auto grid = GridMesh::GetIndices(n, n, GridMesh::kRowsToPositiveZ);
+  auto indices = std::make_shared<std::vector<uint32_t>>();
+  indices->reserve(grid->size());
+  for (size_t t = 0; t < grid->size(); t += 3) {
+    uint32_t a = snap((*grid)[t]);
+    uint32_t b = snap((*grid)[t + 1]);
+    uint32_t c = snap((*grid)[t + 2]);
+    if (a != b && b != c && a != c) {
+      indices->insert(indices->end(), {a, b, c});
+    }
+  }
+
+  index_cache.emplace(key, indices);
+  return indices;
+}
+
+std::unique_ptr<ChunkStreamer::Entry> ChunkStreamer::Build(const Key& key) const {
+  const int quads = params_.chunk_vertices - 1;
+  const int stride = 1 << key.lod;
+  const int n = (quads >> key.lod) + 1;
+  const int m = n + 2; // One texel apron for the normals
+  const float step = stride * params_.texel_size;
+
+  std::vector<float> heights((size_t)m * m);
+  generator_(key.x * quads - stride, key.z * quads - stride, stride, m, 
+             heights.data());
+  auto h = [&](int i, int j) { 
+    return heights[(size_t)(j + 1) * m + (i + 1)]; 
+  };
+
+  auto mesh = std::make_shared<Mesh>();
+  size_t n_vertices = (size_t)n * n;
+  mesh->vertices.resize(n_vertices);
+  mesh->normals.resize(n_vertices);
+  mesh->uv.resize(n_vertices);
+  if (colorizer_) {
+    mesh->colors.resize(n_vertices);
+  }
+
+  float min_y = std::numeric_limits<float>::max();
+  float max_y = std::numeric_limits<float>::lowest();
+  size_t v = 0;
+  for (int j = 0; j < n; ++j) {
+    for (int i = 0; i < n; ++i, ++v) {
+      float y = h(i, j);
+      min_y = std::min(min_y, y);
+      max_y = std::max(max_y, y);
+
+      // Central differences through the apron, same on both sides of a 
+      // border of the same level
+      float dhdx = (h(i + 1, j) - h(i - 1, j)) / (2 * step);
+      float dhdz = (h(i, j + 1) - h(i, j - 1)) / (2 * step);
+      glm::vec3 normal = glm::normalize(glm::vec3(-dhdx, 1, -dhdz));
+
+      mesh->vertices[v] = glm::vec3(i * step, y, j * step);
+      mesh->normals[v] = normal;
+      mesh->uv[v] = glm::vec2((float)i / (n - 1), (float)j / (n - 1));
+      if (colorizer_) {
+        mesh->colors[v] = colorizer_(y, normal);
+      }
+    }
+  }
+  mesh->indices = *GetIndices(n, 0);
+
+  float size = quads * params_.texel_size;
+  auto entry = std::make_unique<Entry>();
+  entry->chunk.key = key;
+  entry->chunk.mesh = mesh;
+  entry->chunk.origin = glm::vec3(key.x * size, 0, key.z * size);
+  entry->chunk.min = entry->chunk.origin + glm::vec3(0, min_y, 0);
+  entry->chunk.max = entry->chunk.origin + glm::vec3(size, max_y, size);
+  entry->chunk.stitch = 0;
+  return entry;
+}
+
+void ChunkStreamer::Work() {
+  for (;;) {
+    Key key;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_cv_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+      if (stop_) {
+        return;
+      }
+      key = queue_.front();
+      queue_.pop_front();
+      running_.insert(key);
+    }
+
+    auto entry = Build(key);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      running_.erase(key);
+      done_.push_back(std::move(entry));
+    }
+    done_cv_.notify_all();
+  }
+}
+
+void ChunkStreamer::Flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [this]() { return queue_.empty() && running_.empty(); });
+}
+
+void ChunkStreamer::Collect() {
+  std::vector<std::unique_ptr<Entry>> done;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    done.swap(done_);
+  }
+
+  for (auto& entry: done) {
+    Key key = entry->chunk.key;
+    if (entries_.count(key)) {
+      continue;
+    }
+    entry->lru = lru_.insert(lru_.end(), key);
+    entries_.emplace(key, std::move(entry));
+    stats_.generated++;
+  }
+}
+
+void ChunkStreamer::Request(const std::vector<Key>& keys) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Whatever was not started and is not needed anymore goes away
+    queue_.clear();
+    for (auto& key: keys) {
+      bool done = std::any_of(done_.begin(), done_.end(), 
+          [&key](const std::unique_ptr<Entry>& e) { return e->chunk.key == key; });
+      if (!done && !running_.count(key)) {
+        queue_.push_back(key);
+      }
+    }
+    stats_.pending = queue_.size() + running_.size();
+  }
+  work_cv_.notify_all();
+}
+
+void ChunkStreamer::Display(Cell& cell, Entry* entry) {
+  if (cell.entry) {
+    Undisplay(cell);
+  }
+  lru_.erase(entry->lru);
+  entry->displayed = true;
+  cell.entry = entry;
+  cell.lod = entry->chunk.key.lod;
+}
+
+void ChunkStreamer::Undisplay(Cell& cell) {
+  if (!cell.entry) {
+    return;
+  }
+  Entry* entry = cell.entry;
+  entry->displayed = false;
+  entry->lru = lru_.insert(lru_.end(), entry->chunk.key);
+  cell.entry = nullptr;
+  cell.lod = -1;
+}
+
+int ChunkStreamer::GetCellLod(int x, int z) const {
+  auto it = cells_.find(CellKey(x, z));
+  return it == cells_.end() ? -1 : it->second.lod;
+}
+
+void ChunkStreamer::Restitch() {
+  for (auto& kv: cells_) {
+    Entry* entry = kv.second.entry;
+    if (!entry) {
+      continue;
+    }
+
+    int x = kv.first.first;
+    int z = kv.first.second;
+    int lod = kv.second.lod;
+    uint32_t stitch = 0;
+    if (GetCellLod(x, z - 1) > lod) stitch |= kStitchNegZ;
+    if (GetCellLod(x + 1, z) > lod) stitch |= kStitchPosX;
+    if (GetCellLod(x, z + 1) > lod) stitch |= kStitchPosZ;
+    if (GetCellLod(x - 1, z) > lod) stitch |= kStitchNegX;
+
+    Chunk& chunk = entry->chunk;
+    if (stitch != chunk.stitch) {
+      int n = ((params_.chunk_vertices - 1) >> lod) + 1;
+      chunk.mesh->indices = *GetIndices(n, stitch);
+      chunk.stitch = stitch;
+      // The new uploads take the indices with the vertices
+      if (std::find(uploads_.begin(), uploads_.end(), &chunk) == uploads_.end()) {
+        restitched_.push_back(&chunk);
+      }
+    }
+  }
+}
+
+void ChunkStreamer::Evict() {
+  auto it = lru_.begin();
+  while ((int)lru_.size() > params_.cache_size && it != lru_.end()) {
+    auto entry = entries_.find(*it);
+    // Keep what is about to be displayed
+    if (entry->second->wanted == frame_) {
+      ++it;
+      continue;
+    }
+    if (entry->second->uploaded) {
+      released_.push_back(*it);
+    }
+    entries_.erase(entry);
+    it = lru_.erase(it);
+  }
+}
+
+void ChunkStreamer::Update(const glm::vec3& eye) {
+  frame_++;
+  visible_.clear();
+  uploads_.clear();
+  restitched_.clear();
+  released_.clear();
+  stats_.generated = 0;
+  stats_.uploaded = 0;
+  stats_.uploaded_vertices = 0;
+
+  Collect();
+
+  float size = GetChunkSize();
+  int cx = (int)std::floor(eye.x / size);
+  int cz = (int)std::floor(eye.z / size);
+  const int view = params_.view_distance;
+
+  // Out of the view
+  for (auto it = cells_.begin(); it != cells_.end();) {
+    if (Ring(it->first.first, it->first.second, cx, cz) > view) {
+      Undisplay(it->second);
+      it = cells_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  // Ring by ring, the nearest chunks are generated and uploaded first
+  std::vector<Key> requests;
+  int budget = params_.upload_budget;
+  for (int ring = 0; ring <= view; ++ring) {
+    int target = GetLod(ring);
+    int side = ring * 2 + 1;
+    int n_cells = ring == 0 ? 1 : ring * 8;
+    for (int c = 0; c < n_cells; ++c) {
+      int x, z;
+      if (ring == 0) {
+        x = cx; z = cz;
+      } else if (c < side) {
+        x = cx - ring + c; z = cz - ring;
+      } else if (c < side * 2) {
+        x = cx - ring + c - side; z = cz + ring;
+      } else {
+        int k = c - side * 2; // side - 2 cells per vertical edge
+        x = k < side - 2 ? cx - ring : cx + ring;
+        z = cz - ring + 1 + k % (side - 2);
+      }
+
+      Cell& cell = cells_[CellKey(x, z)];
+      if (cell.lod == target) {
+        continue;
+      }
+
+      // Nearest level to the target which keeps the neighbours within one
+      // level, the rest of the way is done in the next frames
+      int lo = 0;
+      int hi = params_.lod_levels - 1;
+      for (int lod: {GetCellLod(x, z - 1), GetCellLod(x + 1, z), 
+                     GetCellLod(x, z + 1), GetCellLod(x - 1, z)}) {
+        if (lod >= 0) {
+          lo = std::max(lo, lod - 1);
+          hi = std::min(hi, lod + 1);
+        }
+      }
+      int lod = std::max(lo, std::min(hi, target));
+      if (lod == cell.lod) {
+        continue;
+      }
+
+      Key key{x, z, lod};
+      auto it = entries_.find(key);
+      if (it == entries_.end()) {
+        if (!workers_.empty()) {
+          requests.push_back(key);
+          continue;
+        }
+        auto entry = Build(key);
+        entry->lru = lru_.insert(lru_.end(), key);
+        it = entries_.emplace(key, std::move(entry)).first;
+        stats_.generated++;
+      }
+
+      Entry* entry = it->second.get();
+      entry->wanted = frame_;
+      if (!entry->uploaded) {
+        int n_vertices = (int)entry->chunk.mesh->vertices.size();
+        if (!uploads_.empty() && n_vertices > budget) {
+          continue;
+        }
+        budget -= n_vertices;
+        entry->uploaded = true;
+        uploads_.push_back(&entry->chunk);
+        stats_.uploaded++;
+        stats_.uploaded_vertices += n_vertices;
+      }
+      Display(cell, entry);
+    }
+  }
+
+  if (!workers_.empty()) {
+    Request(requests);
+  }
+
+  Restitch();
+  Evict();
+
+  for (auto& kv: cells_) {
+    if (kv.second.entry) {
+      visible_.push_back(&kv.second.entry->chunk);
+    }
+  }
+
+  stats_.displayed = visible_.size();
+  stats_.cached = lru_.size();
+  stats_.restitched = restitched_.size();
+  stats_.released = released_.size();
+}
+
+}
@@ -0,0 +1,216 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _CHUNKSTREAMER_H_779D4EE4_8299_4CEF_95C7_373F3F7C8D63_
+#define _CHUNKSTREAMER_H_779D4EE4_8299_4CEF_95C7_373F3F7C8D63_ 
+
+#include "mesh.h"
+#include "glm_main.h"
+#include "image/colormap.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace Terrain {
+
+//////////////////////////////////////////////////////////////////////////////
+// Streams terrain around the camera as a grid of square chunks.
+//
+// The chunks are generated on the worker threads, handed out for the upload
+// within a per-frame budget (vertices), and kept in an LRU cache after they
+// leave the view until the cache is full. The streamer knows nothing about
+// GL: after Update() the owner uploads GetUploads(), re-uploads the indices
+// of GetRestitched(), frees GetReleased() and draws GetVisible().
+//
+// LOD is by the ring around the camera chunk: rings closer than lod_distance
+// are level 0, every next level is twice as far. Level l has 
+// (chunk_vertices - 1) >> l quads per side. Neighbours never differ by more 
+// than one level, the finer chunk snaps its odd border vertices to the 
+// coarser edge (index buffer only, 16 variants per level), so there are no
+// cracks. A chunk only switches its level when the new mesh is ready and 
+// the switch keeps the neighbours within one level, so the displayed grid 
+// is always seam-free.
+//
+// Heights come from the generator, in texels: texel (x, z) is at 
+// (x * texel_size, z * texel_size) in world space, chunk (cx, cz) starts at
+// texel (cx, cz) * (chunk_vertices - 1). The generator is called from the
+// workers and must be thread safe:
+//
+// void generator(int x0, int z0, int stride, int n, float* out);
+//   out[j * n + i] = height(x0 + i * stride, z0 + j * stride)
+//////////////////////////////////////////////////////////////////////////////
+class ChunkStreamer {
+ public:
+  using Generator = std::function<void(int x0, int z0, int stride, int n, 
+                                       float* out)>;
+  using Colorizer = std::function<Color(float height, const glm::vec3& normal)>;
+
+  struct Params {
+    int   chunk_vertices = 65;    // Per side, 2^k + 1, k >= lod_levels - 1
+    float texel_size     = 1;     // World units between level 0 vertices
+    int   lod_levels     = 4;
+    int   lod_distance   = 2;     // Rings of level 0, >= 1
+    int   view_distance  = 8;     // Rings around the camera chunk
+    int   cache_size     = 64;    // Chunks kept beyond the displayed ones
+    int   upload_budget  = 65536; // Vertices per frame, at least one chunk
+    int   n_workers      = 1;     // 0 - generate in Update()
+  };
+
+  // Edges snapped to the coarser neighbour
+  enum Stitch : uint32_t {
+    kStitchNegZ = 1, // Row 0
+    kStitchPosX = 2, // Last column
+    kStitchPosZ = 4, // Last row
+    kStitchNegX = 8  // Column 0
+  };
+
+  struct Key {
+    int x;
+    int z;
+    int lod;
+
+    bool operator<(const Key& k) const {
+      if (x != k.x) return x < k.x;
+      if (z != k.z) return z < k.z;
+      return lod < k.lod;
+    }
+    bool operator==(const Key& k) const {
+      return x == k.x && z == k.z && lod == k.lod;
+    }
+  };
+
+  struct Chunk {
+    Key                   key;
+    std::shared_ptr<Mesh> mesh;   // Local space, origin at the chunk corner
+    glm::vec3             origin; // World position of the chunk corner
+    glm::vec3             min;    // World space bounds
+    glm::vec3             max;
+    uint32_t              stitch;
+  };
+
+  struct Stats {
+    size_t displayed   = 0;
+    size_t cached      = 0; // Generated, not displayed
+    size_t pending     = 0; // Queued and being generated
+    size_t generated   = 0; // Since the last Update()
+    size_t uploaded    = 0;
+    size_t uploaded_vertices = 0;
+    size_t restitched  = 0;
+    size_t released    = 0;
+  };
+
+  ChunkStreamer(const Params& params, Generator generator, 
+                Colorizer colorizer = nullptr);
+  ~ChunkStreamer();
+
+  ChunkStreamer(const ChunkStreamer&) = delete;
+  ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+
+  void Update(const glm::vec3& eye);
+
+  // Blocks until the workers are done with the queue
+  void Flush();
+
+  const std::vector<const Chunk*>& GetVisible() const { return visible_; }
+  const std::vector<const Chunk*>& GetUploads() const { return uploads_; }
+  const std::vector<const Chunk*>& GetRestitched() const { return restitched_; }
+  const std::vector<Key>& GetReleased() const { return released_; }
+
+  const Params& GetParams() const { return params_; }
+  const Stats& GetStats() const { return stats_; }
+  float GetChunkSize() const { 
+    return (params_.chunk_vertices - 1) * params_.texel_size; 
+  }
+
+  // Desired level of a chunk, by the ring around the camera chunk
+  int GetLod(int ring) const;
+
+  // Grid triangles of a n x n chunk with the stitched edges, shared
+  static std::shared_ptr<const std::vector<uint32_t>> GetIndices(
+      int n, uint32_t stitch);
+
+ private:
+  struct Entry {
+    Chunk                           chunk;
+    bool                            uploaded = false;
+    bool                            displayed = false;
+    std::list<Key>::iterator        lru;
+    uint32_t                        wanted = 0; // Frame it was needed last
+  };
+
+  struct Cell {
+    int    lod = -1; // Displayed level, -1 - nothing
+    Entry* entry = nullptr;
+  };
+
+  using CellKey = std::pair<int, int>;
+
+  std::unique_ptr<Entry> Build(const Key& key) const;
+  void Work();
+  void Collect();
+  void Request(const std::vector<Key>& keys);
+  void Display(Cell& cell, Entry* entry);
+  void Undisplay(Cell& cell);
+  void Restitch();
+  void Evict();
+  int GetCellLod(int x, int z) const;
+
+  Params                                    params_;
+  Generator                                 generator_;
+  Colorizer                                 colorizer_;
+
+  std::map<Key, std::unique_ptr<Entry>>     entries_;
+  std::map<CellKey, Cell>                   cells_;
+  std::list<Key>                            lru_; // Front - oldest
+
+  std::vector<const Chunk*>                 visible_;
+  std::vector<const Chunk*>                 uploads_;
+  std::vector<const Chunk*>                 restitched_;
+  std::vector<Key>                          released_;
+  Stats                                     stats_;
+  uint32_t                                  frame_;
+
+  // Workers
+  std::vector<std::thread>                  workers_;
+  std::mutex                                mutex_;
+  std::condition_variable                   work_cv_;
+  std::condition_variable                   done_cv_;
+  std::deque<Key>                           queue_;   // Nearest first
+  std::set<Key>                             running_;
+  std::vector<std::unique_ptr<Entry>>       done_;
+  bool                                      stop_;
+};
+
+}
+
+#endif // _CHUNKSTREAMER_H_779D4EE4_8299_4CEF_95C7_373F3F7C8D63_
@@ -0,0 +1,334 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "quadtree.h"
+#include "camera.h"
+#include "common/logging.h"
+#include "common/parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Terrain {
+
+namespace {
+
+// Child c = (z & 1) << 1 | (x & 1), the cut is kept in this order
+QuadTree::Node Child(const QuadTree::Node& node, int c) {
+  return QuadTree::Node{node.level + 1, 
+                        node.x * 2 + (c & 1), 
+                        node.z * 2 + (c >> 1)};
+}
+
+QuadTree::Node Parent(const QuadTree::Node& node) {
+  return QuadTree::Node{node.level - 1, node.x / 2, node.z / 2};
+}
+
+int ChildIndex(const QuadTree::Node& node) {
+  return (node.z & 1) << 1 | (node.x & 1);
+}
+
+bool SameParent(const QuadTree::Node& a, const QuadTree::Node& b) {
+  return a.level == b.level && a.x / 2 == b.x / 2 && a.z / 2 == b.z / 2;
+}
+
+// Merge the dirty slots closer than this into one upload
+const size_t kMergeGap = 8;
+
+}
+
+QuadTree::QuadTree(const Params& params, const Array2d<float>& heights)
+  : params_(params), 
+    eye_(0), 
+    frustum_(nullptr), 
+    frame_(0) {
+  if (params_.levels < 0 || params_.levels > 24) {
+    ABORT_F("QuadTree levels must be in [0, 24], got %d", params_.levels);
+  }
+  if (heights.GetWidth() < 1 || heights.GetHeight() < 1) {
+    ABORT_F("QuadTree needs a heightmap");
+  }
+
+  // No point in cells smaller than a texel
+  int texel_levels = 0;
+  while (((size_t)2 << texel_levels) <= 
+         std::min(heights.GetWidth(), heights.GetHeight())) {
+    ++texel_levels;
+  }
+  max_bounds_level_ = std::min({params_.levels, params_.bounds_levels, 
+                                texel_levels});
+  max_bounds_level_ = std::max(max_bounds_level_, 0);
+  BuildBounds(heights);
+
+  cut_.push_back(Node{0, 0, 0});
+}
+
+void QuadTree::BuildBounds(const Array2d<float>& heights) {
+  bounds_.resize(LevelOffset(max_bounds_level_ + 1));
+
+  // Deepest level straight from the heightmap. A cell takes the texels 
+  // under it plus one around, the terrain is sampled with bilinear filter.
+  int    level  = max_bounds_level_;
+  int    n      = 1 << level;
+  size_t offset = LevelOffset(level);
+  int    width  = heights.GetWidth();
+  int    height = heights.GetHeight();
+  const float* texels = heights.GetArray();
+
+  auto texel_range = [](int cell, int n_cells, int n_texels, int& t0, int& t1) {
+    float u0 = (float)cell / n_cells * n_texels - 0.5f;
+    float u1 = (float)(cell + 1) / n_cells * n_texels - 0.5f;
+    t0 = std::max((int)std::floor(u0), 0);
+    t1 = std::min((int)std::ceil(u1), n_texels - 1);
+  };
+
+  ParallelFor(0, n, 0, [&](int z_begin, int z_end) {
+    for (int z = z_begin; z < z_end; ++z) {
+      int j0, j1;
+      texel_range(z, n, height, j0, j1);
+      for (int x = 0; x < n; ++x) {
+        int i0, i1;
+        texel_range(x, n, width, i0, i1);
+        glm::vec2 b(std::numeric_limits<float>::max(), 
+                    std::numeric_limits<float>::lowest());
+        for (int j = j0; j <= j1; ++j) {
+          for (int i = i0; i <= i1; ++i) {
+            float h = texels[i + j * width];
+            b.x = std::min(b.x, h);
+            b.y = std::max(b.y, h);
+          }
+        }
+        bounds_[offset + x + z * n] = b;
+      }
+    }
+  });
+
+  // The rest from the children
+  for (level = max_bounds_level_ - 1; level >= 0; --level) {
+    n = 1 << level;
+    offset = LevelOffset(level);
+    size_t child_offset = LevelOffset(level + 1);
+    for (int z = 0; z < n; ++z) {
+      for (int x = 0; x < n; ++x) {
+        glm::vec2 b(std::numeric_limits<float>::max(), 
+                    std::numeric_limits<float>::lowest());
+        for (int c = 0; c < 4; ++c) {
+          int cx = x * 2 + (c & 1);
+          int cz = z * 2 + (c >> 1);
+          const glm::vec2& cb = bounds_[child_offset + cx + cz * n * 2];
+          b.x = std::min(b.x, cb.x);
+          b.y = std::max(b.y, cb.y);
+        }
+        bounds_[offset + x + z * n] = b;
+      }
+    }
+  }
+}
+
+void QuadTree::GetBounds(const Node& node, glm::vec3& min, glm::vec3& max) const {
+  float half = params_.half_size / (1 << node.level);
+  min.x = -params_.half_size + node.x * 2 * half;
+  min.z = -params_.half_size + node.z * 2 * half;
+  max.x = min.x + 2 * half;
+  max.z = min.z + 2 * half;
+
+  int level = std::min(node.level, max_bounds_level_);
+  int shift = node.level - level;
+  uint32_t x = node.x >> shift;
+  uint32_t z = node.z >> shift;
+  const glm::vec2& b = bounds_[LevelOffset(level) + x + z * ((size_t)1 << level)];
+  min.y = b.x;
+  max.y = b.y;
+}
+
+bool QuadTree::IsVisible(const Node& node) {
+  glm::vec3 min, max;
+  GetBounds(node, min, max);
+  ++stats_.frustum_tests;
+  return frustum_->TestAabb(min, max);
+}
+
+bool QuadTree::ShouldSplit(const Node& node) {
+  if (node.level >= params_.levels) {
+    return false;
+  }
+
+  glm::vec3 min, max;
+  GetBounds(node, min, max);
+  glm::vec3 d = glm::max(glm::max(min - eye_, eye_ - max), glm::vec3(0));
+  float half = params_.half_size / (1 << node.level);
+  if (glm::dot(d, d) >= half * half * params_.split_distance * params_.split_distance) {
+    return false;
+  }
+
+  ++stats_.frustum_tests;
+  return frustum_->TestAabb(min, max);
+}
+
+void QuadTree::Refine(const Node& node) {
+  if (ShouldSplit(node)) {
+    for (int c = 0; c < 4; ++c) {
+      Refine(Child(node, c));
+    }
+  } else {
+    Emit(node);
+  }
+}
+
+// Appends to the new cut and folds the complete sibling groups at the 
+// tail back into their parent while the parent does not want the split.
+void QuadTree::Emit(const Node& node) {
+  next_.push_back(node);
+
+  while (next_.size() >= 4) {
+    size_t n = next_.size();
+    const Node& last = next_[n - 1];
+    if (last.level == 0 || ChildIndex(last) != 3) {
+      break;
+    }
+
+    bool siblings = true;
+    for (int c = 0; c < 3 && siblings; ++c) {
+      const Node& sibling = next_[n - 4 + c];
+      siblings = SameParent(sibling, last) && ChildIndex(sibling) == c;
+    }
+
+    Node parent = Parent(last);
+    if (!siblings || ShouldSplit(parent)) {
+      break;
+    }
+
+    next_.resize(n - 4);
+    next_.push_back(parent);
+    ++stats_.merges;
+  }
+}
+
+void QuadTree::Update(const glm::vec3& eye, const Frustum& frustum) {
+  stats_ = Stats();
+  eye_ = eye;
+  frustum_ = &frustum;
+
+  next_.clear();
+  for (const Node& node: cut_) {
+    if (ShouldSplit(node)) {
+      ++stats_.splits;
+      for (int c = 0; c < 4; ++c) {
+        Refine(Child(node, c));
+      }
+    } else {
+      Emit(node);
+    }
+  }
+  cut_.swap(next_);
+  stats_.cut = cut_.size();
+
+  UpdatePatches();
+  frustum_ = nullptr;
+}
+
+void QuadTree::UpdatePatches() {
+  ++frame_;
+  added_.clear();
+  dirty_.clear();
+  dirty_ranges_.clear();
+
+  for (const Node& node: cut_) {
+    if (!IsVisible(node)) {
+      continue;
+    }
+    ++stats_.visible;
+    auto it = slots_.find(Key(node));
+    if (it != slots_.end()) {
+      stamps_[it->second] = frame_;
+    } else {
+      added_.push_back(node);
+    }
+  }
+
+  // Swap-remove the stale ones. Going from the back, so the patch moved 
+  // into the hole is always a live one.
+  for (size_t slot = patches_.size(); slot-- > 0;) {
+    if (stamps_[slot] == frame_) {
+      continue;
+    }
+    ++stats_.removed;
+    slots_.erase(keys_[slot]);
+
+    size_t last = patches_.size() - 1;
+    if (slot != last) {
+      patches_[slot] = patches_[last];
+      keys_[slot] = keys_[last];
+      stamps_[slot] = stamps_[last];
+      slots_[keys_[slot]] = slot;
+      dirty_.push_back(slot);
+    }
+    patches_.pop_back();
+    keys_.pop_back();
+    stamps_.pop_back();
+  }
+
+  for (const Node& node: added_) {
+    glm::vec3 min, max;
+    GetBounds(node, min, max);
+    float half = (max.x - min.x) / 2;
+
+    Patch patch;
+    patch.offset_size = glm::vec4(min.x + half, 0, min.z + half, half);
+    patch.lod = glm::vec4(node.level, params_.levels, min.y, max.y);
+
+    size_t slot = patches_.size();
+    patches_.push_back(patch);
+    keys_.push_back(Key(node));
+    stamps_.push_back(frame_);
+    slots_[Key(node)] = slot;
+    dirty_.push_back(slot);
+  }
+  stats_.added = added_.size();
+
+  // Dirty slots to upload ranges
+  std::sort(dirty_.begin(), dirty_.end());
+  for (size_t slot: dirty_) {
+    if (slot >= patches_.size()) {
+      break; // Moved and popped later on
+    }
+    if (!dirty_ranges_.empty()) {
+      auto& range = dirty_ranges_.back();
+      size_t end = range.first + range.second;
+      if (slot < end) {
+        continue;
+      }
+      if (slot - end <= kMergeGap) {
+        range.second = slot + 1 - range.first;
+        continue;
+      }
+    }
+    dirty_ranges_.emplace_back(slot, 1);
+  }
+  for (auto& range: dirty_ranges_) {
+    stats_.uploaded += range.second;
+  }
+}
+
+}
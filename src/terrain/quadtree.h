@@ -0,0 +1,148 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _QUADTREE_H_9D9F0811_501E_4AA7_B22F_8E7B0B8E3697_
+#define _QUADTREE_H_9D9F0811_501E_4AA7_B22F_8E7B0B8E3697_ 
+
+#include "glm_main.h"
+#include "common/array2d.h"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class Frustum;
+
+namespace Terrain {
+
+//////////////////////////////////////////////////////////////////////////////
+// Terrain LOD quadtree.
+//
+// The tree is implicit, a node is (level, x, z) and the children are found
+// by index. Per-node min/max heights are kept in a flat array, level by
+// level, built once from the heightmap; they make tight AABBs for the
+// frustum and LOD tests.
+//
+// The selection (the "cut" of the tree, leaves of the refined tree) is kept
+// between the frames in depth-first order. Update() only splits and merges
+// what changed, so a still camera costs one pass over the cut.
+//
+// The visible patches are kept in a compact array. Patches that did not
+// change keep their slot, GetDirtyRanges() tells which slots have to be
+// re-uploaded after Update().
+//
+// Root is centered at the origin, covers [-half_size, half_size] in xz.
+// heights - elevations in world units over the whole root, row 0 at -z.
+//////////////////////////////////////////////////////////////////////////////
+class QuadTree {
+ public:
+  struct Params {
+    int   levels         = 8;    // Max depth, root is 0, up to 24
+    float half_size      = 1000;
+    float split_distance = 10;   // Split when closer than this * node half size
+    int   bounds_levels  = 10;   // Deeper nodes use the bounds of the ancestor
+  };
+
+  struct Node {
+    int      level;
+    uint32_t x;
+    uint32_t z;
+  };
+
+  // Per-instance data, AttributeLayout<true, glm::vec4, glm::vec4>
+  struct Patch {
+    glm::vec4 offset_size; // xyz - node center, w - node half size
+    glm::vec4 lod;         // level, max level, min height, max height
+  };
+
+  struct Stats {
+    size_t cut           = 0;
+    size_t visible       = 0;
+    size_t splits        = 0;
+    size_t merges        = 0;
+    size_t added         = 0;
+    size_t removed       = 0;
+    size_t uploaded      = 0; // Patches in the dirty ranges
+    size_t frustum_tests = 0;
+  };
+
+  QuadTree(const Params& params, const Array2d<float>& heights);
+
+  void Update(const glm::vec3& eye, const Frustum& frustum);
+
+  const std::vector<Patch>& GetPatches() const { return patches_; }
+
+  // [first, first + count) ranges of GetPatches() changed by the last Update()
+  const std::vector<std::pair<size_t, size_t>>& GetDirtyRanges() const { 
+    return dirty_ranges_; 
+  }
+
+  const std::vector<Node>& GetCut() const { return cut_; }
+  const Params& GetParams() const { return params_; }
+  const Stats& GetStats() const { return stats_; }
+  size_t GetBoundsCount() const { return bounds_.size(); }
+
+  void GetBounds(const Node& node, glm::vec3& min, glm::vec3& max) const;
+
+ private:
+  static size_t LevelOffset(int level) {
+    return (((size_t)1 << (2 * level)) - 1) / 3;
+  }
+
+  static uint64_t Key(const Node& node) {
+    return (uint64_t)node.level << 48 | (uint64_t)node.x << 24 | node.z;
+  }
+
+  void BuildBounds(const Array2d<float>& heights);
+  bool IsVisible(const Node& node);
+  bool ShouldSplit(const Node& node);
+  void Refine(const Node& node);
+  void Emit(const Node& node);
+  void UpdatePatches();
+
+  Params                                  params_;
+  int                                     max_bounds_level_;
+  std::vector<glm::vec2>                  bounds_; // min, max height
+
+  std::vector<Node>                       cut_;
+  std::vector<Node>                       next_;
+  glm::vec3                               eye_;
+  const Frustum*                          frustum_;
+
+  std::vector<Patch>                      patches_;
+  std::vector<uint64_t>                   keys_;
+  std::vector<uint32_t>                   stamps_;
+  std::unordered_map<uint64_t, size_t>    slots_;
+  std::vector<Node>                       added_;
+  std::vector<size_t>                     dirty_;
+  std::vector<std::pair<size_t, size_t>>  dirty_ranges_;
+  uint32_t                                frame_;
+
+  Stats                                   stats_;
+};
+
+}
+
+#endif // _QUADTREE_H_9D9F0811_501E_4AA7_B22F_8E7B0B8E3697_
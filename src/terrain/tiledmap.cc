@@ -0,0 +1,461 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "tiledmap.h"
+#include "common/logging.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Terrain {
+
+namespace {
+
+const char     kMagic[4]  = {'B', '3', 'D', 'T'};
+const uint32_t kVersion   = 1;
+const uint64_t kAlignment = 4096;
+const int      kTexelSize = 4; // float or rgba8
+
+struct Header {
+  char     magic[4];
+  uint32_t version;
+  uint32_t format;
+  uint32_t width;
+  uint32_t height;
+  uint32_t tile_size;
+  uint32_t n_mips;
+  uint32_t reserved;
+  uint64_t directory; // Offset of the tile directory
+};
+
+uint64_t Align(uint64_t offset) {
+  return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+int TileCount(int size, int tile_size) {
+  return (size + tile_size - 1) / tile_size;
+}
+
+float Luminance(const Color32& c) {
+  return (0.2126f * c.r + 0.7152f * c.g + 0.0722f * c.b) / 255.0f;
+}
+
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// TiledMap
+//////////////////////////////////////////////////////////////////////////////
+std::shared_ptr<TiledMap> TiledMap::Open(const std::string& filename) {
+  std::shared_ptr<TiledMap> map(new TiledMap());
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, 
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    ABORT_F("Cant open file %s", filename.c_str());
+  }
+  LARGE_INTEGER size;
+  GetFileSizeEx(file, &size);
+  map->size_ = (size_t)size.QuadPart;
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (!mapping) {
+    ABORT_F("Cant map file %s", filename.c_str());
+  }
+  map->handle_ = mapping;
+  map->data_ = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    ABORT_F("Cant open file %s", filename.c_str());
+  }
+  struct stat st;
+  fstat(fd, &st);
+  map->size_ = (size_t)st.st_size;
+  void* data = map->size_ ? 
+      mmap(nullptr, map->size_, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+  close(fd);
+  map->data_ = data != MAP_FAILED ? (const uint8_t*)data : nullptr;
+#endif
+  if (!map->data_ || map->size_ < sizeof(Header)) {
+    ABORT_F("Cant map file %s", filename.c_str());
+  }
+
+  Header header;
+  memcpy(&header, map->data_, sizeof(header));
+  if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || 
+      header.version != kVersion) {
+    ABORT_F("%s is not a tiled map", filename.c_str());
+  }
+  if ((header.format != kFloat32 && header.format != kRgba8) || 
+      header.tile_size == 0 || header.width == 0 || header.height == 0 ||
+      header.n_mips == 0) {
+    ABORT_F("%s: bad tiled map header", filename.c_str());
+  }
+
+  map->format_ = (Format)header.format;
+  map->tile_size_ = header.tile_size;
+
+  uint64_t tile_bytes = (uint64_t)header.tile_size * header.tile_size * kTexelSize;
+  uint64_t directory = header.directory;
+  int width = header.width, height = header.height;
+  for (uint32_t i = 0; i < header.n_mips; ++i) {
+    Mip mip;
+    mip.width = width;
+    mip.height = height;
+    mip.tiles_x = TileCount(width, header.tile_size);
+    mip.tiles_y = TileCount(height, header.tile_size);
+
+    uint64_t n_entries = (uint64_t)mip.tiles_x * mip.tiles_y;
+    if (directory + n_entries * sizeof(Entry) > map->size_) {
+      ABORT_F("%s: truncated tile directory", filename.c_str());
+    }
+    mip.entries = (const Entry*)(map->data_ + directory);
+    for (uint64_t t = 0; t < n_entries; ++t) {
+      if (mip.entries[t].offset + tile_bytes > map->size_) {
+        ABORT_F("%s: truncated tile", filename.c_str());
+      }
+    }
+    directory += n_entries * sizeof(Entry);
+    map->mips_.push_back(mip);
+
+    width = std::max(1, (width + 1) / 2);
+    height = std::max(1, (height + 1) / 2);
+  }
+
+  return map;
+}
+
+TiledMap::~TiledMap() {
+#ifdef _WIN32
+  if (data_) {
+    UnmapViewOfFile(data_);
+  }
+  if (handle_) {
+    CloseHandle(handle_);
+  }
+#else
+  if (data_) {
+    munmap((void*)data_, size_);
+  }
+#endif
+}
+
+const TiledMap::Entry& TiledMap::GetEntry(int tx, int ty, int mip) const {
+  const Mip& m = mips_.at(mip);
+  if (tx < 0 || ty < 0 || tx >= m.tiles_x || ty >= m.tiles_y) {
+    ABORT_F("Tile %d,%d is out of the map %dx%d", tx, ty, m.tiles_x, m.tiles_y);
+  }
+  return m.entries[tx + ty * m.tiles_x];
+}
+
+float TiledMap::GetTileMin(int tx, int ty, int mip) const {
+  return GetEntry(tx, ty, mip).min;
+}
+
+float TiledMap::GetTileMax(int tx, int ty, int mip) const {
+  return GetEntry(tx, ty, mip).max;
+}
+
+const float* TiledMap::GetHeights(int tx, int ty, int mip) const {
+  assert(format_ == kFloat32);
+  return (const float*)(data_ + GetEntry(tx, ty, mip).offset);
+}
+
+const Color32* TiledMap::GetColors(int tx, int ty, int mip) const {
+  assert(format_ == kRgba8);
+  return (const Color32*)(data_ + GetEntry(tx, ty, mip).offset);
+}
+
+const uint8_t* TiledMap::GetTexel(int x, int y, int mip) const {
+  const Mip& m = mips_.at(mip);
+  x = std::min(std::max(x, 0), m.width - 1);
+  y = std::min(std::max(y, 0), m.height - 1);
+  const Entry& entry = m.entries[x / tile_size_ + y / tile_size_ * m.tiles_x];
+  size_t texel = (size_t)(y % tile_size_) * tile_size_ + x % tile_size_;
+  return data_ + entry.offset + texel * kTexelSize;
+}
+
+float TiledMap::GetHeight(int x, int y, int mip) const {
+  assert(format_ == kFloat32);
+  float h;
+  memcpy(&h, GetTexel(x, y, mip), sizeof(h));
+  return h;
+}
+
+Color TiledMap::GetColor(int x, int y, int mip) const {
+  assert(format_ == kRgba8);
+  const uint8_t* c = GetTexel(x, y, mip);
+  return Rgba(c[0], c[1], c[2], c[3]);
+}
+
+void TiledMap::Evict(int tx, int ty, int mip) const {
+#ifndef _WIN32
+  size_t page = sysconf(_SC_PAGESIZE);
+  size_t begin = GetEntry(tx, ty, mip).offset / page * page;
+  size_t end = GetEntry(tx, ty, mip).offset + 
+               (size_t)tile_size_ * tile_size_ * kTexelSize;
+  madvise((void*)(data_ + begin), end - begin, MADV_DONTNEED);
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// TiledMapWriter
+//////////////////////////////////////////////////////////////////////////////
+struct TiledMapWriter::Level {
+  int                        width;
+  int                        height;
+  int                        tiles_x;
+  int                        tiles_y;
+  int                        row        = 0; // Rows added so far
+  int                        band_rows  = 0; // Rows in the band
+  std::vector<uint8_t>       band;           // tile_size rows, padded width
+  std::vector<uint8_t>       previous;       // Even row waiting for the pair
+  std::vector<TiledMap::Entry> entries;
+};
+
+TiledMapWriter::TiledMapWriter(const std::string& filename, 
+                               TiledMap::Format format, 
+                               int width, int height, 
+                               int tile_size, bool mips) 
+  : filename_(filename), 
+    format_(format), 
+    tile_size_(tile_size), 
+    closed_(false) {
+  if (width < 1 || height < 1 || tile_size < 1) {
+    ABORT_F("Bad tiled map size %dx%d, tile %d", width, height, tile_size);
+  }
+
+  do {
+    std::unique_ptr<Level> level(new Level());
+    level->width = width;
+    level->height = height;
+    level->tiles_x = TileCount(width, tile_size);
+    level->tiles_y = TileCount(height, tile_size);
+    level->band.resize((size_t)level->tiles_x * tile_size * tile_size * kTexelSize);
+    level->entries.resize((size_t)level->tiles_x * level->tiles_y);
+    levels_.push_back(std::move(level));
+
+    width = std::max(1, (width + 1) / 2);
+    height = std::max(1, (height + 1) / 2);
+  } while (mips && (levels_.back()->tiles_x > 1 || levels_.back()->tiles_y > 1));
+
+  out_.open(filename_, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!out_.is_open()) {
+    ABORT_F("Cant open file %s", filename_.c_str());
+  }
+  // Header goes last, when the directory is known
+  std::vector<char> zeros(kAlignment, 0);
+  out_.write(zeros.data(), zeros.size());
+}
+
+TiledMapWriter::~TiledMapWriter() {
+  if (!closed_) {
+    Close();
+  }
+}
+
+void TiledMapWriter::AddRow(const float* heights) {
+  assert(format_ == TiledMap::kFloat32);
+  AddRow(0, (const uint8_t*)heights);
+}
+
+void TiledMapWriter::AddRow(const Color32* colors) {
+  assert(format_ == TiledMap::kRgba8);
+  AddRow(0, (const uint8_t*)colors);
+}
+
+void TiledMapWriter::AddRow(int index, const uint8_t* row) {
+  Level& level = *levels_[index];
+  if (level.row >= level.height) {
+    ABORT_F("%s: too many rows", filename_.c_str());
+  }
+
+  // Copy, repeating the last texel up to the tile border
+  size_t row_bytes = (size_t)level.tiles_x * tile_size_ * kTexelSize;
+  uint8_t* dst = &level.band[level.band_rows * row_bytes];
+  memcpy(dst, row, (size_t)level.width * kTexelSize);
+  for (size_t x = level.width; x < (size_t)level.tiles_x * tile_size_; ++x) {
+    memcpy(dst + x * kTexelSize, row + (level.width - 1) * kTexelSize, kTexelSize);
+  }
+  ++level.row;
+  ++level.band_rows;
+
+  // Next mip gets the average of each pair of rows, the odd last row pairs 
+  // with itself
+  if (index + 1 < (int)levels_.size()) {
+    bool even = level.row % 2 == 1;
+    bool last = level.row == level.height;
+    if (even && !last) {
+      level.previous.assign(dst, dst + row_bytes);
+    } else {
+      std::vector<uint8_t> half((size_t)levels_[index + 1]->width * kTexelSize);
+      const uint8_t* a = even ? dst : level.previous.data();
+      Downsample(a, dst, level.width, half.data());
+      AddRow(index + 1, half.data());
+    }
+  }
+
+  if (level.band_rows == tile_size_ || level.row == level.height) {
+    FlushBand(level);
+  }
+}
+
+void TiledMapWriter::Downsample(const uint8_t* a, const uint8_t* b, 
+                                int width, uint8_t* out) const {
+  int half = std::max(1, (width + 1) / 2);
+  for (int x = 0; x < half; ++x) {
+    int x0 = std::min(2 * x, width - 1);
+    int x1 = std::min(2 * x + 1, width - 1);
+    if (format_ == TiledMap::kFloat32) {
+      float t[4];
+      memcpy(&t[0], a + x0 * kTexelSize, 4);
+      memcpy(&t[1], a + x1 * kTexelSize, 4);
+      memcpy(&t[2], b + x0 * kTexelSize, 4);
+      memcpy(&t[3], b + x1 * kTexelSize, 4);
+      float avg = (t[0] + t[1] + t[2] + t[3]) / 4;
+      memcpy(out + x * kTexelSize, &avg, 4);
+    } else {
+      for (int c = 0; c < 4; ++c) {
+        int sum = a[x0 * 4 + c] + a[x1 * 4 + c] + b[x0 * 4 + c] + b[x1 * 4 + c];
+        out[x * 4 + c] = (uint8_t)((sum + 2) / 4);
+      }
+    }
+  }
+}
+
+void TiledMapWriter::FlushBand(Level& level) {
+  size_t row_bytes = (size_t)level.tiles_x * tile_size_ * kTexelSize;
+
+  // Pad the last band with the last row
+  for (int r = level.band_rows; r < tile_size_; ++r) {
+    memcpy(&level.band[r * row_bytes], &level.band[(level.band_rows - 1) * row_bytes], 
+           row_bytes);
+  }
+
+  int ty = (level.row - 1) / tile_size_;
+  int rows = level.band_rows;
+  for (int tx = 0; tx < level.tiles_x; ++tx) {
+    // Min/max over the real texels only
+    float min = std::numeric_limits<float>::max();
+    float max = std::numeric_limits<float>::lowest();
+    int x_end = std::min(tile_size_, level.width - tx * tile_size_);
+    for (int r = 0; r < rows; ++r) {
+      const uint8_t* texel = &level.band[r * row_bytes + (size_t)tx * tile_size_ * kTexelSize];
+      for (int x = 0; x < x_end; ++x, texel += kTexelSize) {
+        float v;
+        if (format_ == TiledMap::kFloat32) {
+          memcpy(&v, texel, sizeof(v));
+        } else {
+          v = Luminance(*(const Color32*)texel);
+        }
+        min = std::min(min, v);
+        max = std::max(max, v);
+      }
+    }
+
+    uint64_t offset = Align(out_.tellp());
+    out_.seekp(offset);
+    for (int r = 0; r < tile_size_; ++r) {
+      out_.write((const char*)&level.band[r * row_bytes + (size_t)tx * tile_size_ * kTexelSize],
+                 tile_size_ * kTexelSize);
+    }
+    level.entries[tx + ty * level.tiles_x] = TiledMap::Entry{offset, min, max};
+  }
+
+  level.band_rows = 0;
+}
+
+void TiledMapWriter::Close() {
+  if (closed_) {
+    return;
+  }
+  closed_ = true;
+
+  for (auto& level: levels_) {
+    if (level->row != level->height) {
+      ABORT_F("%s: %d rows of %d written", filename_.c_str(), level->row, 
+              level->height);
+    }
+  }
+
+  Header header;
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.format = format_;
+  header.width = levels_[0]->width;
+  header.height = levels_[0]->height;
+  header.tile_size = tile_size_;
+  header.n_mips = levels_.size();
+  header.reserved = 0;
+  header.directory = out_.tellp();
+
+  for (auto& level: levels_) {
+    out_.write((const char*)level->entries.data(), 
+               level->entries.size() * sizeof(TiledMap::Entry));
+  }
+  out_.seekp(0);
+  out_.write((const char*)&header, sizeof(header));
+  out_.close();
+  if (!out_) {
+    ABORT_F("Cant write file %s", filename_.c_str());
+  }
+}
+
+void TiledMapWriter::Write(const std::string& filename, 
+                           const Array2d<float>& heights,
+                           int tile_size, bool mips) {
+  TiledMapWriter writer(filename, TiledMap::kFloat32, heights.GetWidth(), 
+                        heights.GetHeight(), tile_size, mips);
+  for (size_t y = 0; y < heights.GetHeight(); ++y) {
+    writer.AddRow(&heights.At(0, y));
+  }
+  writer.Close();
+}
+
+void TiledMapWriter::Write(const std::string& filename, 
+                           const Image::ColorMap& colors,
+                           int tile_size, bool mips) {
+  TiledMapWriter writer(filename, TiledMap::kRgba8, colors.GetWidth(), 
+                        colors.GetHeight(), tile_size, mips);
+  std::vector<Color32> row(colors.GetWidth());
+  for (size_t y = 0; y < colors.GetHeight(); ++y) {
+    for (size_t x = 0; x < colors.GetWidth(); ++x) {
+      row[x] = Color32(glm::clamp(colors.At(x, y), 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+    writer.AddRow(row.data());
+  }
+  writer.Close();
+}
+
+}
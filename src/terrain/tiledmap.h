@@ -0,0 +1,161 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _TILEDMAP_H_037891DA_C343_4053_BEDF_33BC86BDBAB7_
+#define _TILEDMAP_H_037891DA_C343_4053_BEDF_33BC86BDBAB7_ 
+
+#include "image/colormap.h"
+#include "common/array2d.h"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Terrain {
+
+//////////////////////////////////////////////////////////////////////////////
+// Tiled binary height/color map (.tmap).
+//
+// The map is cut into tile_size x tile_size tiles, the border tiles are 
+// padded with the edge texels. Every tile knows its min/max value (height, 
+// or luminance for the colors). Optional mip levels, halved down to a 
+// single tile.
+//
+// The file is memory mapped, nothing is read until a tile is touched, so 
+// the map size is capped by the address space and not by RAM. Evict() 
+// drops the tile pages that are no longer needed.
+//
+// Layout: header, tiles (page aligned), tile directory (mip by mip, tiles
+// row by row).
+//////////////////////////////////////////////////////////////////////////////
+class TiledMap {
+ public:
+  enum Format : uint32_t {
+    kFloat32 = 1, // Heights
+    kRgba8   = 2  // Colors
+  };
+
+  static std::shared_ptr<TiledMap> Open(const std::string& filename);
+  ~TiledMap();
+
+  TiledMap(const TiledMap&) = delete;
+  TiledMap& operator=(const TiledMap&) = delete;
+
+  Format GetFormat() const { return format_; }
+  int GetTileSize() const { return tile_size_; }
+  int GetMipCount() const { return (int)mips_.size(); }
+  int GetWidth(int mip = 0) const { return mips_.at(mip).width; }
+  int GetHeight(int mip = 0) const { return mips_.at(mip).height; }
+  int GetTilesX(int mip = 0) const { return mips_.at(mip).tiles_x; }
+  int GetTilesY(int mip = 0) const { return mips_.at(mip).tiles_y; }
+
+  float GetTileMin(int tx, int ty, int mip = 0) const;
+  float GetTileMax(int tx, int ty, int mip = 0) const;
+
+  // tile_size x tile_size texels, row by row
+  const float*   GetHeights(int tx, int ty, int mip = 0) const;
+  const Color32* GetColors(int tx, int ty, int mip = 0) const;
+
+  // Single texel, the coordinates are clamped to the map
+  float GetHeight(int x, int y, int mip = 0) const;
+  Color GetColor(int x, int y, int mip = 0) const;
+
+  // Releases the tile pages, the next access reads them from the file again
+  void Evict(int tx, int ty, int mip = 0) const;
+
+  size_t GetFileSize() const { return size_; }
+
+ private:
+  struct Entry {
+    uint64_t offset;
+    float    min;
+    float    max;
+  };
+
+  struct Mip {
+    int          width;
+    int          height;
+    int          tiles_x;
+    int          tiles_y;
+    const Entry* entries;
+  };
+
+  TiledMap() = default;
+
+  const Entry& GetEntry(int tx, int ty, int mip) const;
+  const uint8_t* GetTexel(int x, int y, int mip) const;
+
+  Format            format_    = kFloat32;
+  int               tile_size_ = 0;
+  std::vector<Mip>  mips_;
+  const uint8_t*    data_      = nullptr;
+  size_t            size_      = 0;
+  void*             handle_    = nullptr; // Windows file mapping
+
+  friend class TiledMapWriter;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// Writes .tmap row by row, only a band of tile_size rows per mip level is 
+// kept in memory.
+//
+// TiledMapWriter writer("hmap.tmap", TiledMap::kFloat32, width, height);
+// for (...) writer.AddRow(row);
+// writer.Close();
+//////////////////////////////////////////////////////////////////////////////
+class TiledMapWriter {
+ public:
+  TiledMapWriter(const std::string& filename, TiledMap::Format format, 
+                 int width, int height, int tile_size = 256, bool mips = true);
+  ~TiledMapWriter();
+
+  void AddRow(const float* heights);
+  void AddRow(const Color32* colors);
+  void Close();
+
+  static void Write(const std::string& filename, const Array2d<float>& heights,
+                    int tile_size = 256, bool mips = true);
+  static void Write(const std::string& filename, const Image::ColorMap& colors,
+                    int tile_size = 256, bool mips = true);
+
+ private:
+  struct Level;
+
+  void AddRow(int level, const uint8_t* row);
+  void FlushBand(Level& level);
+  void Downsample(const uint8_t* a, const uint8_t* b, int width, uint8_t* out) const;
+
+  std::string                          filename_;
+  std::ofstream                        out_;
+  TiledMap::Format                     format_;
+  int                                  tile_size_;
+  std::vector<std::unique_ptr<Level>>  levels_;
+  bool                                 closed_;
+};
+
+}
+
+#endif // _TILEDMAP_H_037891DA_C343_4053_BEDF_33BC86BDBAB7_
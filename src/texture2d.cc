@@ -24,6 +24,7 @@
 
 #include "texture2d.h"
 #include "common/logging.h"
+#include "profiler.h"
 
 Texture2D::Texture2D() : Texture(), texture_id_(0) {
 }
@@ -70,6 +71,8 @@ void Texture2D::Apply() {
                GL_RGBA, 
                GL_FLOAT, 
                pixels_->GetArray());
+  PROFILE_COUNT(kUploads, 1);
+  PROFILE_COUNT(kUploadBytes, pixels_->GetLength() * sizeof(Color));
   glGenerateMipmap(GL_TEXTURE_2D);
   glBindTexture(GL_TEXTURE_2D, 0);
 }
@@ -0,0 +1,106 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "texture_buffer.h"
+#include "common/logging.h"
+#include "profiler.h"
+#include <algorithm>
+
+static GLenum GetInternalFormat(TextureBuffer::Format format) {
+  switch (format) {
+    case TextureBuffer::kRgba32f : return GL_RGBA32F;
+    case TextureBuffer::kRg32ui  : return GL_RG32UI;
+    case TextureBuffer::kR32ui   : return GL_R32UI;
+    default: ABORT_F("Invalid texture buffer format %d", format);
+  }
+}
+
+TextureBuffer::TextureBuffer(Format format) 
+  : Texture(), 
+    format_(format), 
+    buffer_id_(0), 
+    texture_id_(0), 
+    capacity_(0), 
+    size_(0) {
+  glGenBuffers(1, &buffer_id_);
+  glGenTextures(1, &texture_id_);
+  // Never empty, the sampler needs a buffer
+  SetData(nullptr, 1);
+  size_ = 0;
+}
+
+TextureBuffer::~TextureBuffer() {
+  if (texture_id_) {
+    glDeleteTextures(1, &texture_id_);
+    texture_id_ = 0;
+  }
+  if (buffer_id_) {
+    glDeleteBuffers(1, &buffer_id_);
+    buffer_id_ = 0;
+  }
+}
+
+size_t TextureBuffer::GetTexelSize() const {
+  switch (format_) {
+    case kRgba32f : return 4 * sizeof(float);
+    case kRg32ui  : return 2 * sizeof(uint32_t);
+    case kR32ui   : return sizeof(uint32_t);
+    default: ABORT_F("Invalid texture buffer format %d", format_);
+  }
+}
+
+void TextureBuffer::SetData(const void* data, size_t n_texels) {
+  size_t texel_size = GetTexelSize();
+  glBindBuffer(GL_TEXTURE_BUFFER, buffer_id_);
+  if (n_texels > capacity_) {
+    // Grow by 1.5 to not reallocate every frame when the count creeps up
+    capacity_ = std::max(n_texels, capacity_ + capacity_ / 2);
+    glBufferData(GL_TEXTURE_BUFFER, capacity_ * texel_size, nullptr, 
+                 GL_STREAM_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, texture_id_);
+    glTexBuffer(GL_TEXTURE_BUFFER, GetInternalFormat(format_), buffer_id_);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+  } else {
+    // Orphan
+    glBufferData(GL_TEXTURE_BUFFER, capacity_ * texel_size, nullptr, 
+                 GL_STREAM_DRAW);
+  }
+  if (data && n_texels) {
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, n_texels * texel_size, data);
+    PROFILE_COUNT(kUploads, 1);
+    PROFILE_COUNT(kUploadBytes, n_texels * texel_size);
+  }
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+  size_ = n_texels;
+}
+
+void TextureBuffer::Bind(int slot) {
+  glActiveTexture(GL_TEXTURE0 + slot);
+  glBindTexture(GL_TEXTURE_BUFFER, texture_id_);
+}
+
+void TextureBuffer::Unbind(int slot) {
+  glActiveTexture(GL_TEXTURE0 + slot);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
@@ -0,0 +1,67 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef _TEXTURE_BUFFER_H_CC6CD44B_7F57_4E09_9D5C_216DE88FB2EF_
+#define _TEXTURE_BUFFER_H_CC6CD44B_7F57_4E09_9D5C_216DE88FB2EF_ 
+
+#include "gl_main.h"
+#include "texture.h"
+#include <cstddef>
+
+//////////////////////////////////////////////////////////////////////////////
+// Buffer texture, a 1D array of texels for texelFetch() in the shaders 
+// (samplerBuffer, usamplerBuffer). The GL 3.3 core way to feed the shaders
+// with big arrays. No filtering, no wrapping.
+//////////////////////////////////////////////////////////////////////////////
+class TextureBuffer : public Texture {
+ public:
+  enum Format {
+    kRgba32f, // vec4
+    kRg32ui,  // uvec2
+    kR32ui    // uint
+  };
+
+  explicit TextureBuffer(Format format);
+  virtual ~TextureBuffer();
+
+  // n_texels of the format. The storage grows as needed and is orphaned on 
+  // every upload, so the frames in flight keep their copy.
+  void SetData(const void* data, size_t n_texels);
+
+  size_t GetSize() const { return size_; }
+
+  void Bind(int slot) override;
+  void Unbind(int slot) override;
+
+ private:
+  size_t GetTexelSize() const;
+
+  Format format_;
+  GLuint buffer_id_;
+  GLuint texture_id_;
+  size_t capacity_;
+  size_t size_;
+};
+
+#endif // _TEXTURE_BUFFER_H_CC6CD44B_7F57_4E09_9D5C_216DE88FB2EF_
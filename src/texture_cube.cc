@@ -24,6 +24,7 @@
 
 #include "texture_cube.h"
 #include "common/logging.h"
+#include "profiler.h"
 
 TextureCube::TextureCube() : Texture(), texture_id_(0) {
   wrap_u_mode = Texture::kWrapClamp;
@@ -77,6 +78,8 @@ void TextureCube::Apply() {
                  GL_RGBA, 
                  GL_FLOAT, 
                  pixels_[i]->GetArray());
+    PROFILE_COUNT(kUploads, 1);
+    PROFILE_COUNT(kUploadBytes, pixels_[i]->GetLength() * sizeof(Color));
   }
   // Set our texture parameters
   glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, Texture::ToOpenGL(wrap_u_mode));
@@ -29,29 +29,44 @@
 
 //////////////////////////////////////////////////////////////////////////////
 // Out handy timer!
+//
+// The time is kept in double, a float loses the milliseconds after a few 
+// hours. SetFixedStep() switches to the simulated clock: every Tick() 
+// advances the time by the step whatever the frame took, so the runs are 
+// reproducible and the simulation does not depend on the frame rate.
 //////////////////////////////////////////////////////////////////////////////
 class Timer {
  public:
-  Timer() : prev_time_(0), time_(0), time_delta_t(0), frame_number_(0) {}
+  Timer() : prev_time_(0), time_(0), time_delta_t(0), fixed_step_(0), 
+            frame_number_(0) {}
 
   ////////////////////////////////////////////////////////////////////////////
   // This method  must be called once per frame!
   ////////////////////////////////////////////////////////////////////////////
   void Tick() {
     prev_time_ = time_;
-    time_ = glfwGetTime(); // time since GLFW was initialized
+    if (fixed_step_ > 0) {
+      time_ = frame_number_ * fixed_step_;
+    } else {
+      time_ = glfwGetTime(); // time since GLFW was initialized
+    }
     time_delta_t = time_ - prev_time_;
     frame_number_++;
   }
 
+  // 0 - the real clock
+  void SetFixedStep(double seconds) { fixed_step_ = seconds; }
+  double GetFixedStep() const { return fixed_step_; }
+
   float GetTime()        const { return time_; }
   float GetTimeDelta()   const { return time_delta_t; }
   int   GetFrameNumber() const { return frame_number_; }
 
  private:
-  float       prev_time_;
-  float       time_;
-  float       time_delta_t;
+  double      prev_time_;
+  double      time_;
+  double      time_delta_t;
+  double      fixed_step_;
   int         frame_number_;
 };
 
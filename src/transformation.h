@@ -27,6 +27,9 @@
 
 #include "glm_main.h"
 #include "common/logging.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <functional>
 #include <stdexcept>
@@ -104,7 +107,7 @@ class Transformation {
   ////////////////////////////////////////////////////////////////////////////
   void SetLocalPosition(const glm::vec3& position) {
     local_position_ = position;
-    dirty_ = true;
+    MarkDirty();
   }
 
   glm::vec3 GetLocalPosition() const {
@@ -114,7 +117,7 @@ class Transformation {
   void SetLocalEulerAngles(const glm::vec3& euler) {
     // TODO - normalize to range [-365 ... 0 ... +365]
     local_euler_angles_ = glm::radians(euler);
-    dirty_ = true;
+    MarkDirty();
   }
 
   template <typename... T>
@@ -139,7 +142,7 @@ class Transformation {
 
   void SetLocalScale(const glm::vec3& scale) {
     local_scale_ = scale;
-    dirty_ = true;
+    MarkDirty();
   };
 
   glm::vec3 GetLocalScale() const {
@@ -209,7 +212,7 @@ class Transformation {
     //local_euler_angles_ = glm::vec3(pitch(q), yaw(q), roll(q));
     //auto d = glm::normalize(target - local_position_);
 
-    dirty_ = true;
+    MarkDirty();
   }
 
   ////////////////////////////////////////////////////////////////////////////
@@ -218,17 +221,17 @@ class Transformation {
 
   void Translate(const glm::vec3& delta_position) {
     local_position_ += delta_position;
-    dirty_ = true;
+    MarkDirty();
   }
 
   void Rotate(const glm::vec3& delta_euler) {
     local_euler_angles_ += glm::radians(delta_euler);
-    dirty_ = true;
+    MarkDirty();
   }
 
   void Scale(const glm::vec3& delta_scale) {
     local_scale_ += delta_scale;
-    dirty_ = true;
+    MarkDirty();
   }
 
   ////////////////////////////////////////////////////////////////////////////
@@ -276,6 +279,18 @@ class Transformation {
     // Inverse the whole thing???
   }
 
+  ////////////////////////////////////////////////////////////////////////////
+  // Changes with every change of the transform or of its parents, for the 
+  // things computed from the world matrix (the static actors' caches). The
+  // versions are stamps of one counter, the latest of the chain is taken.
+  ////////////////////////////////////////////////////////////////////////////
+  uint64_t GetVersion() const {
+    if (auto mum = parent_.lock()) {
+      return std::max(version_, mum->GetVersion());
+    }
+    return version_;
+  }
+
   ////////////////////////////////////////////////////////////////////////////
   // Parent/child relations 
   // SetParent(mum1, kid);
@@ -290,12 +305,19 @@ class Transformation {
       mum->childs_.erase(hasher(kid));
     }
     kid->parent_ = mum;
+    kid->MarkDirty();
     if (mum) {
       mum->childs_[hasher(kid)] = kid;
     }
   }
 
  private:
+  void MarkDirty() {
+    static std::atomic<uint64_t> counter(0);
+    dirty_ = true;
+    version_ = counter.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+
   void Recalculate() const {
     if (dirty_) {
       trs_matrix_.Recalculate(local_position_, local_euler_angles_, local_scale_);
@@ -309,6 +331,7 @@ class Transformation {
 
   mutable TranslateRotateScale             trs_matrix_;
   mutable bool                             dirty_;
+  uint64_t                                 version_ = 0;
 
   Actor&                                   actor_;
   std::weak_ptr<Transformation>            parent_;
@@ -28,9 +28,12 @@
 #include "gl_main.h"
 #include "glm_main.h"
 #include "attributelayout.h"
+#include "indexbuffer.h"
 #include "common/logging.h"
+#include "profiler.h"
 #include <bitset>
 #include <cstdint>
+#include <memory>
 #include <vector>
 #include <algorithm>
 #include <string>
@@ -102,7 +105,7 @@ class VertexArrayObject {
       }
       vbo = VboInfo{};
     }
-    if (indices_vbo_) {
+    if (indices_vbo_ && !shared_indices_) {
       glDeleteBuffers(1, &indices_vbo_);
     }
     if (vao_ != 0) {
@@ -127,6 +130,8 @@ class VertexArrayObject {
 
     glBindBuffer(GL_ARRAY_BUFFER, vbo.id);
     glBufferData(GL_ARRAY_BUFFER, data.data_size, data.data, usage); 
+    PROFILE_COUNT(kUploads, 1);
+    PROFILE_COUNT(kUploadBytes, data.data_size);
     glVertexAttribPointer(attrib_slot, data.num_components, data.type, GL_FALSE, 0, nullptr);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
   }
@@ -135,6 +140,11 @@ class VertexArrayObject {
   // Upload indices to video memory
   //////////////////////////////////////////////////////////////////////////////
   void UploadIndices(PackedData indices, Usage usage) {
+    // Own ones from now on
+    if (shared_indices_) {
+      shared_indices_.reset();
+      indices_vbo_ = 0;
+    }
     if (indices_vbo_ == 0) {
       glGenBuffers(1, &indices_vbo_);
       glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices_vbo_);
@@ -142,10 +152,23 @@ class VertexArrayObject {
 
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.data_size, 
                  indices.data, usage);
+    PROFILE_COUNT(kUploads, 1);
+    PROFILE_COUNT(kUploadBytes, indices.data_size);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
   }
 
+  //////////////////////////////////////////////////////////////////////////////
+  // Draws with the shared indices, uploaded if not yet. Kept alive by the VAO.
+  //////////////////////////////////////////////////////////////////////////////
+  void SetIndices(std::shared_ptr<IndexBuffer> indices) {
+    if (indices_vbo_ && !shared_indices_) {
+      glDeleteBuffers(1, &indices_vbo_);
+    }
+    shared_indices_ = indices;
+    indices_vbo_ = indices->Upload();
+  }
+
   /////////////////////////////////////////////////////////////////////////////
   // Layout driven uploading 
   /////////////////////////////////////////////////////////////////////////////
@@ -169,6 +192,10 @@ class VertexArrayObject {
     vbo = VboInfo{id, 0, 0, buff_sz, start, total};
     glBindBuffer(GL_ARRAY_BUFFER, vbo.id);
     glBufferData(GL_ARRAY_BUFFER, buff_sz, data, usage); 
+    if (data) {
+      PROFILE_COUNT(kUploads, 1);
+      PROFILE_COUNT(kUploadBytes, buff_sz);
+    }
 
     never_easy::for_<total>([&] (auto i) {
         using TAttr = typename TLayout::template TAttribute<i.value>; 
@@ -215,11 +242,35 @@ class VertexArrayObject {
         // https://www.khronos.org/opengl/wiki/Buffer_Object_Streaming
         glBufferData(GL_ARRAY_BUFFER, buff_sz, nullptr, GL_STREAM_DRAW); 
         glBufferSubData(GL_ARRAY_BUFFER, 0, buf_sub_sz, data);
+        PROFILE_COUNT(kUploadBytes, buf_sub_sz);
       } else {
         glBufferData(GL_ARRAY_BUFFER, buff_sz, data, usage); 
+        PROFILE_COUNT(kUploadBytes, buff_sz);
       }
+      PROFILE_COUNT(kUploads, 1);
+      vbo.size = buff_sz;
     }
   }
+
+  // Rewrites elements [first, first + n_elements) of an uploaded buffer, 
+  // data points to the element 'first'. Buffer keeps its size.
+  template <typename TLayout>
+  void UploadRange(int start, size_t first, size_t n_elements, const void* data) {
+    assert(start >= 0 && start < kMaxAttributeSlots);
+
+    constexpr auto total = TLayout::Attributes();
+
+    auto& vbo = GetVbo(start, total); 
+    assert(!vbo.IsEmpty());
+    assert(TLayout::Stride() * (first + n_elements) <= vbo.size);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo.id);
+    glBufferSubData(GL_ARRAY_BUFFER, TLayout::Stride() * first, 
+                    TLayout::Stride() * n_elements, data);
+    PROFILE_COUNT(kUploads, 1);
+    PROFILE_COUNT(kUploadBytes, TLayout::Stride() * n_elements);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
   
   // Per instance attribute memory map
   template <typename TLayout>
@@ -353,6 +404,7 @@ class VertexArrayObject {
   std::vector<VboInfo>            vbo_;
   std::bitset<kMaxAttributeSlots> vbo_bitset_;
   GLuint                          indices_vbo_;
+  std::shared_ptr<IndexBuffer>    shared_indices_; // Owns indices_vbo_ if set
 };
 
 #endif // _VERTEXARRAYOBJECT_H_3757C313_50A4_4E57_A091_C276B99E84DB_
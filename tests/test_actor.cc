@@ -0,0 +1,279 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <actor.h>
+#include <actor_pool.h>
+#include <gtest/gtest.h>
+
+// Counts the calls, moves the actor if told so
+struct Counter : public Action {
+  int  starts = 0;
+  int  updates = 0;
+  bool move = false;
+
+  Counter(std::shared_ptr<Transformation> t) : Action(t) {}
+
+  void Start() override { ++starts; }
+
+  void Update() override {
+    ++updates;
+    if (move) {
+      transform->Translate(glm::vec3(1, 0, 0));
+    }
+  }
+};
+
+TEST(Actor, States) {
+  Actor actor("test.actor");
+  auto counter = actor.AddAction<Counter>();
+  actor.Update(0.01f);
+  EXPECT_TRUE(actor.HasTicked());
+  EXPECT_EQ(1, counter->updates);
+
+  actor.SetActive(false);
+  EXPECT_FALSE(actor.IsVisible());
+  actor.Update(0.01f);
+  EXPECT_FALSE(actor.HasTicked());
+  actor.SetActive(true);
+  actor.SetVisible(false);
+  EXPECT_TRUE(actor.IsActive());
+  EXPECT_FALSE(actor.IsVisible());
+
+  actor.Die();
+  EXPECT_FALSE(actor.IsActive());
+  actor.Update(0.01f);
+  EXPECT_EQ(1, counter->updates);
+}
+
+TEST(Actor, Static) {
+  Actor actor("test.actor");
+  auto counter = actor.AddAction<Counter>();
+  actor.SetStatic(true);
+  EXPECT_TRUE(actor.IsStatic());
+  EXPECT_FALSE(actor.IsSuperStatic());
+  actor.Update(0.01f);
+  actor.Update(0.01f);
+  EXPECT_EQ(1, counter->starts);
+  EXPECT_EQ(0, counter->updates);
+  EXPECT_FALSE(actor.HasTicked());
+
+  // The cache follows the transform and its parents
+  glm::mat4 model;
+  actor.transform->SetLocalPosition(1, 2, 3);
+  actor.GetWorldMatrix(model);
+  EXPECT_EQ(glm::vec4(1, 2, 3, 1), model[3]);
+  auto parent = std::make_shared<Transformation>(actor);
+  Transformation::SetParent(parent, actor.transform);
+  parent->SetLocalPosition(10, 0, 0);
+  actor.GetWorldMatrix(model);
+  EXPECT_EQ(glm::vec4(11, 2, 3, 1), model[3]);
+
+  // Super static ones never look
+  actor.SetStatic(true, true);
+  EXPECT_TRUE(actor.IsSuperStatic());
+  actor.GetWorldMatrix(model);
+  parent->SetLocalPosition(20, 0, 0);
+  actor.GetWorldMatrix(model);
+  EXPECT_EQ(glm::vec4(11, 2, 3, 1), model[3]);
+
+  actor.SetStatic(false);
+  actor.GetWorldMatrix(model);
+  EXPECT_EQ(glm::vec4(21, 2, 3, 1), model[3]);
+  actor.Update(0.01f);
+  EXPECT_EQ(1, counter->updates);
+}
+
+TEST(Actor, AutoSleep) {
+  Actor actor("test.actor");
+  auto counter = actor.AddAction<Counter>();
+  actor.SetAutoSleep(3);
+
+  // Moving, awake
+  counter->move = true;
+  for (int i = 0; i < 5; ++i) {
+    actor.Update(0.01f);
+  }
+  EXPECT_FALSE(actor.IsSleeping());
+
+  // Asleep after 3 still ticks
+  counter->move = false;
+  for (int i = 0; i < 10; ++i) {
+    actor.Update(0.01f);
+  }
+  EXPECT_TRUE(actor.IsSleeping());
+  EXPECT_EQ(8, counter->updates);
+  EXPECT_FALSE(actor.HasTicked());
+
+  // Moved by someone else
+  actor.transform->Translate(glm::vec3(0, 1, 0));
+  actor.Update(0.01f);
+  EXPECT_TRUE(actor.HasTicked());
+  EXPECT_EQ(9, counter->updates);
+  for (int i = 0; i < 10; ++i) {
+    actor.Update(0.01f);
+  }
+  EXPECT_EQ(12, counter->updates);
+
+  // An event
+  actor.WakeUp();
+  actor.Update(0.01f);
+  EXPECT_EQ(13, counter->updates);
+
+  // Put to sleep by hand, no auto sleep
+  actor.SetAutoSleep(0);
+  actor.Sleep();
+  actor.Update(0.01f);
+  EXPECT_EQ(13, counter->updates);
+  actor.WakeUp();
+  for (int i = 0; i < 10; ++i) {
+    actor.Update(0.01f);
+  }
+  EXPECT_EQ(23, counter->updates);
+}
+
+TEST(Actor, TickInterval) {
+  std::vector<std::unique_ptr<Actor>> actors;
+  std::vector<std::shared_ptr<Counter>> counters;
+  for (int i = 0; i < 8; ++i) {
+    actors.emplace_back(new Actor("test.actor." + std::to_string(i)));
+    counters.push_back(actors.back()->AddAction<Counter>());
+    actors.back()->SetTickInterval(4);
+  }
+  EXPECT_TRUE(actors[0]->IsTickIntervalPinned());
+
+  // Staggered, two of eight every frame
+  for (int frame = 0; frame < 8; ++frame) {
+    int ticked = 0;
+    for (auto& actor: actors) {
+      actor->Update(0.01f);
+      ticked += actor->HasTicked();
+    }
+    EXPECT_EQ(2, ticked);
+  }
+  for (auto& counter: counters) {
+    EXPECT_EQ(2, counter->updates);
+  }
+}
+
+// Remembers the delta time of every tick
+struct DeltaLog : public Action {
+  std::vector<float> deltas;
+
+  DeltaLog(std::shared_ptr<Transformation> t) : Action(t) {}
+
+  void Update() override { deltas.push_back(GetDeltaTime()); }
+};
+
+TEST(Actor, DeltaTime) {
+  Actor actor("test.actor");
+  auto log = actor.AddAction<DeltaLog>();
+  for (int i = 0; i < 3; ++i) {
+    actor.Update(0.01f);
+  }
+  actor.SetTickInterval(8, false);
+  EXPECT_FALSE(actor.IsTickIntervalPinned());
+  for (int i = 0; i < 32; ++i) {
+    actor.Update(0.01f);
+  }
+
+  // Nothing is lost between the ticks, at most the last interval is pending
+  ASSERT_EQ(7u, log->deltas.size());
+  float total = 0;
+  for (size_t i = 0; i < log->deltas.size(); ++i) {
+    if (i < 3) {
+      EXPECT_FLOAT_EQ(0.01f, log->deltas[i]);
+    } else if (i > 3) {
+      EXPECT_NEAR(0.08f, log->deltas[i], 1e-5f);
+    }
+    total += log->deltas[i];
+  }
+  EXPECT_LE(total, 0.35f + 1e-4f);
+  EXPECT_GT(total, 0.35f - 0.08f);
+}
+
+TEST(Actor, NoTimeWhileOut) {
+  Actor actor("test.actor");
+  auto log = actor.AddAction<DeltaLog>();
+  actor.SetTickInterval(4);
+
+  // Inactive
+  for (int i = 0; i < 4; ++i) {
+    actor.Update(0.01f);
+  }
+  actor.SetActive(false);
+  for (int i = 0; i < 100; ++i) {
+    actor.Update(0.01f);
+  }
+  actor.SetActive(true);
+  actor.Update(0.01f);
+  ASSERT_EQ(2u, log->deltas.size());
+  EXPECT_FLOAT_EQ(0.01f, log->deltas[1]);
+
+  // Asleep, woken up by an event and by a move
+  actor.SetTickInterval(1);
+  actor.Sleep();
+  for (int i = 0; i < 100; ++i) {
+    actor.Update(0.01f);
+  }
+  actor.WakeUp();
+  actor.Update(0.01f);
+  ASSERT_EQ(3u, log->deltas.size());
+  EXPECT_FLOAT_EQ(0.01f, log->deltas[2]);
+
+  actor.Sleep();
+  for (int i = 0; i < 100; ++i) {
+    actor.Update(0.01f);
+  }
+  actor.transform->Translate(glm::vec3(1, 0, 0));
+  actor.Update(0.01f);
+  ASSERT_EQ(4u, log->deltas.size());
+  EXPECT_FLOAT_EQ(0.01f, log->deltas[3]);
+}
+
+// A recycled actor starts from scratch
+TEST(Actor, PoolRecycle) {
+  ActorPool pool("test.pool", 1);
+  auto actor = pool.Get(false);
+  auto counter = actor->AddAction<Counter>();
+  actor->transform->SetLocalPosition(1, 2, 3);
+  glm::mat4 model;
+  actor->SetStatic(true, true);
+  actor->GetWorldMatrix(model);
+  actor->SetAutoSleep(1);
+  actor->Sleep();
+  actor->Die();
+  pool.Update(0.01f);
+
+  auto recycled = pool.Get(false);
+  ASSERT_EQ(actor, recycled);
+  EXPECT_FALSE(recycled->IsStatic());
+  EXPECT_FALSE(recycled->IsSleeping());
+  recycled->GetWorldMatrix(model);
+  EXPECT_EQ(glm::vec4(0, 0, 0, 1), model[3]);
+  for (int i = 0; i < 3; ++i) {
+    recycled->Update(0.01f);
+  }
+  EXPECT_EQ(3, counter->updates);
+  EXPECT_FALSE(recycled->IsSleeping());
+}
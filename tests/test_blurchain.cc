@@ -0,0 +1,98 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <blurchain.h>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+
+TEST(BlurChain, KernelIsNormalized) {
+  for (int radius: {1, 4, 7, 30}) {
+    auto kernel = BlurChain::ComputeKernel(radius, 0);
+    ASSERT_EQ(kernel.size(), 2u * radius + 1);
+    float sum = 0;
+    for (float w: kernel) sum += w;
+    EXPECT_NEAR(sum, 1, 1e-5);
+    EXPECT_FLOAT_EQ(kernel.front(), kernel.back());
+    EXPECT_GT(kernel[radius], kernel[radius + 1]);
+  }
+}
+
+TEST(BlurChain, LinearTapsMatchTheDiscreteKernel) {
+  // Bilinear fetches of the taps give the same result as the full kernel
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<float> value(0, 1);
+  std::vector<float> signal(128);
+  for (auto& v: signal) v = value(rng);
+  auto fetch = [&](float x) {
+    int i = (int)std::floor(x);
+    float t = x - i;
+    return signal[i] * (1 - t) + signal[i + 1] * t;
+  };
+
+  for (int radius: {1, 2, 5, 8, 30}) {
+    auto kernel = BlurChain::ComputeKernel(radius, 0);
+    auto taps = BlurChain::ComputeTaps(radius, 0);
+    EXPECT_EQ(taps.size(), 1u + (radius + 1) / 2);
+
+    for (int x = 40; x < 80; ++x) {
+      float expected = 0;
+      for (int i = -radius; i <= radius; ++i) {
+        expected += signal[x + i] * kernel[i + radius];
+      }
+      float actual = taps[0].weight * signal[x];
+      for (size_t t = 1; t < taps.size(); ++t) {
+        actual += taps[t].weight * (fetch(x + taps[t].offset) + 
+                                    fetch(x - taps[t].offset));
+      }
+      EXPECT_NEAR(actual, expected, 1e-5) << "radius " << radius;
+    }
+  }
+}
+
+TEST(BlurChain, Stages) {
+  BlurChain::Params params;
+  params.radius = 4;
+  params.levels = 3;
+  BlurChain chain(params, 1920, 1080);
+
+  std::vector<std::string> names;
+  for (auto& stage: chain.GetStages()) names.push_back(stage.name);
+  EXPECT_EQ(names, (std::vector<std::string>{
+      "down0", "down1", "down2", 
+      "hblur2", "vblur2", 
+      "hblur1", "vblur1", "up1", 
+      "hblur0", "vblur0", "up0"}));
+
+  auto& stages = chain.GetStages();
+  EXPECT_EQ(stages[0].width, 960);
+  EXPECT_EQ(stages[2].height, 135);
+  EXPECT_EQ(stages[3].fetches, 5);
+
+  size_t level0 = 960 * 540, level1 = 480 * 270, level2 = 240 * 135;
+  EXPECT_EQ(chain.GetShadedPixels(), 
+            4 * level0 + 4 * level1 + 3 * level2);
+  EXPECT_EQ(chain.GetTextureFetches(), 
+            (level0 + level1 + level2) * (4 + 2 * 5) + (level0 + level1) * 5);
+}
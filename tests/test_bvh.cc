@@ -0,0 +1,162 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <phys/bvh.h>
+#include <gridmesh.h>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+
+using Phys::Bvh;
+using Phys::Ray;
+
+// Random triangles in a cube, some of them long and thin
+static Mesh MakeSoup(int n, bool indexed) {
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<float> position(-10, 10);
+  std::uniform_real_distribution<float> offset(-1, 1);
+  Mesh mesh;
+  for (int i = 0; i < n; ++i) {
+    glm::vec3 center(position(rng), position(rng), position(rng));
+    float scale = i % 10 ? 1 : 5;
+    for (int k = 0; k < 3; ++k) {
+      mesh.vertices.push_back(center + scale * 
+          glm::vec3(offset(rng), offset(rng), offset(rng)));
+      if (indexed) {
+        mesh.indices.push_back(mesh.vertices.size() - 1);
+      }
+    }
+  }
+  return mesh;
+}
+
+static std::vector<Ray> MakeRays(int n) {
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<float> position(-12, 12);
+  std::vector<Ray> rays;
+  for (int i = 0; i < n; ++i) {
+    glm::vec3 from(position(rng), position(rng), position(rng));
+    glm::vec3 to(position(rng), position(rng), position(rng));
+    rays.push_back({from, to - from}); // Not normalized, t in [0, 1]
+  }
+  return rays;
+}
+
+static void ExpectSameAsBruteForce(const Mesh& mesh, const Bvh& bvh) {
+  int hits = 0;
+  for (auto& ray: MakeRays(2000)) {
+    Bvh::Hit expected, hit;
+    bool found = Bvh::RaycastBruteForce(mesh, ray, expected);
+    ASSERT_EQ(found, bvh.Raycast(ray, hit));
+    ASSERT_EQ(found, bvh.Occluded(ray));
+    if (found) {
+      EXPECT_EQ(expected.triangle, hit.triangle);
+      EXPECT_FLOAT_EQ(expected.t, hit.t);
+      EXPECT_NEAR(expected.u, hit.u, 1e-5f);
+      EXPECT_NEAR(expected.v, hit.v, 1e-5f);
+      ++hits;
+    }
+    EXPECT_EQ(Bvh::RaycastBruteForce(mesh, ray, expected, 0, 0.5f), 
+              bvh.Occluded(ray, 0, 0.5f));
+  }
+  EXPECT_GT(hits, 100);
+}
+
+TEST(Bvh, MatchesBruteForce) {
+  for (auto isa: {Bvh::Isa::kScalar, Bvh::Isa::kBest}) {
+    Mesh mesh = MakeSoup(5000, true);
+    Bvh::Params params;
+    params.isa = isa;
+    Bvh bvh(mesh, params);
+    EXPECT_EQ(5000u, bvh.GetStats().triangles);
+    EXPECT_LE(bvh.GetStats().depth, 64);
+    EXPECT_EQ(bvh.GetStats().nodes, 2 * bvh.GetStats().leaves - 1);
+    ExpectSameAsBruteForce(mesh, bvh);
+  }
+}
+
+TEST(Bvh, NotIndexedMesh) {
+  Mesh mesh = MakeSoup(1000, false);
+  ExpectSameAsBruteForce(mesh, Bvh(mesh));
+}
+
+TEST(Bvh, GridMesh) {
+  GridMesh::Params params;
+  params.x_vertices = params.z_vertices = 65;
+  params.x_length = params.z_length = 20;
+  auto mesh = GridMesh::Build(params, [](int x, int z) {
+    return std::sin(x * 0.3f) * std::cos(z * 0.2f);
+  });
+  Bvh bvh(*mesh);
+
+  // Straight down onto the terrain
+  Bvh::Hit hit;
+  ASSERT_TRUE(bvh.Raycast({glm::vec3(0.1f, 10, 0.2f), glm::vec3(0, -1, 0)}, hit));
+  EXPECT_NEAR(10, hit.t, 1.1f);
+  EXPECT_FALSE(bvh.Raycast({glm::vec3(0, 10, 0), glm::vec3(0, 1, 0)}, hit));
+  EXPECT_FALSE(bvh.Raycast({glm::vec3(30, 10, 0), glm::vec3(0, -1, 0)}, hit));
+  ExpectSameAsBruteForce(*mesh, bvh);
+}
+
+TEST(Bvh, SameTreeForAnyThreads) {
+  Mesh mesh = MakeSoup(50000, true);
+  Bvh::Params params;
+  params.n_threads = 1;
+  Bvh one(mesh, params);
+  params.n_threads = 8;
+  Bvh many(mesh, params);
+  auto& a = one.GetNodes();
+  auto& b = many.GetNodes();
+  ASSERT_EQ(a.size(), b.size());
+  for (size_t i = 0; i < a.size(); ++i) {
+    EXPECT_EQ(a[i].offset, b[i].offset);
+    EXPECT_EQ(a[i].count, b[i].count);
+    EXPECT_EQ(a[i].min, b[i].min);
+    EXPECT_EQ(a[i].max, b[i].max);
+  }
+  EXPECT_FLOAT_EQ(one.GetStats().sah_cost, many.GetStats().sah_cost);
+}
+
+TEST(Bvh, EmptyMesh) {
+  Mesh mesh;
+  Bvh bvh(mesh);
+  Bvh::Hit hit;
+  EXPECT_FALSE(bvh.Raycast({glm::vec3(0), glm::vec3(1, 0, 0)}, hit));
+  EXPECT_TRUE(bvh.GetNodes().empty());
+}
+
+TEST(BvhCache, BuildsOnce) {
+  Phys::BvhCache cache;
+  auto mesh = std::make_shared<Mesh>(MakeSoup(100, true));
+  auto bvh = cache.Get(mesh);
+  ASSERT_TRUE(bvh);
+  EXPECT_EQ(bvh, cache.Get(mesh));
+  cache.Invalidate(mesh.get());
+  EXPECT_NE(bvh, cache.Get(mesh));
+  EXPECT_EQ(1u, cache.GetSize());
+
+  mesh.reset();
+  cache.Get(std::make_shared<Mesh>(MakeSoup(10, true)));
+  EXPECT_EQ(1u, cache.GetSize()); // The dead one is dropped
+}
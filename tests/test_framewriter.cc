@@ -0,0 +1,205 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <image/framewriter.h>
+#include <image/portablepixmap.h>
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <atomic>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using Image::FrameWriter;
+using Image::ColorMap32;
+
+static std::string TempFile(const std::string& name) {
+  return "test_framewriter_" + name;
+}
+
+static std::string ReadFile(const std::string& filename) {
+  std::ifstream in(filename, std::ios::in | std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in), 
+                     std::istreambuf_iterator<char>());
+}
+
+// Bottom row red, the rest white, as glReadPixels gives it
+static void Fill(ColorMap32& frame, uint8_t value) {
+  for (size_t y = 0; y < frame.GetHeight(); ++y) {
+    for (size_t x = 0; x < frame.GetWidth(); ++x) {
+      frame.At(x, y) = y == 0 ? Color32(255, 0, 0, 255) : 
+                                Color32(value, value, value, 255);
+    }
+  }
+}
+
+TEST(FrameWriter, PpmIsFlipped) {
+  ColorMap32 frame(4, 2);
+  Fill(frame, 255);
+  std::vector<uint8_t> ppm;
+  FrameWriter::EncodePpm(frame, ppm);
+
+  std::string header = "P6\n4 2\n255\n";
+  ASSERT_EQ(ppm.size(), header.size() + 4 * 2 * 3);
+  EXPECT_EQ(std::string(ppm.begin(), ppm.begin() + header.size()), header);
+  const uint8_t* rgb = ppm.data() + header.size();
+  EXPECT_EQ(rgb[0], 255); // top row white
+  EXPECT_EQ(rgb[1], 255);
+  EXPECT_EQ(rgb[4 * 3 + 0], 255); // bottom row red
+  EXPECT_EQ(rgb[4 * 3 + 1], 0);
+  EXPECT_EQ(rgb[4 * 3 + 2], 0);
+}
+
+TEST(FrameWriter, Y4mFrame) {
+  // Odd size, the last chroma column and row use the edge pixels
+  ColorMap32 frame(5, 3);
+  Fill(frame, 255);
+  std::vector<uint8_t> y4m;
+  FrameWriter::EncodeY4mFrame(frame, y4m);
+
+  const size_t n_header = 6;
+  ASSERT_EQ(y4m.size(), n_header + 5 * 3 + 3 * 2 * 2);
+  EXPECT_EQ(std::string(y4m.begin(), y4m.begin() + n_header), "FRAME\n");
+  const uint8_t* luma = y4m.data() + n_header;
+  const uint8_t* u = luma + 5 * 3;
+  const uint8_t* v = u + 3 * 2;
+  EXPECT_EQ(luma[0], 255);        // white
+  EXPECT_EQ(luma[2 * 5], 77);     // red, BT.601 76.2
+  EXPECT_EQ(u[0], 128);
+  EXPECT_EQ(v[0], 128);
+  EXPECT_EQ(u[3], 85);            // red, 85.0
+  EXPECT_EQ(v[3], 255);
+}
+
+TEST(FrameWriter, Y4mFile) {
+  FrameWriter::Params params;
+  params.format = FrameWriter::kY4m;
+  params.filename = TempFile("video.y4m");
+  params.fps = 30;
+  params.max_queued = 100;
+  {
+    FrameWriter writer(params, 8, 6);
+    for (int i = 0; i < 10; ++i) {
+      auto frame = writer.GetFrame();
+      Fill(*frame, i * 10);
+      EXPECT_TRUE(writer.Push(frame));
+    }
+    writer.Flush();
+    auto stats = writer.GetStats();
+    EXPECT_EQ(stats.pushed, 10u);
+    EXPECT_EQ(stats.written, 10u);
+    EXPECT_EQ(stats.dropped, 0u);
+  }
+
+  std::string header = "YUV4MPEG2 W8 H6 F30:1 Ip A1:1 C420jpeg\n";
+  size_t n_frame = 6 + 8 * 6 + 4 * 3 * 2;
+  std::string video = ReadFile(params.filename);
+  ASSERT_EQ(video.size(), header.size() + 10 * n_frame);
+  EXPECT_EQ(video.substr(0, header.size()), header);
+  // In order, the top left luma of every frame
+  for (int i = 0; i < 10; ++i) {
+    size_t frame = header.size() + i * n_frame;
+    EXPECT_EQ(video.substr(frame, 6), "FRAME\n");
+    EXPECT_EQ((uint8_t)video[frame + 6], i * 10);
+  }
+  std::remove(params.filename.c_str());
+}
+
+TEST(FrameWriter, PpmSequence) {
+  FrameWriter::Params params;
+  params.format = FrameWriter::kPpmSequence;
+  params.filename = TempFile("frame%03d.ppm");
+  {
+    FrameWriter writer(params, 4, 2);
+    for (int i = 0; i < 3; ++i) {
+      auto frame = writer.GetFrame();
+      Fill(*frame, 100);
+      writer.Push(frame);
+      writer.Flush();
+    }
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    char filename[64];
+    std::snprintf(filename, sizeof(filename), params.filename.c_str(), i);
+    auto img = Image::PortablePixMap::Read(filename);
+    ASSERT_TRUE(img);
+    EXPECT_EQ(img->GetWidth(), 4u);
+    EXPECT_NEAR(img->At(0, 0).r, 100 / 255.0f, 1e-5);
+    EXPECT_EQ(img->At(0, 1).g, 0);
+    std::remove(filename);
+  }
+}
+
+TEST(FrameWriter, DropsWhenFull) {
+  FrameWriter::Params params;
+  params.format = FrameWriter::kY4m;
+  params.filename = TempFile("drops.y4m");
+  params.max_queued = 1;
+  size_t accepted = 0;
+  {
+    FrameWriter writer(params, 64, 64);
+    for (int i = 0; i < 50; ++i) {
+      accepted += writer.Push(writer.GetFrame());
+    }
+    writer.Flush();
+    auto stats = writer.GetStats();
+    EXPECT_EQ(stats.pushed, 50u);
+    EXPECT_EQ(stats.written, accepted);
+    EXPECT_EQ(stats.dropped, 50 - accepted);
+  }
+  std::remove(params.filename.c_str());
+}
+
+// Lent pixels (a mapped readback) are given back once encoded or dropped
+TEST(FrameWriter, LentPixels) {
+  FrameWriter::Params params;
+  params.format = FrameWriter::kY4m;
+  params.filename = TempFile("lent.y4m");
+  params.max_queued = 2;
+  std::vector<ColorMap32> frames(20, ColorMap32(8, 6));
+  std::atomic<int> released(0);
+  size_t accepted = 0;
+  {
+    FrameWriter writer(params, 8, 6);
+    for (size_t i = 0; i < frames.size(); ++i) {
+      Fill(frames[i], i * 10);
+      accepted += writer.Push(frames[i].GetArray(), [&released]() { 
+        ++released; 
+      });
+    }
+    writer.Flush();
+    EXPECT_EQ(released, 20);
+    auto stats = writer.GetStats();
+    EXPECT_EQ(stats.written, accepted);
+    EXPECT_EQ(stats.dropped, 20 - accepted);
+  }
+
+  // The first one is never dropped
+  std::string video = ReadFile(params.filename);
+  size_t header = FrameWriter::GetY4mHeader(8, 6, params.fps).size();
+  ASSERT_GT(video.size(), header + 6);
+  EXPECT_EQ((uint8_t)video[header + 6], 0);
+  std::remove(params.filename.c_str());
+}
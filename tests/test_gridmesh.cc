@@ -0,0 +1,106 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <gridmesh.h>
+#include <gtest/gtest.h>
+#include <cmath>
+
+static GridMesh::Params GetParams(GridMesh::RowDirection rows) {
+  GridMesh::Params params;
+  params.x_vertices = 33;
+  params.z_vertices = 17;
+  params.x_length = 10;
+  params.z_length = 7;
+  params.rows = rows;
+  params.n_threads = 3;
+  return params;
+}
+
+static float Wave(int x, int z) {
+  return std::sin(x * 0.3f) * std::cos(z * 0.2f);
+}
+
+TEST(GridMesh, FlatGridFacesUp) {
+  for (auto rows: {GridMesh::kRowsToNegativeZ, GridMesh::kRowsToPositiveZ}) {
+    auto mesh = GridMesh::Build(GetParams(rows), [](int, int) { return 0.0f; });
+    ASSERT_EQ(mesh->vertices.size(), 33u * 17u);
+    ASSERT_EQ(mesh->indices.size(), 32u * 16u * 6u);
+    EXPECT_TRUE(mesh->colors.empty());
+
+    for (auto& n: mesh->normals) {
+      EXPECT_FLOAT_EQ(n.y, 1);
+    }
+    for (size_t i = 0; i < mesh->indices.size(); i += 3) {
+      auto& a = mesh->vertices[mesh->indices[i]];
+      auto& b = mesh->vertices[mesh->indices[i + 1]];
+      auto& c = mesh->vertices[mesh->indices[i + 2]];
+      EXPECT_GT(glm::cross(b - a, c - a).y, 0);
+    }
+  }
+}
+
+TEST(GridMesh, RowDirection) {
+  auto neg = GridMesh::Build(GetParams(GridMesh::kRowsToNegativeZ), Wave);
+  auto pos = GridMesh::Build(GetParams(GridMesh::kRowsToPositiveZ), Wave);
+  EXPECT_FLOAT_EQ(neg->vertices.front().z,  3.5f);
+  EXPECT_FLOAT_EQ(pos->vertices.front().z, -3.5f);
+  EXPECT_FLOAT_EQ(pos->vertices.back().x,   5.0f);
+  EXPECT_FLOAT_EQ(pos->vertices[40].y, Wave(40 % 33, 40 / 33));
+}
+
+TEST(GridMesh, CloseToRecalculatedNormals) {
+  auto mesh = GridMesh::Build(GetParams(GridMesh::kRowsToNegativeZ), Wave);
+  Mesh recalculated = *mesh;
+  recalculated.RecalculateNormals();
+  for (size_t i = 0; i < mesh->normals.size(); ++i) {
+    EXPECT_GT(glm::dot(mesh->normals[i], recalculated.normals[i]), 0.99f);
+  }
+}
+
+TEST(GridMesh, SharedIndices) {
+  auto a = GridMesh::GetIndices(9, 5, GridMesh::kRowsToPositiveZ);
+  auto b = GridMesh::GetIndices(9, 5, GridMesh::kRowsToPositiveZ);
+  auto c = GridMesh::GetIndices(9, 5, GridMesh::kRowsToNegativeZ);
+  EXPECT_EQ(a, b);
+  EXPECT_NE(a, c);
+  GridMesh::ClearIndices();
+  EXPECT_NE(a, GridMesh::GetIndices(9, 5, GridMesh::kRowsToPositiveZ));
+}
+
+// One buffer in vRAM for the grids of the same size, while they live
+TEST(GridMesh, SharedIndexBuffer) {
+  auto params = GetParams(GridMesh::kRowsToPositiveZ);
+  auto a = GridMesh::Build(params, Wave);
+  auto b = GridMesh::Build(params, Wave);
+  ASSERT_TRUE(a->index_buffer);
+  EXPECT_EQ(a->index_buffer, b->index_buffer);
+  EXPECT_EQ(a->indices, a->index_buffer->GetIndices());
+  EXPECT_EQ((GLenum)GL_UNSIGNED_SHORT, a->index_buffer->GetType());
+  EXPECT_EQ(0u, a->index_buffer->GetId());
+
+  std::weak_ptr<IndexBuffer> buffer = a->index_buffer;
+  a.reset();
+  b.reset();
+  EXPECT_TRUE(buffer.expired());
+}
@@ -0,0 +1,162 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <lightclusters.h>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+
+static const float kNear = 0.5f;
+static const float kFar  = 300.0f;
+
+static glm::mat4 GetProj() {
+  return glm::perspective(glm::radians(60.0f), 16 / 9.0f, kNear, kFar);
+}
+
+static glm::mat4 GetView() {
+  return glm::lookAt(glm::vec3(5, 10, 20), glm::vec3(0, 0, -100), 
+                     glm::vec3(0, 1, 0));
+}
+
+static std::vector<LightClusters::Light> GetLights(size_t n, bool spots) {
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> pos(-150, 150);
+  std::uniform_real_distribution<float> range(1, 20);
+  std::uniform_real_distribution<float> unit(-1, 1);
+  std::vector<LightClusters::Light> lights(n);
+  for (size_t i = 0; i < n; ++i) {
+    auto& light = lights[i];
+    light.position = glm::vec3(pos(rng), pos(rng) * 0.1f, pos(rng) - 100);
+    light.range = range(rng);
+    if (spots && i % 2) {
+      light.direction = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + 
+                                       glm::vec3(0, 0, 0.01f));
+      light.spot_angle = glm::radians(10.0f + 30.0f * std::abs(unit(rng)));
+    }
+  }
+  return lights;
+}
+
+static bool IsLit(const LightClusters::Light& light, const glm::vec3& p) {
+  glm::vec3 v = p - light.position;
+  float distance = glm::length(v);
+  if (distance > light.range) {
+    return false;
+  }
+  if (light.spot_angle > 0 && distance > 0) {
+    return glm::dot(v / distance, light.direction) >= std::cos(light.spot_angle);
+  }
+  return true;
+}
+
+static LightClusters::Params GetParams(int n_threads) {
+  LightClusters::Params params;
+  params.n_threads = n_threads;
+  return params;
+}
+
+static void ExpectConservative(bool spots) {
+  auto lights = GetLights(2000, spots);
+  glm::mat4 view = GetView();
+  glm::mat4 proj = GetProj();
+  LightClusters clusters(GetParams(0));
+  clusters.Bin(lights, view, proj, kNear, kFar);
+
+  // Every lit point finds its lights in the cluster
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> ndc(-0.999f, 0.999f);
+  std::uniform_real_distribution<float> depth(0, 1);
+  glm::mat4 inv_view = glm::affineInverse(view);
+  int n_checked = 0;
+  for (int i = 0; i < 20000; ++i) {
+    float d = kNear * std::pow(kFar / kNear, depth(rng));
+    glm::vec3 p(d * ndc(rng) / proj[0][0], d * ndc(rng) / proj[1][1], -d);
+    int c = clusters.GetCluster(p);
+    ASSERT_GE(c, 0);
+    glm::uvec2 cluster = clusters.GetClusters()[c];
+    const uint32_t* begin = clusters.GetIndices().data() + cluster.x;
+    const uint32_t* end = begin + cluster.y;
+    glm::vec3 world(inv_view * glm::vec4(p, 1));
+    for (uint32_t l = 0; l < lights.size(); ++l) {
+      if (IsLit(lights[l], world)) {
+        EXPECT_TRUE(std::binary_search(begin, end, l)) << "light " << l;
+        ++n_checked;
+      }
+    }
+  }
+  EXPECT_GT(n_checked, 1000);
+}
+
+TEST(LightClusters, PointLightsConservative) {
+  ExpectConservative(false);
+}
+
+TEST(LightClusters, SpotLightsConservative) {
+  ExpectConservative(true);
+}
+
+TEST(LightClusters, ThreadsGiveTheSameResult) {
+  auto lights = GetLights(4000, true);
+  LightClusters single(GetParams(1));
+  LightClusters multi(GetParams(8));
+  single.Bin(lights, GetView(), GetProj(), kNear, kFar);
+  multi.Bin(lights, GetView(), GetProj(), kNear, kFar);
+  EXPECT_EQ(single.GetClusters(), multi.GetClusters());
+  EXPECT_EQ(single.GetIndices(), multi.GetIndices());
+  EXPECT_EQ(single.GetStats().indices, single.GetIndices().size());
+  EXPECT_EQ(single.GetStats().lights, 4000u);
+}
+
+TEST(LightClusters, Tight) {
+  // A small light right in front of the camera touches a few clusters only
+  LightClusters::Light light;
+  light.position = glm::vec3(0, 0, -10);
+  light.range = 1;
+  LightClusters clusters(GetParams(0));
+  clusters.Bin({light}, glm::mat4(1), GetProj(), kNear, kFar);
+  EXPECT_GT(clusters.GetIndices().size(), 0u);
+  EXPECT_LE(clusters.GetIndices().size(), 16u);
+  EXPECT_EQ(clusters.GetStats().max_cluster, 1u);
+
+  int c = clusters.GetCluster(light.position);
+  EXPECT_EQ(clusters.GetClusters()[c].y, 1u);
+  EXPECT_EQ(clusters.GetClusters()[clusters.GetCluster(glm::vec3(0, 0, -100))].y, 0u);
+
+  // Behind the camera and beyond the far plane
+  light.position = glm::vec3(0, 0, 10);
+  clusters.Bin({light}, glm::mat4(1), GetProj(), kNear, kFar);
+  EXPECT_EQ(clusters.GetIndices().size(), 0u);
+  light.position = glm::vec3(0, 0, -kFar - 2);
+  clusters.Bin({light}, glm::mat4(1), GetProj(), kNear, kFar);
+  EXPECT_EQ(clusters.GetIndices().size(), 0u);
+
+  // A spot light looking away from the camera skips the clusters behind it
+  light.position = glm::vec3(0, 0, -10);
+  light.range = 8;
+  light.direction = glm::vec3(0, 0, -1);
+  light.spot_angle = glm::radians(15.0f);
+  clusters.Bin({light}, glm::mat4(1), GetProj(), kNear, kFar);
+  EXPECT_EQ(clusters.GetClusters()[clusters.GetCluster(glm::vec3(0, 0, -3))].y, 0u);
+  EXPECT_EQ(clusters.GetClusters()[clusters.GetCluster(glm::vec3(0, 0, -15))].y, 1u);
+}
@@ -0,0 +1,231 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <looseoctree.h>
+#include <camera.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+
+struct Box {
+  glm::vec3 min;
+  glm::vec3 max;
+  bool      alive;
+};
+
+// Boxes of all the sizes, the world is 100 in every direction
+static glm::vec3 RandomBox(std::mt19937& rng, glm::vec3& max, 
+                           float range = 150) {
+  std::uniform_real_distribution<float> position(-range, range);
+  std::uniform_real_distribution<float> size(0, 1);
+  glm::vec3 center(position(rng), position(rng), position(rng));
+  float s = size(rng);
+  glm::vec3 half = glm::vec3(size(rng), size(rng), size(rng)) * 
+                   (s < 0.9f ? 2.0f : s < 0.99f ? 20.0f : 120.0f);
+  max = center + half;
+  return center - half;
+}
+
+static std::vector<uint32_t> BruteForce(const std::vector<Box>& boxes, 
+                                        const Frustum& frustum) {
+  std::vector<uint32_t> ids;
+  for (size_t i = 0; i < boxes.size(); ++i) {
+    if (boxes[i].alive && frustum.TestAabb(boxes[i].min, boxes[i].max)) {
+      ids.push_back(i);
+    }
+  }
+  return ids;
+}
+
+static std::vector<uint32_t> BruteForce(const std::vector<Box>& boxes, 
+                                        const glm::vec3& min, 
+                                        const glm::vec3& max) {
+  std::vector<uint32_t> ids;
+  for (size_t i = 0; i < boxes.size(); ++i) {
+    const Box& b = boxes[i];
+    if (b.alive && b.min.x <= max.x && min.x <= b.max.x && 
+        b.min.y <= max.y && min.y <= b.max.y && 
+        b.min.z <= max.z && min.z <= b.max.z) {
+      ids.push_back(i);
+    }
+  }
+  return ids;
+}
+
+static void ExpectSameAsBruteForce(LooseOctree& octree, 
+                                   const std::vector<Box>& boxes, int seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> position(-120, 120);
+  for (int i = 0; i < 20; ++i) {
+    glm::vec3 eye(position(rng), position(rng), position(rng));
+    glm::vec3 target(position(rng), position(rng), position(rng));
+    Frustum frustum;
+    frustum.Calculate(
+        glm::perspective(glm::radians(60.0f), 16 / 9.0f, 0.5f, 80.0f) * 
+        glm::lookAt(eye, target, glm::vec3(0, 1, 0)));
+    std::vector<uint32_t> ids;
+    octree.Query(frustum, ids);
+    std::sort(ids.begin(), ids.end());
+    ASSERT_EQ(BruteForce(boxes, frustum), ids);
+
+    glm::vec3 half(std::abs(position(rng)) * 0.3f);
+    ids.clear();
+    octree.Query(eye - half, eye + half, ids);
+    std::sort(ids.begin(), ids.end());
+    ASSERT_EQ(BruteForce(boxes, eye - half, eye + half), ids);
+  }
+}
+
+TEST(LooseOctree, Query) {
+  LooseOctree::Params params;
+  params.half_size = 100;
+  params.max_depth = 6;
+  LooseOctree octree(params);
+  std::mt19937 rng(1);
+  std::vector<Box> boxes;
+  for (int i = 0; i < 5000; ++i) {
+    Box box;
+    box.min = RandomBox(rng, box.max, 90);
+    box.alive = true;
+    ASSERT_EQ(i, octree.Add(box.min, box.max));
+    boxes.push_back(box);
+  }
+  EXPECT_EQ(5000u, octree.GetStats().objects);
+  ExpectSameAsBruteForce(octree, boxes, 2);
+
+  // 40 queries, a small part of the boxes tested
+  auto& stats = octree.GetStats();
+  EXPECT_LT(stats.object_tests, 40 * 5000 / 10);
+  EXPECT_GT(stats.node_tests, 0u);
+  octree.ResetStats();
+  EXPECT_EQ(0u, octree.GetStats().object_tests);
+}
+
+TEST(LooseOctree, UpdateAndRemove) {
+  LooseOctree::Params params;
+  params.half_size = 100;
+  params.max_depth = 6;
+  LooseOctree octree(params);
+  std::mt19937 rng(4);
+  std::vector<Box> boxes;
+  for (int i = 0; i < 3000; ++i) {
+    Box box;
+    box.min = RandomBox(rng, box.max);
+    box.alive = true;
+    octree.Add(box.min, box.max);
+    boxes.push_back(box);
+  }
+
+  std::uniform_real_distribution<float> step(-3, 3);
+  std::uniform_int_distribution<int> action(0, 19);
+  for (int frame = 0; frame < 10; ++frame) {
+    for (size_t i = 0; i < boxes.size(); ++i) {
+      Box& box = boxes[i];
+      if (!box.alive) {
+        continue;
+      }
+      int a = action(rng);
+      if (a == 0) {
+        octree.Remove(i);
+        box.alive = false;
+      } else if (a < 5) {
+        box.min = RandomBox(rng, box.max); // Teleport
+        octree.Update(i, box.min, box.max);
+      } else if (a < 15) {
+        glm::vec3 d(step(rng), step(rng), step(rng));
+        box.min += d;
+        box.max += d;
+        octree.Update(i, box.min, box.max);
+      }
+      glm::vec3 min, max;
+      octree.GetBounds(i, min, max);
+      if (box.alive) {
+        ASSERT_EQ(box.min, min);
+      }
+    }
+    ExpectSameAsBruteForce(octree, boxes, frame);
+  }
+  EXPECT_GT(octree.GetStats().moves, 0u);
+
+  // The removed ids come back
+  Box box;
+  box.min = glm::vec3(-1);
+  box.max = glm::vec3(1);
+  box.alive = true;
+  uint32_t id = octree.Add(box.min, box.max);
+  ASSERT_LT(id, boxes.size());
+  EXPECT_FALSE(boxes[id].alive);
+  boxes[id] = box;
+  ExpectSameAsBruteForce(octree, boxes, 11);
+
+  // All the empty nodes go
+  for (size_t i = 0; i < boxes.size(); ++i) {
+    if (boxes[i].alive) {
+      octree.Remove(i);
+    }
+  }
+  EXPECT_EQ(0u, octree.GetStats().objects);
+  EXPECT_EQ(1u, octree.GetStats().nodes);
+}
+
+TEST(LooseOctree, OutOfWorld) {
+  LooseOctree::Params params;
+  params.half_size = 10;
+  LooseOctree octree(params);
+  uint32_t far = octree.Add(glm::vec3(1000), glm::vec3(1001));
+  uint32_t big = octree.Add(glm::vec3(-50), glm::vec3(50));
+  uint32_t small = octree.Add(glm::vec3(1), glm::vec3(1.1f));
+  EXPECT_GT(octree.GetStats().nodes, 1u);
+
+  std::vector<uint32_t> ids;
+  octree.Query(glm::vec3(900), glm::vec3(1100), ids);
+  EXPECT_EQ(std::vector<uint32_t>({far}), ids);
+
+  ids.clear();
+  octree.Query(glm::vec3(0.9f), glm::vec3(1.2f), ids);
+  std::sort(ids.begin(), ids.end());
+  EXPECT_EQ(std::vector<uint32_t>({big, small}), ids);
+
+  // Into the world and out again
+  octree.Update(small, glm::vec3(2000), glm::vec3(2001));
+  EXPECT_EQ(1u, octree.GetStats().nodes);
+  octree.Update(far, glm::vec3(-5), glm::vec3(-4.9f));
+  ids.clear();
+  octree.Query(glm::vec3(-10), glm::vec3(0), ids);
+  std::sort(ids.begin(), ids.end());
+  EXPECT_EQ(std::vector<uint32_t>({far, big}), ids);
+}
+
+TEST(Frustum, ClassifyAabb) {
+  Frustum frustum;
+  frustum.Calculate(glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, 0.0f, 100.0f));
+  EXPECT_EQ(Frustum::kInside, 
+            frustum.ClassifyAabb(glm::vec3(-1, -1, -10), glm::vec3(1, 1, -5)));
+  EXPECT_EQ(Frustum::kIntersects, 
+            frustum.ClassifyAabb(glm::vec3(5, -1, -10), glm::vec3(15, 1, -5)));
+  EXPECT_EQ(Frustum::kOutside, 
+            frustum.ClassifyAabb(glm::vec3(15, -1, -10), glm::vec3(20, 1, -5)));
+  EXPECT_EQ(Frustum::kIntersects, 
+            frustum.ClassifyAabb(glm::vec3(-1, -1, -1), glm::vec3(1, 1, 1)));
+}
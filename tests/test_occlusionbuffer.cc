@@ -0,0 +1,119 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <occlusionbuffer.h>
+#include <gtest/gtest.h>
+#include <vector>
+
+// Camera at the origin looking at -z
+static glm::mat4 GetPv() {
+  return glm::perspective(glm::radians(60.0f), 2.0f, 1.0f, 1000.0f) *
+         glm::lookAt(glm::vec3(0, 0, 0), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0));
+}
+
+// size x size wall at the distance, facing the camera
+static void AddWall(OcclusionBuffer& buffer, float distance, float size) {
+  std::vector<glm::vec3> vertices = {
+    glm::vec3(-size, -size, 0), glm::vec3(size, -size, 0),
+    glm::vec3( size,  size, 0), glm::vec3(-size, size, 0)
+  };
+  std::vector<uint32_t> indices = {0, 1, 2, 0, 2, 3};
+  glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(0, 0, -distance));
+  buffer.AddOccluder(vertices, indices, model);
+}
+
+static OcclusionBuffer::Params GetParams(OcclusionBuffer::Isa isa, int n_threads) {
+  OcclusionBuffer::Params params;
+  params.isa = isa;
+  params.n_threads = n_threads;
+  return params;
+}
+
+TEST(OcclusionBuffer, WallHidesWhatIsBehind) {
+  OcclusionBuffer buffer(GetParams(OcclusionBuffer::Isa::kBest, 0));
+  buffer.Begin(GetPv());
+  AddWall(buffer, 10, 4);
+  buffer.Rasterize();
+  EXPECT_EQ(buffer.GetStats().triangles, 2u);
+
+  // Behind the wall
+  EXPECT_FALSE(buffer.TestAabb(glm::vec3(-1, -1, -30), glm::vec3(1, 1, -20)));
+  // In front of the wall
+  EXPECT_TRUE(buffer.TestAabb(glm::vec3(-1, -1, -8), glm::vec3(1, 1, -6)));
+  // Behind, but sticks out on the side
+  EXPECT_TRUE(buffer.TestAabb(glm::vec3(2, -1, -30), glm::vec3(20, 1, -20)));
+  // Crosses the near plane
+  EXPECT_TRUE(buffer.TestAabb(glm::vec3(-1, -1, -30), glm::vec3(1, 1, 1)));
+  // Local box moved behind the wall by the model matrix
+  glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(0, 0, -50));
+  EXPECT_FALSE(buffer.TestAabb(glm::vec3(-1), glm::vec3(1), model));
+
+  EXPECT_EQ(buffer.GetStats().tested, 5u);
+  EXPECT_EQ(buffer.GetStats().occluded, 2u);
+}
+
+TEST(OcclusionBuffer, NearPlaneOccludersAreSkipped) {
+  OcclusionBuffer buffer(GetParams(OcclusionBuffer::Isa::kBest, 1));
+  buffer.Begin(GetPv());
+  // Floor under the camera, from behind it to far away 
+  std::vector<glm::vec3> vertices = {
+    glm::vec3(-100, -1, 10), glm::vec3(100, -1, 10), glm::vec3(0, -1, -100)
+  };
+  buffer.AddOccluder(vertices, {}, glm::mat4(1.0f));
+  buffer.Rasterize();
+  EXPECT_EQ(buffer.GetStats().triangles, 0u);
+  EXPECT_TRUE(buffer.TestAabb(glm::vec3(-1, -3, -60), glm::vec3(1, -2, -50)));
+}
+
+TEST(OcclusionBuffer, SimdAndThreadsMatchScalar) {
+  OcclusionBuffer scalar(GetParams(OcclusionBuffer::Isa::kScalar, 1));
+  OcclusionBuffer simd(GetParams(OcclusionBuffer::Isa::kBest, 4));
+  for (auto buffer: {&scalar, &simd}) {
+    buffer->Begin(GetPv());
+    // Slanted walls at odd angles for the partial coverage
+    for (int i = 0; i < 10; ++i) {
+      std::vector<glm::vec3> vertices = {
+        glm::vec3(-3 + i, -2, -5 - i), glm::vec3(1 + i * 0.7f, -1.3f, -15), 
+        glm::vec3(-2, 3 - i * 0.3f, -8 - i * 2)
+      };
+      buffer->AddOccluder(vertices, {}, glm::mat4(1.0f));
+    }
+    buffer->Rasterize();
+  }
+
+  int covered = 0;
+  for (int y = 0; y < scalar.GetHeight(); ++y) {
+    for (int x = 0; x < scalar.GetWidth(); ++x) {
+      ASSERT_EQ(scalar.GetDepth(x, y), simd.GetDepth(x, y)) << x << " " << y;
+      covered += scalar.GetDepth(x, y) < 1;
+    }
+  }
+  EXPECT_GT(covered, 100);
+
+  for (int ty = 0; ty < scalar.GetHeight() / OcclusionBuffer::kTileSize; ++ty) {
+    for (int tx = 0; tx < scalar.GetWidth() / OcclusionBuffer::kTileSize; ++tx) {
+      EXPECT_EQ(scalar.GetTileMax(tx, ty), simd.GetTileMax(tx, ty));
+    }
+  }
+}
@@ -0,0 +1,96 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <noise/perlin.h>
+#include <gtest/gtest.h>
+#include <cstring>
+#include <vector>
+
+using Noise::Perlin;
+
+static std::vector<float> FillWith(Perlin::Isa isa, int n_threads, 
+                                   const Perlin::FbmParams& params) {
+  const int kWidth = 67, kHeight = 33;
+  std::vector<float> grid(kWidth * kHeight);
+  Perlin::SetIsa(isa);
+  Perlin::FillFbm(grid.data(), kWidth, kHeight, -3.7f, 11.2f, 0.173f, 
+                  params, n_threads);
+  Perlin::SetIsa(Perlin::Isa::kBest);
+  return grid;
+}
+
+static Perlin::FbmParams GetParams() {
+  Perlin::FbmParams params;
+  params.octaves = 4;
+  params.lacunarity = 1.9f;
+  params.offset_x = {0, 13.5f, -7.25f};
+  params.offset_y = {0, 2.5f};
+  return params;
+}
+
+TEST(Perlin, SameOnAllInstructionSets) {
+  auto params = GetParams();
+  auto scalar = FillWith(Perlin::Isa::kScalar, 1, params);
+  for (auto isa: {Perlin::Isa::kSse2, Perlin::Isa::kAvx2, Perlin::Isa::kBest}) {
+    auto other = FillWith(isa, 1, params);
+    EXPECT_EQ(0, memcmp(scalar.data(), other.data(), 
+                        scalar.size() * sizeof(float)));
+  }
+}
+
+TEST(Perlin, SameWithThreads) {
+  auto params = GetParams();
+  auto single = FillWith(Perlin::Isa::kBest, 1, params);
+  auto multi = FillWith(Perlin::Isa::kBest, 5, params);
+  EXPECT_EQ(0, memcmp(single.data(), multi.data(), 
+                      single.size() * sizeof(float)));
+}
+
+TEST(Perlin, GridMatchesSinglePoint) {
+  auto params = GetParams();
+  auto grid = FillWith(Perlin::Isa::kBest, 0, params);
+  for (int j = 0; j < 33; j += 4) {
+    for (int i = 0; i < 67; i += 3) {
+      float x = -3.7f + (float)i * 0.173f;
+      float y = 11.2f + (float)j * 0.173f;
+      EXPECT_FLOAT_EQ(Perlin::Fbm(x, y, params), grid[i + j * 67]);
+    }
+  }
+
+  float row[16];
+  Perlin::Fill(row, 16, 1, 0.31f, 4.4f, 0.5f);
+  for (int i = 0; i < 16; ++i) {
+    EXPECT_FLOAT_EQ(Perlin::Get(0.31f + (float)i * 0.5f, 4.4f), row[i]);
+  }
+}
+
+TEST(Perlin, Seed) {
+  Perlin::Seed(42);
+  float a = Perlin::Get(1.3f, 2.7f);
+  Perlin::Seed(7);
+  float b = Perlin::Get(1.3f, 2.7f);
+  Perlin::Seed(42);
+  EXPECT_FLOAT_EQ(a, Perlin::Get(1.3f, 2.7f));
+  EXPECT_NE(a, b);
+}
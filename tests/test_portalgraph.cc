@@ -0,0 +1,189 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <portalgraph.h>
+#include <camera.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+
+// Rooms 10 x 4 x 10 one after another along -z, 2 x 3 doors in the middle
+static PortalGraph MakeCorridor(int n_rooms) {
+  PortalGraph graph;
+  for (int i = 0; i < n_rooms; ++i) {
+    graph.AddCell(glm::vec3(-5, 0, -10 * (i + 1)), glm::vec3(5, 4, -10 * i));
+  }
+  for (int i = 0; i + 1 < n_rooms; ++i) {
+    float z = -10 * (i + 1);
+    graph.AddPortal(i, i + 1, {{-1, 0, z}, {1, 0, z}, {1, 3, z}, {-1, 3, z}});
+  }
+  return graph;
+}
+
+static Frustum MakeFrustum(const glm::vec3& eye, const glm::vec3& target) {
+  Frustum frustum;
+  frustum.Calculate(glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f) *
+                    glm::lookAt(eye, target, glm::vec3(0, 1, 0)));
+  return frustum;
+}
+
+static uint32_t AddBox(PortalGraph& graph, const glm::vec3& center) {
+  return graph.Add(center - 0.2f, center + 0.2f);
+}
+
+static std::vector<uint32_t> Query(PortalGraph& graph, const glm::vec3& eye,
+                                   const Frustum& frustum) {
+  std::vector<uint32_t> ids;
+  graph.Query(eye, frustum, ids);
+  std::sort(ids.begin(), ids.end());
+  return ids;
+}
+
+TEST(PortalGraph, Corridor) {
+  PortalGraph graph = MakeCorridor(4);
+  EXPECT_EQ(4u, graph.GetCellCount());
+  EXPECT_EQ(3u, graph.GetPortalCount());
+  EXPECT_EQ(0, graph.FindCell(glm::vec3(0, 2, -1)));
+  EXPECT_EQ(2, graph.FindCell(glm::vec3(3, 1, -25)));
+  EXPECT_EQ(-1, graph.FindCell(glm::vec3(0, 2, 1)));
+
+  uint32_t near = AddBox(graph, glm::vec3(4, 1.5f, -8));
+  uint32_t through_door = AddBox(graph, glm::vec3(0.5f, 1.5f, -15));
+  AddBox(graph, glm::vec3(4, 1.5f, -15)); // Behind the wall
+  uint32_t far = AddBox(graph, glm::vec3(0, 1.5f, -25));
+  AddBox(graph, glm::vec3(-4, 1.5f, -35)); // Behind the wall
+  AddBox(graph, glm::vec3(0, 1.5f, -0.5f)); // Behind the eye
+
+  glm::vec3 eye(0, 2, -1);
+  Frustum frustum = MakeFrustum(eye, glm::vec3(0, 2, -10));
+  EXPECT_TRUE(frustum.TestAabb(glm::vec3(3.8f, 1.3f, -15.2f), 
+                               glm::vec3(4.2f, 1.7f, -14.8f)));
+  EXPECT_EQ(std::vector<uint32_t>({near, through_door, far}), 
+            Query(graph, eye, frustum));
+  auto& stats = graph.GetStats();
+  EXPECT_FALSE(stats.outside);
+  EXPECT_EQ(4u, stats.cells_visited);
+  EXPECT_EQ(3u, stats.portals_passed);
+  EXPECT_EQ(3u, stats.objects_culled);
+  ASSERT_EQ(4u, graph.GetViews().size());
+  EXPECT_EQ(3, graph.GetViews().back().depth);
+
+  // Looking at the side wall, the doors are out of the frustum
+  frustum = MakeFrustum(eye, glm::vec3(5, 2, -1));
+  Query(graph, eye, frustum);
+  EXPECT_EQ(1u, graph.GetStats().cells_visited);
+  EXPECT_EQ(0u, graph.GetStats().portals_passed);
+
+  // Out of all the cells, the frustum only
+  eye = glm::vec3(0, 2, 5);
+  frustum = MakeFrustum(eye, glm::vec3(0, 2, -10));
+  Query(graph, eye, frustum);
+  EXPECT_TRUE(graph.GetStats().outside);
+  EXPECT_EQ(6u, graph.GetStats().objects_found);
+}
+
+TEST(PortalGraph, UpdateAndRemove) {
+  PortalGraph graph = MakeCorridor(3);
+  glm::vec3 eye(0, 2, -1);
+  Frustum frustum = MakeFrustum(eye, glm::vec3(0, 2, -10));
+
+  uint32_t box = AddBox(graph, glm::vec3(4, 1.5f, -15));
+  EXPECT_TRUE(Query(graph, eye, frustum).empty());
+
+  // Into the view, then on the wall between the rooms
+  graph.Update(box, glm::vec3(0.3f, 1.3f, -15.2f), glm::vec3(0.7f, 1.7f, -14.8f));
+  EXPECT_EQ(std::vector<uint32_t>({box}), Query(graph, eye, frustum));
+  graph.Update(box, glm::vec3(0.3f, 1.3f, -20.2f), glm::vec3(0.7f, 1.7f, -19.8f));
+  EXPECT_EQ(std::vector<uint32_t>({box}), Query(graph, eye, frustum));
+  EXPECT_EQ(1u, graph.GetStats().objects_tested); // Once for two cells
+
+  // Out of the building, the frustum only
+  graph.Update(box, glm::vec3(30, 1, -31), glm::vec3(31, 2, -30));
+  EXPECT_EQ(std::vector<uint32_t>({box}), Query(graph, eye, frustum));
+
+  uint32_t other = AddBox(graph, glm::vec3(0, 1.5f, -5));
+  graph.Remove(box);
+  EXPECT_EQ(std::vector<uint32_t>({other}), Query(graph, eye, frustum));
+  EXPECT_EQ(box, AddBox(graph, glm::vec3(4, 1.5f, -15)));
+  EXPECT_EQ(1u, graph.GetStats().objects_found);
+}
+
+// The rooms on a grid, every wall has a door: all that is found is in the
+// camera frustum, all that is in the frustum and in the cell of the eye is
+// found
+TEST(PortalGraph, Grid) {
+  const int kSize = 8;
+  PortalGraph graph;
+  for (int z = 0; z < kSize; ++z) {
+    for (int x = 0; x < kSize; ++x) {
+      graph.AddCell(glm::vec3(x * 10, 0, z * 10), 
+                    glm::vec3(x * 10 + 10, 4, z * 10 + 10));
+    }
+  }
+  for (int z = 0; z < kSize; ++z) {
+    for (int x = 0; x < kSize; ++x) {
+      int cell = z * kSize + x;
+      if (x + 1 < kSize) {
+        float px = x * 10 + 10, pz = z * 10 + 5;
+        graph.AddPortal(cell, cell + 1, {{px, 0, pz - 1}, {px, 0, pz + 1}, 
+                                         {px, 3, pz + 1}, {px, 3, pz - 1}});
+      }
+      if (z + 1 < kSize) {
+        float px = x * 10 + 5, pz = z * 10 + 10;
+        graph.AddPortal(cell, cell + kSize, {{px - 1, 0, pz}, {px + 1, 0, pz},
+                                             {px + 1, 3, pz}, {px - 1, 3, pz}});
+      }
+    }
+  }
+
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> position(0, kSize * 10);
+  std::uniform_real_distribution<float> height(0.5f, 3.5f);
+  std::vector<glm::vec3> centers;
+  for (int i = 0; i < 2000; ++i) {
+    centers.emplace_back(position(rng), height(rng), position(rng));
+    AddBox(graph, centers.back());
+  }
+
+  size_t n_culled = 0;
+  for (int i = 0; i < 50; ++i) {
+    glm::vec3 eye(position(rng), 2, position(rng));
+    glm::vec3 target(position(rng), 2, position(rng));
+    Frustum frustum = MakeFrustum(eye, target);
+    auto ids = Query(graph, eye, frustum);
+    int cell = graph.FindCell(eye);
+    for (uint32_t id = 0; id < centers.size(); ++id) {
+      bool in_frustum = frustum.TestAabb(centers[id] - 0.2f, centers[id] + 0.2f);
+      bool found = std::binary_search(ids.begin(), ids.end(), id);
+      if (found) {
+        ASSERT_TRUE(in_frustum);
+      }
+      if (in_frustum && graph.FindCell(centers[id]) == cell) {
+        ASSERT_TRUE(found);
+      }
+      n_culled += in_frustum && !found;
+    }
+  }
+  EXPECT_GT(n_culled, 0u);
+}
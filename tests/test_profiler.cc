@@ -0,0 +1,115 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <profiler.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <thread>
+
+static int CountEvents(const Profiler::Frame& frame, const char* name) {
+  return std::count_if(frame.cpu.begin(), frame.cpu.end(), 
+      [name](const Profiler::Event& e) { return std::strcmp(e.name, name) == 0; });
+}
+
+TEST(Profiler, ScopesFromAllThreads) {
+  auto& profiler = Profiler::Instance();
+  profiler.BeginFrame();
+  {
+    ProfileScope scope("Main");
+    std::thread worker([]() { 
+      ProfileScope scope("Worker"); 
+    });
+    worker.join();
+  }
+  profiler.EndFrame();
+
+  auto& frame = profiler.GetLastFrame();
+  EXPECT_EQ(1, CountEvents(frame, "Main"));
+  EXPECT_EQ(1, CountEvents(frame, "Worker"));
+  EXPECT_EQ(1, CountEvents(frame, "Frame"));
+  for (auto& event: frame.cpu) {
+    EXPECT_LE(frame.begin_ns, event.begin_ns);
+    EXPECT_LE(event.begin_ns, event.end_ns);
+    EXPECT_LE(event.end_ns, frame.end_ns);
+  }
+  auto main = std::find_if(frame.cpu.begin(), frame.cpu.end(), 
+      [](const Profiler::Event& e) { return std::strcmp(e.name, "Main") == 0; });
+  auto worker = std::find_if(frame.cpu.begin(), frame.cpu.end(), 
+      [](const Profiler::Event& e) { return std::strcmp(e.name, "Worker") == 0; });
+  EXPECT_NE(main->thread, worker->thread);
+
+  // The events go to one frame only
+  profiler.BeginFrame();
+  profiler.EndFrame();
+  EXPECT_EQ(0, CountEvents(profiler.GetLastFrame(), "Main"));
+}
+
+TEST(Profiler, CountersResetPerFrame) {
+  auto& profiler = Profiler::Instance();
+  profiler.BeginFrame();
+  profiler.Count(Profiler::kDrawCalls, 2);
+  profiler.Count(Profiler::kTriangles, 100);
+  profiler.Count(Profiler::kDrawCalls, 1);
+  profiler.EndFrame();
+  EXPECT_EQ(3, profiler.GetLastFrame().counters[Profiler::kDrawCalls]);
+  EXPECT_EQ(100, profiler.GetLastFrame().counters[Profiler::kTriangles]);
+  EXPECT_EQ(0, profiler.GetLastFrame().counters[Profiler::kUploads]);
+
+  profiler.BeginFrame();
+  profiler.EndFrame();
+  EXPECT_EQ(0, profiler.GetLastFrame().counters[Profiler::kDrawCalls]);
+}
+
+TEST(Profiler, InternIsStable) {
+  auto& profiler = Profiler::Instance();
+  const char* a = profiler.Intern("material/pass");
+  const char* b = profiler.Intern(std::string("material/") + "pass");
+  EXPECT_EQ(a, b);
+  EXPECT_STREQ("material/pass", a);
+  EXPECT_NE(a, profiler.Intern("material/other"));
+}
+
+TEST(Profiler, Trace) {
+  auto& profiler = Profiler::Instance();
+  profiler.StartTrace(2);
+  EXPECT_TRUE(profiler.IsTracing());
+  for (int i = 0; i < 3; ++i) {
+    profiler.BeginFrame();
+    {
+      ProfileScope scope(i < 2 ? "Traced \"scope\"" : "Not traced");
+      profiler.Count(Profiler::kDrawCalls, 7);
+    }
+    profiler.EndFrame();
+  }
+  EXPECT_FALSE(profiler.IsTracing());
+
+  std::string trace = profiler.GetTrace();
+  EXPECT_EQ(0u, trace.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+  EXPECT_EQ('}', trace[trace.find_last_not_of("\n")]);
+  EXPECT_NE(std::string::npos, trace.find("\"name\":\"Traced \\\"scope\\\"\""));
+  EXPECT_EQ(std::string::npos, trace.find("Not traced"));
+  EXPECT_NE(std::string::npos, trace.find("\"draw_calls\":7"));
+}
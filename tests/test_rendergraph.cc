@@ -0,0 +1,161 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <rendergraph.h>
+#include <gtest/gtest.h>
+
+static RenderGraph::Resource ColorResource(int w, int h) {
+  RenderGraph::Resource resource;
+  resource.width = w;
+  resource.height = h;
+  return resource;
+}
+
+static RenderGraph::Pass Pass(const std::string& name, 
+                              const std::vector<std::string>& reads,
+                              const std::vector<std::string>& writes) {
+  RenderGraph::Pass pass;
+  pass.name = name;
+  pass.reads = reads;
+  pass.writes = writes;
+  return pass;
+}
+
+// A stand-in for the imported textures, never bound
+struct NullTexture : public Texture {
+  void Bind(int) override {}
+  void Unbind(int) override {}
+};
+
+TEST(RenderGraph, OrdersByDependencies) {
+  RenderGraph graph;
+  graph.Import("scene", std::make_shared<NullTexture>());
+  graph.AddResource("a", ColorResource(64, 64));
+  graph.AddResource("b", ColorResource(64, 64));
+  graph.AddResource("c", ColorResource(64, 64));
+  // Declared out of order
+  graph.AddPass(Pass("pc", {"b", "scene"}, {"c"}));
+  graph.AddPass(Pass("pb", {"a"}, {"b"}));
+  graph.AddPass(Pass("pa", {"scene"}, {"a"}));
+  graph.Output("c");
+  graph.Compile();
+  EXPECT_EQ(graph.GetOrder(), (std::vector<std::string>{"pa", "pb", "pc"}));
+  EXPECT_EQ(graph.GetPhysical("scene"), -1);
+}
+
+TEST(RenderGraph, CullsUnusedPasses) {
+  RenderGraph graph;
+  graph.Import("scene", std::make_shared<NullTexture>());
+  graph.AddResource("a", ColorResource(64, 64));
+  graph.AddResource("debug", ColorResource(64, 64));
+  graph.AddResource("debug2", ColorResource(64, 64));
+  graph.AddResource("b", ColorResource(64, 64));
+  graph.AddPass(Pass("pa", {"scene"}, {"a"}));
+  graph.AddPass(Pass("debug", {"a"}, {"debug"}));
+  graph.AddPass(Pass("debug2", {"debug"}, {"debug2"}));
+  graph.AddPass(Pass("pb", {"a"}, {"b"}));
+  graph.Output("b");
+  graph.Compile();
+  EXPECT_EQ(graph.GetOrder(), (std::vector<std::string>{"pa", "pb"}));
+  EXPECT_TRUE(graph.IsCulled("debug"));
+  EXPECT_TRUE(graph.IsCulled("debug2"));
+  EXPECT_FALSE(graph.IsCulled("pa"));
+  EXPECT_EQ(graph.GetPhysical("debug"), -1);
+  EXPECT_EQ(graph.GetStats().culled, 2u);
+
+  // Unless they are outputs
+  graph.Output("debug2");
+  graph.Compile();
+  EXPECT_EQ(graph.GetOrder().size(), 4u);
+}
+
+TEST(RenderGraph, AliasesDeadResources) {
+  // Ping-pong blur chain, the radial shafts pipeline
+  RenderGraph graph;
+  graph.Import("scene", std::make_shared<NullTexture>());
+  const char* names[] = {"highlight", "radial", "hblur", "vblur"};
+  std::string prev = "scene";
+  for (auto name: names) {
+    graph.AddResource(name, ColorResource(160, 90));
+    graph.AddPass(Pass(name, {prev}, {name}));
+    prev = name;
+  }
+  graph.AddResource("hblur2", ColorResource(80, 45));
+  graph.AddResource("vblur2", ColorResource(80, 45));
+  graph.AddResource("combine", ColorResource(1280, 720));
+  graph.AddPass(Pass("hblur2", {"vblur"}, {"hblur2"}));
+  graph.AddPass(Pass("vblur2", {"hblur2"}, {"vblur2"}));
+  graph.AddPass(Pass("combine", {"scene", "vblur2"}, {"combine"}));
+  graph.Output("combine");
+  graph.Compile();
+
+  // Overlapping lifetimes never share
+  EXPECT_NE(graph.GetPhysical("highlight"), graph.GetPhysical("radial"));
+  EXPECT_NE(graph.GetPhysical("radial"), graph.GetPhysical("hblur"));
+  EXPECT_NE(graph.GetPhysical("hblur2"), graph.GetPhysical("vblur2"));
+  // Dead ones do, the sizes match
+  EXPECT_EQ(graph.GetPhysical("highlight"), graph.GetPhysical("hblur"));
+  EXPECT_EQ(graph.GetPhysical("radial"), graph.GetPhysical("vblur"));
+
+  auto& stats = graph.GetStats();
+  EXPECT_EQ(stats.resources, 7u);
+  EXPECT_EQ(stats.textures, 5u);
+  EXPECT_EQ(stats.bytes_unaliased, (4 * 160 * 90 + 2 * 80 * 45 + 1280 * 720) * 4u);
+  EXPECT_EQ(stats.bytes, (2 * 160 * 90 + 2 * 80 * 45 + 1280 * 720) * 4u);
+}
+
+TEST(RenderGraph, OutputsAreNotAliased) {
+  RenderGraph graph;
+  graph.Import("scene", std::make_shared<NullTexture>());
+  graph.AddResource("a", ColorResource(64, 64));
+  graph.AddResource("b", ColorResource(64, 64));
+  graph.AddResource("c", ColorResource(64, 64));
+  graph.AddPass(Pass("pa", {"scene"}, {"a"}));
+  graph.AddPass(Pass("pb", {"a"}, {"b"}));
+  graph.AddPass(Pass("pc", {"b"}, {"c"}));
+  graph.Output("c");
+  graph.Compile();
+  EXPECT_EQ(graph.GetPhysical("a"), graph.GetPhysical("c"));
+
+  // The output is read after the graph, a is displayed too
+  graph.Output("a");
+  graph.Compile();
+  EXPECT_NE(graph.GetPhysical("a"), graph.GetPhysical("c"));
+  EXPECT_EQ(graph.GetStats().textures, 3u);
+}
+
+TEST(RenderGraph, DepthIsNotAliasedWithColor) {
+  RenderGraph graph;
+  RenderGraph::Resource depth = ColorResource(64, 64);
+  depth.type = Layer::kDepth;
+  graph.AddResource("color", ColorResource(64, 64));
+  graph.AddResource("depth", depth);
+  graph.AddResource("post", ColorResource(64, 64));
+  graph.AddPass(Pass("scene", {}, {"color", "depth"}));
+  graph.AddPass(Pass("post", {"color"}, {"post"}));
+  graph.Output("post");
+  graph.Compile();
+  EXPECT_EQ(graph.GetOrder().size(), 2u);
+  EXPECT_EQ(graph.GetStats().textures, 3u);
+}
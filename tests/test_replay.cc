@@ -0,0 +1,174 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <framestats.h>
+#include <inputtrack.h>
+#include <camerapath.h>
+#include <timer.h>
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+TEST(Timer, FixedStep) {
+  Timer timer;
+  timer.SetFixedStep(0.25);
+  for (int i = 0; i < 1000; ++i) {
+    timer.Tick();
+  }
+  EXPECT_EQ(1000, timer.GetFrameNumber());
+  EXPECT_FLOAT_EQ(999 * 0.25f, timer.GetTime());
+  EXPECT_FLOAT_EQ(0.25f, timer.GetTimeDelta());
+}
+
+TEST(FrameStats, Percentiles) {
+  FrameStats stats;
+  for (int i = 1; i <= 100; ++i) {
+    FrameStats::Frame frame;
+    frame.ms = 101 - i; // Order does not matter
+    frame.phase_ms[FrameStats::kDraw] = 2;
+    frame.allocations = i % 2 ? 10 : 0;
+    stats.Add(frame);
+  }
+  auto summary = stats.GetSummary();
+  EXPECT_EQ(100u, summary.frames);
+  EXPECT_DOUBLE_EQ(50, summary.ms_p50);
+  EXPECT_DOUBLE_EQ(95, summary.ms_p95);
+  EXPECT_DOUBLE_EQ(99, summary.ms_p99);
+  EXPECT_DOUBLE_EQ(100, summary.ms_max);
+  EXPECT_DOUBLE_EQ(50.5, summary.ms_avg);
+  EXPECT_DOUBLE_EQ(2, summary.phase_ms[FrameStats::kDraw]);
+  EXPECT_DOUBLE_EQ(0, summary.phase_ms[FrameStats::kUpdate]);
+  EXPECT_DOUBLE_EQ(5, summary.allocations);
+}
+
+TEST(FrameStats, WarmupAndPhases) {
+  FrameStats stats(2);
+  for (int i = 0; i < 5; ++i) {
+    stats.BeginFrame();
+    stats.Mark(FrameStats::kInput);
+    stats.Mark(FrameStats::kUpdate);
+    stats.Mark(FrameStats::kDraw);
+    stats.Mark(FrameStats::kPresent);
+    stats.EndFrame();
+  }
+  // Outside of a frame
+  stats.Mark(FrameStats::kDraw);
+  stats.EndFrame();
+
+  ASSERT_EQ(3u, stats.GetFrames().size());
+  for (auto& frame: stats.GetFrames()) {
+    double phases = 0;
+    for (double ms: frame.phase_ms) {
+      EXPECT_LE(0, ms);
+      phases += ms;
+    }
+    EXPECT_LE(phases, frame.ms + 1e-9);
+  }
+}
+
+TEST(FrameStats, Report) {
+  FrameStats stats;
+  FrameStats::Frame frame;
+  frame.ms = 16;
+  stats.Add(frame);
+  std::string report = stats.GetReport("Example \"02\"");
+  EXPECT_NE(std::string::npos, report.find("\"name\": \"Example \\\"02\\\"\""));
+  EXPECT_NE(std::string::npos, report.find("\"ms_p99\": 16.0000"));
+  EXPECT_NE(std::string::npos, report.find("\"present\": 0.0000"));
+  EXPECT_NE(std::string::npos, report.find("\"frame_ms\": [\n    16.0000\n  ]"));
+}
+
+TEST(InputTrack, SaveLoad) {
+  InputTrack track;
+  InputTrack::Frame frame;
+  frame.cursor = glm::vec2(10.5f, 20);
+  track.Add(frame);
+  frame.keys = {87, 65};
+  frame.buttons = 2;
+  track.Add(frame);
+
+  const std::string filename = "test_inputtrack.txt";
+  track.Save(filename);
+  InputTrack loaded;
+  loaded.Load(filename);
+  std::remove(filename.c_str());
+
+  ASSERT_EQ(2u, loaded.GetLength());
+  EXPECT_FLOAT_EQ(10.5f, loaded.Get(0).cursor.x);
+  EXPECT_FALSE(loaded.Get(0).GetKey(87));
+  EXPECT_TRUE(loaded.Get(1).GetKey(87));
+  EXPECT_TRUE(loaded.Get(1).GetKey(65));
+  EXPECT_FALSE(loaded.Get(1).GetKey(83));
+  EXPECT_TRUE(loaded.Get(1).GetMouseButton(1));
+  EXPECT_FALSE(loaded.Get(1).GetMouseButton(0));
+  // Holds the last frame
+  EXPECT_TRUE(loaded.Get(100).GetKey(87));
+}
+
+TEST(CameraPath, Sample) {
+  CameraPath path;
+  path.AddKey({0, glm::vec3(0, 0, 0), glm::vec3(0, 0, 0)});
+  path.AddKey({1, glm::vec3(1, 0, 0), glm::vec3(0, 90, 0)});
+  path.AddKey({2, glm::vec3(2, 0, 0), glm::vec3(0, 180, 0)});
+
+  glm::vec3 position, euler;
+  path.Sample(1, position, euler);
+  EXPECT_FLOAT_EQ(1, position.x);
+  EXPECT_FLOAT_EQ(90, euler.y);
+
+  // Through the keys on a line
+  path.Sample(1.5f, position, euler);
+  EXPECT_NEAR(1.5f, position.x, 0.1f);
+  EXPECT_FLOAT_EQ(0, position.y);
+  EXPECT_FLOAT_EQ(135, euler.y);
+
+  path.Sample(5, position, euler);
+  EXPECT_FLOAT_EQ(2, position.x);
+
+  path.SetLoop(true);
+  path.Sample(2.5f, position, euler);
+  EXPECT_FLOAT_EQ(45, euler.y);
+}
+
+TEST(CameraPath, Load) {
+  const std::string filename = "test_camerapath.yaml";
+  {
+    std::ofstream out(filename);
+    out << "loop: on\n"
+        << "keys:\n"
+        << "  - {time: 0, position: [0, 3, 3], euler: [-30, 0, 0]}\n"
+        << "  - {time: 4, position: [3, 3, 0], euler: [-30, 90, 0]}\n";
+  }
+  auto path = CameraPath::Load(filename);
+  std::remove(filename.c_str());
+
+  EXPECT_TRUE(path.IsLoop());
+  EXPECT_EQ(2u, path.GetKeyCount());
+  EXPECT_FLOAT_EQ(4, path.GetDuration());
+  glm::vec3 position, euler;
+  path.Sample(2, position, euler);
+  EXPECT_FLOAT_EQ(-30, euler.x);
+  EXPECT_FLOAT_EQ(45, euler.y);
+}
@@ -0,0 +1,48 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <b3d.h>
+#include <myactions/rotator.h>
+#include <gtest/gtest.h>
+
+// Every kind of the scene actors gets the frame time for its actions
+TEST(Scene, FrameTime) {
+  Scene scene;
+  auto actor = scene.Add<Actor>("test.actor");
+  auto light = scene.Add<Light>("test.light", Light::kDirectional);
+  auto batch = scene.Add<StdBatch::Batch>("test.batch", 4);
+  auto batched = scene.Add<StdBatch::Actor>("test.batched", batch);
+  std::shared_ptr<Actor> actors[] = {actor, light, batched};
+  for (auto& a: actors) {
+    a->AddAction<Rotator>(glm::vec3(90, 0, 0));
+  }
+
+  for (int i = 0; i < 10; ++i) {
+    scene.Update(0.05f);
+  }
+  for (auto& a: actors) {
+    EXPECT_NEAR(45, a->transform->GetLocalEulerAngles().x, 0.01f) 
+      << a->GetName();
+  }
+}
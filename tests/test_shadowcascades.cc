@@ -0,0 +1,184 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <shadowcascades.h>
+#include <gtest/gtest.h>
+#include <cmath>
+
+static const float kNear = 0.1f;
+static const float kFar  = 500.0f;
+
+static glm::mat4 GetProj() {
+  return glm::perspective(glm::radians(60.0f), 16 / 9.0f, kNear, kFar);
+}
+
+static glm::mat4 GetView(const glm::vec3& eye, float yaw) {
+  glm::vec3 ahead(std::sin(yaw), -0.2f, -std::cos(yaw));
+  return glm::lookAt(eye, eye + ahead, glm::vec3(0, 1, 0));
+}
+
+static ShadowCascades::Params GetParams() {
+  ShadowCascades::Params params;
+  params.n_cascades = 4;
+  params.resolution = 1024;
+  params.max_distance = 200;
+  params.cache_from = 2;
+  params.cache_frames = 4;
+  return params;
+}
+
+static const glm::vec3 kSun(0.3f, -1.0f, 0.5f);
+
+TEST(ShadowCascades, Splits) {
+  float splits[5];
+  ShadowCascades::ComputeSplits(4, 1, 1000, 0, splits);
+  EXPECT_FLOAT_EQ(splits[0], 1);
+  EXPECT_FLOAT_EQ(splits[2], 500.5f);
+  EXPECT_FLOAT_EQ(splits[4], 1000);
+
+  ShadowCascades::ComputeSplits(3, 1, 1000, 1, splits);
+  EXPECT_NEAR(splits[1], 10, 1e-3);
+  EXPECT_NEAR(splits[2], 100, 1e-2);
+  EXPECT_FLOAT_EQ(splits[3], 1000);
+
+  ShadowCascades::ComputeSplits(4, kNear, kFar, 0.75f, splits);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_LT(splits[i], splits[i + 1]);
+  }
+}
+
+TEST(ShadowCascades, CascadesCoverTheirSlices) {
+  ShadowCascades cascades(GetParams());
+  glm::vec3 eye(10, 20, 30);
+  glm::mat4 view = GetView(eye, 0.7f);
+  cascades.Update(view, GetProj(), kNear, kFar, kSun);
+  ASSERT_EQ(cascades.GetCount(), 4);
+  EXPECT_FLOAT_EQ(cascades.GetCascade(3).split_far, 200);
+
+  // Points along the view direction at the slice distances are inside the
+  // cascade, in the light clip space
+  glm::mat4 inv_view = glm::inverse(view);
+  for (int i = 0; i < cascades.GetCount(); ++i) {
+    auto& cascade = cascades.GetCascade(i);
+    EXPECT_TRUE(cascade.update);
+    for (float t: {0.0f, 0.5f, 1.0f}) {
+      float d = glm::mix(cascade.split_near, cascade.split_far, t);
+      for (glm::vec2 xy: {glm::vec2(0), glm::vec2(0.5f, 0.25f), 
+                          glm::vec2(-0.5f, -0.25f)}) {
+        glm::vec3 p(inv_view * glm::vec4(xy * d, -d, 1));
+        glm::vec4 clip = cascade.pv * glm::vec4(p, 1);
+        EXPECT_LE(std::abs(clip.x), 1.0f);
+        EXPECT_LE(std::abs(clip.y), 1.0f);
+        EXPECT_LE(std::abs(clip.z), 1.0f);
+      }
+    }
+  }
+
+  // A caster above the slice, towards the sun, is still in the box
+  auto& cascade = cascades.GetCascade(0);
+  glm::vec3 p(inv_view * glm::vec4(0, 0, -cascade.split_far, 1));
+  glm::vec4 clip = cascade.pv * glm::vec4(p - glm::normalize(kSun) * 50.0f, 1);
+  EXPECT_LE(std::abs(clip.z), 1.0f);
+}
+
+TEST(ShadowCascades, TexelSnapping) {
+  auto params = GetParams();
+  params.cache_from = params.n_cascades;
+  ShadowCascades cascades(params);
+
+  cascades.Update(GetView(glm::vec3(0, 20, 0), 0), GetProj(), kNear, kFar, kSun);
+  std::vector<ShadowCascades::Cascade> first;
+  for (int i = 0; i < cascades.GetCount(); ++i) {
+    first.push_back(cascades.GetCascade(i));
+  }
+
+  // Moving and turning the camera keeps the size and moves the boxes by
+  // the whole texels
+  for (int frame = 1; frame < 50; ++frame) {
+    glm::vec3 eye(frame * 0.37f, 20, frame * -0.11f);
+    cascades.Update(GetView(eye, frame * 0.05f), GetProj(), kNear, kFar, kSun);
+    for (int i = 0; i < cascades.GetCount(); ++i) {
+      auto& a = first[i];
+      auto& b = cascades.GetCascade(i);
+      float size = a.box_max.x - a.box_min.x;
+      EXPECT_FLOAT_EQ(b.box_max.x - b.box_min.x, size);
+      float texel = size / params.resolution;
+      for (float offset: {b.box_min.x - a.box_min.x, b.box_min.y - a.box_min.y}) {
+        float texels = offset / texel;
+        EXPECT_NEAR(texels, std::round(texels), 1e-2) << i;
+      }
+    }
+  }
+}
+
+TEST(ShadowCascades, FarCascadesAreCached) {
+  ShadowCascades cascades(GetParams());
+  glm::mat4 view = GetView(glm::vec3(0, 20, 0), 0);
+  cascades.Update(view, GetProj(), kNear, kFar, kSun);
+  EXPECT_EQ(cascades.GetStats().updated, 4);
+
+  int updates[4] = {0};
+  for (int frame = 0; frame < 40; ++frame) {
+    cascades.Update(view, GetProj(), kNear, kFar, kSun);
+    for (int i = 0; i < 4; ++i) {
+      updates[i] += cascades.GetCascade(i).update;
+    }
+  }
+  EXPECT_EQ(updates[0], 40);
+  EXPECT_EQ(updates[1], 40);
+  EXPECT_EQ(updates[2], 10);
+  EXPECT_EQ(updates[3], 10);
+
+  // Static geometry changed
+  cascades.Invalidate();
+  cascades.Update(view, GetProj(), kNear, kFar, kSun);
+  EXPECT_EQ(cascades.GetStats().updated, 4);
+  cascades.Update(view, GetProj(), kNear, kFar, kSun);
+  EXPECT_LT(cascades.GetStats().updated, 4);
+
+  // The light moved
+  cascades.Update(view, GetProj(), kNear, kFar, kSun + glm::vec3(0.1f, 0, 0));
+  EXPECT_EQ(cascades.GetStats().updated, 4);
+}
+
+TEST(ShadowCascades, LightEulerAnglesMatchView) {
+  ShadowCascades cascades(GetParams());
+  cascades.Update(GetView(glm::vec3(0), 0), GetProj(), kNear, kFar, kSun);
+
+  // The engine camera rotation, see Transformation
+  glm::vec3 e = glm::radians(cascades.GetLightEulerAngles());
+  glm::mat4 rotation = glm::eulerAngleYXZ(e.y, e.x, e.z);
+  glm::vec3 forward(rotation * glm::vec4(0, 0, -1, 0));
+  glm::vec3 sun = glm::normalize(kSun);
+  EXPECT_NEAR(forward.x, sun.x, 1e-5);
+  EXPECT_NEAR(forward.y, sun.y, 1e-5);
+  EXPECT_NEAR(forward.z, sun.z, 1e-5);
+
+  glm::mat4 view = glm::affineInverse(rotation);
+  for (int c = 0; c < 4; ++c) {
+    for (int r = 0; r < 4; ++r) {
+      EXPECT_NEAR(view[c][r], cascades.GetLightView()[c][r], 1e-5);
+    }
+  }
+}
@@ -0,0 +1,200 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <phys/sweepandprune.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+using Phys::Aabb;
+using Phys::SweepAndPrune;
+
+using PairSet = std::set<std::pair<uint32_t, uint32_t>>;
+
+static PairSet ToSet(const std::vector<SweepAndPrune::Pair>& pairs) {
+  PairSet set;
+  for (auto& pair: pairs) {
+    EXPECT_LT(pair.a, pair.b);
+    set.insert({pair.a, pair.b});
+  }
+  EXPECT_EQ(pairs.size(), set.size()); // No duplicates
+  return set;
+}
+
+struct World {
+  std::mt19937 rng{7};
+  std::vector<glm::vec3> centers;
+  std::vector<glm::vec3> sizes;
+
+  explicit World(int n) {
+    std::uniform_real_distribution<float> position(-100, 100);
+    std::uniform_real_distribution<float> size(0.5f, 4);
+    for (int i = 0; i < n; ++i) {
+      centers.emplace_back(position(rng), position(rng) / 4, position(rng));
+      sizes.emplace_back(size(rng), size(rng), size(rng));
+    }
+  }
+
+  void Move(float step) {
+    std::uniform_real_distribution<float> delta(-step, step);
+    for (auto& c: centers) {
+      c += glm::vec3(delta(rng), delta(rng), delta(rng));
+    }
+  }
+
+  Aabb GetBounds(int i) const {
+    return {centers[i] - sizes[i], centers[i] + sizes[i]};
+  }
+
+  std::vector<Aabb> GetBoxes() const {
+    std::vector<Aabb> boxes;
+    for (size_t i = 0; i < centers.size(); ++i) {
+      boxes.push_back(GetBounds(i));
+    }
+    return boxes;
+  }
+};
+
+TEST(SweepAndPrune, MatchesBruteForce) {
+  World world(3000);
+  SweepAndPrune::Params params;
+  params.n_threads = 1;
+  SweepAndPrune sap(params);
+  for (int i = 0; i < 3000; ++i) {
+    EXPECT_EQ((uint32_t)i, sap.Add(world.GetBounds(i)));
+  }
+
+  std::vector<SweepAndPrune::Pair> expected;
+  for (int frame = 0; frame < 5; ++frame) {
+    SweepAndPrune::FindPairsBruteForce(world.GetBoxes(), expected);
+    ASSERT_FALSE(expected.empty());
+    EXPECT_EQ(ToSet(expected), ToSet(sap.FindPairs()));
+    EXPECT_EQ(expected.size(), sap.GetStats().pairs);
+    EXPECT_GE(sap.GetStats().tests, expected.size());
+
+    world.Move(0.5f);
+    for (int i = 0; i < 3000; ++i) {
+      sap.Update(i, world.GetBounds(i));
+    }
+  }
+  // The bodies barely moved, no full sort
+  EXPECT_FALSE(sap.GetStats().resorted);
+  EXPECT_GT(sap.GetStats().swaps, 0u);
+}
+
+TEST(SweepAndPrune, TouchingBoxes) {
+  SweepAndPrune sap;
+  sap.Add({glm::vec3(0), glm::vec3(1)});
+  sap.Add({glm::vec3(1, 0, 0), glm::vec3(2, 1, 1)});  // Touches 0
+  sap.Add({glm::vec3(2.5f, 0, 0), glm::vec3(3, 1, 1)});
+  sap.Add({glm::vec3(0, 1.5f, 0), glm::vec3(1, 2, 1)});
+  auto pairs = ToSet(sap.FindPairs());
+  EXPECT_EQ(PairSet({{0, 1}}), pairs);
+}
+
+TEST(SweepAndPrune, AddRemove) {
+  World world(500);
+  SweepAndPrune sap;
+  std::vector<uint32_t> ids;
+  for (int i = 0; i < 500; ++i) {
+    ids.push_back(sap.Add(world.GetBounds(i)));
+  }
+  sap.FindPairs();
+
+  // Every other body goes, some come back under the reused ids
+  std::vector<Aabb> boxes;
+  std::vector<uint32_t> alive;
+  for (int i = 0; i < 500; ++i) {
+    if (i % 2) {
+      sap.Remove(ids[i]);
+    }
+  }
+  for (int i = 1; i < 100; i += 2) {
+    uint32_t id = sap.Add(world.GetBounds(i));
+    EXPECT_LT(id, 500u);
+    ids[i] = id;
+  }
+  EXPECT_EQ(300u, sap.GetBodyCount());
+  for (int i = 0; i < 500; ++i) {
+    if (i % 2 == 0 || i < 100) {
+      boxes.push_back(world.GetBounds(i));
+      alive.push_back(ids[i]);
+    }
+  }
+
+  std::vector<SweepAndPrune::Pair> expected;
+  SweepAndPrune::FindPairsBruteForce(boxes, expected);
+  PairSet expected_ids;
+  for (auto& pair: expected) {
+    uint32_t a = alive[pair.a], b = alive[pair.b];
+    expected_ids.insert({std::min(a, b), std::max(a, b)});
+  }
+  EXPECT_EQ(expected_ids, ToSet(sap.FindPairs()));
+  EXPECT_EQ(300u, sap.GetStats().bodies);
+}
+
+TEST(SweepAndPrune, SameForThreadsAndIsa) {
+  World world(20000);
+  auto boxes = world.GetBoxes();
+  std::vector<std::vector<SweepAndPrune::Pair>> results;
+  for (auto isa: {SweepAndPrune::Isa::kScalar, SweepAndPrune::Isa::kBest}) {
+    for (int n_threads: {1, 4}) {
+      SweepAndPrune sap({n_threads, isa});
+      for (auto& box: boxes) {
+        sap.Add(box);
+      }
+      results.push_back(sap.FindPairs());
+    }
+  }
+  for (auto& result: results) {
+    ASSERT_EQ(results[0].size(), result.size());
+    for (size_t i = 0; i < result.size(); ++i) {
+      EXPECT_EQ(results[0][i].a, result[i].a);
+      EXPECT_EQ(results[0][i].b, result[i].b);
+    }
+  }
+}
+
+// A ground plane and a wall, infinite along the sort axis
+TEST(SweepAndPrune, InfiniteBoxes) {
+  const float inf = std::numeric_limits<float>::infinity();
+  World world(1000);
+  auto boxes = world.GetBoxes();
+  boxes.push_back({glm::vec3(-inf, -inf, -inf), glm::vec3(inf, 0, inf)});
+  boxes.push_back({glm::vec3(50, -inf, -inf), glm::vec3(inf, inf, inf)});
+  std::vector<SweepAndPrune::Pair> expected;
+  SweepAndPrune::FindPairsBruteForce(boxes, expected);
+  for (auto isa: {SweepAndPrune::Isa::kScalar, SweepAndPrune::Isa::kBest}) {
+    SweepAndPrune sap({1, isa});
+    for (auto& box: boxes) {
+      sap.Add(box);
+    }
+    EXPECT_EQ(ToSet(expected), ToSet(sap.FindPairs()));
+    EXPECT_LE(sap.GetBounds(1000).max.x, SweepAndPrune::kMaxCoord);
+  }
+}
@@ -0,0 +1,198 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <terrain/chunkstreamer.h>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <utility>
+
+using Terrain::ChunkStreamer;
+
+static void Generate(int x0, int z0, int stride, int n, float* out) {
+  for (int j = 0; j < n; ++j) {
+    for (int i = 0; i < n; ++i) {
+      float x = x0 + i * stride;
+      float z = z0 + j * stride;
+      out[j * n + i] = 10 * std::sin(x * 0.05f) * std::cos(z * 0.07f);
+    }
+  }
+}
+
+static ChunkStreamer::Params GetParams() {
+  ChunkStreamer::Params params;
+  params.chunk_vertices = 17;
+  params.texel_size = 2;
+  params.lod_levels = 3;
+  params.lod_distance = 1;
+  params.view_distance = 4;
+  params.n_workers = 2;
+  return params;
+}
+
+// Updates until nothing changes
+static void Settle(ChunkStreamer& streamer, const glm::vec3& eye) {
+  for (int i = 0; i < 100; ++i) {
+    streamer.Update(eye);
+    streamer.Flush();
+    auto& stats = streamer.GetStats();
+    if (stats.generated == 0 && stats.uploaded == 0 && stats.pending == 0 &&
+        stats.restitched == 0) {
+      return;
+    }
+  }
+  FAIL() << "Streamer did not settle";
+}
+
+TEST(TerrainChunkStreamer, StitchedIndicesCoverTheGrid) {
+  const int n = 9;
+  for (uint32_t stitch = 0; stitch < 16; ++stitch) {
+    auto indices = ChunkStreamer::GetIndices(n, stitch);
+    ASSERT_EQ(indices->size() % 3, 0u);
+
+    float area = 0;
+    for (size_t t = 0; t < indices->size(); t += 3) {
+      int i[3], j[3];
+      for (int k = 0; k < 3; ++k) {
+        uint32_t v = (*indices)[t + k];
+        i[k] = v % n;
+        j[k] = v / n;
+        bool snapped = ((j[k] == 0 && (stitch & ChunkStreamer::kStitchNegZ)) ||
+                        (j[k] == n - 1 && (stitch & ChunkStreamer::kStitchPosZ))) && (i[k] & 1);
+        snapped |= ((i[k] == 0 && (stitch & ChunkStreamer::kStitchNegX)) ||
+                    (i[k] == n - 1 && (stitch & ChunkStreamer::kStitchPosX))) && (j[k] & 1);
+        EXPECT_FALSE(snapped) << "stitch " << stitch << " uses " << v;
+      }
+      // Same facing for all the triangles (counter-clockwise from above is
+      // clockwise in x, z), nothing folds over
+      float a = 0.5f * ((i[2] - i[0]) * (j[1] - j[0]) - (i[1] - i[0]) * (j[2] - j[0]));
+      EXPECT_GT(a, 0);
+      area += a;
+    }
+    EXPECT_FLOAT_EQ(area, (n - 1) * (n - 1)) << "stitch " << stitch;
+  }
+}
+
+TEST(TerrainChunkStreamer, SeamFreeLods) {
+  ChunkStreamer streamer(GetParams(), Generate);
+  glm::vec3 eye(100, 0, -40);
+  Settle(streamer, eye);
+
+  const int view = streamer.GetParams().view_distance;
+  const int quads = streamer.GetParams().chunk_vertices - 1;
+  ASSERT_EQ(streamer.GetVisible().size(), (size_t)(2 * view + 1) * (2 * view + 1));
+
+  int cx = (int)std::floor(eye.x / streamer.GetChunkSize());
+  int cz = (int)std::floor(eye.z / streamer.GetChunkSize());
+  std::map<std::pair<int, int>, const ChunkStreamer::Chunk*> cells;
+  for (auto chunk: streamer.GetVisible()) {
+    auto& key = chunk->key;
+    int ring = std::max(std::abs(key.x - cx), std::abs(key.z - cz));
+    EXPECT_EQ(key.lod, streamer.GetLod(ring));
+    cells[std::make_pair(key.x, key.z)] = chunk;
+  }
+
+  // Right neighbours, the used vertices of the shared edge match
+  for (auto& kv: cells) {
+    auto it = cells.find(std::make_pair(kv.first.first + 1, kv.first.second));
+    if (it == cells.end()) {
+      continue;
+    }
+    auto a = kv.second;
+    auto b = it->second;
+    ASSERT_LE(std::abs(a->key.lod - b->key.lod), 1);
+    EXPECT_EQ(!!(a->stitch & ChunkStreamer::kStitchPosX), b->key.lod > a->key.lod);
+    EXPECT_EQ(!!(b->stitch & ChunkStreamer::kStitchNegX), a->key.lod > b->key.lod);
+
+    int na = (quads >> a->key.lod) + 1;
+    int nb = (quads >> b->key.lod) + 1;
+    std::set<uint32_t> used(a->mesh->indices.begin(), a->mesh->indices.end());
+    for (int j = 0; j < na; ++j) {
+      uint32_t v = j * na + na - 1;
+      if (!used.count(v)) {
+        continue;
+      }
+      // Same texel row in b
+      int texel = j << a->key.lod;
+      ASSERT_EQ(texel % (1 << b->key.lod), 0) << "T-junction at " << j;
+      int jb = texel >> b->key.lod;
+      glm::vec3 pa = a->origin + a->mesh->vertices[v];
+      glm::vec3 pb = b->origin + b->mesh->vertices[jb * nb];
+      EXPECT_FLOAT_EQ(pa.y, pb.y);
+      EXPECT_NEAR(pa.z, pb.z, 1e-3f);
+    }
+  }
+}
+
+TEST(TerrainChunkStreamer, UploadBudget) {
+  auto params = GetParams();
+  params.n_workers = 0;
+  params.upload_budget = 17 * 17;
+  ChunkStreamer streamer(params, Generate);
+
+  size_t total = 0;
+  for (int frame = 0; frame < 200; ++frame) {
+    streamer.Update(glm::vec3(0, 0, 0));
+    EXPECT_LE(streamer.GetStats().uploaded_vertices, 
+              (size_t)params.upload_budget);
+    total += streamer.GetStats().uploaded;
+  }
+  EXPECT_EQ(streamer.GetVisible().size(), 81u);
+  EXPECT_GE(total, 81u);
+}
+
+TEST(TerrainChunkStreamer, LruCache) {
+  auto params = GetParams();
+  params.cache_size = 10;
+  ChunkStreamer streamer(params, Generate);
+
+  glm::vec3 home(0, 0, 0);
+  Settle(streamer, home);
+  std::set<ChunkStreamer::Key> before;
+  for (auto chunk: streamer.GetVisible()) {
+    before.insert(chunk->key);
+  }
+
+  // Far away, everything is released but the last cache_size chunks
+  std::set<ChunkStreamer::Key> released;
+  glm::vec3 away(10000, 0, 0);
+  for (int i = 0; i < 20; ++i) {
+    streamer.Update(away);
+    streamer.Flush();
+    released.insert(streamer.GetReleased().begin(), streamer.GetReleased().end());
+    EXPECT_LE(streamer.GetStats().cached, (size_t)params.cache_size);
+  }
+  EXPECT_GE(released.size(), before.size() - params.cache_size);
+
+  // One step back, the cached chunks come back without an upload
+  Settle(streamer, glm::vec3(32, 0, 0));
+  streamer.Update(home);
+  size_t reused = 0;
+  for (auto chunk: streamer.GetVisible()) {
+    reused += before.count(chunk->key);
+  }
+  EXPECT_GT(reused, 0u);
+}
@@ -0,0 +1,138 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <terrain/quadtree.h>
+#include <camera.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <tuple>
+
+using Terrain::QuadTree;
+
+static Array2d<float> GetHeights() {
+  Array2d<float> heights(64, 64);
+  for (size_t z = 0; z < heights.GetHeight(); ++z) {
+    for (size_t x = 0; x < heights.GetWidth(); ++x) {
+      heights.At(x, z) = 50 * std::sin(x * 0.2f) * std::cos(z * 0.3f);
+    }
+  }
+  return heights;
+}
+
+static QuadTree::Params GetParams() {
+  QuadTree::Params params;
+  params.levels = 10;
+  params.half_size = 1000;
+  return params;
+}
+
+static Frustum GetFrustum(const glm::vec3& eye, const glm::vec3& target) {
+  Frustum frustum;
+  frustum.Calculate(glm::perspective(glm::radians(60.0f), 16 / 9.0f, 1.0f, 3000.0f) * 
+                    glm::lookAt(eye, target, glm::vec3(0, 1, 0)));
+  return frustum;
+}
+
+static std::set<std::tuple<float, float, float>> GetPatchSet(const QuadTree& tree) {
+  std::set<std::tuple<float, float, float>> patches;
+  for (auto& p: tree.GetPatches()) {
+    patches.emplace(p.offset_size.x, p.offset_size.z, p.offset_size.w);
+  }
+  return patches;
+}
+
+TEST(TerrainQuadTree, TightBounds) {
+  Array2d<float> heights(64, 64);
+  heights.At(60, 60) = 100;
+  QuadTree tree(GetParams(), heights);
+
+  glm::vec3 min, max;
+  tree.GetBounds(QuadTree::Node{0, 0, 0}, min, max);
+  EXPECT_FLOAT_EQ(min.x, -1000);
+  EXPECT_FLOAT_EQ(max.z,  1000);
+  EXPECT_FLOAT_EQ(max.y,  100);
+
+  tree.GetBounds(QuadTree::Node{2, 0, 0}, min, max);
+  EXPECT_FLOAT_EQ(max.x, -500);
+  EXPECT_FLOAT_EQ(max.y, 0);
+
+  tree.GetBounds(QuadTree::Node{2, 3, 3}, min, max);
+  EXPECT_FLOAT_EQ(max.y, 100);
+}
+
+TEST(TerrainQuadTree, IncrementalMatchesRebuild) {
+  auto heights = GetHeights();
+  QuadTree moving(GetParams(), heights);
+
+  glm::vec3 eye(-900, 80, -900);
+  for (int frame = 0; frame < 40; ++frame) {
+    eye += glm::vec3(45, 0, 40);
+    auto frustum = GetFrustum(eye, eye + glm::vec3(1, -0.2f, 0.5f));
+    moving.Update(eye, frustum);
+
+    QuadTree fresh(GetParams(), heights);
+    fresh.Update(eye, frustum);
+    ASSERT_EQ(moving.GetCut().size(), fresh.GetCut().size());
+    ASSERT_EQ(GetPatchSet(moving), GetPatchSet(fresh));
+  }
+  EXPECT_GT(moving.GetStats().visible, 0u);
+}
+
+TEST(TerrainQuadTree, StillCameraUploadsNothing) {
+  QuadTree tree(GetParams(), GetHeights());
+  glm::vec3 eye(0, 100, 0);
+  auto frustum = GetFrustum(eye, glm::vec3(100, 0, 100));
+  tree.Update(eye, frustum);
+  tree.Update(eye, frustum);
+  EXPECT_EQ(tree.GetStats().splits, 0u);
+  EXPECT_EQ(tree.GetStats().merges, 0u);
+  tree.Update(eye, frustum);
+  EXPECT_TRUE(tree.GetDirtyRanges().empty());
+  EXPECT_GT(tree.GetPatches().size(), 0u);
+}
+
+TEST(TerrainQuadTree, DirtyRangesKeepMirrorInSync) {
+  QuadTree tree(GetParams(), GetHeights());
+  std::vector<QuadTree::Patch> mirror;
+
+  for (int frame = 0; frame < 60; ++frame) {
+    float a = frame * 0.1f;
+    glm::vec3 eye(600 * std::cos(a), 60, 600 * std::sin(a));
+    tree.Update(eye, GetFrustum(eye, glm::vec3(0)));
+
+    auto& patches = tree.GetPatches();
+    mirror.resize(patches.size());
+    for (auto& range: tree.GetDirtyRanges()) {
+      std::copy(patches.begin() + range.first, 
+                patches.begin() + range.first + range.second, 
+                mirror.begin() + range.first);
+    }
+    for (size_t i = 0; i < patches.size(); ++i) {
+      ASSERT_EQ(mirror[i].offset_size, patches[i].offset_size);
+      ASSERT_EQ(mirror[i].lod, patches[i].lod);
+    }
+  }
+}
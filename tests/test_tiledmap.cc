@@ -0,0 +1,122 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <terrain/tiledmap.h>
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+
+using Terrain::TiledMap;
+using Terrain::TiledMapWriter;
+
+static std::string TempFile(const char* name) {
+  return std::string("test_tiledmap_") + name + ".tmap";
+}
+
+static Array2d<float> GetHeights(int width, int height) {
+  Array2d<float> heights(width, height);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      heights.At(x, y) = x * 0.5f - y * 0.25f;
+    }
+  }
+  return heights;
+}
+
+TEST(TiledMap, HeightsRoundTrip) {
+  auto heights = GetHeights(150, 70);
+  TiledMapWriter::Write(TempFile("heights"), heights, 32);
+  auto map = TiledMap::Open(TempFile("heights"));
+
+  EXPECT_EQ(map->GetFormat(), TiledMap::kFloat32);
+  EXPECT_EQ(map->GetWidth(), 150);
+  EXPECT_EQ(map->GetHeight(), 70);
+  EXPECT_EQ(map->GetTilesX(), 5);
+  EXPECT_EQ(map->GetTilesY(), 3);
+  for (int y = 0; y < 70; ++y) {
+    for (int x = 0; x < 150; ++x) {
+      ASSERT_EQ(map->GetHeight(x, y), heights.At(x, y));
+    }
+  }
+  // Clamped to the border
+  EXPECT_EQ(map->GetHeight(200, -3), heights.At(149, 0));
+
+  // Border tile covers x 128..149, y 64..69
+  EXPECT_FLOAT_EQ(map->GetTileMin(4, 2), 128 * 0.5f - 69 * 0.25f);
+  EXPECT_FLOAT_EQ(map->GetTileMax(4, 2), 149 * 0.5f - 64 * 0.25f);
+  // Padding repeats the edge
+  EXPECT_EQ(map->GetHeights(4, 2)[31], heights.At(149, 64));
+
+  map.reset();
+  std::remove(TempFile("heights").c_str());
+}
+
+TEST(TiledMap, Mips) {
+  auto heights = GetHeights(150, 70);
+  TiledMapWriter::Write(TempFile("mips"), heights, 32);
+  auto map = TiledMap::Open(TempFile("mips"));
+
+  ASSERT_EQ(map->GetMipCount(), 4);
+  EXPECT_EQ(map->GetWidth(1), 75);
+  EXPECT_EQ(map->GetHeight(1), 35);
+  EXPECT_EQ(map->GetWidth(3), 19);
+  EXPECT_EQ(map->GetTilesX(3), 1);
+  float avg = (heights.At(20, 10) + heights.At(21, 10) + 
+               heights.At(20, 11) + heights.At(21, 11)) / 4;
+  EXPECT_FLOAT_EQ(map->GetHeight(10, 5, 1), avg);
+  // Odd last column and row pair with themselves
+  EXPECT_FLOAT_EQ(map->GetHeight(37, 17, 2), 
+                  (map->GetHeight(74, 34, 1) + map->GetHeight(74, 34, 1) + 
+                   map->GetHeight(74, 34, 1) + map->GetHeight(74, 34, 1)) / 4);
+
+  map.reset();
+  std::remove(TempFile("mips").c_str());
+}
+
+TEST(TiledMap, ColorsRoundTrip) {
+  Image::ColorMap colors(40, 33);
+  for (size_t i = 0; i < colors.GetLength(); ++i) {
+    colors.At(i) = Rgba(i % 256, (i * 7) % 256, 255, 128);
+  }
+  TiledMapWriter::Write(TempFile("colors"), colors, 16, false);
+  auto map = TiledMap::Open(TempFile("colors"));
+
+  EXPECT_EQ(map->GetFormat(), TiledMap::kRgba8);
+  EXPECT_EQ(map->GetMipCount(), 1);
+  for (int y = 0; y < 33; ++y) {
+    for (int x = 0; x < 40; ++x) {
+      auto c = map->GetColor(x, y);
+      ASSERT_NEAR(c.r, colors.At(x, y).r, 1e-6);
+      ASSERT_NEAR(c.g, colors.At(x, y).g, 1e-6);
+      ASSERT_NEAR(c.a, colors.At(x, y).a, 1e-6);
+    }
+  }
+
+  // Pages come back after the eviction
+  map->Evict(1, 1);
+  EXPECT_NEAR(map->GetColor(20, 20).g, colors.At(20, 20).g, 1e-6);
+
+  map.reset();
+  std::remove(TempFile("colors").c_str());
+}
@@ -0,0 +1,47 @@
+#!/bin/bash
+#
+# Runs the examples headless for a fixed number of frames on the simulated 
+# clock and collects the frame reports (see src/replay.h), one JSON per
+# example. Run from the repository root, the examples load the assets
+# from there.
+#
+#   tools/replay.sh [-n frames] [-w warmup] [-s step] [-i input] [-o dir] \
+#                   build/examples/02_rotating_model [-- example args]
+#
+
+frames=600
+warmup=60
+step=0.016666667
+input=""
+out="replay"
+
+while getopts "n:w:s:i:o:" opt; do
+  case $opt in
+    n) frames=$OPTARG ;;
+    w) warmup=$OPTARG ;;
+    s) step=$OPTARG ;;
+    i) input=$OPTARG ;;
+    o) out=$OPTARG ;;
+    *) echo "Usage: $0 [-n frames] [-w warmup] [-s step] [-i input] [-o dir] example... [-- args]"
+       exit 1 ;;
+  esac
+done
+shift $((OPTIND - 1))
+
+examples=()
+while [ $# -gt 0 ] && [ "$1" != "--" ]; do
+  examples+=("$1")
+  shift
+done
+[ "$1" == "--" ] && shift
+
+mkdir -p "$out"
+status=0
+for example in "${examples[@]}"; do
+  name=$(basename "$example")
+  echo "== $name"
+  B3D_HEADLESS=1 B3D_FRAMES=$frames B3D_WARMUP=$warmup B3D_FIXED_STEP=$step \
+  B3D_INPUT_PLAY=$input B3D_REPORT="$out/$name.json" "$example" "$@" || status=1
+  grep -E '"ms_p(50|95|99)"|"allocations"' "$out/$name.json"
+done
+exit $status
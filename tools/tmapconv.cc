@@ -0,0 +1,204 @@
+//
+// This source file is a part of borsch.3d
+//
+// Copyright (C) borsch.3d team 2017-2018
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "terrain/tiledmap.h"
+#include "common/logging.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Converts a height/color map to the tiled .tmap container, streaming row
+// by row, so the whole map never has to fit in RAM.
+//
+// tmapconv [--tile N] [--no-mips] [--scale S] input [output.tmap]
+//   .hm      text heights:  "width height", then one float per line
+//   .cm      text colors:   "width height", then "r g b a" per line, 0..1
+//   .pgm P5  heights = sample / maxval * scale, 8 or 16 bit
+//   .ppm P6  colors, 8 or 16 bit
+//   --scale  multiplies the heights, 1 by default
+
+using Terrain::TiledMap;
+using Terrain::TiledMapWriter;
+
+struct Options {
+  int   tile_size = 256;
+  bool  mips      = true;
+  float scale     = 1;
+};
+
+static std::string GetExtension(const std::string& filename) {
+  auto dot = filename.find_last_of('.');
+  return dot == std::string::npos ? "" : filename.substr(dot);
+}
+
+static void ConvertText(std::ifstream& in, const std::string& output, 
+                        bool colors, const Options& options) {
+  int width, height;
+  in >> width >> height;
+  if (!in || width < 1 || height < 1) {
+    ABORT_F("Bad text map header");
+  }
+
+  TiledMapWriter writer(output, colors ? TiledMap::kRgba8 : TiledMap::kFloat32, 
+                        width, height, options.tile_size, options.mips);
+  std::vector<float> heights(width);
+  std::vector<Color32> row(width);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      if (colors) {
+        Color c;
+        in >> c.r >> c.g >> c.b >> c.a;
+        row[x] = Color32(glm::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f);
+      } else {
+        in >> heights[x];
+        heights[x] *= options.scale;
+      }
+    }
+    if (!in) {
+      ABORT_F("Unexpected end of file at row %d", y);
+    }
+    if (colors) {
+      writer.AddRow(row.data());
+    } else {
+      writer.AddRow(heights.data());
+    }
+  }
+  writer.Close();
+}
+
+// Next header token, skipping the comments
+static std::string PnmToken(std::ifstream& in) {
+  std::string token;
+  while (in >> token) {
+    if (token[0] != '#') {
+      return token;
+    }
+    std::getline(in, token);
+  }
+  ABORT_F("Bad PNM header");
+}
+
+static void ConvertPnm(std::ifstream& in, const std::string& output, 
+                       const Options& options) {
+  std::string magic = PnmToken(in);
+  if (magic != "P5" && magic != "P6") {
+    ABORT_F("Only P5 and P6 are supported, got %s", magic.c_str());
+  }
+  int width = std::atoi(PnmToken(in).c_str());
+  int height = std::atoi(PnmToken(in).c_str());
+  int maxval = std::atoi(PnmToken(in).c_str());
+  in.get(); // Single whitespace before the raster
+  if (width < 1 || height < 1 || maxval < 1 || maxval > 65535) {
+    ABORT_F("Bad PNM header");
+  }
+
+  bool colors = magic == "P6";
+  int channels = colors ? 3 : 1;
+  int sample_size = maxval > 255 ? 2 : 1;
+  TiledMapWriter writer(output, colors ? TiledMap::kRgba8 : TiledMap::kFloat32, 
+                        width, height, options.tile_size, options.mips);
+
+  std::vector<uint8_t> raster((size_t)width * channels * sample_size);
+  std::vector<float> heights(width);
+  std::vector<Color32> row(width);
+  auto sample = [&](size_t i) -> float {
+    int v = sample_size == 2 ? raster[2 * i] << 8 | raster[2 * i + 1] : raster[i];
+    return (float)v / maxval;
+  };
+
+  for (int y = 0; y < height; ++y) {
+    if (!in.read((char*)raster.data(), raster.size())) {
+      ABORT_F("Unexpected end of file at row %d", y);
+    }
+    for (int x = 0; x < width; ++x) {
+      if (colors) {
+        row[x] = Color32(sample(x * 3) * 255 + 0.5f, 
+                         sample(x * 3 + 1) * 255 + 0.5f, 
+                         sample(x * 3 + 2) * 255 + 0.5f, 
+                         255);
+      } else {
+        heights[x] = sample(x) * options.scale;
+      }
+    }
+    if (colors) {
+      writer.AddRow(row.data());
+    } else {
+      writer.AddRow(heights.data());
+    }
+  }
+  writer.Close();
+}
+
+int main(int argc, char* argv[]) {
+  Options options;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--tile" && i + 1 < argc) {
+      options.tile_size = std::atoi(argv[++i]);
+    } else if (arg == "--no-mips") {
+      options.mips = false;
+    } else if (arg == "--scale" && i + 1 < argc) {
+      options.scale = std::atof(argv[++i]);
+    } else {
+      files.push_back(arg);
+    }
+  }
+  if (files.empty() || files.size() > 2) {
+    std::cerr << "Usage: tmapconv [--tile N] [--no-mips] [--scale S] "
+                 "input.{hm,cm,pgm,ppm} [output.tmap]" << std::endl;
+    return 1;
+  }
+
+  std::string input = files[0];
+  std::string ext = GetExtension(input);
+  std::string output = files.size() == 2 ? files[1] : 
+      input.substr(0, input.size() - ext.size()) + ".tmap";
+
+  auto start = std::chrono::steady_clock::now();
+  std::ifstream in(input, std::ios::in | std::ios::binary);
+  if (!in.is_open()) {
+    ABORT_F("Cant open file %s", input.c_str());
+  }
+  if (ext == ".hm" || ext == ".cm") {
+    ConvertText(in, output, ext == ".cm", options);
+  } else if (ext == ".pgm" || ext == ".ppm") {
+    ConvertPnm(in, output, options);
+  } else {
+    ABORT_F("Unknown input format %s", ext.c_str());
+  }
+  auto ms = std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - start).count();
+
+  auto map = TiledMap::Open(output);
+  printf("%s: %dx%d, %dx%d tiles of %d, %d mips, %.1f MB, %.0f ms\n", 
+         output.c_str(), map->GetWidth(), map->GetHeight(), 
+         map->GetTilesX(), map->GetTilesY(), map->GetTileSize(), 
+         map->GetMipCount(), map->GetFileSize() / (1024 * 1024.0), ms);
+  return 0;
+}